@@ -172,7 +172,7 @@ void readConfigFile()
 			// Keep reading name/value pairs until we hit the ending '}'
 			while (!tz.checkOrEnd("}"))
 			{
-				read_cvar(tz.current().text, tz.peek().text);
+				read_cvar(tz.current().text(), tz.peek().text());
 				tz.adv(2);
 			}
 
@@ -184,7 +184,7 @@ void readConfigFile()
 		{
 			while (!tz.checkOrEnd("}"))
 			{
-				archive_manager.addBaseResourcePath(wxString::FromUTF8(UTF8(tz.current().text)));
+				archive_manager.addBaseResourcePath(wxString::FromUTF8(UTF8(tz.current().text())));
 				tz.adv();
 			}
 
@@ -196,7 +196,7 @@ void readConfigFile()
 		{
 			while (!tz.checkOrEnd("}"))
 			{
-				archive_manager.addRecentFile(wxString::FromUTF8(UTF8(tz.current().text)));
+				archive_manager.addRecentFile(wxString::FromUTF8(UTF8(tz.current().text())));
 				tz.adv();
 			}
 
@@ -212,7 +212,7 @@ void readConfigFile()
 		{
 			while (!tz.checkOrEnd("}"))
 			{
-				NodeBuilders::addBuilderPath(tz.current().text, tz.peek().text);
+				NodeBuilders::addBuilderPath(tz.current().text(), tz.peek().text());
 				tz.adv(2);
 			}
 
@@ -224,7 +224,7 @@ void readConfigFile()
 		{
 			while (!tz.checkOrEnd("}"))
 			{
-				Executables::setGameExePath(tz.current().text, tz.peek().text);
+				Executables::setGameExePath(tz.current().text(), tz.peek().text());
 				tz.adv(2);
 			}
 
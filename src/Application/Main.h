@@ -89,7 +89,7 @@ typename M::mapped_type findInMap(M& m, const typename M::key_type& k, typename
 // Namespace to hold 'global' variables
 namespace Global
 {
-	extern string error;
+	extern thread_local string error;	// Per thread, so worker threads can't clobber it
 	extern string version;
 	extern string sc_rev;
 	extern bool debug;
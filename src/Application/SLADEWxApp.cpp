@@ -33,6 +33,7 @@
 #include "SLADEWxApp.h"
 #include "App.h"
 #include "Archive/ArchiveManager.h"
+#include "Archive/Formats/WadArchive.h"
 #include "External/email/wxMailer.h"
 #include "General/Console/Console.h"
 #include "General/Web.h"
@@ -57,7 +58,7 @@
 // -----------------------------------------------------------------------------
 namespace Global
 {
-string error = "";
+thread_local string error = "";
 
 int    beta_num    = 5;
 int    version_num = 3120;
@@ -797,6 +798,11 @@ void SLADEWxApp::onActivate(wxActivateEvent& e)
 	if (theMainWindow && theMainWindow->getArchiveManagerPanel())
 		theMainWindow->getArchiveManagerPanel()->checkDirArchives();
 
+	// Stop using memory mapped wad files that were changed on the file system
+	for (int a = 0; a < App::archiveManager().numArchives(); a++)
+		if (auto wad = dynamic_cast<WadArchive*>(App::archiveManager().getArchive(a)))
+			wad->checkMappedFile();
+
 	e.Skip();
 }
 
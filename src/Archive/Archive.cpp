@@ -555,22 +555,23 @@ ArchiveEntry* Archive::entryAtPath(string path)
 	if (path.StartsWith("/"))
 		path.Remove(0, 1);
 
-	// Get path as wxFileName for processing
-	wxFileName fn(path);
+	// Split path into directory and entry name
+	auto   last_sep = path.find_last_of('/');
+	string name     = last_sep == string::npos ? path : path.Mid(last_sep + 1);
 
 	// Get directory from path
 	ArchiveTreeNode* dir;
-	if (fn.GetPath(false, wxPATH_UNIX).IsEmpty())
+	if (last_sep == string::npos)
 		dir = &dir_root_;
 	else
-		dir = getDir(fn.GetPath(true, wxPATH_UNIX));
+		dir = getDir(path.Left(last_sep + 1));
 
 	// If dir doesn't exist, return nullptr
 	if (!dir)
 		return nullptr;
 
 	// Return entry
-	return dir->entry(fn.GetFullName());
+	return dir->entry(name);
 }
 
 // -----------------------------------------------------------------------------
@@ -583,22 +584,23 @@ ArchiveEntry::SPtr Archive::entryAtPathShared(string path)
 	if (path.StartsWith("/"))
 		path.Remove(0, 1);
 
-	// Get path as wxFileName for processing
-	wxFileName fn(path);
+	// Split path into directory and entry name
+	auto   last_sep = path.find_last_of('/');
+	string name     = last_sep == string::npos ? path : path.Mid(last_sep + 1);
 
 	// Get directory from path
 	ArchiveTreeNode* dir;
-	if (fn.GetPath(false, wxPATH_UNIX).IsEmpty())
+	if (last_sep == string::npos)
 		dir = &dir_root_;
 	else
-		dir = getDir(fn.GetPath(true, wxPATH_UNIX));
+		dir = getDir(path.Left(last_sep + 1));
 
 	// If dir doesn't exist, return nullptr
 	if (!dir)
 		return nullptr;
 
 	// Return entry
-	return dir->sharedEntry(fn.GetFullName());
+	return dir->sharedEntry(name);
 }
 
 // -----------------------------------------------------------------------------
@@ -738,6 +740,28 @@ void Archive::entryStateChanged(ArchiveEntry* entry)
 	setModified(true);
 }
 
+// -----------------------------------------------------------------------------
+// Announces that the types of [entries] (all unmodified) were detected after
+// the archive was opened. This is done once for a whole batch of entries
+// rather than per entry, since listeners may need to refresh all resources
+// -----------------------------------------------------------------------------
+void Archive::entryTypesDetected(const vector<ArchiveEntry*>& entries)
+{
+	if (entries.empty())
+		return;
+
+	// Write the number of entries followed by the entry pointers
+	MemChunk mc(sizeof(uint32_t) + entries.size() * sizeof(wxUIntPtr));
+	uint32_t count = entries.size();
+	mc.write(&count, sizeof(uint32_t));
+	for (auto entry : entries)
+	{
+		wxUIntPtr ptr = wxPtrToUInt(entry);
+		mc.write(&ptr, sizeof(wxUIntPtr));
+	}
+	announce("entry_types_detected", mc);
+}
+
 // -----------------------------------------------------------------------------
 // Adds the directory structure starting from [start] to [list]
 // -----------------------------------------------------------------------------
@@ -3,6 +3,7 @@
 #include "ArchiveEntry.h"
 #include "ArchiveTreeNode.h"
 #include "General/ListenerAnnouncer.h"
+#include <mutex>
 
 struct ArchiveFormat
 {
@@ -91,6 +92,7 @@ public:
 	virtual unsigned numEntries();
 	virtual void     close();
 	void             entryStateChanged(ArchiveEntry* entry);
+	void             entryTypesDetected(const vector<ArchiveEntry*>& entries);
 	void             getEntryTreeAsList(vector<ArchiveEntry*>& list, ArchiveTreeNode* start = nullptr);
 	void             getEntryTreeAsList(vector<ArchiveEntry::SPtr>& list, ArchiveTreeNode* start = nullptr);
 	bool             canSave() const { return parent_ || on_disk_; }
@@ -98,6 +100,9 @@ public:
 	virtual bool     importDir(string directory);
 	virtual bool     hasFlatHack() { return false; }
 
+	// Held while loading entry data on demand (see ArchiveEntry::getMCData)
+	std::recursive_mutex& dataLoadMutex() { return data_load_mutex_; }
+
 	// Directory stuff
 	virtual ArchiveTreeNode* getDir(string path, ArchiveTreeNode* base = nullptr);
 	virtual ArchiveTreeNode* createDir(string path, ArchiveTreeNode* base = nullptr);
@@ -170,8 +175,9 @@ protected:
 	bool          read_only_; // If true, the archive cannot be modified
 
 private:
-	bool            modified_;
-	ArchiveTreeNode dir_root_;
+	bool                 modified_;
+	ArchiveTreeNode      dir_root_;
+	std::recursive_mutex data_load_mutex_;
 
 	static vector<ArchiveFormat> formats;
 };
@@ -65,7 +65,7 @@ ArchiveEntry::ArchiveEntry(string name, uint32_t size)
 	next_         = nullptr;
 	prev_         = nullptr;
 	encrypted_    = ENC_NONE;
-	index_guess_  = 0;
+	index_        = 0;
 }
 
 // -----------------------------------------------------------------------------
@@ -87,7 +87,7 @@ ArchiveEntry::ArchiveEntry(ArchiveEntry& copy)
 	next_         = nullptr;
 	prev_         = nullptr;
 	encrypted_    = copy.encrypted_;
-	index_guess_  = 0;
+	index_        = 0;
 
 	// Copy data
 	data_.importMem(copy.getData(true), copy.getSize());
@@ -146,6 +146,20 @@ string ArchiveEntry::getUpperNameNoExt()
 		return Misc::lumpNameToFileName(upper_name_);
 }
 
+// -----------------------------------------------------------------------------
+// Sets the entry name to [name], without changing the entry state
+// -----------------------------------------------------------------------------
+void ArchiveEntry::setName(string name)
+{
+	string old_name = name_;
+	name_           = name;
+	upper_name_     = name.Upper();
+
+	// Update the parent dir's name index
+	if (parent_)
+		parent_->entryRenamed(this, old_name);
+}
+
 // -----------------------------------------------------------------------------
 // Returns the entry's parent archive
 // -----------------------------------------------------------------------------
@@ -209,8 +223,36 @@ MemChunk& ArchiveEntry::getMCData(bool allow_load)
 	// Load the data if needed (and possible)
 	if (allow_load && !isLoaded() && parent_archive && size_ > 0)
 	{
-		data_loaded_ = parent_archive->loadEntryData(this);
-		setState(0);
+		// Entry data can be loaded on demand from worker threads (eg. when
+		// loading browser thumbnails), so only load one entry at a time per
+		// archive
+		std::lock_guard<std::recursive_mutex> lock(parent_archive->dataLoadMutex());
+		if (!isLoaded())
+		{
+			// State changes are announced to the parent archive's listeners,
+			// which must only happen on the main thread
+			if (wxThread::IsMain())
+			{
+				data_loaded_ = parent_archive->loadEntryData(this);
+				setState(0);
+			}
+			else
+			{
+				bool state_locked = state_locked_;
+				state_locked_     = true;
+				data_loaded_      = parent_archive->loadEntryData(this);
+				state_locked_     = state_locked;
+
+				if (state_ != 0 && wxTheApp)
+				{
+					ArchiveEntry::WPtr entry = getShared();
+					wxTheApp->CallAfter([entry]() {
+						if (auto e = entry.lock())
+							e->setState(0);
+					});
+				}
+			}
+		}
 	}
 
 	return data_;
@@ -307,8 +349,7 @@ bool ArchiveEntry::rename(string new_name)
 	}
 
 	// Update attributes
-	name_       = new_name;
-	upper_name_ = name_.Upper();
+	setName(new_name);
 	setState(1);
 
 	return true;
@@ -2,6 +2,7 @@
 
 #include "EntryType/EntryType.h"
 #include "Utility/PropertyList/PropertyList.h"
+#include <atomic>
 
 class ArchiveTreeNode;
 class Archive;
@@ -59,11 +60,7 @@ public:
 	SPtr             getShared();
 
 	// Modifiers (won't change entry state, except setState of course :P)
-	void setName(string name)
-	{
-		this->name_ = name;
-		upper_name_ = name.Upper();
-	}
+	void setName(string name);
 	void setLoaded(bool loaded = true) { data_loaded_ = loaded; }
 	void setType(EntryType* type, int r = 0)
 	{
@@ -113,6 +110,7 @@ public:
 	void          stateChanged();
 	void          setExtensionByType();
 	int           getTypeReliability() { return (type_ ? (getType()->reliability() * reliability_ / 255) : 0); }
+	int           getIdentReliability() { return reliability_; }
 	bool          isInNamespace(string ns);
 	ArchiveEntry* relativeEntry(const string& path, bool allow_absolute_path = true) const;
 
@@ -127,16 +125,16 @@ private:
 	PropertyList     ex_props_;
 
 	// Entry status
-	uint8_t state_;        // 0 = unmodified, 1 = modified, 2 = newly created (not saved to disk)
-	bool    state_locked_; // If true the entry state cannot be changed (used for initial loading)
-	bool    locked_;       // If true the entry data+info cannot be changed
-	bool    data_loaded_;  // True if the entry's data is currently loaded into the data MemChunk
-	int     encrypted_;    // Is there some encrypting on the archive?
+	uint8_t           state_;        // 0 = unmodified, 1 = modified, 2 = newly created (not saved to disk)
+	bool              state_locked_; // If true the entry state cannot be changed (used for initial loading)
+	bool              locked_;       // If true the entry data+info cannot be changed
+	std::atomic<bool> data_loaded_;  // True if the entry's data is currently loaded into the data MemChunk
+	int               encrypted_;    // Is there some encrypting on the archive?
 
 	// Misc stuff
 	int           reliability_; // The reliability of the entry's identification
 	ArchiveEntry* next_;
 	ArchiveEntry* prev_;
 
-	size_t index_guess_; // for speed
+	size_t index_; // Position within the parent dir, see ArchiveTreeNode::entryIndex
 };
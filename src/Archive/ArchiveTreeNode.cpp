@@ -33,6 +33,49 @@
 #include "Main.h"
 #include "ArchiveTreeNode.h"
 #include "General/Misc.h"
+#include "Utility/StringUtils.h"
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns the lowercase index key for entry [name], with the extension cut if
+// [cut_ext] is true (as ArchiveEntry::getName does)
+// -----------------------------------------------------------------------------
+string indexKey(const string& name, bool cut_ext)
+{
+	if (!cut_ext)
+		return name.Lower();
+
+	string saname = Misc::lumpNameToFileName(name);
+	if (saname.Contains(StringUtils::FULLSTOP))
+		return saname.BeforeLast('.').Lower();
+	else
+		return saname.Lower();
+}
+
+// -----------------------------------------------------------------------------
+// Removes [entry] from the [index] list for [key]
+// -----------------------------------------------------------------------------
+template<typename T> void removeFromIndex(T& index, const string& key, ArchiveEntry* entry)
+{
+	auto i = index.find(key);
+	if (i == index.end())
+		return;
+
+	auto& list = i->second;
+	auto  pos  = std::find(list.begin(), list.end(), entry);
+	if (pos != list.end())
+		list.erase(pos);
+	if (list.empty())
+		index.erase(i);
+}
+} // namespace
 
 
 // -----------------------------------------------------------------------------
@@ -95,7 +138,13 @@ string ArchiveTreeNode::getName()
 
 // -----------------------------------------------------------------------------
 // Returns the index of [entry] within this directory, or -1 if the entry
-// doesn't exist
+// doesn't exist (or is before [startfrom])
+//
+// Each entry keeps its position in [index_], which is only updated (from
+// [index_valid_to_] onwards) when needed after entries are inserted or removed.
+// This is only done on the main thread, when called from another thread (eg.
+// looking up patches while converting textures) the entry is searched for
+// instead, so nothing shared is modified
 // -----------------------------------------------------------------------------
 int ArchiveTreeNode::entryIndex(ArchiveEntry* entry, size_t startfrom)
 {
@@ -103,41 +152,37 @@ int ArchiveTreeNode::entryIndex(ArchiveEntry* entry, size_t startfrom)
 	if (!entry)
 		return -1;
 
-	// Search for it
+	// Update entry positions if needed
 	const size_t size = entries_.size();
-	if (entry->index_guess_ < startfrom || entry->index_guess_ >= size)
+	if (entry->index_ >= index_valid_to_ && index_valid_to_ < size && wxThread::IsMain())
 	{
-		for (auto a = startfrom; a < size; a++)
-		{
-			if (entries_[a].get() == entry)
-			{
-				entry->index_guess_ = a;
-				return (int)a;
-			}
-		}
+		for (size_t a = index_valid_to_; a < size; a++)
+			entries_[a]->index_ = a;
+		index_valid_to_ = size;
 	}
-	else
+
+	// Check the entry is actually at its position here, if not it's probably
+	// in another directory (or also in another directory, in which case it
+	// has to be searched for)
+	auto index = entry->index_;
+	if (index >= size || entries_[index].get() != entry)
 	{
-		for (auto a = entry->index_guess_; a < size; a++)
+		index = size;
+		for (size_t a = 0; a < size; a++)
 		{
 			if (entries_[a].get() == entry)
 			{
-				entry->index_guess_ = a;
-				return (int)a;
-			}
-		}
-		for (auto a = startfrom; a < entry->index_guess_; a++)
-		{
-			if (entries_[a].get() == entry)
-			{
-				entry->index_guess_ = a;
-				return (int)a;
+				index = a;
+				break;
 			}
 		}
+
+		// Not found
+		if (index == size)
+			return -1;
 	}
 
-	// Not found
-	return -1;
+	return index < startfrom ? -1 : (int)index;
 }
 
 // -----------------------------------------------------------------------------
@@ -200,16 +245,7 @@ ArchiveEntry* ArchiveTreeNode::entry(const string& name, bool cut_ext)
 	if (name.empty())
 		return nullptr;
 
-	// Go through entries
-	for (auto& entry : entries_)
-	{
-		// Check for (non-case-sensitive) name match
-		if (S_CMPNOCASE(entry->getName(cut_ext), name))
-			return entry.get();
-	}
-
-	// Not found
-	return nullptr;
+	return findEntry(name, cut_ext);
 }
 
 // -----------------------------------------------------------------------------
@@ -222,16 +258,11 @@ ArchiveEntry::SPtr ArchiveTreeNode::sharedEntry(const string& name, bool cut_ext
 	if (name.empty())
 		return nullptr;
 
-	// Go through entries
-	for (auto& entry : entries_)
-	{
-		// Check for (non-case-sensitive) name match
-		if (S_CMPNOCASE(entry->getName(cut_ext), name))
-			return entry;
-	}
+	auto entry = findEntry(name, cut_ext);
+	if (!entry)
+		return nullptr;
 
-	// Not found
-	return nullptr;
+	return entries_[entryIndex(entry)];
 }
 
 // -----------------------------------------------------------------------------
@@ -241,9 +272,9 @@ ArchiveEntry::SPtr ArchiveTreeNode::sharedEntry(const string& name, bool cut_ext
 ArchiveEntry::SPtr ArchiveTreeNode::sharedEntry(ArchiveEntry* entry)
 {
 	// Find entry
-	for (auto& e : entries_)
-		if (entry == e.get())
-			return e;
+	int index = entryIndex(entry);
+	if (index >= 0)
+		return entries_[index];
 
 	// Not in this ArchiveTreeNode
 	return nullptr;
@@ -301,6 +332,7 @@ bool ArchiveTreeNode::addEntry(ArchiveEntry* entry, unsigned index)
 		entry->next_ = nullptr;
 
 		// Add it to end
+		index = entries_.size();
 		entries_.push_back(ArchiveEntry::SPtr(entry));
 	}
 	else
@@ -320,6 +352,7 @@ bool ArchiveTreeNode::addEntry(ArchiveEntry* entry, unsigned index)
 
 	// Set entry's parent to this node
 	entry->parent_ = this;
+	entryInserted(entry, index);
 
 	// Check entry name if duplicate names aren't allowed
 	if (!allow_duplicate_names_)
@@ -352,6 +385,7 @@ bool ArchiveTreeNode::addEntry(ArchiveEntry::SPtr& entry, unsigned index)
 		entry->next_ = nullptr;
 
 		// Add it to end
+		index = entries_.size();
 		entries_.push_back(ArchiveEntry::SPtr(entry));
 	}
 	else
@@ -371,6 +405,7 @@ bool ArchiveTreeNode::addEntry(ArchiveEntry::SPtr& entry, unsigned index)
 
 	// Set entry's parent to this node
 	entry->parent_ = this;
+	entryInserted(entry.get(), index);
 
 	// Check entry name if duplicate names aren't allowed
 	if (!allow_duplicate_names_)
@@ -390,6 +425,7 @@ bool ArchiveTreeNode::removeEntry(unsigned index)
 		return false;
 
 	// De-parent entry
+	unindexEntry(entries_[index].get(), entries_[index]->name_);
 	entries_[index]->parent_ = nullptr;
 
 	// De-link entry
@@ -402,6 +438,7 @@ bool ArchiveTreeNode::removeEntry(unsigned index)
 
 	// Remove it from the entry list
 	entries_.erase(entries_.begin() + index);
+	index_valid_to_ = std::min<size_t>(index_valid_to_, index);
 
 	return true;
 }
@@ -422,6 +459,8 @@ bool ArchiveTreeNode::swapEntries(unsigned index1, unsigned index2)
 
 	// Swap entries
 	entries_[index1].swap(entries_[index2]);
+	entry1->index_ = index2;
+	entry2->index_ = index1;
 
 	// Update links
 	linkEntries(entryAt(index1 - 1), entry2);
@@ -439,11 +478,12 @@ void ArchiveTreeNode::clear()
 {
 	// Clear entries
 	entries_.clear();
+	entry_names_.clear();
+	entry_names_noext_.clear();
+	index_valid_to_ = 0;
 
 	// Clear subdirs
-	for (auto& subdir : children)
-		delete subdir;
-	children.clear();
+	clearChildren();
 }
 
 // -----------------------------------------------------------------------------
@@ -537,30 +577,144 @@ bool ArchiveTreeNode::exportTo(string path)
 // -----------------------------------------------------------------------------
 void ArchiveTreeNode::ensureUniqueName(ArchiveEntry* entry)
 {
-	unsigned   index     = 0;
-	unsigned   number    = 0;
-	const auto n_entries = entries_.size();
+	// Returns true if an entry other than [entry] is named [name]
+	auto name_taken = [&](const string& name) {
+		auto i = entry_names_.find(name.Lower());
+		if (i == entry_names_.end())
+			return false;
+
+		for (auto e : i->second)
+			if (e != entry)
+				return true;
+
+		return false;
+	};
+
+	unsigned   number = 0;
 	wxFileName fn(entry->getName());
 	string     name = fn.GetFullName();
-	while (index < n_entries)
+	while (name_taken(name))
 	{
-		if (entries_[index].get() == entry)
+		fn.SetName(S_FMT("%s%d", CHR(entry->getName(true)), ++number));
+		name = fn.GetFullName();
+	}
+
+	if (number > 0)
+		entry->rename(name);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the entry matching [name] in this directory, or null if no entries
+// match. If multiple entries match, the first one is returned
+// -----------------------------------------------------------------------------
+ArchiveEntry* ArchiveTreeNode::findEntry(const string& name, bool cut_ext)
+{
+	// Build the extensionless name index if it's the first time it's needed.
+	// Like entry positions (see entryIndex) this is only done on the main
+	// thread, elsewhere the entries are searched instead
+	if (cut_ext && !noext_indexed_)
+	{
+		if (!wxThread::IsMain())
 		{
-			index++;
-			continue;
+			string key = name.Lower();
+			for (auto& entry : entries_)
+				if (indexKey(entry->name_, true) == key)
+					return entry.get();
+			return nullptr;
 		}
 
-		if (S_CMPNOCASE(entries_[index]->getName(false), name))
+		for (auto& entry : entries_)
+			entry_names_noext_[indexKey(entry->name_, true)].push_back(entry.get());
+		noext_indexed_ = true;
+	}
+
+	auto& index = cut_ext ? entry_names_noext_ : entry_names_;
+	auto  i     = index.find(name.Lower());
+	if (i == index.end() || i->second.empty())
+		return nullptr;
+
+	// Get the first if there are duplicate names
+	auto first = i->second[0];
+	if (i->second.size() > 1)
+	{
+		int first_index = entryIndex(first);
+		for (auto entry : i->second)
 		{
-			fn.SetName(S_FMT("%s%d", CHR(entry->getName(true)), ++number));
-			name  = fn.GetFullName();
-			index = 0;
-			continue;
+			int entry_index = entryIndex(entry);
+			if (entry_index < first_index)
+			{
+				first       = entry;
+				first_index = entry_index;
+			}
 		}
+	}
+
+	return first;
+}
 
-		index++;
+// -----------------------------------------------------------------------------
+// Adds [entry] to the name index(es)
+// -----------------------------------------------------------------------------
+void ArchiveTreeNode::indexEntry(ArchiveEntry* entry)
+{
+	entry_names_[indexKey(entry->name_, false)].push_back(entry);
+	if (noext_indexed_)
+		entry_names_noext_[indexKey(entry->name_, true)].push_back(entry);
+}
+
+// -----------------------------------------------------------------------------
+// Removes [entry] (indexed as [name]) from the name index(es)
+// -----------------------------------------------------------------------------
+void ArchiveTreeNode::unindexEntry(ArchiveEntry* entry, const string& name)
+{
+	removeFromIndex(entry_names_, indexKey(name, false), entry);
+	if (noext_indexed_)
+		removeFromIndex(entry_names_noext_, indexKey(name, true), entry);
+}
+
+// -----------------------------------------------------------------------------
+// Called when [entry] (with this as its parent) has been renamed from
+// [old_name], updates the relevant name index
+// -----------------------------------------------------------------------------
+void ArchiveTreeNode::entryRenamed(ArchiveEntry* entry, const string& old_name)
+{
+	// Subdirectory entries have this as their parent, but aren't in the entry
+	// list
+	if (entry->type_ == EntryType::folderType())
+	{
+		for (auto child : children)
+		{
+			if (((ArchiveTreeNode*)child)->dir_entry_.get() == entry)
+			{
+				childRenamed(child, old_name);
+				return;
+			}
+		}
 	}
 
-	if (number > 0)
-		entry->rename(name);
+	// Ignore if it isn't actually in this directory (eg. the directory entry
+	// of a subdirectory that has since been removed)
+	if (entryIndex(entry) < 0)
+		return;
+
+	unindexEntry(entry, old_name);
+	indexEntry(entry);
+}
+
+// -----------------------------------------------------------------------------
+// Called when [entry] has been inserted at [index], updates the name index
+// and entry positions
+// -----------------------------------------------------------------------------
+void ArchiveTreeNode::entryInserted(ArchiveEntry* entry, unsigned index)
+{
+	indexEntry(entry);
+
+	// Positions are still valid if it was added to the end
+	if (index == entries_.size() - 1 && index_valid_to_ == index)
+	{
+		entry->index_ = index;
+		index_valid_to_++;
+	}
+	else
+		index_valid_to_ = std::min<size_t>(index_valid_to_, index);
 }
@@ -2,10 +2,12 @@
 
 #include "ArchiveEntry.h"
 #include "Utility/Tree.h"
+#include <atomic>
 
 class ArchiveTreeNode : public STreeNode
 {
 	friend class Archive;
+	friend class ArchiveEntry;
 
 public:
 	ArchiveTreeNode(ArchiveTreeNode* parent = nullptr, Archive* archive = nullptr);
@@ -19,7 +21,7 @@ public:
 	// STreeNode
 	string getName() override;
 	void   addChild(STreeNode* child) override;
-	void   setName(string name) override { dir_entry_->name_ = name; }
+	void   setName(string name) override { dir_entry_->setName(name); }
 
 	// Entry Access
 	ArchiveEntry*      entryAt(unsigned index);
@@ -59,10 +61,22 @@ protected:
 	}
 
 private:
+	// Entries by lowercase name (in no particular order)
+	typedef std::unordered_map<string, vector<ArchiveEntry*>, wxStringHash, wxStringEqual> EntryIndex;
+
 	Archive*                   archive_;
 	ArchiveEntry::SPtr         dir_entry_;
 	vector<ArchiveEntry::SPtr> entries_;
 	bool                       allow_duplicate_names_ = true;
+	EntryIndex                 entry_names_;
+	EntryIndex                 entry_names_noext_; // Only built once needed
+	std::atomic<bool>          noext_indexed_{ false };
+	std::atomic<size_t>        index_valid_to_{ 0 }; // Entries before this have a correct index_
 
-	void ensureUniqueName(ArchiveEntry* entry);
+	void          ensureUniqueName(ArchiveEntry* entry);
+	ArchiveEntry* findEntry(const string& name, bool cut_ext);
+	void          indexEntry(ArchiveEntry* entry);
+	void          unindexEntry(ArchiveEntry* entry, const string& name);
+	void          entryRenamed(ArchiveEntry* entry, const string& old_name);
+	void          entryInserted(ArchiveEntry* entry, unsigned index);
 };
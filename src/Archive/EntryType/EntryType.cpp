@@ -37,6 +37,7 @@
 #include "General/Console/Console.h"
 #include "MainEditor/BinaryControlLump.h"
 #include "MainEditor/MainEditor.h"
+#include "Utility/Compression.h"
 #include "Utility/Parser.h"
 
 
@@ -55,9 +56,114 @@ EntryType etype_unknown; // The default, 'unknown' entry type
 EntryType etype_folder;  // Folder entry type
 EntryType etype_marker;  // Marker entry type
 EntryType etype_map;     // Map marker type
+
+// Index used to find the entry types that could possibly match an entry, so
+// detectEntryType doesn't have to check every type (see buildDetectionIndex)
+struct DetectionIndex
+{
+	bool                            valid = false;
+	vector<int>                     any;     // Types that don't require any of the below
+	std::map<unsigned, vector<int>> by_size; // Types that require an exact size
+	std::map<string, vector<int>>   by_ext;  // Types that require an extension
+	std::map<string, vector<int>>   by_name; // Types that require a (non-wildcard) name
+};
+DetectionIndex detection_index;
+
+// Checksum of all loaded entry type definitions (see definitionsSignature)
+uint32_t definitions_signature = 0;
 } // namespace
 
 
+// -----------------------------------------------------------------------------
+//
+// Structs
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Info about an entry used when checking it against entry types. Anything that
+// would be the same for each type checked (name, data format checks, etc.) is
+// only worked out once, when first needed
+// -----------------------------------------------------------------------------
+struct EntryType::MatchInfo
+{
+	ArchiveEntry* entry;
+	unsigned      size;
+	string        name;    // Upper case name, without extension
+	string        ext;     // Upper case extension (everything after the first .)
+	bool          has_ext; // Ext is only valid if this is true
+	string        archive; // Parent archive format id
+
+	MatchInfo(ArchiveEntry* entry) : entry{ entry }, size{ entry->getSize() }
+	{
+		string fn      = entry->getUpperName();
+		size_t ext_sep = fn.find_first_of('.', 0);
+		has_ext        = ext_sep != wxString::npos;
+		name           = has_ext ? fn.Left(ext_sep) : fn;
+		if (has_ext)
+			ext = fn.Mid(ext_sep + 1);
+		if (entry->getParent())
+			archive = entry->getParent()->formatId();
+	}
+
+	// For entries that aren't in an archive (yet), with the [archive] format and
+	// [section] they will have given
+	MatchInfo(ArchiveEntry* entry, const string& archive, const string& section) : MatchInfo{ entry }
+	{
+		this->archive     = archive;
+		section_          = section;
+		section_detected_ = true;
+	}
+
+	// Returns the result of checking the entry data against [format]
+	int formatResult(EntryDataFormat* format)
+	{
+		for (auto& result : format_results_)
+			if (result.first == format)
+				return result.second;
+
+		int r = format->isThisFormat(entry->getMCData());
+		format_results_.emplace_back(format, r);
+		return r;
+	}
+
+	// Returns true if the entry data could be text (contains no null bytes)
+	bool isText()
+	{
+		if (is_text_ < 0)
+		{
+			// Hack for identifying ACS script sources despite DB2 apparently appending
+			// two null bytes to them, which make the memchr test fail.
+			size_t end = size - 1;
+			if (end > 3)
+				end -= 2;
+			is_text_ = (size > 0 && memchr(entry->getData(), 0, end) != nullptr) ? 0 : 1;
+		}
+
+		return is_text_ > 0;
+	}
+
+	// Returns the namespace the entry is in within its parent archive
+	const string& section()
+	{
+		if (!section_detected_)
+		{
+			section_          = entry->getParent()->detectNamespace(entry);
+			section_detected_ = true;
+		}
+
+		return section_;
+	}
+
+private:
+	vector<std::pair<EntryDataFormat*, int>> format_results_;
+	int                                      is_text_          = -1;
+	string                                   section_;
+	bool                                     section_detected_ = false;
+};
+
+
 // -----------------------------------------------------------------------------
 //
 // EntryType Class Functions
@@ -99,6 +205,9 @@ void EntryType::addToList()
 {
 	entry_types.push_back(this);
 	index_ = entry_types.size() - 1;
+
+	// Detection index needs to be rebuilt
+	detection_index.valid = false;
 }
 
 // -----------------------------------------------------------------------------
@@ -179,16 +288,27 @@ int EntryType::isThisType(ArchiveEntry* entry)
 	if (!entry)
 		return EDF_FALSE;
 
+	MatchInfo info(entry);
+	return isThisType(info);
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the entry in [info] matches the EntryType's criteria, false
+// otherwise. The cheaper checks are done first, the data format and section
+// checks last
+// -----------------------------------------------------------------------------
+int EntryType::isThisType(MatchInfo& info)
+{
 	// Check type is detectable
 	if (!detectable_)
 		return EDF_FALSE;
 
 	// Check min size
-	if (size_limit_[0] >= 0 && entry->getSize() < (unsigned)size_limit_[0])
+	if (size_limit_[0] >= 0 && info.size < (unsigned)size_limit_[0])
 		return EDF_FALSE;
 
 	// Check max size
-	if (size_limit_[1] >= 0 && entry->getSize() > (unsigned)size_limit_[1])
+	if (size_limit_[1] >= 0 && info.size > (unsigned)size_limit_[1])
 		return EDF_FALSE;
 
 	// Check for archive match if needed
@@ -197,7 +317,7 @@ int EntryType::isThisType(ArchiveEntry* entry)
 		bool match = false;
 		for (size_t a = 0; a < match_archive_.size(); a++)
 		{
-			if (entry->getParent() && entry->getParent()->formatId() == match_archive_[a])
+			if (!info.archive.empty() && info.archive == match_archive_[a])
 			{
 				match = true;
 				break;
@@ -213,7 +333,7 @@ int EntryType::isThisType(ArchiveEntry* entry)
 		bool match = false;
 		for (size_t a = 0; a < match_size_.size(); a++)
 		{
-			if (entry->getSize() == match_size_[a])
+			if (info.size == match_size_[a])
 			{
 				match = true;
 				break;
@@ -224,27 +344,6 @@ int EntryType::isThisType(ArchiveEntry* entry)
 			return EDF_FALSE;
 	}
 
-	// Check for data format match if needed
-	int r = EDF_TRUE;
-	if (format_ == EntryDataFormat::textFormat())
-	{
-		// Hack for identifying ACS script sources despite DB2 apparently appending
-		// two null bytes to them, which make the memchr test fail.
-		size_t end = entry->getSize() - 1;
-		if (end > 3)
-			end -= 2;
-		// Text is a special case, as other data formats can sometimes be detected as 'text',
-		// we'll only check for it if text data is specified in the entry type
-		if (entry->getSize() > 0 && memchr(entry->getData(), 0, end) != nullptr)
-			return EDF_FALSE;
-	}
-	else if (format_ != EntryDataFormat::anyFormat() && entry->getSize() > 0)
-	{
-		r = format_->isThisFormat(entry->getMCData());
-		if (r == EDF_FALSE)
-			return EDF_FALSE;
-	}
-
 	// Check for size multiple match if needed
 	if (!size_multiple_.empty())
 	{
@@ -252,7 +351,7 @@ int EntryType::isThisType(ArchiveEntry* entry)
 		size_t size_multiple_size = size_multiple_.size();
 		for (size_t a = 0; a < size_multiple_size; a++)
 		{
-			if (entry->getSize() % size_multiple_[a] == 0)
+			if (info.size % size_multiple_[a] == 0)
 			{
 				match = true;
 				break;
@@ -270,68 +369,71 @@ int EntryType::isThisType(ArchiveEntry* entry)
 	if (match_ext_or_name_ && !match_name_.empty() && !match_extension_.empty())
 		extorname = true;
 
-	// Entry name related stuff
-	if (!match_name_.empty() || !match_extension_.empty())
+	// Check for name match if needed
+	if (!match_name_.empty())
 	{
-		// Get entry name (lowercase), find extension separator
-		string fn      = entry->getUpperName();
-		size_t ext_sep = fn.find_first_of('.', 0);
-
-		// Check for name match if needed
-		if (!match_name_.empty())
+		bool   match           = false;
+		size_t match_name_size = match_name_.size();
+		for (size_t a = 0; a < match_name_size; a++)
 		{
-			string name = fn;
-			if (ext_sep != wxString::npos)
-				name = fn.Left(ext_sep);
-
-			bool   match           = false;
-			size_t match_name_size = match_name_.size();
-			for (size_t a = 0; a < match_name_size; a++)
+			if (info.name.Matches(match_name_[a]))
 			{
-				if (name.Matches(match_name_[a]))
-				{
-					match = true;
-					break;
-				}
+				match = true;
+				break;
 			}
-
-			if (!match && !extorname)
-				return EDF_FALSE;
-			else
-				matchedname = match;
 		}
 
-		// Check for extension match if needed
-		if (!match_extension_.empty())
+		if (!match && !extorname)
+			return EDF_FALSE;
+		else
+			matchedname = match;
+	}
+
+	// Check for extension match if needed
+	if (!match_extension_.empty())
+	{
+		bool match = false;
+		if (info.has_ext)
 		{
-			bool match = false;
-			if (ext_sep != wxString::npos)
+			size_t match_extension_size = match_extension_.size();
+			for (size_t a = 0; a < match_extension_size; a++)
 			{
-				string ext                  = fn.Mid(ext_sep + 1);
-				size_t match_extension_size = match_extension_.size();
-				for (size_t a = 0; a < match_extension_size; a++)
+				if (info.ext == match_extension_[a])
 				{
-					if (ext == match_extension_[a])
-					{
-						match = true;
-						break;
-					}
+					match = true;
+					break;
 				}
 			}
-
-			if (!match && !(extorname && matchedname))
-				return EDF_FALSE;
 		}
+
+		if (!match && !(extorname && matchedname))
+			return EDF_FALSE;
+	}
+
+	// Check for data format match if needed
+	int r = EDF_TRUE;
+	if (format_ == EntryDataFormat::textFormat())
+	{
+		// Text is a special case, as other data formats can sometimes be detected as 'text',
+		// we'll only check for it if text data is specified in the entry type
+		if (!info.isText())
+			return EDF_FALSE;
+	}
+	else if (format_ != EntryDataFormat::anyFormat() && info.size > 0)
+	{
+		r = info.formatResult(format_);
+		if (r == EDF_FALSE)
+			return EDF_FALSE;
 	}
 
 	// Check for entry section match if needed
 	if (!section_.empty())
 	{
 		// Check entry is part of an archive (if not it can't be in a section)
-		if (!entry->getParent())
+		if (info.archive.empty())
 			return EDF_FALSE;
 
-		string e_section = entry->getParent()->detectNamespace(entry);
+		const string& e_section = info.section();
 
 		r = EDF_FALSE;
 		for (auto ns : section_)
@@ -570,12 +672,20 @@ bool EntryType::loadEntryTypes()
 		return false;
 	}
 
+	// Include the program version in the definitions signature, since
+	// detection itself can change between versions
+	auto version          = Global::version.ToUTF8();
+	definitions_signature = Compression::ZipCRC((const uint8_t*)version.data(), version.length());
+
 	// Read in each file in the directory
 	bool         etypes_read       = false;
 	unsigned int et_dir_numEntries = et_dir->numEntries();
 	for (unsigned a = 0; a < et_dir_numEntries; a++)
 	{
-		if (readEntryTypeDefinition(et_dir->entryAt(a)->getMCData(), et_dir->entryAt(a)->getName()))
+		MemChunk& mc = et_dir->entryAt(a)->getMCData();
+		if (mc.hasData())
+			definitions_signature = Compression::ZipCRC(mc.getData(), mc.getSize(), definitions_signature);
+		if (readEntryTypeDefinition(mc, et_dir->entryAt(a)->getName()))
 			etypes_read = true;
 	}
 
@@ -601,6 +711,8 @@ bool EntryType::loadEntryTypes()
 		// Load file data
 		MemChunk mc;
 		mc.importFile(res_dir.GetName() + "/" + filename);
+		if (mc.hasData())
+			definitions_signature = Compression::ZipCRC(mc.getData(), mc.getSize(), definitions_signature);
 
 		// Parse file
 		readEntryTypeDefinition(mc, filename);
@@ -609,16 +721,92 @@ bool EntryType::loadEntryTypes()
 		files = res_dir.GetNext(&filename);
 	}
 
+	// Build detection index
+	buildDetectionIndex();
+
 	return true;
 }
 
+// -----------------------------------------------------------------------------
+// Builds the index used by detectEntryType to find the types that could match
+// an entry. Each detectable type is added to one bucket, keyed by the most
+// selective criteria it requires: an exact size, an extension or a name
+// (without wildcards). Types that require none of these are always checked
+// -----------------------------------------------------------------------------
+void EntryType::buildDetectionIndex()
+{
+	detection_index = DetectionIndex();
+
+	for (auto type : entry_types)
+	{
+		if (!type->detectable_)
+			continue;
+
+		// Name or extension is optional if the type can match either
+		bool extorname = type->match_ext_or_name_ && !type->match_name_.empty() && !type->match_extension_.empty();
+
+		// Check for wildcards in names
+		bool literal_names = !type->match_name_.empty();
+		for (auto& name : type->match_name_)
+			if (name.find_first_of("*?") != wxString::npos)
+				literal_names = false;
+
+		if (!type->match_size_.empty())
+		{
+			for (auto size : type->match_size_)
+				detection_index.by_size[size].push_back(type->index_);
+		}
+		else if (!type->match_extension_.empty() && !extorname)
+		{
+			for (auto& ext : type->match_extension_)
+				detection_index.by_ext[ext].push_back(type->index_);
+		}
+		else if (literal_names && !extorname)
+		{
+			for (auto& name : type->match_name_)
+				detection_index.by_name[name].push_back(type->index_);
+		}
+		else
+			detection_index.any.push_back(type->index_);
+	}
+
+	detection_index.valid = true;
+}
+
 // -----------------------------------------------------------------------------
 // Attempts to detect the given entry's type
 // -----------------------------------------------------------------------------
 bool EntryType::detectEntryType(ArchiveEntry* entry)
+{
+	if (!entry)
+		return false;
+
+	MatchInfo info(entry);
+	return detectEntryType(info);
+}
+
+// -----------------------------------------------------------------------------
+// Attempts to detect the type of [entry], which isn't in an archive, as if it
+// were in the [section] namespace of an archive of [archive_format].
+// Doesn't touch anything other than [entry], so can be used from any thread
+// -----------------------------------------------------------------------------
+bool EntryType::detectEntryType(ArchiveEntry* entry, const string& archive_format, const string& section)
+{
+	if (!entry)
+		return false;
+
+	MatchInfo info(entry, archive_format, section);
+	return detectEntryType(info);
+}
+
+// -----------------------------------------------------------------------------
+// Attempts to detect the type of the entry in [info]
+// -----------------------------------------------------------------------------
+bool EntryType::detectEntryType(MatchInfo& info)
 {
 	// Do nothing if the entry is a folder or a map marker
-	if (!entry || entry->getType() == &etype_folder || entry->getType() == &etype_map)
+	auto entry = info.entry;
+	if (entry->getType() == &etype_folder || entry->getType() == &etype_map)
 		return false;
 
 	// If the entry's size is zero, set it to marker type
@@ -631,16 +819,46 @@ bool EntryType::detectEntryType(ArchiveEntry* entry)
 	// Reset entry type
 	entry->setType(&etype_unknown);
 
-	// Go through all registered types
-	size_t entry_types_size = entry_types.size();
-	for (size_t a = 0; a < entry_types_size; a++)
+	// Get the types that could possibly match the entry, in the order they were
+	// registered (the first of equally reliable matches is used)
+	vector<int> candidates;
+	if (detection_index.valid)
+	{
+		auto add = [&candidates](const vector<int>& types) {
+			candidates.insert(candidates.end(), types.begin(), types.end());
+		};
+
+		add(detection_index.any);
+		auto i_size = detection_index.by_size.find(info.size);
+		if (i_size != detection_index.by_size.end())
+			add(i_size->second);
+		auto i_name = detection_index.by_name.find(info.name);
+		if (i_name != detection_index.by_name.end())
+			add(i_name->second);
+		if (info.has_ext)
+		{
+			auto i_ext = detection_index.by_ext.find(info.ext);
+			if (i_ext != detection_index.by_ext.end())
+				add(i_ext->second);
+		}
+
+		std::sort(candidates.begin(), candidates.end());
+	}
+	else
+	{
+		for (unsigned a = 0; a < entry_types.size(); a++)
+			candidates.push_back(a);
+	}
+
+	// Go through all candidate types
+	for (auto a : candidates)
 	{
 		// If the current type is more 'reliable' than this one, skip it
 		if (entry->getTypeReliability() >= entry_types[a]->reliability())
 			continue;
 
 		// Check for possible type match
-		int r = entry_types[a]->isThisType(entry);
+		int r = entry_types[a]->isThisType(info);
 		if (r > 0)
 		{
 			// Type matches, set it
@@ -659,6 +877,15 @@ bool EntryType::detectEntryType(ArchiveEntry* entry)
 		return true;
 }
 
+// -----------------------------------------------------------------------------
+// Returns a checksum of all loaded entry type definitions (and the program
+// version), for checking if previous detection results are still valid
+// -----------------------------------------------------------------------------
+uint32_t EntryType::definitionsSignature()
+{
+	return definitions_signature;
+}
+
 // -----------------------------------------------------------------------------
 // Returns the entry type with the given id, or etype_unknown if no id match is
 // found
@@ -852,3 +1079,70 @@ CONSOLE_COMMAND(size, 0, true)
 	}
 	LOG_MESSAGE(1, "%s: %i bytes", meep->getName().mb_str(), meep->getSize());
 }
+
+// -----------------------------------------------------------------------------
+// Benchmarks entry type detection on all entries in the current archive, and
+// checks the results are the same as when checking every type
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(test_detect_speed, 0, false)
+{
+	auto archive = MainEditor::currentArchive();
+	if (!archive)
+	{
+		Log::console("No archive open");
+		return;
+	}
+
+	// Get all (non-folder) entries, and load their data so it isn't included
+	// in the timing
+	vector<ArchiveEntry*> all_entries, entries;
+	archive->getEntryTreeAsList(all_entries);
+	for (auto entry : all_entries)
+	{
+		if (entry->getType() != EntryType::folderType())
+		{
+			entry->getData();
+			entries.push_back(entry);
+		}
+	}
+
+	Log::console("Testing...");
+
+	// Run detection on all entries 5 times, returning the average time taken
+	auto test = [&entries]() {
+		long times[5];
+		for (unsigned t = 0; t < 5; t++)
+		{
+			auto start = App::runTimer();
+			for (auto entry : entries)
+				EntryType::detectEntryType(entry);
+			times[t] = App::runTimer() - start;
+		}
+		return float(times[0] + times[1] + times[2] + times[3] + times[4]) / 5.0f;
+	};
+
+	// Indexed
+	float                              avg_indexed = test();
+	vector<std::pair<EntryType*, int>> results;
+	for (auto entry : entries)
+		results.emplace_back(entry->getType(), entry->getTypeReliability());
+
+	// All types
+	bool valid            = detection_index.valid;
+	detection_index.valid = false;
+	float avg_all         = test();
+	detection_index.valid = valid;
+
+	// Compare results
+	unsigned diff = 0;
+	for (unsigned a = 0; a < entries.size(); a++)
+		if (entries[a]->getType() != results[a].first || entries[a]->getTypeReliability() != results[a].second)
+			diff++;
+
+	Log::console(S_FMT(
+		"Detection on %d entries took %dms avg (%dms avg checking all types), %d differing results",
+		(int)entries.size(),
+		(int)avg_indexed,
+		(int)avg_all,
+		diff));
+}
@@ -36,6 +36,8 @@ public:
 	static bool               readEntryTypeDefinition(MemChunk& mc, const string& source);
 	static bool               loadEntryTypes();
 	static bool               detectEntryType(ArchiveEntry* entry);
+	static bool               detectEntryType(ArchiveEntry* entry, const string& archive_format, const string& section);
+	static uint32_t           definitionsSignature();
 	static EntryType*         fromId(const string& id);
 	static EntryType*         unknownType();
 	static EntryType*         folderType();
@@ -46,6 +48,10 @@ public:
 	static vector<string>     allCategories();
 
 private:
+	struct MatchInfo; // Entry info used for type matching (see EntryType.cpp)
+
+	static bool detectEntryType(MatchInfo& info);
+
 	// Type info
 	string  id_;
 	string  name_;
@@ -78,4 +84,8 @@ private:
 	vector<string> section_;       // The 'section' of the archive the entry must be in, eg "sprites" for entries
 								   // between SS_START/SS_END in a wad, or the 'sprites' folder in a zip
 	vector<string> match_archive_; // The types of archive the entry can be found in (e.g., wad or zip)
+
+	int isThisType(MatchInfo& info);
+
+	static void buildDetectionIndex();
 };
@@ -0,0 +1,428 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    EntryTypeCache.cpp
+// Description: EntryTypeCache class, keeps the detected types of an archive's
+//              entries on disk (in the user dir) so they don't need to be
+//              detected again next time the archive is opened, as long as the
+//              archive file and entry type definitions haven't changed
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "EntryTypeCache.h"
+#include "App.h"
+#include "Archive/ArchiveEntry.h"
+#include "General/Console/Console.h"
+#include "Utility/Compression.h"
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Bool, entry_type_cache, true, CVAR_SAVE)
+namespace
+{
+const char     CACHE_MAGIC[4] = { 'S', 'E', 'T', 'C' };
+const uint32_t CACHE_VERSION  = 1;
+
+// Cache files not used for this many days are removed, as are the oldest ones
+// if there are more than CACHE_MAX_FILES
+const int      CACHE_MAX_AGE   = 90;
+const unsigned CACHE_MAX_FILES = 500;
+bool           cache_pruned    = false;
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns the directory cache files are kept in
+// -----------------------------------------------------------------------------
+string cacheDir()
+{
+	return App::path("entry_type_cache", App::Dir::User);
+}
+
+// -----------------------------------------------------------------------------
+// Appends [size] bytes at [data] to [buf]
+// -----------------------------------------------------------------------------
+void writeData(vector<uint8_t>& buf, const void* data, unsigned size)
+{
+	buf.insert(buf.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+}
+
+// -----------------------------------------------------------------------------
+// Appends [str] to [buf] as UTF-8, prefixed by its length
+// -----------------------------------------------------------------------------
+void writeString(vector<uint8_t>& buf, const string& str)
+{
+	auto     utf8 = str.ToUTF8();
+	uint16_t len  = MIN(utf8.length(), 0xFFFF);
+	writeData(buf, &len, 2);
+	writeData(buf, utf8.data(), len);
+}
+
+// -----------------------------------------------------------------------------
+// Reads a string written with writeString from [mc] into [str].
+// Returns false if it couldn't be read
+// -----------------------------------------------------------------------------
+bool readString(MemChunk& mc, string& str)
+{
+	uint16_t len = 0;
+	if (!mc.read(&len, 2) || mc.currentPos() + len > mc.getSize())
+		return false;
+
+	str = wxString::FromUTF8((const char*)mc.getData() + mc.currentPos(), len);
+	mc.seek(len, SEEK_CUR);
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the archive file that the cache file [cache_file] is for
+// still exists
+// -----------------------------------------------------------------------------
+bool archiveExists(const string& cache_file)
+{
+	// Only the header (up to the archive path) needs reading
+	wxFile   file(cache_file);
+	MemChunk mc;
+	if (!file.IsOpened() || file.Length() < 30)
+		return false;
+	if (!mc.importFileStream(file, (uint32_t)MIN(file.Length(), (wxFileOffset)0xFFFF + 30)))
+		return false;
+
+	char   magic[4];
+	string path;
+	if (!mc.read(magic, 4) || memcmp(magic, CACHE_MAGIC, 4) != 0 || !mc.seek(24, SEEK_CUR) || !readString(mc, path))
+		return false;
+
+	return wxFileExists(path);
+}
+
+// -----------------------------------------------------------------------------
+// Removes cache files for archives that no longer exist or that haven't been
+// used for CACHE_MAX_AGE days, then the least recently used ones if there are
+// still more than CACHE_MAX_FILES (other than [keep])
+// -----------------------------------------------------------------------------
+void pruneCache(const string& keep)
+{
+	wxArrayString files;
+	wxDir::GetAllFiles(cacheDir(), &files, "*.cache", wxDIR_FILES);
+
+	vector<std::pair<time_t, string>> remaining;
+	time_t                            now     = wxDateTime::Now().GetTicks();
+	unsigned                          removed = 0;
+	for (auto& file : files)
+	{
+		if (wxFileName(file).SameAs(wxFileName(keep)))
+			continue;
+
+		time_t time = wxFileModificationTime(file);
+		if (now - time > CACHE_MAX_AGE * 24 * 60 * 60 || !archiveExists(file))
+		{
+			wxRemoveFile(file);
+			removed++;
+		}
+		else
+			remaining.emplace_back(time, file);
+	}
+
+	if (remaining.size() >= CACHE_MAX_FILES)
+	{
+		std::sort(remaining.begin(), remaining.end());
+		for (unsigned a = 0; a <= remaining.size() - CACHE_MAX_FILES; a++)
+		{
+			wxRemoveFile(remaining[a].second);
+			removed++;
+		}
+	}
+
+	if (removed > 0)
+		LOG_MESSAGE(2, "Removed %d old entry type cache files", (int)removed);
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// EntryTypeCache Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// EntryTypeCache class constructor. Loads the cached types for the
+// [num_entries] entries of the archive file [filename], if they are still
+// valid
+// -----------------------------------------------------------------------------
+EntryTypeCache::EntryTypeCache(const string& filename, unsigned num_entries) :
+	enabled_{ false },
+	file_size_{ 0 },
+	file_time_{ 0 }
+{
+	records_.resize(num_entries);
+
+	if (!entry_type_cache || num_entries == 0 || !wxFileExists(filename))
+		return;
+
+	// Get archive file info
+	wxFileName fn(filename);
+	fn.Normalize(wxPATH_NORM_ABSOLUTE | wxPATH_NORM_DOTS | wxPATH_NORM_TILDE);
+	filename_  = fn.GetFullPath();
+	file_size_ = fn.GetSize().GetValue();
+	file_time_ = fn.GetModificationTime().GetValue().GetValue();
+
+	// Cache file name is a checksum of the archive path
+	auto path   = filename_.ToUTF8();
+	cache_file_ = cacheDir() + "/"
+				  + S_FMT("%08x.cache", Compression::ZipCRC((const uint8_t*)path.data(), path.length()));
+
+	enabled_ = true;
+	load();
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if there is a valid cached type for [entry] at [index] (its
+// position in the archive file)
+// -----------------------------------------------------------------------------
+bool EntryTypeCache::contains(unsigned index, ArchiveEntry* entry) const
+{
+	if (!enabled_ || index >= records_.size())
+		return false;
+
+	auto& rec = records_[index];
+	return rec.type && !rec.stored && rec.size == entry->getSize() && entry->getSize() > 0
+		   && rec.name == entry->getName();
+}
+
+// -----------------------------------------------------------------------------
+// Sets [entry]'s type from the cache, if there is a valid cached type for it.
+// Returns false if there isn't (and the entry type needs to be detected)
+// -----------------------------------------------------------------------------
+bool EntryTypeCache::apply(unsigned index, ArchiveEntry* entry) const
+{
+	if (!contains(index, entry))
+		return false;
+
+	entry->setType(records_[index].type, records_[index].reliability);
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Records the detected type of [entry] at [index], to be written on save.
+// Different indices can be stored from different threads at the same time
+// -----------------------------------------------------------------------------
+void EntryTypeCache::store(unsigned index, ArchiveEntry* entry)
+{
+	if (!enabled_ || index >= records_.size() || entry->getSize() == 0)
+		return;
+
+	auto& rec       = records_[index];
+	rec.name        = entry->getName();
+	rec.size        = entry->getSize();
+	rec.type        = entry->getType();
+	rec.reliability = entry->getIdentReliability();
+	rec.stored      = true;
+}
+
+// -----------------------------------------------------------------------------
+// Writes the cache file, if any new types were stored.
+// Returns true if successful (or nothing needed writing), false otherwise
+// -----------------------------------------------------------------------------
+bool EntryTypeCache::save()
+{
+	if (!enabled_)
+		return true;
+
+	// Check if anything needs saving
+	bool changed = false;
+	for (auto& rec : records_)
+		if (rec.stored)
+		{
+			changed = true;
+			break;
+		}
+	if (!changed)
+		return true;
+
+	// Build list of types used
+	vector<EntryType*> types;
+	for (auto& rec : records_)
+		if (rec.type && std::find(types.begin(), types.end(), rec.type) == types.end())
+			types.push_back(rec.type);
+
+	// Header
+	vector<uint8_t> buf;
+	uint32_t        signature = EntryType::definitionsSignature();
+	uint32_t        count     = records_.size();
+	uint16_t        n_types   = types.size();
+	buf.reserve(count * 16);
+	writeData(buf, CACHE_MAGIC, 4);
+	writeData(buf, &CACHE_VERSION, 4);
+	writeData(buf, &signature, 4);
+	writeData(buf, &file_size_, 8);
+	writeData(buf, &file_time_, 8);
+	writeString(buf, filename_);
+	writeData(buf, &count, 4);
+
+	// Type ids
+	writeData(buf, &n_types, 2);
+	for (auto type : types)
+		writeString(buf, type->id());
+
+	// Records
+	for (auto& rec : records_)
+	{
+		uint16_t type = 0xFFFF;
+		if (rec.type)
+			type = std::find(types.begin(), types.end(), rec.type) - types.begin();
+
+		writeString(buf, rec.name);
+		writeData(buf, &rec.size, 4);
+		writeData(buf, &type, 2);
+		writeData(buf, &rec.reliability, 1);
+	}
+
+	// Write file
+	if (!wxDirExists(cacheDir()))
+		wxMkdir(cacheDir());
+	wxFile file;
+	if (!file.Create(cache_file_, true) || file.Write(buf.data(), buf.size()) != buf.size())
+	{
+		LOG_MESSAGE(2, "Unable to write entry type cache %s", cache_file_);
+		return false;
+	}
+
+	for (auto& rec : records_)
+		rec.stored = false;
+
+	// Remove old cache files (once per session is enough)
+	if (!cache_pruned)
+	{
+		cache_pruned = true;
+		pruneCache(cache_file_);
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads the cache file, if it exists and is valid for the archive file and
+// current entry type definitions.
+// Returns true if the cache was loaded, false otherwise
+// -----------------------------------------------------------------------------
+bool EntryTypeCache::load()
+{
+	if (!wxFileExists(cache_file_))
+		return false;
+
+	MemChunk mc;
+	if (!mc.importFile(cache_file_))
+		return false;
+
+	// Check header
+	char     magic[4];
+	uint32_t version   = 0;
+	uint32_t signature = 0;
+	uint64_t file_size = 0;
+	int64_t  file_time = 0;
+	string   path;
+	uint32_t count = 0;
+	if (!mc.read(magic, 4) || memcmp(magic, CACHE_MAGIC, 4) != 0 || !mc.read(&version, 4)
+		|| version != CACHE_VERSION || !mc.read(&signature, 4) || signature != EntryType::definitionsSignature()
+		|| !mc.read(&file_size, 8) || file_size != file_size_ || !mc.read(&file_time, 8) || file_time != file_time_
+		|| !readString(mc, path) || path != filename_ || !mc.read(&count, 4) || count != records_.size())
+		return false;
+
+	// Read type ids
+	uint16_t n_types = 0;
+	if (!mc.read(&n_types, 2))
+		return false;
+	vector<EntryType*> types(n_types);
+	for (auto& type : types)
+	{
+		string id;
+		if (!readString(mc, id))
+			return false;
+
+		// Unknown ids can't be used (types only match themselves, except 'unknown')
+		type = EntryType::fromId(id);
+		if (type == EntryType::unknownType() && id != EntryType::unknownType()->id())
+			type = nullptr;
+	}
+
+	// Read records
+	vector<Record> records(count);
+	for (auto& rec : records)
+	{
+		uint16_t type = 0xFFFF;
+		if (!readString(mc, rec.name) || !mc.read(&rec.size, 4) || !mc.read(&type, 2)
+			|| !mc.read(&rec.reliability, 1))
+			return false;
+
+		if (type < types.size())
+			rec.type = types[type];
+	}
+
+	records_.swap(records);
+
+	// The cache file's modification time is used as its last use time when
+	// pruning old cache files
+	wxFileName(cache_file_).Touch();
+
+	return true;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Deletes all entry type cache files
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(clear_entry_type_cache, 0, true)
+{
+	wxArrayString files;
+	if (wxDirExists(cacheDir()))
+		wxDir::GetAllFiles(cacheDir(), &files, "*.cache", wxDIR_FILES);
+
+	for (auto& file : files)
+		wxRemoveFile(file);
+
+	Log::console(S_FMT("Removed %d entry type cache files", (int)files.size()));
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+class ArchiveEntry;
+class EntryType;
+
+class EntryTypeCache
+{
+public:
+	EntryTypeCache(const string& filename, unsigned num_entries);
+	~EntryTypeCache() {}
+
+	bool enabled() const { return enabled_; }
+
+	bool contains(unsigned index, ArchiveEntry* entry) const;
+	bool apply(unsigned index, ArchiveEntry* entry) const;
+	void store(unsigned index, ArchiveEntry* entry);
+	bool save();
+
+private:
+	// Detected type of an entry, the entry name and size must match for it
+	// to be used
+	struct Record
+	{
+		string     name;
+		uint32_t   size        = 0;
+		EntryType* type        = nullptr;
+		uint8_t    reliability = 0;
+		bool       stored      = false; // True if detected this time (needs saving)
+	};
+
+	bool           enabled_;
+	string         filename_;
+	string         cache_file_;
+	uint64_t       file_size_;
+	int64_t        file_time_;
+	vector<Record> records_;
+
+	bool load();
+};
@@ -34,10 +34,21 @@
 #include "Main.h"
 #include "DirArchive.h"
 #include "App.h"
+#include "DirArchiveWatcher.h"
 #include "General/UI.h"
+#include "Utility/ThreadPool.h"
 #include "WadArchive.h"
 
 
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Bool, dir_archive_watch, true, CVAR_SAVE)
+CVAR(Bool, dir_archive_lazy_load, false, CVAR_SAVE)
+
+
 // -----------------------------------------------------------------------------
 //
 // External Variables
@@ -46,6 +57,32 @@
 EXTERN_CVAR(Bool, archive_load_data)
 
 
+// -----------------------------------------------------------------------------
+//
+// Structs
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Entry types detected by the I/O workers, waiting to be applied on the main
+// thread
+// -----------------------------------------------------------------------------
+struct DirArchive::DetectedTypes
+{
+	struct Result
+	{
+		ArchiveEntry::WPtr entry;
+		EntryType*         type;
+		int                reliability;
+	};
+
+	DirArchive*    archive;
+	std::mutex     mutex;
+	vector<Result> results;
+};
+
+
 // -----------------------------------------------------------------------------
 //
 // DirArchive Class Functions
@@ -71,7 +108,12 @@ DirArchive::DirArchive() : Archive("folder")
 // -----------------------------------------------------------------------------
 // DirArchive class destructor
 // -----------------------------------------------------------------------------
-DirArchive::~DirArchive() {}
+DirArchive::~DirArchive()
+{
+	// Don't bother detecting any remaining entry types
+	if (io_pool_)
+		io_pool_->cancelPending();
+}
 
 // -----------------------------------------------------------------------------
 // Reads files from the directory [filename] into the archive
@@ -79,10 +121,15 @@ DirArchive::~DirArchive() {}
 // -----------------------------------------------------------------------------
 bool DirArchive::open(string filename)
 {
+	// Watch for changes on disk if possible. This is started before reading
+	// anything, so nothing changed while the directory is being read is missed
+	if (dir_archive_watch)
+		watcher_ = std::make_unique<DirArchiveWatcher>(filename);
+
 	UI::setSplashProgressMessage("Reading directory structure");
 	UI::setSplashProgress(0);
 	vector<string>      files, dirs;
-	DirArchiveTraverser traverser(files, dirs);
+	DirArchiveTraverser traverser(files, dirs, watcher_.get());
 	wxDir               dir(filename);
 	dir.Traverse(traverser, "", wxDIR_FILES | wxDIR_DIRS);
 
@@ -102,9 +149,22 @@ bool DirArchive::open(string filename)
 
 		// LOG_MESSAGE(3, fn.GetPath(true, wxPATH_UNIX));
 
+		// If lazy loading, only the size and modification time are needed for now
+		wxStructStat info;
+		bool         lazy = dir_archive_lazy_load && wxStat(files[a], &info) == 0;
+
+		// Entry sizes are 32bit, so files of 4GB or more can't be added
+		if (lazy && (uint64_t)info.st_size > 0xFFFFFFFF)
+		{
+			Log::warning(S_FMT("Unable to add %s to the archive, it is too large", files[a]));
+			ignored_file_changes_[files[a]] =
+				DirEntryChange(DirEntryChange::ADDED_FILE, files[a], name, info.st_mtime);
+			continue;
+		}
+
 		// Create entry
 		wxFileName    fn(name);
-		ArchiveEntry* new_entry = new ArchiveEntry(fn.GetFullName());
+		ArchiveEntry* new_entry = new ArchiveEntry(fn.GetFullName(), lazy ? (uint32_t)info.st_size : 0);
 
 		// Setup entry info
 		new_entry->setLoaded(false);
@@ -115,6 +175,13 @@ bool DirArchive::open(string filename)
 		ndir->addEntry(new_entry);
 		ndir->dirEntry()->exProp("filePath") = filename + fn.GetPath(true, wxPATH_UNIX);
 
+		// Data is loaded on demand and the type detected in the background
+		if (lazy)
+		{
+			file_modification_times_[new_entry] = info.st_mtime;
+			continue;
+		}
+
 		// Read entry data
 		new_entry->importFile(files[a]);
 		new_entry->setLoaded(true);
@@ -156,6 +223,10 @@ bool DirArchive::open(string filename)
 	setModified(false);
 	on_disk_ = true;
 
+	// Detect entry types in the background if lazy loading
+	if (dir_archive_lazy_load)
+		detectTypesInBackground();
+
 	UI::setSplashProgressMessage("");
 
 	return true;
@@ -206,12 +277,14 @@ bool DirArchive::save(string filename)
 	getEntryTreeAsList(entries);
 
 	// Get entry path list
-	vector<string> entry_paths;
+	vector<string>                                          entry_paths;
+	std::unordered_set<string, wxStringHash, wxStringEqual> entry_path_set;
 	for (unsigned a = 0; a < entries.size(); a++)
 	{
 		entry_paths.push_back(this->filename_ + entries[a]->getPath(true));
 		if (separator_ != "/")
 			entry_paths.back().Replace("/", separator_);
+		entry_path_set.insert(entry_paths.back());
 	}
 
 	// Get current directory structure
@@ -237,15 +310,7 @@ bool DirArchive::save(string filename)
 	for (int a = dirs.size() - 1; a >= 0; a--)
 	{
 		// Check if dir path matches an existing dir
-		bool found = false;
-		for (unsigned e = 0; e < entry_paths.size(); e++)
-		{
-			if (dirs[a] == entry_paths[e])
-			{
-				found = true;
-				break;
-			}
-		}
+		bool found = entry_path_set.count(dirs[a]) > 0;
 
 		// Dir on disk isn't part of the archive in memory
 		// (Note that this will fail if there are any untracked files in the
@@ -303,13 +368,32 @@ bool DirArchive::save(string filename)
 // -----------------------------------------------------------------------------
 bool DirArchive::loadEntryData(ArchiveEntry* entry)
 {
-	if (entry->importFile(entry->exProp("filePath").getStringValue()))
+	// Read directly into the entry's MemChunk, the entry is unmodified so its
+	// type and state should stay as they are
+	string path = entry->exProp("filePath").getStringValue();
+	if (!entry->getMCData(false).importFile(path))
+		return false;
+
+	entry->setLoaded();
+
+	// The entry type isn't detected here since this can be called from a
+	// worker thread, unknown types are detected in the background (see
+	// detectTypesInBackground) or when the entry is opened.
+	// Likewise file_modification_times_ is only accessed on the main thread
+	time_t modtime = wxFileModificationTime(path);
+	if (wxThread::IsMain())
+		file_modification_times_[entry] = modtime;
+	else if (wxTheApp)
 	{
-		file_modification_times_[entry] = wxFileModificationTime(entry->exProp("filePath").getStringValue());
-		return true;
+		ArchiveEntry::WPtr entry_ptr = entry->getShared();
+		wxTheApp->CallAfter([entry_ptr, modtime]() {
+			auto e = entry_ptr.lock();
+			if (e && e->getParent() && e->getParent()->formatId() == "folder")
+				((DirArchive*)e->getParent())->file_modification_times_[e.get()] = modtime;
+		});
 	}
 
-	return false;
+	return true;
 }
 
 // -----------------------------------------------------------------------------
@@ -621,6 +705,51 @@ void DirArchive::updateChangedEntries(vector<DirEntryChange>& changes)
 			file_modification_times_[entry] = wxFileModificationTime(changes[a].file_path);
 		}
 
+		// Renamed Entries/Directories
+		else if (
+			changes[a].action == DirEntryChange::RENAMED_FILE || changes[a].action == DirEntryChange::RENAMED_DIR)
+		{
+			ArchiveTreeNode* dir   = nullptr;
+			ArchiveEntry*    entry = nullptr;
+			if (changes[a].action == DirEntryChange::RENAMED_DIR)
+			{
+				dir   = getDir(changes[a].entry_path);
+				entry = dir ? dir->dirEntry() : nullptr;
+			}
+			else
+				entry = entryAtPath(changes[a].entry_path);
+
+			// If an earlier change removed it, this entry no longer exists
+			if (!entry)
+				continue;
+
+			// Rename via Archive directly, the file on disk has already been
+			// renamed so there's nothing to do when saving
+			string old_path = entry->exProp("filePath").getStringValue();
+			string new_name = wxFileName(changes[a].file_path).GetFullName();
+			bool   modified = entry->getState() != 0;
+			if (dir)
+				Archive::renameDir(dir, new_name);
+			else
+				Archive::renameEntry(entry, new_name);
+			if (!modified)
+				entry->setState(0);
+
+			// Update the path on disk of the entry, or everything in the
+			// directory
+			vector<ArchiveEntry*> entries;
+			if (dir)
+				getEntryTreeAsList(entries, dir);
+			else
+				entries.push_back(entry);
+			for (auto renamed : entries)
+			{
+				string path = renamed->exProp("filePath").getStringValue();
+				if (path == old_path || path.StartsWith(old_path + separator_))
+					renamed->exProp("filePath") = changes[a].file_path + path.Mid(old_path.size());
+			}
+		}
+
 		// Deleted Entries
 		else if (changes[a].action == DirEntryChange::DELETED_FILE)
 		{
@@ -692,6 +821,103 @@ void DirArchive::updateChangedEntries(vector<DirEntryChange>& changes)
 	setModified(was_modified);
 }
 
+// -----------------------------------------------------------------------------
+// Gets the paths of all files and directories changed on disk since the last
+// call into [paths], and those renamed into [renamed] (see
+// DirArchiveWatcher::changedPaths). Returns false if changes aren't being
+// watched for (or some were missed), in which case the whole directory needs
+// to be checked
+// -----------------------------------------------------------------------------
+bool DirArchive::changedPaths(vector<string>& paths, vector<key_value_t>& renamed)
+{
+	return watcher_ && watcher_->changedPaths(paths, renamed);
+}
+
+// -----------------------------------------------------------------------------
+// Reads all unloaded entries and detects their types on a pool of I/O worker
+// threads. The detected types are applied to the entries on the main thread
+// as they come in (see applyDetectedTypes)
+// -----------------------------------------------------------------------------
+void DirArchive::detectTypesInBackground()
+{
+	vector<ArchiveEntry::SPtr> entries;
+	getEntryTreeAsList(entries);
+
+	// Mostly waiting on the disk, so more than a few threads won't help
+	detected_types_          = std::make_shared<DetectedTypes>();
+	detected_types_->archive = this;
+	io_pool_                 = std::make_unique<ThreadPool>(std::min(4u, ThreadPool::defaultNumThreads()));
+
+	string format = formatId();
+	for (auto& entry : entries)
+	{
+		if (entry->getType() == EntryType::folderType() || entry->isLoaded())
+			continue;
+
+		// The entry could be modified or removed in the meantime, so the data
+		// is read into a separate entry (with the same name and namespace) to
+		// detect the type from
+		ArchiveEntry::WPtr entry_ptr = entry;
+		string             path      = entry->exProp("filePath").getStringValue();
+		string             name      = entry->getName();
+		string             section   = detectNamespace(entry.get());
+		auto               detected  = detected_types_;
+		io_pool_->queue([=]() {
+			ArchiveEntry temp(name);
+			if (!temp.importFile(path))
+				return;
+			EntryType::detectEntryType(&temp, format, section);
+
+			bool first;
+			{
+				std::lock_guard<std::mutex> lock(detected->mutex);
+				first = detected->results.empty();
+				detected->results.push_back({ entry_ptr, temp.getType(), temp.getIdentReliability() });
+			}
+
+			// Apply on the main thread (unless the archive is closed before then)
+			if (first && wxTheApp)
+			{
+				std::weak_ptr<DetectedTypes> weak = detected;
+				wxTheApp->CallAfter([weak]() {
+					if (auto types = weak.lock())
+						types->archive->applyDetectedTypes();
+				});
+			}
+		});
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Sets the types of entries detected in the background so far
+// -----------------------------------------------------------------------------
+void DirArchive::applyDetectedTypes()
+{
+	vector<DetectedTypes::Result> results;
+	{
+		std::lock_guard<std::mutex> lock(detected_types_->mutex);
+		results.swap(detected_types_->results);
+	}
+
+	vector<ArchiveEntry*> typed;
+	for (auto& result : results)
+	{
+		// Ignore if the entry was removed, modified or had its type detected
+		// since
+		auto entry = result.entry.lock();
+		if (!entry || entry->getParent() != this || entry->getState() != 0
+			|| entry->getType() != EntryType::unknownType())
+			continue;
+
+		entry->setType(result.type, result.reliability);
+		typed.push_back(entry.get());
+	}
+
+	// Announce the whole batch at once, so entry lists and resources are
+	// only updated once
+	entryTypesDetected(typed);
+}
+
 // -----------------------------------------------------------------------------
 // Returns true iff the user has previously indicated no interest in this change
 // -----------------------------------------------------------------------------
@@ -721,3 +947,25 @@ bool DirArchive::shouldIgnoreEntryChange(DirEntryChange& change)
 	// and an unmodified file will never change mtime.)
 	return (old_change.mtime == change.mtime);
 }
+
+
+// -----------------------------------------------------------------------------
+//
+// DirArchiveTraverser Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Called for each subdirectory found, before its contents are traversed
+// -----------------------------------------------------------------------------
+wxDirTraverseResult DirArchiveTraverser::OnDir(const wxString& dirname)
+{
+	dirs_.push_back(dirname);
+
+	// Start watching the directory before anything in it is listed
+	if (watcher_)
+		watcher_->watchDir(dirname);
+
+	return wxDIR_CONTINUE;
+}
@@ -11,7 +11,9 @@ struct DirEntryChange
 		DELETED_FILE = 1,
 		DELETED_DIR  = 2,
 		ADDED_FILE   = 3,
-		ADDED_DIR    = 4
+		ADDED_DIR    = 4,
+		RENAMED_FILE = 5, // Renamed on disk to file_path (entry_path is the path before renaming)
+		RENAMED_DIR  = 6
 	};
 
 	string entry_path;
@@ -31,6 +33,9 @@ struct DirEntryChange
 
 typedef std::map<string, DirEntryChange> IgnoredFileChanges;
 
+class DirArchiveWatcher;
+class ThreadPool;
+
 class DirArchive : public Archive
 {
 public:
@@ -76,6 +81,7 @@ public:
 	void ignoreChangedEntries(vector<DirEntryChange>& changes);
 	void updateChangedEntries(vector<DirEntryChange>& changes);
 	bool shouldIgnoreEntryChange(DirEntryChange& change);
+	bool changedPaths(vector<string>& paths, vector<key_value_t>& renamed);
 
 private:
 	string                          separator_;
@@ -83,12 +89,27 @@ private:
 	std::map<ArchiveEntry*, time_t> file_modification_times_;
 	vector<string>                  removed_files_;
 	IgnoredFileChanges              ignored_file_changes_;
+
+	std::unique_ptr<DirArchiveWatcher> watcher_;
+
+	// Entry types detected in the background (when opened with lazy loading)
+	struct DetectedTypes;
+	std::shared_ptr<DetectedTypes> detected_types_;
+	std::unique_ptr<ThreadPool>    io_pool_;
+
+	void detectTypesInBackground();
+	void applyDetectedTypes();
 };
 
 class DirArchiveTraverser : public wxDirTraverser
 {
 public:
-	DirArchiveTraverser(vector<string>& pathlist, vector<string>& dirlist) : paths_{ pathlist }, dirs_{ dirlist } {}
+	DirArchiveTraverser(vector<string>& pathlist, vector<string>& dirlist, DirArchiveWatcher* watcher = nullptr) :
+		paths_{ pathlist },
+		dirs_{ dirlist },
+		watcher_{ watcher }
+	{
+	}
 	~DirArchiveTraverser() {}
 
 	wxDirTraverseResult OnFile(const wxString& filename) override
@@ -97,13 +118,10 @@ public:
 		return wxDIR_CONTINUE;
 	}
 
-	wxDirTraverseResult OnDir(const wxString& dirname) override
-	{
-		dirs_.push_back(dirname);
-		return wxDIR_CONTINUE;
-	}
+	wxDirTraverseResult OnDir(const wxString& dirname) override;
 
 private:
-	vector<string>& paths_;
-	vector<string>& dirs_;
+	vector<string>&    paths_;
+	vector<string>&    dirs_;
+	DirArchiveWatcher* watcher_; // If given, directories are watched before their contents are listed
 };
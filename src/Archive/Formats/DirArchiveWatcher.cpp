@@ -0,0 +1,339 @@
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    DirArchiveWatcher.cpp
+// Description: DirArchiveWatcher class, keeps track of which paths have
+//              changed within a directory on disk, so DirArchive change checks
+//              don't need to traverse the entire directory tree each time.
+//              Currently only implemented on Linux (via inotify), elsewhere it
+//              is never active and a full check is always done
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "DirArchiveWatcher.h"
+#include "DirArchive.h"
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+#ifdef __linux__
+const uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVED_FROM
+							| IN_MOVED_TO | IN_ONLYDIR;
+#endif
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// DirArchiveWatcher Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// DirArchiveWatcher class constructor. Starts watching the directory at
+// [path], its subdirectories need to be added via watchDir (eg. by passing the
+// watcher to a DirArchiveTraverser)
+// -----------------------------------------------------------------------------
+DirArchiveWatcher::DirArchiveWatcher(const string& path)
+{
+#ifdef __linux__
+	fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd_ < 0)
+	{
+		Log::warning(S_FMT("Unable to watch %s for changes: %s", CHR(path), strerror(errno)));
+		return;
+	}
+
+	// Watch root directory (with the same path format as wxDir uses)
+	string root = path;
+	while (root.size() > 1 && root.EndsWith("/"))
+		root.RemoveLast();
+	addWatch(root);
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// DirArchiveWatcher class destructor
+// -----------------------------------------------------------------------------
+DirArchiveWatcher::~DirArchiveWatcher()
+{
+	stop();
+}
+
+// -----------------------------------------------------------------------------
+// Starts watching the subdirectory at [path], if the watcher is still active
+// -----------------------------------------------------------------------------
+void DirArchiveWatcher::watchDir(const string& path)
+{
+	if (active())
+		addWatch(path);
+}
+
+// -----------------------------------------------------------------------------
+// Gets all paths (files and directories) that have been changed, added or
+// removed since the last call into [paths], and all files and directories
+// renamed within the watched tree into [renamed] (old path -> new path, in the
+// order they were renamed). Changed paths within renamed directories are given
+// at their new path.
+// Returns false if the watcher isn't active or has missed changes, in which
+// case a full check of the directory is needed
+// -----------------------------------------------------------------------------
+bool DirArchiveWatcher::changedPaths(vector<string>& paths, vector<key_value_t>& renamed)
+{
+	if (!active())
+		return false;
+
+	readEvents();
+
+	// Check if events were missed (or the watcher was stopped while reading)
+	if (overflow_ || !active())
+	{
+		overflow_ = false;
+		changed_.clear();
+		renamed_.clear();
+		return false;
+	}
+
+	paths.assign(changed_.begin(), changed_.end());
+	std::sort(paths.begin(), paths.end());
+	changed_.clear();
+	renamed.swap(renamed_);
+	renamed_.clear();
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Adds a watch for the directory at [path]. If this fails the watcher is
+// stopped (most likely the system limit on watches was reached) and false is
+// returned
+// -----------------------------------------------------------------------------
+bool DirArchiveWatcher::addWatch(const string& path)
+{
+#ifdef __linux__
+	int wd = inotify_add_watch(fd_, path.fn_str(), WATCH_MASK);
+	if (wd < 0)
+	{
+		// Directory may have been removed already, that's fine
+		if (errno == ENOENT || errno == ENOTDIR)
+			return true;
+
+		Log::warning(S_FMT("Unable to watch %s for changes: %s", CHR(path), strerror(errno)));
+		stop();
+		return false;
+	}
+
+	watches_[wd] = path;
+#endif
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Removes the watches for the directory at [path] and all its subdirectories
+// (for when the directory was moved elsewhere)
+// -----------------------------------------------------------------------------
+void DirArchiveWatcher::removeWatches(const string& path)
+{
+#ifdef __linux__
+	string sub_path = path + "/";
+	for (auto i = watches_.begin(); i != watches_.end();)
+	{
+		if (i->second == path || i->second.StartsWith(sub_path))
+		{
+			inotify_rm_watch(fd_, i->first);
+			i = watches_.erase(i);
+		}
+		else
+			++i;
+	}
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// Records that the file or directory at [path] was renamed to [new_path], and
+// updates any watched or changed paths within it
+// -----------------------------------------------------------------------------
+void DirArchiveWatcher::renamePath(const string& path, const string& new_path)
+{
+	renamed_.emplace_back(path, new_path);
+
+	// Watches follow the directories they were added for, so only the paths
+	// need updating
+	string sub_path = path + "/";
+	for (auto& watch : watches_)
+		if (watch.second == path || watch.second.StartsWith(sub_path))
+			watch.second = new_path + watch.second.Mid(path.size());
+
+	// Anything changed before the rename is now at the new path
+	PathSet changed;
+	for (auto& changed_path : changed_)
+	{
+		if (changed_path == path || changed_path.StartsWith(sub_path))
+			changed.insert(new_path + changed_path.Mid(path.size()));
+		else
+			changed.insert(changed_path);
+	}
+	changed_.swap(changed);
+}
+
+// -----------------------------------------------------------------------------
+// Starts watching the newly added directory at [path]. Anything already in the
+// directory (eg. if it was moved here) is marked as changed
+// -----------------------------------------------------------------------------
+void DirArchiveWatcher::addNewDir(const string& path)
+{
+	if (!addWatch(path))
+		return;
+
+	// Subdirectories are watched as they are found
+	vector<string>      files, dirs;
+	DirArchiveTraverser traverser(files, dirs, this);
+	wxDir               dir(path);
+	if (!dir.IsOpened())
+		return;
+	dir.Traverse(traverser, "", wxDIR_FILES | wxDIR_DIRS);
+
+	for (auto& file : files)
+		changed_.insert(file);
+	for (auto& subdir : dirs)
+		changed_.insert(subdir);
+}
+
+// -----------------------------------------------------------------------------
+// Reads all pending events and adds the paths they refer to to the list of
+// changed paths
+// -----------------------------------------------------------------------------
+void DirArchiveWatcher::readEvents()
+{
+#ifdef __linux__
+	alignas(inotify_event) char buffer[16384];
+	while (active())
+	{
+		auto length = read(fd_, buffer, sizeof(buffer));
+		if (length <= 0)
+			break; // No more events (EAGAIN)
+
+		for (char* ptr = buffer; ptr < buffer + length;)
+		{
+			auto event = (const inotify_event*)ptr;
+			ptr += sizeof(inotify_event) + event->len;
+
+			// Queue overflowed, changes were missed
+			if (event->mask & IN_Q_OVERFLOW)
+			{
+				overflow_ = true;
+				continue;
+			}
+
+			auto watch = watches_.find(event->wd);
+			if (watch == watches_.end())
+				continue;
+
+			// Watched directory was removed (its parent gets an event for it)
+			if (event->mask & IN_IGNORED)
+			{
+				watches_.erase(watch);
+				continue;
+			}
+
+			// Ignore events for the watched directory itself
+			if (event->len == 0)
+				continue;
+
+			string path = watch->second + "/" + wxString(event->name, *wxConvFileName);
+
+			// A rename (or move within the watched tree) gives a moved from
+			// and a moved to event with the same cookie. Pair them up so the
+			// entry can be renamed rather than deleted and added again
+			if (event->mask & IN_MOVED_FROM)
+			{
+				moved_from_[event->cookie] = path;
+				continue;
+			}
+			if (event->mask & IN_MOVED_TO)
+			{
+				auto moved = moved_from_.find(event->cookie);
+				if (moved != moved_from_.end())
+				{
+					renamePath(moved->second, path);
+					moved_from_.erase(moved);
+					continue;
+				}
+			}
+
+			changed_.insert(path);
+
+			// Update watches for added/removed directories
+			if (event->mask & IN_ISDIR)
+			{
+				if (event->mask & (IN_CREATE | IN_MOVED_TO))
+					addNewDir(path);
+				else if (event->mask & IN_DELETE)
+					removeWatches(path);
+			}
+
+			if (!active())
+				return;
+		}
+	}
+
+	// Anything moved without a matching moved to event was moved out of the
+	// watched tree, so it has been removed as far as the archive is concerned
+	for (auto& moved : moved_from_)
+	{
+		changed_.insert(moved.second);
+		removeWatches(moved.second);
+	}
+	moved_from_.clear();
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// Stops watching for changes
+// -----------------------------------------------------------------------------
+void DirArchiveWatcher::stop()
+{
+#ifdef __linux__
+	if (fd_ >= 0)
+		close(fd_);
+#endif
+
+	fd_ = -1;
+	watches_.clear();
+	changed_.clear();
+	moved_from_.clear();
+	renamed_.clear();
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+
+// Watches a directory tree on disk for changes (via inotify on Linux), so a
+// DirArchive can be checked for external changes without traversing the whole
+// tree. Not thread-safe, should only be used from the main thread
+class DirArchiveWatcher
+{
+public:
+	DirArchiveWatcher(const string& path);
+	~DirArchiveWatcher();
+
+	bool active() const { return fd_ >= 0; }
+	void watchDir(const string& path);
+	bool changedPaths(vector<string>& paths, vector<key_value_t>& renamed);
+
+private:
+	typedef std::unordered_set<string, wxStringHash, wxStringEqual> PathSet;
+
+	int                                  fd_       = -1;
+	bool                                 overflow_ = false;
+	std::unordered_map<int, string>      watches_;    // Watch descriptor -> directory path
+	PathSet                              changed_;
+	std::unordered_map<uint32_t, string> moved_from_; // Move cookie -> old path, until the new path is known
+	vector<key_value_t>                  renamed_;    // Old path -> new path, in the order they happened
+
+	bool addWatch(const string& path);
+	void removeWatches(const string& path);
+	void renamePath(const string& path, const string& new_path);
+	void addNewDir(const string& path);
+	void readEvents();
+	void stop();
+};
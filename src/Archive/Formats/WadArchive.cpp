@@ -31,10 +31,12 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "WadArchive.h"
+#include "Archive/EntryType/EntryTypeCache.h"
 #include "General/Misc.h"
 #include "General/UI.h"
 #include "Utility/Tokenizer.h"
 #include "WadJArchive.h"
+#include <unordered_set>
 
 
 // -----------------------------------------------------------------------------
@@ -44,6 +46,8 @@
 // -----------------------------------------------------------------------------
 CVAR(Bool, wad_force_uppercase, true, CVAR_SAVE)
 CVAR(Bool, iwad_lock, true, CVAR_SAVE)
+CVAR(Bool, wad_mmap_data, true, CVAR_SAVE)
+CVAR(Bool, wad_save_in_place, true, CVAR_SAVE)
 
 namespace
 {
@@ -103,6 +107,7 @@ const int n_special_namespaces = 11;
 //
 // -----------------------------------------------------------------------------
 EXTERN_CVAR(Bool, archive_load_data)
+EXTERN_CVAR(Bool, backup_archives)
 
 
 // -----------------------------------------------------------------------------
@@ -300,6 +305,43 @@ bool WadArchive::hasFlatHack()
 	return false;
 }
 
+// -----------------------------------------------------------------------------
+// Reads wad data from a file. The file is memory mapped if possible, so that
+// unmodified entries can refer to their data in the mapping rather than each
+// having a copy of it
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool WadArchive::open(string filename)
+{
+	// Read the file normally if it can't be mapped
+	auto mapped = wad_mmap_data ? MappedFile::open(filename) : nullptr;
+	if (!mapped)
+		return Archive::open(filename);
+
+	// Update filename before opening
+	string backupname = filename_;
+	filename_         = filename;
+	mapped_file_      = mapped;
+	mapping_stale_    = false;
+
+	// Load from the mapped data
+	MemChunk mc;
+	mc.importShared(mapped, mapped->data(), mapped->size());
+	sf::Clock timer;
+	if (open(mc))
+	{
+		LOG_MESSAGE(2, "WadArchive::open took %dms", timer.getElapsedTime().asMilliseconds());
+		on_disk_ = true;
+		return true;
+	}
+	else
+	{
+		filename_ = backupname;
+		mapped_file_.reset();
+		return false;
+	}
+}
+
 // -----------------------------------------------------------------------------
 // Reads wad format data from a MemChunk
 // Returns true if successful, false otherwise
@@ -451,7 +493,12 @@ bool WadArchive::open(MemChunk& mc)
 	// rely on being within certain namespaces)
 	updateNamespaces();
 
+	// Get cached entry types if the wad was opened from a file
+	string cache_file = (!filename_.IsEmpty() && wxFileName::GetSize(filename_) == mc.getSize()) ? filename_ : "";
+	EntryTypeCache type_cache(cache_file, numEntries());
+
 	// Detect all entry types
+	bool     mapped = mapped_file_ && mc.getData() == mapped_file_->data();
 	MemChunk edata;
 	UI::setSplashProgressMessage("Detecting entry types");
 	for (size_t a = 0; a < numEntries(); a++)
@@ -462,8 +509,32 @@ bool WadArchive::open(MemChunk& mc)
 		// Get entry
 		ArchiveEntry* entry = getEntry(a);
 
-		// Read entry data if it isn't zero-sized
-		if (entry->getSize() > 0)
+		// Check if the entry type is cached (encrypted entries are always
+		// loaded + detected since their data needs decoding)
+		bool cached = !entry->isEncrypted() && type_cache.contains(a, entry);
+
+		// If the wad is memory mapped, refer to the entry data in the mapping
+		// rather than copying it (it stays 'loaded' since it costs nothing)
+		if (mapped && !entry->isEncrypted())
+		{
+			if (entry->getSize() > 0)
+			{
+				entry->getMCData(false).importShared(
+					mapped_file_, mapped_file_->data() + getEntryOffset(entry), entry->getSize());
+				entry->setLoaded();
+			}
+
+			if (!cached || !type_cache.apply(a, entry))
+			{
+				EntryType::detectEntryType(entry);
+				type_cache.store(a, entry);
+			}
+			entry->setState(0);
+			continue;
+		}
+
+		// Read entry data if it isn't zero-sized (and is needed)
+		if (entry->getSize() > 0 && (!cached || archive_load_data))
 		{
 			// Read the entry data
 			mc.exportMemChunk(edata, getEntryOffset(entry), entry->getSize());
@@ -483,8 +554,12 @@ bool WadArchive::open(MemChunk& mc)
 			entry->importMemChunk(edata);
 		}
 
-		// Detect entry type
-		EntryType::detectEntryType(entry);
+		// Detect entry type (if not cached)
+		if (!cached || !type_cache.apply(a, entry))
+		{
+			EntryType::detectEntryType(entry);
+			type_cache.store(a, entry);
+		}
 
 		// Unload entry data if needed
 		if (!archive_load_data)
@@ -493,6 +568,7 @@ bool WadArchive::open(MemChunk& mc)
 		// Set entry to unchanged
 		entry->setState(0);
 	}
+	type_cache.save();
 
 	// Identify #included lumps (DECORATE, GLDEFS, etc.)
 	detectIncludes();
@@ -525,6 +601,14 @@ bool WadArchive::write(MemChunk& mc, bool update)
 		return false;
 	}
 
+	// Don't read from the mapped wad if it was changed on disk
+	checkMappedFile();
+
+	// Make sure all entry data is available before the lump offsets change
+	// (unloaded entry data is read using its current offset)
+	for (uint32_t l = 0; l < numEntries(); l++)
+		getEntry(l)->getData();
+
 	// Determine directory offset & individual lump offsets
 	uint32_t      dir_offset = 12;
 	ArchiveEntry* entry      = nullptr;
@@ -600,9 +684,22 @@ bool WadArchive::write(string filename, bool update)
 		return false;
 	}
 
+	// Don't read from the mapped wad if it was changed on disk
+	checkMappedFile();
+
+	// Make sure all entry data is available before the lump offsets change
+	// (unloaded entry data is read using its current offset)
+	for (uint32_t l = 0; l < numEntries(); l++)
+		getEntry(l)->getData();
+
+	// If overwriting the memory mapped file, write to a temp file first so the
+	// mapped data stays intact while it is being written
+	bool   replace_mapped = mapped_file_ && wxFileName(filename).SameAs(wxFileName(mapped_file_->filename()));
+	string write_file     = replace_mapped ? filename + ".slade-tmp" : filename;
+
 	// Open file for writing
 	wxFile file;
-	file.Open(filename, wxFile::write);
+	file.Open(write_file, wxFile::write);
 	if (!file.IsOpened())
 	{
 		Global::error = "Unable to open file for writing";
@@ -664,6 +761,407 @@ bool WadArchive::write(string filename, bool update)
 
 	file.Close();
 
+	// Replace the mapped file with the one just written
+	if (replace_mapped && !replaceMappedFile(write_file, filename))
+		return false;
+
+	// Map the new file, unloaded entries will refer to it from now on (any
+	// entries referring to the old mapping keep it alive until they are
+	// modified or unloaded)
+	if (update)
+	{
+		mapped_file_   = wad_mmap_data ? MappedFile::open(filename) : nullptr;
+		mapping_stale_ = false;
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Saves the archive. If it is being saved over its existing file on disk, only
+// modified or new lumps and the directory are written to the existing file
+// where possible (see writeInPlace), otherwise the whole wad is written out
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool WadArchive::save(string filename)
+{
+	// Check if the wad can be updated in place
+	if (!wad_save_in_place || format_ != "wad" || parent_ || read_only_ || !on_disk_ || filename_.IsEmpty()
+		|| (!filename.IsEmpty() && !wxFileName(filename).SameAs(wxFileName(filename_))))
+		return Archive::save(filename);
+
+	// Create backup (as Archive::save would)
+	bool backup = backup_archives && save_backup && wxFileName::FileExists(filename_);
+	if (backup)
+	{
+		string bakfile = filename_ + ".bak";
+		LOG_MESSAGE(1, "Creating backup %s", bakfile);
+		wxCopyFile(filename_, bakfile, true);
+	}
+
+	// Write changes to the existing file, or the whole wad if that isn't possible
+	sf::Clock timer;
+	if (!writeInPlace())
+	{
+		// Don't overwrite the backup just made with a partially updated file
+		if (!backup)
+			return Archive::save(filename);
+
+		save_backup  = false;
+		bool success = Archive::save(filename);
+		save_backup  = true;
+		return success;
+	}
+
+	LOG_MESSAGE(2, "WadArchive::save: Updated %s in place (%dms)", filename_, timer.getElapsedTime().asMilliseconds());
+	setModified(false);
+	announce("saved");
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Saves the archive, writing out the whole wad to reclaim any unused space
+// left in the file by previous (in place) saves
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool WadArchive::compact()
+{
+	return Archive::save();
+}
+
+// -----------------------------------------------------------------------------
+// Replaces [filename] (the currently mapped wad file) with [temp_file]
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool WadArchive::replaceMappedFile(const string& temp_file, const string& filename)
+{
+	if (wxRenameFile(temp_file, filename, true))
+		return true;
+
+	// Some platforms (Windows) don't allow replacing a file that is mapped, so
+	// give any entries referring to the mapping their own copy of the data
+	// and try again
+	vector<ArchiveEntry*> detached;
+	for (uint32_t l = 0; l < numEntries(); l++)
+	{
+		auto entry = getEntry(l);
+		if (entry->getMCData(false).isShared())
+		{
+			entry->getMCData(false).detach();
+			detached.push_back(entry);
+		}
+	}
+	mapped_file_.reset();
+	if (wxRenameFile(temp_file, filename, true))
+	{
+		// Unload the copies again, they will refer to the new file when reloaded
+		for (auto entry : detached)
+			entry->unloadData();
+
+		return true;
+	}
+
+	LOG_MESSAGE(1, "WadArchive::write: Unable to replace %s", filename);
+	Global::error = "Unable to write file. Make sure it isn't in use by another program.";
+	wxRemoveFile(temp_file);
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// Checks if the mapped wad file was changed on disk (by another program) since
+// it was mapped, and if so stops using the mapping. Entries referring to data
+// in the mapping get their own copy of it where it is still within the file,
+// otherwise they are unloaded, since mapped data past the end of a truncated
+// file is no longer valid (see MappedFile::changed).
+// Returns true if the mapping was dropped
+// -----------------------------------------------------------------------------
+bool WadArchive::checkMappedFile()
+{
+	if (!mapped_file_ || !mapped_file_->changed())
+		return false;
+
+	LOG_MESSAGE(1, "%s was modified outside of SLADE, no longer using its memory mapped data", filename_);
+
+	// Get the current size of the file (if it was removed, the mapping is still
+	// intact)
+	uint64_t    file_size = mapped_file_->size();
+	wxULongLong size      = wxFileName::GetSize(mapped_file_->filename());
+	if (size != wxInvalidSize)
+		file_size = size.GetValue();
+
+	const uint8_t* start = mapped_file_->data();
+	const uint8_t* end   = start + mapped_file_->size();
+	for (uint32_t l = 0; l < numEntries(); l++)
+	{
+		auto  entry = getEntry(l);
+		auto& mc    = entry->getMCData(false);
+		if (!mc.isShared() || mc.getData() < start || mc.getData() >= end)
+			continue;
+
+		if ((uint64_t)(mc.getData() - start) + mc.getSize() <= file_size)
+			mc.detach();
+		else
+		{
+			mc.clear();
+			entry->setLoaded(false);
+		}
+	}
+	mapped_file_.reset();
+	mapping_stale_ = false;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if anything other than entries in this archive refers to data
+// in the mapped wad file (eg. removed entries kept for undo)
+// -----------------------------------------------------------------------------
+bool WadArchive::mappingUsedElsewhere()
+{
+	if (!mapped_file_)
+		return false;
+
+	long           refs  = 1; // mapped_file_
+	const uint8_t* start = mapped_file_->data();
+	const uint8_t* end   = start + mapped_file_->size();
+	for (uint32_t l = 0; l < numEntries(); l++)
+	{
+		auto& mc = getEntry(l)->getMCData(false);
+		if (mc.isShared() && mc.getData() >= start && mc.getData() < end)
+			refs++;
+	}
+
+	return mapped_file_.use_count() > refs;
+}
+
+// -----------------------------------------------------------------------------
+// Updates the existing wad file on disk with any changes, without rewriting
+// lumps that are unchanged. Modified and new lumps and the directory are
+// written to space in the file that the current directory doesn't use, or
+// appended to the end. The header is written last, so if anything fails
+// before that the file is still valid and unchanged. Unused space is only
+// reused if nothing else refers to it via the mapped file, and is otherwise
+// left in the file until it is compacted (see compact)
+// Returns false if the wad couldn't be updated in place, in which case it
+// should be written out in full instead
+// -----------------------------------------------------------------------------
+bool WadArchive::writeInPlace()
+{
+	// Don't write if iwad
+	if (iwad_ && iwad_lock)
+		return false;
+
+	// Don't read from the mapped wad if it was changed on disk
+	checkMappedFile();
+
+	// Open the existing file
+	wxFile file;
+	if (!wxFileName::FileExists(filename_) || !file.Open(filename_, wxFile::read_write))
+		return false;
+
+	// Read the current header
+	char     type[4];
+	uint32_t num_lumps  = 0;
+	uint32_t dir_offset = 0;
+	uint64_t file_size  = file.Length();
+	if (file_size < 12 || file_size > 0xFFFFFFFF || file.Read(type, 4) != 4 || file.Read(&num_lumps, 4) != 4
+		|| file.Read(&dir_offset, 4) != 4)
+		return false;
+	num_lumps  = wxINT32_SWAP_ON_BE(num_lumps);
+	dir_offset = wxINT32_SWAP_ON_BE(dir_offset);
+	if ((type[0] != 'I' && type[0] != 'P') || type[1] != 'W' || type[2] != 'A' || type[3] != 'D'
+		|| (uint64_t)dir_offset + num_lumps * 16ull > file_size)
+		return false;
+
+	// Read the current directory
+	MemChunk dir;
+	file.Seek(dir_offset, wxFromStart);
+	if (num_lumps > 0 && (!dir.importFileStream(file, num_lumps * 16) || dir.getSize() != num_lumps * 16))
+		return false;
+
+	// Get the space used by the current directory and the lumps it refers to,
+	// none of this can be written to before the header is updated
+	typedef std::pair<uint64_t, uint64_t> Extent; // Offset, size
+	vector<Extent>                        used;
+	std::unordered_set<uint64_t>          lumps;
+	used.emplace_back(0, 12);
+	used.emplace_back(dir_offset, num_lumps * 16);
+	dir.seek(0, SEEK_SET);
+	for (uint32_t l = 0; l < num_lumps; l++)
+	{
+		uint32_t offset = 0;
+		uint32_t size   = 0;
+		dir.read(&offset, 4);
+		dir.read(&size, 4);
+		dir.seek(8, SEEK_CUR);
+		offset = wxINT32_SWAP_ON_BE(offset);
+		size   = wxINT32_SWAP_ON_BE(size);
+		if ((uint64_t)offset + size > file_size)
+			return false;
+
+		if (size > 0)
+		{
+			used.emplace_back(offset, size);
+			lumps.insert(((uint64_t)offset << 32) | size);
+		}
+	}
+
+	// Check which entries can be left where they are. Their data must be
+	// unchanged (not loaded, or unmodified since being loaded or saved), and
+	// still be referred to by the directory on disk
+	vector<ArchiveEntry*> changed;
+	for (uint32_t l = 0; l < numEntries(); l++)
+	{
+		auto entry = getEntry(l);
+		if (entry->isEncrypted())
+			return false;
+		if (entry->getSize() == 0)
+			continue;
+
+		auto& mc        = entry->getMCData(false);
+		bool  unchanged = !entry->isLoaded() || mc.isShared() || entry->getState() == 0;
+		bool  on_disk   = lumps.count(((uint64_t)getEntryOffset(entry) << 32) | entry->getSize()) > 0;
+		if (unchanged && on_disk)
+			continue;
+
+		// The file doesn't match what was loaded (most likely modified
+		// externally), unloaded entries can't be read
+		if (!entry->isLoaded())
+			return false;
+
+		changed.push_back(entry);
+	}
+
+	// Find unused space in the file, other than at the end. This can only be
+	// reused if nothing still refers to the existing data there
+	vector<Extent> unused;
+	uint64_t       end = file_size;
+	if (!mappingUsedElsewhere())
+	{
+		std::sort(used.begin(), used.end());
+		end = 0;
+		for (auto& extent : used)
+		{
+			if (extent.first > end)
+				unused.emplace_back(end, extent.first - end);
+			end = std::max(end, extent.first + extent.second);
+		}
+	}
+
+	// Gets an offset to write [size] bytes to (the first unused space that
+	// fits, or the end of the file)
+	auto allocate = [&](uint64_t size) {
+		for (auto& space : unused)
+			if (space.second >= size)
+			{
+				uint64_t offset = space.first;
+				space.first += size;
+				space.second -= size;
+				return offset;
+			}
+
+		uint64_t offset = end;
+		end += size;
+		return offset;
+	};
+
+	// Write modified/new lumps
+	vector<uint32_t> offsets(changed.size());
+	uint64_t         written = 0;
+	for (unsigned a = 0; a < changed.size(); a++)
+	{
+		auto     entry  = changed[a];
+		uint64_t offset = allocate(entry->getSize());
+		if (offset + entry->getSize() > 0xFFFFFFFF)
+			return false;
+
+		file.Seek(offset, wxFromStart);
+		if (file.Write(entry->getData(), entry->getSize()) != entry->getSize())
+			return false;
+
+		offsets[a] = (uint32_t)offset;
+		if (mapped_file_ && offset < mapped_file_->size())
+			mapping_stale_ = true;
+		written += entry->getSize();
+	}
+
+	// Build the new directory
+	uint32_t new_num_lumps = numEntries();
+	MemChunk new_dir(new_num_lumps * 16);
+	unsigned index = 0;
+	for (uint32_t l = 0; l < new_num_lumps; l++)
+	{
+		auto     entry  = getEntry(l);
+		uint32_t offset = getEntryOffset(entry);
+		if (index < changed.size() && changed[index] == entry)
+			offset = offsets[index++];
+		offset        = wxINT32_SWAP_ON_BE(offset);
+		uint32_t size = wxINT32_SWAP_ON_BE(entry->getSize());
+		char     name[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+		for (size_t c = 0; c < entry->getName().length() && c < 8; c++)
+			name[c] = entry->getName()[c];
+
+		new_dir.write(&offset, 4);
+		new_dir.write(&size, 4);
+		new_dir.write(name, 8);
+	}
+
+	// Write the new directory
+	uint64_t new_dir_offset = allocate(new_dir.getSize());
+	if (new_dir_offset + new_dir.getSize() > 0xFFFFFFFF)
+		return false;
+	file.Seek(new_dir_offset, wxFromStart);
+	if (new_num_lumps > 0 && file.Write(new_dir.getData(), new_dir.getSize()) != new_dir.getSize())
+		return false;
+	if (mapped_file_ && new_dir_offset < mapped_file_->size())
+		mapping_stale_ = true;
+
+	// Make sure everything is on disk before the header refers to it
+	if (!file.Flush())
+		return false;
+
+	// Update the header
+	char header[12] = { 'P', 'W', 'A', 'D' };
+	if (iwad_)
+		header[0] = 'I';
+	new_num_lumps           = wxINT32_SWAP_ON_BE(new_num_lumps);
+	uint32_t header_dir_ofs = wxINT32_SWAP_ON_BE((uint32_t)new_dir_offset);
+	memcpy(header + 4, &new_num_lumps, 4);
+	memcpy(header + 8, &header_dir_ofs, 4);
+	file.Seek(0, wxFromStart);
+	if (file.Write(header, 12) != 12)
+	{
+		LOG_MESSAGE(1, "WadArchive::writeInPlace: Unable to write header of %s", filename_);
+		return false;
+	}
+	file.Flush();
+	file.Close();
+
+	// The file was only written to where nothing the mapping is still used
+	// for refers to, so don't treat this as an external change
+	if (mapped_file_)
+		mapped_file_->updateFileInfo();
+
+	// Update entries
+	index = 0;
+	for (uint32_t l = 0; l < numEntries(); l++)
+	{
+		auto entry = getEntry(l);
+		if (index < changed.size() && changed[index] == entry)
+			setEntryOffset(entry, offsets[index++]);
+		entry->setState(0);
+	}
+
+	LOG_MESSAGE(
+		2,
+		"WadArchive::writeInPlace: Wrote %d of %d lumps (%lld bytes), directory at %lld",
+		(int)changed.size(),
+		numEntries(),
+		(long long)written,
+		(long long)new_dir_offset);
+
 	return true;
 }
 
@@ -685,6 +1183,19 @@ bool WadArchive::loadEntryData(ArchiveEntry* entry)
 		return true;
 	}
 
+	// Refer to the data in the mapped wad if possible (and it wasn't changed
+	// on disk since it was mapped)
+	checkMappedFile();
+	uint32_t offset = getEntryOffset(entry);
+	if (mapped_file_ && !mapping_stale_ && !entry->isEncrypted() && (uint64_t)offset + entry->getSize() <= mapped_file_->size())
+	{
+		entry->getMCData(false).importShared(mapped_file_, mapped_file_->data() + offset, entry->getSize());
+		entry->setLoaded();
+		entry->setState(0);
+
+		return true;
+	}
+
 	// Open wadfile
 	wxFile file(filename_);
 
@@ -696,7 +1207,7 @@ bool WadArchive::loadEntryData(ArchiveEntry* entry)
 	}
 
 	// Seek to lump offset in file and read it in
-	file.Seek(getEntryOffset(entry), wxFromStart);
+	file.Seek(offset, wxFromStart);
 	entry->importFileStream(file, entry->getSize());
 
 	// Set the lump to loaded
@@ -1272,7 +1783,7 @@ void WadArchive::detectIncludes()
 					{
 						if (i >= 3) // skip '=' or '('
 							tz.adv();
-						string name = tz.next().text;
+						string name = tz.next().text();
 						if (i == 5) // skip ')'
 							tz.adv();
 						opt.match_name      = name;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Archive/Archive.h"
+#include "Utility/MappedFile.h"
 
 class WadArchive : public TreelessArchive
 {
@@ -16,14 +17,18 @@ public:
 	void     updateNamespaces();
 
 	// Opening
-	bool open(MemChunk& mc) override;
+	bool open(string filename) override; // Open from File
+	bool open(MemChunk& mc) override;    // Open from MemChunk
 
 	// Writing/Saving
 	bool write(MemChunk& mc, bool update = true) override;    // Write to MemChunk
 	bool write(string filename, bool update = true) override; // Write to File
+	bool save(string filename = "") override;                 // Save archive
+	bool compact();                                           // Save archive, reclaiming unused space
 
 	// Misc
 	bool loadEntryData(ArchiveEntry* entry) override;
+	bool checkMappedFile();
 
 	// Entry addition/removal
 	ArchiveEntry* addEntry(
@@ -92,6 +97,12 @@ private:
 		}
 	};
 
-	bool           iwad_;
-	vector<NSPair> namespaces_;
+	bool             iwad_;
+	vector<NSPair>   namespaces_;
+	MappedFile::SPtr mapped_file_;           // Memory mapping of the wad file, unmodified entries refer to its data
+	bool             mapping_stale_ = false; // True if the mapped file was written to after mapping it
+
+	bool replaceMappedFile(const string& temp_file, const string& filename);
+	bool mappingUsedElsewhere();
+	bool writeInPlace();
 };
@@ -32,9 +32,23 @@
 #include "Main.h"
 #include "ZipArchive.h"
 #include "App.h"
+#include "Archive/EntryType/EntryTypeCache.h"
 #include "General/UI.h"
+#include "Utility/Compression.h"
+#include "Utility/ThreadPool.h"
 #include "WadArchive.h"
+#include <atomic>
 #include <fstream>
+#include <future>
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Bool, zip_parallel_open, true, CVAR_SAVE)
+CVAR(Int, zip_compression_level, 2, CVAR_SAVE) // 0 = Fast, 1 = Default, 2 = Max
 
 
 // -----------------------------------------------------------------------------
@@ -67,6 +81,392 @@ struct ZipFileHeader
 	uint16_t len_fn;
 	uint16_t len_extra;
 };
+
+// An entry read from the zip central directory, used when loading entry data
+// in parallel
+struct ZipDirEntry
+{
+	ArchiveEntry*              entry;
+	ZipArchive::EntryLocation location;
+};
+
+// An entry to be written to a zip file
+struct ZipOutRecord
+{
+	std::string                      name;                // Full path+name (UTF-8)
+	bool                             dir       = false;   // True if the entry is a directory
+	ZipArchive::EntryLocation        location  = {};      // Location/info in the new zip
+	const ZipArchive::EntryLocation* copy_from = nullptr; // Location in the source zip if unmodified
+	const uint8_t*                   data      = nullptr; // Uncompressed data (if modified)
+	vector<uint8_t>                  compressed;          // Compressed data (if modified)
+	std::future<void>                done;                // Set when compression is finished
+};
+
+// Zip record signatures/sizes
+const uint32_t SIG_LOCAL_HEADER  = 0x04034b50;
+const uint32_t SIG_CENTRAL_DIR   = 0x02014b50;
+const uint32_t SIG_END_OF_DIR    = 0x06054b50;
+const unsigned SIZE_LOCAL_HEADER = 30;
+const unsigned SIZE_CENTRAL_DIR  = 46;
+const unsigned SIZE_END_OF_DIR   = 22;
+const uint32_t MAX_ENTRY_SIZE    = 250 * 1024 * 1024;
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Reads little-endian 16/32 bit values from [data]
+// -----------------------------------------------------------------------------
+uint16_t readL16(const uint8_t* data)
+{
+	return data[0] | (data[1] << 8);
+}
+uint32_t readL32(const uint8_t* data)
+{
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+// -----------------------------------------------------------------------------
+// Finds the zip 'end of central directory' record in [file] and reads the
+// central directory [offset], [size] and number of [records] from it.
+// Returns false if no valid record was found, or if the zip is split or uses
+// zip64 extensions (these are left to wxZipInputStream)
+// -----------------------------------------------------------------------------
+bool readEndOfCentralDir(wxFile& file, uint32_t& offset, uint32_t& size, unsigned& records)
+{
+	// The record is at the end of the file, followed by a comment of up to 64kb
+	wxFileOffset file_size = file.Length();
+	if (file_size < SIZE_END_OF_DIR || file_size > 0xFFFFFFFFLL)
+		return false;
+
+	size_t          tail_size  = (size_t)MIN(file_size, (wxFileOffset)SIZE_END_OF_DIR + 0xFFFF);
+	wxFileOffset    tail_start = file_size - tail_size;
+	vector<uint8_t> tail(tail_size);
+	if (file.Seek(tail_start) == wxInvalidOffset || file.Read(tail.data(), tail_size) != (ssize_t)tail_size)
+		return false;
+
+	// Search backwards for the signature
+	for (int a = tail_size - SIZE_END_OF_DIR; a >= 0; a--)
+	{
+		const uint8_t* rec = tail.data() + a;
+		if (readL32(rec) != SIG_END_OF_DIR)
+			continue;
+
+		// Check for split archive or zip64 placeholders
+		uint16_t disk      = readL16(rec + 4);
+		uint16_t disk_cd   = readL16(rec + 6);
+		uint16_t n_disk    = readL16(rec + 8);
+		uint16_t n_total   = readL16(rec + 10);
+		uint32_t cd_size   = readL32(rec + 12);
+		uint32_t cd_offset = readL32(rec + 16);
+		if (disk != 0 || disk_cd != 0 || n_disk != n_total || n_total == 0xFFFF || cd_size == 0xFFFFFFFF
+			|| cd_offset == 0xFFFFFFFF)
+			return false;
+
+		// Check the directory is within the file
+		if ((wxFileOffset)cd_offset + cd_size > tail_start + a)
+			return false;
+
+		offset  = cd_offset;
+		size    = cd_size;
+		records = n_total;
+		return true;
+	}
+
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// Reads the central directory of the zip [file] into [locations], indexed by
+// zip entry index (directory entries included).
+// Returns false if the central directory couldn't be read
+// -----------------------------------------------------------------------------
+bool readEntryLocations(wxFile& file, vector<ZipArchive::EntryLocation>& locations)
+{
+	locations.clear();
+
+	uint32_t cd_offset, cd_size;
+	unsigned num_records;
+	if (!readEndOfCentralDir(file, cd_offset, cd_size, num_records))
+		return false;
+	vector<uint8_t> cd(cd_size);
+	if (file.Seek(cd_offset) == wxInvalidOffset || file.Read(cd.data(), cd_size) != (ssize_t)cd_size)
+		return false;
+
+	locations.resize(num_records);
+	size_t pos = 0;
+	for (unsigned a = 0; a < num_records; a++)
+	{
+		const uint8_t* rec = cd.data() + pos;
+		if (pos + SIZE_CENTRAL_DIR > cd_size || readL32(rec) != SIG_CENTRAL_DIR)
+		{
+			locations.clear();
+			return false;
+		}
+
+		locations[a].offset    = readL32(rec + 42);
+		locations[a].size_comp = readL32(rec + 20);
+		locations[a].size_orig = readL32(rec + 24);
+		locations[a].crc       = readL32(rec + 16);
+		locations[a].method    = readL16(rec + 10);
+		locations[a].mod_time  = readL16(rec + 12);
+		locations[a].mod_date  = readL16(rec + 14);
+
+		pos += SIZE_CENTRAL_DIR + readL16(rec + 28) + readL16(rec + 30) + readL16(rec + 32);
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads the raw (possibly compressed) data for the zip entry at [location] in
+// [file] into [buf].
+// Returns false if it couldn't be read
+// -----------------------------------------------------------------------------
+bool readRawEntryData(wxFile& file, const ZipArchive::EntryLocation& location, vector<uint8_t>& buf)
+{
+	// Read the local header to find the start of the entry data
+	// (the local 'extra' field can differ from the central directory one)
+	uint8_t header[SIZE_LOCAL_HEADER];
+	if (!file.IsOpened() || file.Seek(location.offset) == wxInvalidOffset
+		|| file.Read(header, SIZE_LOCAL_HEADER) != (ssize_t)SIZE_LOCAL_HEADER || readL32(header) != SIG_LOCAL_HEADER)
+		return false;
+
+	// Read the data
+	wxFileOffset data_offset = (wxFileOffset)location.offset + SIZE_LOCAL_HEADER + readL16(header + 26)
+							   + readL16(header + 28);
+	buf.resize(location.size_comp);
+	return file.Seek(data_offset) != wxInvalidOffset
+		   && file.Read(buf.data(), location.size_comp) == (ssize_t)location.size_comp;
+}
+
+// -----------------------------------------------------------------------------
+// Reads the data for the zip entry at [location] in [file], inflating it if
+// needed. [buf_comp] and [buf_orig] are used as work buffers, so they can be
+// reused between calls.
+// Returns a pointer to the (uncompressed) entry data, or null if it couldn't
+// be read
+// -----------------------------------------------------------------------------
+const uint8_t* readEntryData(
+	wxFile&                          file,
+	const ZipArchive::EntryLocation& location,
+	vector<uint8_t>&                 buf_comp,
+	vector<uint8_t>&                 buf_orig)
+{
+	if (!readRawEntryData(file, location, buf_comp))
+		return nullptr;
+
+	// Stored
+	if (location.method == wxZIP_METHOD_STORE)
+		return location.size_comp == location.size_orig ? buf_comp.data() : nullptr;
+
+	// Deflated
+	if (location.method == wxZIP_METHOD_DEFLATE)
+	{
+		buf_orig.resize(location.size_orig);
+		if (Compression::ZipInflate(buf_comp.data(), location.size_comp, buf_orig.data(), location.size_orig))
+			return buf_orig.data();
+	}
+
+	return nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// Reads the data for [count] entries in [entries] (starting at [first]) from
+// the zip file at [filename], inflating it if needed, and detects its type.
+// Types are taken from [type_cache] where possible, otherwise detected types
+// are stored in it. Each ArchiveEntry is only accessed by the thread running
+// this, and the archive tree must not be modified while it runs. Increments
+// [done] for each entry processed and [failed] for each entry whose data
+// couldn't be read
+// -----------------------------------------------------------------------------
+void loadEntries(
+	const string&          filename,
+	const ZipDirEntry*     entries,
+	size_t                 first,
+	size_t                 count,
+	EntryTypeCache&        type_cache,
+	std::atomic<unsigned>& done,
+	std::atomic<unsigned>& failed)
+{
+	wxFile          file(filename);
+	vector<uint8_t> buf_comp;
+	vector<uint8_t> buf_orig;
+
+	for (size_t a = first; a < first + count; a++)
+	{
+		ArchiveEntry* entry = entries[a].entry;
+
+		// Zero-sized entries need no data
+		if (entries[a].location.size_orig == 0)
+		{
+			entry->setLoaded(true);
+			EntryType::detectEntryType(entry);
+			done++;
+			continue;
+		}
+
+		// If the entry type is cached and the data doesn't need to be loaded,
+		// nothing else to do
+		if (!archive_load_data && type_cache.apply(a, entry))
+		{
+			done++;
+			continue;
+		}
+
+		// Read data
+		const uint8_t* data = readEntryData(file, entries[a].location, buf_comp, buf_orig);
+		if (!data)
+		{
+			// Leave the entry unloaded, loadEntryData will try again later
+			failed++;
+			done++;
+			continue;
+		}
+
+		// Import data and detect type (entry state is locked so the
+		// parent archive isn't notified from this thread)
+		entry->lockState();
+		entry->importMem(data, entries[a].location.size_orig);
+		entry->setLoaded(true);
+		if (!type_cache.apply(a, entry))
+		{
+			EntryType::detectEntryType(entry);
+			type_cache.store(a, entry);
+		}
+		if (!archive_load_data)
+			entry->unloadData();
+		entry->unlockState();
+
+		done++;
+	}
+}
+// -----------------------------------------------------------------------------
+// Returns the zlib compression level to use for [level]
+// -----------------------------------------------------------------------------
+int zlibLevel(ZipArchive::CompressionLevel level)
+{
+	switch (level)
+	{
+	case ZipArchive::CompressionLevel::Fast: return 1;
+	case ZipArchive::CompressionLevel::Default: return 6;
+	default: return 9;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Calculates the CRC of [rec]'s data and compresses it at [level]. If
+// compression doesn't make the data any smaller it is stored uncompressed
+// -----------------------------------------------------------------------------
+void compressRecord(ZipOutRecord& rec, int level)
+{
+	uint32_t size    = rec.location.size_orig;
+	rec.location.crc = Compression::ZipCRC(rec.data, size);
+
+	if (size > 0 && Compression::ZipDeflate(rec.data, size, rec.compressed, level) && rec.compressed.size() < size)
+	{
+		rec.location.method    = wxZIP_METHOD_DEFLATE;
+		rec.location.size_comp = rec.compressed.size();
+	}
+	else
+	{
+		vector<uint8_t>().swap(rec.compressed);
+		rec.location.method    = wxZIP_METHOD_STORE;
+		rec.location.size_comp = size;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Appends little-endian 16/32 bit values to [out]
+// -----------------------------------------------------------------------------
+void writeL16(vector<uint8_t>& out, uint16_t value)
+{
+	out.push_back(value & 0xFF);
+	out.push_back(value >> 8);
+}
+void writeL32(vector<uint8_t>& out, uint32_t value)
+{
+	writeL16(out, value & 0xFFFF);
+	writeL16(out, value >> 16);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the general purpose flags to use for an entry called [name]
+// (bit 11 is set if the name needs UTF-8)
+// -----------------------------------------------------------------------------
+uint16_t nameFlags(const std::string& name)
+{
+	for (auto c : name)
+		if ((uint8_t)c >= 0x80)
+			return 1 << 11;
+
+	return 0;
+}
+
+// -----------------------------------------------------------------------------
+// Appends a zip local file header for [rec] to [out]
+// -----------------------------------------------------------------------------
+void writeLocalHeader(vector<uint8_t>& out, const ZipOutRecord& rec)
+{
+	writeL32(out, SIG_LOCAL_HEADER);
+	writeL16(out, 20); // Version needed to extract (2.0)
+	writeL16(out, nameFlags(rec.name));
+	writeL16(out, rec.location.method);
+	writeL16(out, rec.location.mod_time);
+	writeL16(out, rec.location.mod_date);
+	writeL32(out, rec.location.crc);
+	writeL32(out, rec.location.size_comp);
+	writeL32(out, rec.location.size_orig);
+	writeL16(out, rec.name.size());
+	writeL16(out, 0); // Extra field length
+	out.insert(out.end(), rec.name.begin(), rec.name.end());
+}
+
+// -----------------------------------------------------------------------------
+// Appends a zip central directory record for [rec] to [out]
+// -----------------------------------------------------------------------------
+void writeCentralDirRecord(vector<uint8_t>& out, const ZipOutRecord& rec)
+{
+	writeL32(out, SIG_CENTRAL_DIR);
+	writeL16(out, 20); // Version made by (MS-DOS, 2.0)
+	writeL16(out, 20); // Version needed to extract (2.0)
+	writeL16(out, nameFlags(rec.name));
+	writeL16(out, rec.location.method);
+	writeL16(out, rec.location.mod_time);
+	writeL16(out, rec.location.mod_date);
+	writeL32(out, rec.location.crc);
+	writeL32(out, rec.location.size_comp);
+	writeL32(out, rec.location.size_orig);
+	writeL16(out, rec.name.size());
+	writeL16(out, 0);                   // Extra field length
+	writeL16(out, 0);                   // Comment length
+	writeL16(out, 0);                   // Disk number
+	writeL16(out, 0);                   // Internal attributes
+	writeL32(out, rec.dir ? 0x10 : 0); // External attributes (MS-DOS directory flag)
+	writeL32(out, rec.location.offset);
+	out.insert(out.end(), rec.name.begin(), rec.name.end());
+}
+
+// -----------------------------------------------------------------------------
+// Appends a zip end of central directory record to [out]
+// -----------------------------------------------------------------------------
+void writeEndOfCentralDir(vector<uint8_t>& out, unsigned records, uint32_t cd_size, uint32_t cd_offset)
+{
+	writeL32(out, SIG_END_OF_DIR);
+	writeL16(out, 0); // Disk number
+	writeL16(out, 0); // Disk with central directory
+	writeL16(out, records);
+	writeL16(out, records);
+	writeL32(out, cd_size);
+	writeL32(out, cd_offset);
+	writeL16(out, 0); // Comment length
+}
 } // namespace
 
 // -----------------------------------------------------------------------------
@@ -79,13 +479,18 @@ struct ZipFileHeader
 // -----------------------------------------------------------------------------
 // ZipArchive class constructor
 // -----------------------------------------------------------------------------
-ZipArchive::ZipArchive() : Archive("zip") {}
+ZipArchive::ZipArchive() : Archive("zip"), source_size_{ 0 }, source_time_{ 0 }
+{
+	compression_level_ = (CompressionLevel)MAX(0, MIN(2, (int)zip_compression_level));
+}
 
 // -----------------------------------------------------------------------------
 // ZipArchive class destructor
 // -----------------------------------------------------------------------------
 ZipArchive::~ZipArchive()
 {
+	data_file_.Close();
+
 	std::ifstream test(CHR(temp_file_));
 	if (test.good())
 	{
@@ -100,10 +505,29 @@ ZipArchive::~ZipArchive()
 // -----------------------------------------------------------------------------
 bool ZipArchive::open(string filename)
 {
-	// Copy the zip to a temp file (for use when saving)
-	generateTempFileName(filename);
-	wxCopyFile(filename, temp_file_);
+	// Entry data will be read from the file directly
+	source_file_ = filename;
 
+	// Read the central directory and load entries in parallel if possible
+	if (zip_parallel_open)
+	{
+		bool fallback = false;
+		if (openParallel(filename, fallback))
+			return true;
+		else if (!fallback)
+			return false;
+	}
+
+	// Otherwise read the zip sequentially
+	return openStream(filename);
+}
+
+// -----------------------------------------------------------------------------
+// Reads zip data from a file, in order via wxZipInputStream.
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool ZipArchive::openStream(const string& filename)
+{
 	// Open the file
 	wxFFileInputStream in(filename);
 	if (!in.IsOk())
@@ -206,6 +630,181 @@ bool ZipArchive::open(string filename)
 	this->filename_ = filename;
 	setModified(false);
 	on_disk_ = true;
+	updateEntryLocations();
+
+	UI::setSplashProgressMessage("");
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads zip data from a file. The directory tree is built straight from the
+// zip central directory, then entry data is read, inflated and type-detected
+// on a pool of worker threads.
+// If the zip can't be read this way (eg. zip64 or split archives), returns
+// false with [fallback] set to true so it can be opened via openStream instead
+// -----------------------------------------------------------------------------
+bool ZipArchive::openParallel(const string& filename, bool& fallback)
+{
+	fallback = true;
+
+	// Open the file
+	wxFile file(filename);
+	if (!file.IsOpened())
+		return false;
+
+	// Read the central directory
+	uint32_t cd_offset, cd_size;
+	unsigned num_records;
+	if (!readEndOfCentralDir(file, cd_offset, cd_size, num_records))
+		return false;
+	vector<uint8_t> cd(cd_size);
+	if (file.Seek(cd_offset) == wxInvalidOffset || file.Read(cd.data(), cd_size) != (ssize_t)cd_size)
+		return false;
+	file.Close();
+
+	// Check all records are valid before we start building the tree
+	size_t pos = 0;
+	for (unsigned a = 0; a < num_records; a++)
+	{
+		if (pos + SIZE_CENTRAL_DIR > cd_size || readL32(cd.data() + pos) != SIG_CENTRAL_DIR)
+			return false;
+
+		const uint8_t* rec = cd.data() + pos;
+		if (readL16(rec + 8) & 1) // Encrypted
+			return false;
+
+		uint16_t method = readL16(rec + 10);
+		if (method != wxZIP_METHOD_DEFLATE && method != wxZIP_METHOD_STORE)
+		{
+			Global::error = "Unsupported zip compression method";
+			fallback      = false;
+			return false;
+		}
+
+		pos += SIZE_CENTRAL_DIR + readL16(rec + 28) + readL16(rec + 30) + readL16(rec + 32);
+	}
+	if (pos > cd_size)
+		return false;
+
+	// From here on the zip can be opened this way
+	fallback = false;
+
+	// Stop announcements (don't want to be announcing modification due to entries being added etc)
+	setMuted(true);
+
+	// Build the directory tree
+	UI::setSplashProgressMessage("Reading zip data");
+	vector<ZipDirEntry> dir_entries;
+	dir_entries.reserve(num_records);
+	string           last_path;
+	ArchiveTreeNode* last_dir = rootDir();
+	pos                       = 0;
+	for (unsigned a = 0; a < num_records; a++)
+	{
+		const uint8_t* rec    = cd.data() + pos;
+		uint16_t       len_fn = readL16(rec + 28);
+		pos += SIZE_CENTRAL_DIR + len_fn + readL16(rec + 30) + readL16(rec + 32);
+
+		// Get the entry name (bit 11 of the flags indicates UTF-8)
+		const char* fn_data = (const char*)rec + SIZE_CENTRAL_DIR;
+		string      name;
+		if (readL16(rec + 8) & (1 << 11))
+			name = wxString::FromUTF8(fn_data, len_fn);
+		else
+			name = wxString(fn_data, wxConvLocal, len_fn);
+		name.Replace("\\", "/");
+
+		// Split into path + filename
+		string path       = name.BeforeLast('/');
+		string entry_name = name.AfterLast('/');
+		if (!path.IsEmpty())
+			path += "/";
+
+		// Get the entry's directory, creating it if needed.
+		// Zip entries are usually grouped by directory so the last one is cached
+		if (path != last_path)
+		{
+			last_dir  = createDir(path);
+			last_path = path;
+		}
+
+		// Zip entry is a directory, nothing else to do
+		if (entry_name.IsEmpty())
+			continue;
+
+		// Check size
+		uint32_t size_orig = readL32(rec + 24);
+		if (size_orig >= MAX_ENTRY_SIZE)
+		{
+			Global::error = S_FMT("Entry too large: %s is %u mb", name, size_orig / (1 << 20));
+			setMuted(false);
+			return false;
+		}
+
+		// Create entry
+		ArchiveEntry* new_entry = new ArchiveEntry(entry_name, size_orig);
+		new_entry->setLoaded(false);
+		new_entry->exProp("ZipIndex") = (int)a;
+		last_dir->addEntry(new_entry);
+		new_entry->setState(0, true);
+
+		ZipDirEntry ze;
+		ze.entry              = new_entry;
+		ze.location.offset    = readL32(rec + 42);
+		ze.location.size_comp = readL32(rec + 20);
+		ze.location.size_orig = size_orig;
+		ze.location.crc       = readL32(rec + 16);
+		ze.location.method    = readL16(rec + 10);
+		ze.location.mod_time  = readL16(rec + 12);
+		ze.location.mod_date  = readL16(rec + 14);
+		dir_entries.push_back(ze);
+	}
+
+	// Load entry data and detect types on worker threads, in batches
+	if (!dir_entries.empty())
+	{
+		// Get cached entry types (not for temp files)
+		EntryTypeCache        type_cache(filename == temp_file_ ? "" : filename, dir_entries.size());
+		std::atomic<unsigned> done(0);
+		std::atomic<unsigned> failed(0);
+		{
+			ThreadPool         pool;
+			const ZipDirEntry* entries    = dir_entries.data();
+			size_t             total      = dir_entries.size();
+			size_t             batch_size = MAX((size_t)16, total / (pool.numThreads() * 8));
+			for (size_t start = 0; start < total; start += batch_size)
+			{
+				size_t count = MIN(batch_size, total - start);
+				pool.queue([&filename, entries, start, count, &type_cache, &done, &failed]() {
+					loadEntries(filename, entries, start, count, type_cache, done, failed);
+				});
+			}
+
+			while (!pool.waitFor(100))
+				UI::setSplashProgress((float)done / (float)total);
+		}
+		type_cache.save();
+
+		if (failed > 0)
+			LOG_MESSAGE(1, "ZipArchive::open: Unable to read data for %d entries in \"%s\"", (int)failed, filename);
+	}
+	UI::updateSplash();
+
+	// Set all entries/directories to unmodified
+	vector<ArchiveEntry*> entry_list;
+	getEntryTreeAsList(entry_list);
+	for (size_t a = 0; a < entry_list.size(); a++)
+		entry_list[a]->setState(0);
+
+	// Enable announcements
+	setMuted(false);
+
+	// Setup variables
+	this->filename_ = filename;
+	setModified(false);
+	on_disk_ = true;
+	updateEntryLocations();
 
 	UI::setSplashProgressMessage("");
 
@@ -218,17 +817,13 @@ bool ZipArchive::open(string filename)
 // -----------------------------------------------------------------------------
 bool ZipArchive::open(MemChunk& mc)
 {
-	// Write the MemChunk to a temp file
-	string tempfile = App::path("slade-temp-open.zip", App::Dir::Temp);
-	mc.exportFile(tempfile);
+	// Write the MemChunk to a temp file, this is kept as the source for entry
+	// data until the archive is closed
+	generateTempFileName("slade-temp-open.zip");
+	mc.exportFile(temp_file_);
 
 	// Load the file
-	bool success = open(tempfile);
-
-	// Clean up
-	wxRemoveFile(tempfile);
-
-	return success;
+	return open(temp_file_);
 }
 
 // -----------------------------------------------------------------------------
@@ -237,27 +832,68 @@ bool ZipArchive::open(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool ZipArchive::write(MemChunk& mc, bool update)
 {
-	bool success = false;
+	// Write to the temp file (it becomes the new source for entry data)
+	if (temp_file_.IsEmpty())
+		generateTempFileName("slade-temp-write.zip");
+	if (!write(temp_file_, true))
+		return false;
 
-	// Write to a temporary file
-	string tempfile = App::path("slade-temp-write.zip", App::Dir::Temp);
-	if (write(tempfile, true))
+	// Load file into MemChunk
+	return mc.importFile(temp_file_);
+}
+
+// -----------------------------------------------------------------------------
+// Writes the zip archive to a file
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool ZipArchive::write(string filename, bool update)
+{
+	// Write to a new file next to the destination first, since the destination
+	// may be the file unmodified entries are being copied from
+	string new_file = filename + ".slade-tmp";
+	bool   fallback = false;
+	bool   success  = writeDirect(new_file, update, fallback);
+	if (!success && fallback)
+		success = writeStream(new_file, update);
+	if (!success)
 	{
-		// Load file into MemChunk
-		success = mc.importFile(tempfile);
+		if (wxFileExists(new_file))
+			wxRemoveFile(new_file);
+		return false;
 	}
 
-	// Clean up
-	wxRemoveFile(tempfile);
+	// Replace the destination with the new file
+	{
+		std::lock_guard<std::mutex> lock(data_mutex_);
+		data_file_.Close();
+		entry_locations_.clear();
+	}
+	if (!wxRenameFile(new_file, filename, true))
+	{
+		success = wxCopyFile(new_file, filename, true);
+		wxRemoveFile(new_file);
+		if (!success)
+		{
+			Global::error = "Unable to open file for saving. Make sure it isn't in use by another program.";
+			updateEntryLocations();
+			return false;
+		}
+	}
+
+	// Entry data is now read from the new file
+	if (update)
+		source_file_ = filename;
+	updateEntryLocations();
 
-	return success;
+	return true;
 }
 
 // -----------------------------------------------------------------------------
-// Writes the zip archive to a file
+// Writes the zip archive to a file via wxZipOutputStream (used for zips that
+// need zip64 extensions).
 // Returns true if successful, false otherwise
 // -----------------------------------------------------------------------------
-bool ZipArchive::write(string filename, bool update)
+bool ZipArchive::writeStream(const string& filename, bool update)
 {
 	// Open the file
 	wxFFileOutputStream out(filename);
@@ -268,18 +904,18 @@ bool ZipArchive::write(string filename, bool update)
 	}
 
 	// Open as zip for writing
-	wxZipOutputStream zip(out, 9);
+	wxZipOutputStream zip(out, zlibLevel(compression_level_));
 	if (!zip.IsOk())
 	{
 		Global::error = "Unable to create zip for saving";
 		return false;
 	}
 
-	// Open old zip for copying, from the temp file that was copied on opening.
+	// Open old zip for copying, from the last opened/saved file.
 	// This is used to copy any entries that have been previously saved/compressed
 	// and are unmodified, to greatly speed up zip file saving by not having to
 	// recompress unchanged entries
-	wxFFileInputStream in(temp_file_);
+	wxFFileInputStream in(source_file_);
 	wxZipInputStream   inzip(in);
 
 	// Get a list of all entries in the old zip
@@ -337,16 +973,180 @@ bool ZipArchive::write(string filename, bool update)
 	zip.Close();
 	out.Close();
 
-	// Update the temp file
-	if (temp_file_.IsEmpty())
-		generateTempFileName(filename);
-	wxCopyFile(filename, temp_file_);
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Writes the zip archive to a file directly. Unmodified entries have their
+// compressed data copied as-is from the source zip, modified entries are
+// compressed on a pool of worker threads and written in order as they finish.
+// Returns true if successful, false otherwise. If the zip would need zip64
+// extensions (too many entries or too large), returns false with [fallback]
+// set to true so it can be written via writeStream instead
+// -----------------------------------------------------------------------------
+bool ZipArchive::writeDirect(const string& filename, bool update, bool& fallback)
+{
+	fallback = true;
+
+	// Get a linear list of all entries in the archive
+	vector<ArchiveEntry*> entries;
+	getEntryTreeAsList(entries);
+	if (entries.size() >= 0xFFFF)
+		return false;
+
+	// Open the file
+	wxFile out;
+	if (!out.Create(filename, true))
+	{
+		Global::error = "Unable to open file for saving. Make sure it isn't in use by another program.";
+		fallback      = false;
+		return false;
+	}
+
+	// Setup a record for each entry, and queue compression of modified entries
+	unsigned long        dos_time = wxDateTime::Now().GetAsDOS();
+	int                  level    = zlibLevel(compression_level_);
+	vector<ZipOutRecord> records(entries.size());
+	ThreadPool           pool;
+	for (size_t a = 0; a < entries.size(); a++)
+	{
+		ArchiveEntry* entry = entries[a];
+		ZipOutRecord& rec   = records[a];
+		bool          dir   = entry->getType() == EntryType::folderType();
+
+		// Get the full path+name in the zip (directories end with /)
+		string name = dir ? entry->getPath(true) : entry->getPath() + entry->getName();
+		while (name.StartsWith("/"))
+			name.Remove(0, 1);
+		if (dir && !name.EndsWith("/"))
+			name += "/";
+		rec.name = name.ToUTF8().data();
+		rec.dir  = dir;
+
+		rec.location.mod_time  = dos_time & 0xFFFF;
+		rec.location.mod_date  = (dos_time >> 16) & 0xFFFF;
+		rec.location.crc       = 0;
+		rec.location.method    = wxZIP_METHOD_STORE;
+		rec.location.size_comp = 0;
+		rec.location.size_orig = 0;
+		if (dir)
+			continue;
+
+		// Check if the entry is unmodified and exists in the source zip
+		int index = -1;
+		if (entry->exProps().propertyExists("ZipIndex"))
+			index = entry->exProp("ZipIndex");
+		if (entry->getState() == 0 && index >= 0 && index < (int)entry_locations_.size())
+		{
+			rec.copy_from = &entry_locations_[index];
+			rec.location  = entry_locations_[index];
+			continue;
+		}
+
+		// Otherwise compress it on a worker thread
+		rec.data               = entry->getData();
+		rec.location.size_orig = entry->getSize();
+		auto task = std::make_shared<std::packaged_task<void()>>([&rec, level]() { compressRecord(rec, level); });
+		rec.done = task->get_future();
+		pool.queue([task]() { (*task)(); });
+	}
+
+	// Unmodified entries are copied from the source zip, so make sure it hasn't
+	// been changed by another program since it was read
+	for (auto& rec : records)
+	{
+		if (!rec.copy_from)
+			continue;
+
+		std::lock_guard<std::mutex> lock(data_mutex_);
+		if (sourceFileChanged())
+		{
+			Global::error = S_FMT(
+				"The file \"%s\" was modified outside of SLADE since it was opened, unable to save unmodified "
+				"entries from it. Reopen the archive and try again.",
+				source_file_);
+			fallback = false;
+			return false;
+		}
+		break;
+	}
+
+	// Write entries in order
+	uint64_t        offset = 0;
+	vector<uint8_t> buf_raw;
+	for (size_t a = 0; a < records.size(); a++)
+	{
+		ZipOutRecord&  rec  = records[a];
+		const uint8_t* data = nullptr;
+		if (rec.copy_from)
+		{
+			// Copy compressed data from the source zip
+			std::lock_guard<std::mutex> lock(data_mutex_);
+			if (!readRawEntryData(data_file_, *rec.copy_from, buf_raw))
+			{
+				Global::error = S_FMT("Unable to read entry \"%s\" from the existing zip file", rec.name);
+				fallback      = false;
+				return false;
+			}
+			data = buf_raw.data();
+		}
+		else if (!rec.dir)
+		{
+			// Wait for compression to finish
+			rec.done.wait();
+			data = rec.compressed.empty() ? rec.data : rec.compressed.data();
+		}
+
+		// Write local header + data
+		rec.location.offset = offset;
+		vector<uint8_t> header;
+		writeLocalHeader(header, rec);
+		offset += header.size() + rec.location.size_comp;
+		if (offset > 0xFFFFFFFF)
+			return false;
+		if (out.Write(header.data(), header.size()) != header.size()
+			|| (rec.location.size_comp > 0 && out.Write(data, rec.location.size_comp) != rec.location.size_comp))
+		{
+			Global::error = "Error writing zip file";
+			fallback      = false;
+			return false;
+		}
+
+		// Free compressed data
+		vector<uint8_t>().swap(rec.compressed);
+	}
+
+	// Write central directory
+	vector<uint8_t> cd;
+	for (auto& rec : records)
+		writeCentralDirRecord(cd, rec);
+	if (offset + cd.size() > 0xFFFFFFFF)
+		return false;
+	writeEndOfCentralDir(cd, records.size(), cd.size(), offset);
+	if (out.Write(cd.data(), cd.size()) != cd.size())
+	{
+		Global::error = "Error writing zip file";
+		fallback      = false;
+		return false;
+	}
+	out.Close();
+
+	// Update entry info
+	if (update)
+	{
+		for (size_t a = 0; a < entries.size(); a++)
+		{
+			entries[a]->setState(0);
+			if (!records[a].dir)
+				entries[a]->exProp("ZipIndex") = (int)a;
+		}
+	}
 
 	return true;
 }
 
 // -----------------------------------------------------------------------------
-// Loads an entry's data from the saved copy of the archive if any.
+// Loads an entry's data from the last opened/saved copy of the archive.
 // Returns false if the entry is invalid, doesn't belong to the archive or
 // doesn't exist in the saved copy, true otherwise.
 // -----------------------------------------------------------------------------
@@ -378,11 +1178,48 @@ bool ZipArchive::loadEntryData(ArchiveEntry* entry)
 		return false;
 	}
 
+	// Read the data directly from its location in the source zip, if known
+	{
+		std::lock_guard<std::mutex> lock(data_mutex_);
+
+		// Don't read anything if the zip was changed by another program, the
+		// data at the known location (or zip index) could be for a different
+		// entry
+		if (sourceFileChanged())
+		{
+			LOG_MESSAGE(
+				1,
+				"ZipArchive::loadEntryData: Unable to load data for entry \"%s\", \"%s\" was modified outside of SLADE",
+				entry->getName(),
+				source_file_);
+			return false;
+		}
+
+		if (zip_index >= 0 && zip_index < (int)entry_locations_.size() && data_file_.IsOpened())
+		{
+			vector<uint8_t>      buf_comp, buf_orig;
+			const EntryLocation& location = entry_locations_[zip_index];
+			const uint8_t*       data     = readEntryData(data_file_, location, buf_comp, buf_orig);
+			if (data)
+			{
+				// Import directly into the entry's MemChunk, the entry is unmodified
+				// so its type and state should stay as they are
+				entry->getMCData(false).importMem(data, location.size_orig);
+				entry->setLoaded();
+
+				return true;
+			}
+
+			LOG_MESSAGE(1, "ZipArchive::loadEntryData: Unable to read data for entry \"%s\"", entry->getName());
+		}
+	}
+
+	// Otherwise find it by reading through the zip
 	// Open the file
-	wxFFileInputStream in(filename_);
+	wxFFileInputStream in(source_file_);
 	if (!in.IsOk())
 	{
-		LOG_MESSAGE(1, "ZipArchive::loadEntryData: Unable to open zip file \"%s\"!", filename_);
+		LOG_MESSAGE(1, "ZipArchive::loadEntryData: Unable to open zip file \"%s\"!", source_file_);
 		return false;
 	}
 
@@ -390,7 +1227,7 @@ bool ZipArchive::loadEntryData(ArchiveEntry* entry)
 	wxZipInputStream zip(in);
 	if (!zip.IsOk())
 	{
-		LOG_MESSAGE(1, "ZipArchive::loadEntryData: Invalid zip file \"%s\"!", filename_);
+		LOG_MESSAGE(1, "ZipArchive::loadEntryData: Invalid zip file \"%s\"!", source_file_);
 		return false;
 	}
 
@@ -649,6 +1486,49 @@ void ZipArchive::generateTempFileName(string filename)
 }
 
 
+// -----------------------------------------------------------------------------
+// Opens a persistent handle to the source zip file (the last opened/saved zip)
+// and reads the location of each zip entry's data within it, so entry data can
+// be read directly by loadEntryData and copied when saving
+// -----------------------------------------------------------------------------
+void ZipArchive::updateEntryLocations()
+{
+	std::lock_guard<std::mutex> lock(data_mutex_);
+
+	data_file_.Close();
+	entry_locations_.clear();
+
+	// Remember the file's size and modification time, so it can be checked
+	// that it wasn't changed before reading entry data from it
+	wxStructStat info;
+	if (wxStat(source_file_, &info) != 0)
+		return;
+	source_size_ = info.st_size;
+	source_time_ = info.st_mtime;
+
+	if (!data_file_.Open(source_file_))
+		return;
+
+	if (!readEntryLocations(data_file_, entry_locations_))
+		data_file_.Close();
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the source zip file was changed (or removed) since the entry
+// locations were read from it, in which case entry data can't be read from
+// those locations anymore.
+// data_mutex_ must be locked by the caller
+// -----------------------------------------------------------------------------
+bool ZipArchive::sourceFileChanged() const
+{
+	wxStructStat info;
+	if (wxStat(source_file_, &info) != 0)
+		return true;
+
+	return info.st_size != source_size_ || info.st_mtime != source_time_;
+}
+
+
 // -----------------------------------------------------------------------------
 //
 // ZipArchive Class Static Functions
@@ -1,10 +1,31 @@
 #pragma once
 
 #include "Archive/Archive.h"
+#include <mutex>
 
 class ZipArchive : public Archive
 {
 public:
+	// Location of an entry's data within a zip file
+	struct EntryLocation
+	{
+		uint32_t offset; // Offset of the local file header
+		uint32_t size_comp;
+		uint32_t size_orig;
+		uint32_t crc;
+		uint16_t method;
+		uint16_t mod_time;
+		uint16_t mod_date;
+	};
+
+	// Compression level to use for modified entries when saving
+	enum class CompressionLevel
+	{
+		Fast,
+		Default,
+		Max
+	};
+
 	ZipArchive();
 	~ZipArchive();
 
@@ -17,7 +38,9 @@ public:
 	bool write(string filename, bool update = true) override; // Write to File
 
 	// Misc
-	bool loadEntryData(ArchiveEntry* entry) override;
+	bool             loadEntryData(ArchiveEntry* entry) override;
+	CompressionLevel compressionLevel() const { return compression_level_; }
+	void             setCompressionLevel(CompressionLevel level) { compression_level_ = level; }
 
 	// Entry addition/removal
 	ArchiveEntry* addEntry(ArchiveEntry* entry, string add_namespace, bool copy = false) override;
@@ -36,7 +59,20 @@ public:
 	static bool isZipArchive(string filename);
 
 private:
-	string temp_file_;
+	string                temp_file_;       // Temp file owned by this archive (removed on close)
+	string                source_file_;     // File that entry data is read from (the last opened/saved zip)
+	vector<EntryLocation> entry_locations_; // Indexed by ZipIndex, locations in source_file_
+	wxFile                data_file_;       // Persistent handle to source_file_
+	wxFileOffset          source_size_;     // Size of source_file_ when entry_locations_ were read
+	time_t                source_time_;     // Modification time of source_file_ when entry_locations_ were read
+	std::mutex            data_mutex_;
+	CompressionLevel      compression_level_;
 
 	void generateTempFileName(string filename);
+	void updateEntryLocations();
+	bool sourceFileChanged() const;
+	bool openStream(const string& filename);
+	bool openParallel(const string& filename, bool& fallback);
+	bool writeStream(const string& filename, bool update);
+	bool writeDirect(const string& filename, bool update, bool& fallback);
 };
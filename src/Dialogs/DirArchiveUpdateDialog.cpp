@@ -105,6 +105,8 @@ void DirArchiveUpdateDialog::populateChangeList()
 		case DirEntryChange::DELETED_FILE: row.push_back(wxVariant("Deleted")); break;
 		case DirEntryChange::DELETED_DIR: row.push_back(wxVariant("Deleted")); break;
 		case DirEntryChange::UPDATED: row.push_back(wxVariant("Modified")); break;
+		case DirEntryChange::RENAMED_FILE: row.push_back(wxVariant("Renamed")); break;
+		case DirEntryChange::RENAMED_DIR: row.push_back(wxVariant("Renamed")); break;
 		default: break;
 		}
 		row.push_back(wxVariant(changes_[a].file_path));
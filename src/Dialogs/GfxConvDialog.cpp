@@ -38,6 +38,7 @@
 #include "General/Misc.h"
 #include "General/UI.h"
 #include "Graphics/CTexture/CTexture.h"
+#include "Graphics/GfxConverter.h"
 #include "Graphics/Icons.h"
 #include "Graphics/Palette/PaletteManager.h"
 #include "Graphics/SImage/SIFormat.h"
@@ -594,7 +595,12 @@ void GfxConvDialog::applyConversion()
 	// Update item info
 	item.modified   = true;
 	item.new_format = current_format.format;
-	item.palette    = pal_chooser_target->getSelectedPalette(item.entry);
+
+	// Keep a copy of the target palette, the chooser's archive palette is
+	// shared between all items (and reloaded for each one)
+	item.target_palette = std::make_shared<Palette>();
+	item.target_palette->copyPalette(pal_chooser_target->getSelectedPalette(item.entry));
+	item.palette = item.target_palette.get();
 }
 
 
@@ -633,16 +639,89 @@ void GfxConvDialog::onBtnConvert(wxCommandEvent& e)
 void GfxConvDialog::onBtnConvertAll(wxCommandEvent& e)
 {
 	// Show splash window
-	UI::showSplash("Converting Gfx...", true);
+	UI::showSplash("Converting Gfx... (Esc to cancel)", true);
+
+	// Convert the current item as previewed
+	applyConversion();
 
-	// Convert all images
-	for (size_t a = current_item; a < items.size(); a++)
+	// Convert the remaining items in the background with the same options
+	SIFormat::convert_options_t opt;
+	getConvertOptions(opt);
+	GfxConverter converter;
+	size_t       first = current_item + 1;
+	for (size_t a = first; a < items.size(); a++)
 	{
-		applyConversion();
-		if (!nextItem())
-			break;
+		gcd_item_t& item = items[a];
+		auto&       conv = converter.addItem();
+		conv.format      = current_format.format;
+		conv.convert     = true;
+		conv.options     = opt;
+		conv.pal_current = converter.copyPalette(pal_chooser_current->getSelectedPalette(item.entry));
+		conv.pal_target  = converter.copyPalette(pal_chooser_target->getSelectedPalette(item.entry));
+
+		if (item.image.isValid())
+			conv.image.copyImage(&item.image);
+		else if (item.entry)
+		{
+			// Detect entry type here, it can't be done on a worker thread
+			ArchiveEntry* entry = item.entry;
+			if (entry->getType() == EntryType::unknownType())
+				EntryType::detectEntryType(entry);
+
+			conv.loader = [entry](SImage& image) { return Misc::loadImageFromEntry(&image, entry); };
+		}
+		else if (item.texture)
+		{
+			// Detect patch entry types here, as above
+			item.texture->detectPatchTypes(item.archive);
+
+			CTexture* texture    = item.texture;
+			Archive*  archive    = item.archive;
+			Palette*  palette    = item.palette;
+			bool      force_rgba = item.force_rgba;
+			conv.loader          = [=](SImage& image) {
+				if (force_rgba)
+					image.convertRGBA(palette);
+				return texture->toImage(image, archive, palette, force_rgba);
+			};
+		}
 	}
 
+	// Apply the results in order
+	converter.run(
+		[&](GfxConverter::Item& conv, size_t index) {
+			gcd_item_t& item = items[first + index];
+
+			// Stop at the first image that can't be written to the selected
+			// format, so the user can pick a format for it
+			if (conv.status == GfxConverter::Status::NotWritable)
+			{
+				item.image.copyImage(&conv.image);
+				return false;
+			}
+
+			// Skip if not a valid image
+			current_item = first + index;
+			if (conv.status != GfxConverter::Status::Ok)
+				return true;
+
+			item.image.copyImage(&conv.image);
+			item.modified       = true;
+			item.new_format     = current_format.format;
+			item.target_palette = conv.pal_target;
+			item.palette        = item.target_palette.get();
+
+			return true;
+		},
+		[&](size_t done, size_t total) {
+			UI::setSplashProgressMessage(S_FMT("%lu of %lu", first + done, items.size()));
+			UI::setSplashProgress((float)(first + done) / (float)items.size());
+			return !wxGetKeyState(WXK_ESCAPE);
+		});
+
+	// Open the next unconverted item (closes the dialog if there are none left)
+	nextItem();
+
 	// Hide splash window
 	UI::hideSplash();
 }
@@ -40,6 +40,8 @@ struct gcd_item_t
 	Archive*      archive;
 	bool          force_rgba;
 
+	std::shared_ptr<Palette> target_palette; // Copy of the palette the image was converted to
+
 	gcd_item_t(ArchiveEntry* entry = nullptr)
 	{
 		this->entry      = entry;
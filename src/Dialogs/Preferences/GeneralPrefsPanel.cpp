@@ -46,6 +46,7 @@ EXTERN_CVAR(Bool, update_check)
 EXTERN_CVAR(Bool, update_check_beta)
 EXTERN_CVAR(Bool, confirm_exit)
 EXTERN_CVAR(Bool, backup_archives)
+EXTERN_CVAR(Int, zip_compression_level)
 
 
 // -----------------------------------------------------------------------------
@@ -60,7 +61,11 @@ EXTERN_CVAR(Bool, backup_archives)
 // -----------------------------------------------------------------------------
 GeneralPrefsPanel::GeneralPrefsPanel(wxWindow* parent) : PrefsPanelBase(parent)
 {
-	// Create + Layout controls
+	// Create controls
+	choice_zip_compression_ = new wxChoice(this, -1);
+	choice_zip_compression_->Append(WxUtils::arrayString({ "Fast", "Default", "Maximum" }));
+
+	// Layout
 	SetSizer(WxUtils::layoutVertically(
 		{ cb_archive_load_      = new wxCheckBox(this, -1, "Load all archive entry data to memory when opened"),
 		  cb_archive_close_tab_ = new wxCheckBox(this, -1, "Close archive when its tab is closed"),
@@ -70,10 +75,14 @@ GeneralPrefsPanel::GeneralPrefsPanel(wxWindow* parent) : PrefsPanelBase(parent)
 		  cb_update_check_beta_ = new wxCheckBox(this, -1, "Include beta versions when checking for updates"),
 #endif
 		  cb_confirm_exit_    = new wxCheckBox(this, -1, "Show confirmation dialog on exit"),
-		  cb_backup_archives_ = new wxCheckBox(this, -1, "Back up archives") }));
+		  cb_backup_archives_ = new wxCheckBox(this, -1, "Back up archives"),
+		  WxUtils::createLabelHBox(this, "Zip compression level:", choice_zip_compression_) }));
 
 	cb_wads_root_->SetToolTip(
 		"When opening a zip or folder archive, automatically open all wad entries in the root directory");
+	choice_zip_compression_->SetToolTip(
+		"The compression level to use for modified entries when saving zip archives. Lower levels save faster "
+		"but produce larger files");
 }
 
 // -----------------------------------------------------------------------------
@@ -95,6 +104,7 @@ void GeneralPrefsPanel::init()
 #endif
 	cb_confirm_exit_->SetValue(confirm_exit);
 	cb_backup_archives_->SetValue(backup_archives);
+	choice_zip_compression_->SetSelection(MAX(0, MIN(2, (int)zip_compression_level)));
 }
 
 // -----------------------------------------------------------------------------
@@ -109,6 +119,7 @@ void GeneralPrefsPanel::applyPreferences()
 	update_check      = cb_update_check_->GetValue();
 	update_check_beta = cb_update_check_beta_->GetValue();
 #endif
-	confirm_exit    = cb_confirm_exit_->GetValue();
-	backup_archives = cb_backup_archives_->GetValue();
+	confirm_exit          = cb_confirm_exit_->GetValue();
+	backup_archives       = cb_backup_archives_->GetValue();
+	zip_compression_level = choice_zip_compression_->GetSelection();
 }
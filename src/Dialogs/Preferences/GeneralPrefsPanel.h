@@ -20,4 +20,5 @@ private:
 	wxCheckBox* cb_update_check_beta_;
 	wxCheckBox* cb_confirm_exit_;
 	wxCheckBox* cb_backup_archives_;
+	wxChoice*   choice_zip_compression_;
 };
@@ -78,9 +78,9 @@ void parseStates(Tokenizer& tz, PropertyList& props)
 		if (tz.checkNext(":"))
 		{
 			// Add to list of current states
-			states.push_back(tz.current().text.Lower());
+			states.push_back(tz.current().text().Lower());
 			if (state_first.empty())
-				state_first = tz.current().text.Lower();
+				state_first = tz.current().text().Lower();
 
 			tz.adv();
 		}
@@ -97,9 +97,9 @@ void parseStates(Tokenizer& tz, PropertyList& props)
 			}
 
 			// Set sprite for current states (if it is defined)
-			if (!(tz.current().text.Contains("#") || tz.current().text.Contains("-")))
+			if (!(tz.current().text().Contains("#") || tz.current().text().Contains("-")))
 				for (auto& state : states)
-					state_sprites[state] = tz.current().text + tz.peek().text[0];
+					state_sprites[state] = tz.current().text() + tz.peek().text()[0];
 
 			states.clear();
 			tz.adv();
@@ -240,14 +240,14 @@ void parseStates(Tokenizer& tz, PropertyList& props)
 void parseDecorateActor(Tokenizer& tz, std::map<int, ThingType>& types, vector<ThingType>& parsed)
 {
 	// Get actor name
-	string name       = tz.next().text;
+	string name       = tz.next().text();
 	string actor_name = name;
 	string parent;
 
 	// Check for inheritance
 	// string next = tz.peekToken();
 	if (tz.advIfNext(":"))
-		parent = tz.next().text;
+		parent = tz.next().text();
 
 	// Check for replaces
 	if (tz.checkNextNC("replaces"))
@@ -298,13 +298,13 @@ void parseDecorateActor(Tokenizer& tz, std::map<int, ThingType>& types, vector<T
 			else if (tz.checkNC("game"))
 			{
 				filters_present = true;
-				if (gameDef(configuration().currentGame()).supportsFilter(tz.next().text))
+				if (gameDef(configuration().currentGame()).supportsFilter(tz.next().text()))
 					available = true;
 			}
 
 			// Tag
 			else if (!title_given && tz.checkNC("tag"))
-				name = tz.next().text;
+				name = tz.next().text();
 
 			// Category
 			else if (tz.checkNC("//$Group") || tz.checkNC("//$Category"))
@@ -316,7 +316,7 @@ void parseDecorateActor(Tokenizer& tz, std::map<int, ThingType>& types, vector<T
 			// Sprite
 			else if (tz.checkNC("//$EditorSprite") || tz.checkNC("//$Sprite"))
 			{
-				found_props["sprite"] = tz.next().text;
+				found_props["sprite"] = tz.next().text();
 				sprite_given          = true;
 			}
 
@@ -363,11 +363,11 @@ void parseDecorateActor(Tokenizer& tz, std::map<int, ThingType>& types, vector<T
 
 			// Icon
 			else if (tz.checkNC("//$Icon"))
-				found_props["icon"] = tz.next().text;
+				found_props["icon"] = tz.next().text();
 
 			// DB2 Color
 			else if (tz.checkNC("//$Color"))
-				found_props["color"] = tz.next().text;
+				found_props["color"] = tz.next().text();
 
 			// SLADE 3 Colour (overrides DB2 color)
 			// Good thing US spelling differs from ABC (Aussie/Brit/Canuck) spelling! :p
@@ -385,11 +385,11 @@ void parseDecorateActor(Tokenizer& tz, std::map<int, ThingType>& types, vector<T
 			else if (tz.checkNC("translation"))
 			{
 				string translation = "\"";
-				translation += tz.next().text;
+				translation += tz.next().text();
 				while (tz.checkNext(","))
 				{
-					translation += tz.next().text; // ,
-					translation += tz.next().text; // next range
+					translation += tz.next().text(); // ,
+					translation += tz.next().text(); // next range
 				}
 				translation += "\"";
 				found_props["translation"] = translation;
@@ -400,7 +400,7 @@ void parseDecorateActor(Tokenizer& tz, std::map<int, ThingType>& types, vector<T
 				found_props["solid"] = true;
 
 			// Unrecognised DB comment prop
-			else if (tz.current().text.StartsWith("//$"))
+			else if (tz.current().startsWith("//$"))
 			{
 				tz.advToNextLine();
 				continue;
@@ -484,12 +484,12 @@ void parseDecorateOld(Tokenizer& tz, std::map<int, ThingType>& types)
 	int          type       = -1;
 	PropertyList found_props;
 	if (tz.checkNext("{"))
-		name = tz.current().text;
+		name = tz.current().text();
 	// DamageTypes aren't old DECORATE format, but we handle them here to skip over them
 	else if (tz.checkNC("pickup") || tz.checkNC("breakable") || tz.checkNC("projectile") || tz.checkNC("damagetype"))
 	{
-		group = tz.current().text;
-		name  = tz.next().text;
+		group = tz.current().text();
+		name  = tz.next().text();
 	}
 	tz.adv(); // skip '{'
 	do
@@ -505,13 +505,13 @@ void parseDecorateOld(Tokenizer& tz, std::map<int, ThingType>& types)
 		// else if (S_CMPNOCASE(token, "Sprite"))
 		else if (tz.checkNC("sprite"))
 		{
-			sprite      = tz.next().text;
+			sprite      = tz.next().text();
 			spritefound = true;
 		}
 		// else if (S_CMPNOCASE(token, "Frames"))
 		else if (tz.checkNC("frames"))
 		{
-			string   frames = tz.next().text;
+			string   frames = tz.next().text();
 			unsigned pos    = 0;
 			if (frames.length() > 0)
 			{
@@ -580,7 +580,7 @@ void parseDecorateEntry(ArchiveEntry* entry, std::map<int, ThingType>& types, ve
 		// Check for #include
 		if (tz.checkNC("#include"))
 		{
-			auto inc_entry = entry->relativeEntry(tz.next().text);
+			auto inc_entry = entry->relativeEntry(tz.next().text());
 
 			// Check #include path could be resolved
 			if (!inc_entry)
@@ -589,7 +589,7 @@ void parseDecorateEntry(ArchiveEntry* entry, std::map<int, ThingType>& types, ve
 					"Warning parsing DECORATE entry %s: "
 					"Unable to find #included entry \"%s\" at line %d, skipping",
 					CHR(entry->getName()),
-					CHR(tz.current().text),
+					CHR(tz.current().text()),
 					tz.current().line_no));
 			}
 			else
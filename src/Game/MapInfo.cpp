@@ -144,7 +144,7 @@ bool MapInfo::checkEqualsToken(Tokenizer& tz, const string& parsing) const
 		Log::error(S_FMT(
 			"Error Parsing %s: Expected \"=\", got \"%s\" at line %d",
 			CHR(parsing),
-			CHR(tz.current().text),
+			CHR(tz.current().text()),
 			tz.lineNo()));
 		return false;
 	}
@@ -201,14 +201,14 @@ bool MapInfo::parseZMapInfo(ArchiveEntry* entry)
 		if (tz.check("include"))
 		{
 			// Get entry at include path
-			ArchiveEntry* include_entry = entry->getParent()->entryAtPath(tz.next().text);
+			ArchiveEntry* include_entry = entry->getParent()->entryAtPath(tz.next().text());
 
 			if (!include_entry)
 			{
 				Log::warning(S_FMT(
 					"Warning - Parsing ZMapInfo \"%s\": Unable to include \"%s\" at line %d",
 					CHR(entry->getName()),
-					CHR(tz.current().text),
+					CHR(tz.current().text()),
 					tz.lineNo()));
 			}
 			else if (!parseZMapInfo(include_entry))
@@ -218,7 +218,7 @@ bool MapInfo::parseZMapInfo(ArchiveEntry* entry)
 		// Map
 		else if (tz.check("map") || tz.check("defaultmap") || tz.check("adddefaultmap"))
 		{
-			if (!parseZMap(tz, tz.current().text))
+			if (!parseZMap(tz, tz.current().text()))
 				return false;
 		}
 
@@ -247,7 +247,7 @@ bool MapInfo::parseZMapInfo(ArchiveEntry* entry)
 				S_FMT(
 					"Warning - Parsing ZMapInfo \"%s\": Unknown token \"%s\"",
 					CHR(entry->getName()),
-					CHR(tz.current().text)));
+					CHR(tz.current().text())));
 		}
 
 		tz.adv();
@@ -272,19 +272,19 @@ bool MapInfo::parseZMap(Tokenizer& tz, string type)
 	if (type == "map")
 	{
 		// Entry name should be just after map keyword
-		map.entry_name = tz.current().text;
+		map.entry_name = tz.current().text();
 
 		// Parse map name
 		tz.adv();
 		if (tz.check("lookup"))
 		{
 			map.lookup_name = true;
-			map.name        = tz.next().text;
+			map.name        = tz.next().text();
 		}
 		else
 		{
 			map.lookup_name = false;
-			map.name        = tz.current().text;
+			map.name        = tz.current().text();
 		}
 
 		tz.adv();
@@ -293,7 +293,7 @@ bool MapInfo::parseZMap(Tokenizer& tz, string type)
 	if (!tz.advIf("{"))
 	{
 		Log::error(S_FMT(
-			"Error Parsing ZMapInfo: Expecting \"{\", got \"%s\" at line %d", CHR(tz.current().text), tz.lineNo()));
+			"Error Parsing ZMapInfo: Expecting \"{\", got \"%s\" at line %d", CHR(tz.current().text()), tz.lineNo()));
 		return false;
 	}
 
@@ -320,7 +320,7 @@ bool MapInfo::parseZMap(Tokenizer& tz, string type)
 			if (!checkEqualsToken(tz, "ZMapInfo"))
 				return false;
 
-			map.sky1 = tz.next().text;
+			map.sky1 = tz.next().text();
 
 			// Scroll speed
 			// TODO: Checks
@@ -334,7 +334,7 @@ bool MapInfo::parseZMap(Tokenizer& tz, string type)
 			if (!checkEqualsToken(tz, "ZMapInfo"))
 				return false;
 
-			map.sky2 = tz.next().text;
+			map.sky2 = tz.next().text();
 
 			// Scroll speed
 			// TODO: Checks
@@ -348,7 +348,7 @@ bool MapInfo::parseZMap(Tokenizer& tz, string type)
 			if (!checkEqualsToken(tz, "ZMapInfo"))
 				return false;
 
-			map.sky1 = tz.next().text;
+			map.sky1 = tz.next().text();
 		}
 
 		// DoubleSky
@@ -369,7 +369,7 @@ bool MapInfo::parseZMap(Tokenizer& tz, string type)
 			if (!checkEqualsToken(tz, "ZMapInfo"))
 				return false;
 
-			if (!strToCol(tz.next().text, map.fade))
+			if (!strToCol(tz.next().text(), map.fade))
 				return false;
 		}
 
@@ -379,7 +379,7 @@ bool MapInfo::parseZMap(Tokenizer& tz, string type)
 			if (!checkEqualsToken(tz, "ZMapInfo"))
 				return false;
 
-			if (!strToCol(tz.next().text, map.fade_outside))
+			if (!strToCol(tz.next().text(), map.fade_outside))
 				return false;
 		}
 
@@ -454,7 +454,7 @@ bool MapInfo::parseDoomEdNums(Tokenizer& tz)
 	if (!tz.advIfNext("{", 2))
 	{
 		Log::error(
-			S_FMT("Error Parsing ZMapInfo: Expecting \"{\", got \"%s\" at line %d", CHR(tz.peek().text), tz.lineNo()));
+			S_FMT("Error Parsing ZMapInfo: Expecting \"{\", got \"%s\" at line %d", CHR(tz.peek().text()), tz.lineNo()));
 		return false;
 	}
 
@@ -465,7 +465,7 @@ bool MapInfo::parseDoomEdNums(Tokenizer& tz)
 		{
 			Log::error(S_FMT(
 				"Error Parsing ZMapInfo DoomEdNums: Expecting editor number, got \"%s\" at line %d",
-				CHR(tz.current().text),
+				CHR(tz.current().text()),
 				tz.lineNo()));
 			return false;
 		}
@@ -481,13 +481,13 @@ bool MapInfo::parseDoomEdNums(Tokenizer& tz)
 		{
 			Log::error(S_FMT(
 				"Error Parsing ZMapInfo DoomEdNums: Expecting \"=\", got \"%s\" at line %d",
-				CHR(tz.current().text),
+				CHR(tz.current().text()),
 				tz.lineNo()));
 			return false;
 		}
 
 		// Actor Class
-		editor_nums_[number].actor_class = tz.next().text;
+		editor_nums_[number].actor_class = tz.next().text();
 
 		// Check for special/args definition
 		if (tz.advIfNext(",", 2))
@@ -496,7 +496,7 @@ bool MapInfo::parseDoomEdNums(Tokenizer& tz)
 
 			// Check if special or arg
 			if (!tz.current().isInteger())
-				editor_nums_[number].special = tz.current().text;
+				editor_nums_[number].special = tz.current().text();
 			else
 				editor_nums_[number].args[arg++] = tz.current().asInt();
 
@@ -507,7 +507,7 @@ bool MapInfo::parseDoomEdNums(Tokenizer& tz)
 				{
 					Log::error(S_FMT(
 						"Error Parsing ZMapInfo DoomEdNums: Expecting arg value, got \"%s\" at line %d",
-						CHR(tz.current().text),
+						CHR(tz.current().text()),
 						tz.current().line_no));
 					return false;
 				}
@@ -557,7 +557,7 @@ MapInfo::Format MapInfo::detectMapInfoType(ArchiveEntry* entry)
 				return Format::ZDoomNew;
 		}
 
-		prev = tz.current().text;
+		prev = tz.current().text();
 		tz.adv();
 	}
 
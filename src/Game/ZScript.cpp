@@ -198,11 +198,11 @@ void parseBlocks(ArchiveEntry* entry, vector<ParsedStatement>& parsed)
 	while (!tz.atEnd())
 	{
 		// Preprocessor
-		if (tz.current().text.StartsWith("#"))
+		if (tz.current().startsWith("#"))
 		{
 			if (tz.checkNC("#include"))
 			{
-				auto inc_entry = entry->relativeEntry(tz.next().text);
+				auto inc_entry = entry->relativeEntry(tz.next().text());
 
 				// Check #include path could be resolved
 				if (!inc_entry)
@@ -211,7 +211,7 @@ void parseBlocks(ArchiveEntry* entry, vector<ParsedStatement>& parsed)
 						"Warning parsing ZScript entry %s: "
 						"Unable to find #included entry \"%s\" at line %u, skipping",
 						CHR(entry->getName()),
-						CHR(tz.current().text),
+						CHR(tz.current().text()),
 						tz.current().line_no));
 				}
 				else
@@ -1066,9 +1066,9 @@ bool ParsedStatement::parse(Tokenizer& tz)
 			return true;
 
 		// DB comment
-		if (tz.current().text.StartsWith(db_comment))
+		if (tz.current().text().StartsWith(db_comment))
 		{
-			tokens.push_back(tz.current().text);
+			tokens.push_back(tz.current().text());
 			tokens.push_back(tz.getLine());
 			return true;
 		}
@@ -1099,7 +1099,7 @@ bool ParsedStatement::parse(Tokenizer& tz)
 			break;
 
 		// Array initializer: ... = { ... }
-		if (tz.current().text.Cmp("=") == 0 && tz.peek() == '{')
+		if (tz.current() == "=" && tz.peek() == '{')
 		{
 			tokens.emplace_back("=");
 			tokens.emplace_back("{");
@@ -1108,7 +1108,7 @@ bool ParsedStatement::parse(Tokenizer& tz)
 			continue;
 		}
 
-		tokens.push_back(tz.current().text);
+		tokens.push_back(tz.current().text());
 		tz.adv();
 	}
 
@@ -84,12 +84,12 @@ void Console::execute(string command)
 	tz.openString(command);
 
 	// Get the command name
-	string cmd_name = tz.current().text;
+	string cmd_name = tz.current().text();
 
 	// Get all args
 	vector<string> args;
 	while (!tz.atEnd())
-		args.push_back(tz.next().text);
+		args.push_back(tz.next().text());
 
 	// Check that it is a valid command
 	for (size_t a = 0; a < commands.size(); a++)
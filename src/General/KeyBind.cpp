@@ -790,13 +790,13 @@ bool KeyBind::readBinds(Tokenizer& tz)
 	while (!tz.checkOrEnd("}"))
 	{
 		// Clear any current binds for the key
-		string name = tz.current().text;
+		string name = tz.current().text();
 		getBind(name).keys.clear();
 
 		// Read keys
 		while (true)
 		{
-			string keystr = tz.next().text;
+			string keystr = tz.next().text();
 
 			// Finish if no keys are bound
 			if (keystr == "unbound")
@@ -730,7 +730,7 @@ void Misc::readWindowInfo(Tokenizer& tz)
 	tz.advIf("{");
 	while (!tz.check("}") && !tz.atEnd())
 	{
-		string id = tz.current().text;
+		string id = tz.current().text();
 		int width = tz.next().asInt();
 		int height = tz.next().asInt();
 		int left = tz.next().asInt();
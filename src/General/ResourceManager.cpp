@@ -47,6 +47,51 @@ ResourceManager* ResourceManager::instance_ = nullptr;
 string ResourceManager::doom64_hash_table_[65536];
 
 
+// ----------------------------------------------------------------------------
+//
+// Functions
+//
+// ----------------------------------------------------------------------------
+namespace
+{
+// ----------------------------------------------------------------------------
+// Returns the most relevant entry for [name] in [map], or nullptr if there is
+// no resource with that name (see EntryResource::getEntry)
+// ----------------------------------------------------------------------------
+ArchiveEntry* findEntry(
+	EntryResourceMap& map,
+	const string& name,
+	Archive* priority,
+	const string& nspace = "",
+	bool ns_required = false)
+{
+	auto i = map.find(name);
+	if (i == map.end())
+		return nullptr;
+
+	return i->second.getEntry(priority, nspace, ns_required);
+}
+
+// ----------------------------------------------------------------------------
+// Returns pointers to all resources in [map], sorted by name
+// ----------------------------------------------------------------------------
+template<class M> vector<typename M::value_type*> sortedResources(M& map)
+{
+	vector<typename M::value_type*> list;
+	list.reserve(map.size());
+	for (auto& i : map)
+		list.push_back(&i);
+
+	std::sort(list.begin(), list.end(), [](typename M::value_type* left, typename M::value_type* right)
+	{
+		return left->first < right->first;
+	});
+
+	return list;
+}
+} // namespace
+
+
 // ----------------------------------------------------------------------------
 //
 // EntryResource Class Functions
@@ -62,7 +107,10 @@ string ResourceManager::doom64_hash_table_[65536];
 void EntryResource::add(ArchiveEntry::SPtr& entry)
 {
 	if (entry->getParent())
+	{
 		entries_.push_back(entry);
+		cache_.clear();
+	}
 }
 
 // ----------------------------------------------------------------------------
@@ -80,6 +128,29 @@ void EntryResource::remove(ArchiveEntry::SPtr& entry)
 		else
 			++a;
 	}
+
+	cache_.clear();
+}
+
+// ----------------------------------------------------------------------------
+// EntryResource::removeArchive
+//
+// Removes any entries in [archive] from the resource (and any entries that no
+// longer exist)
+// ----------------------------------------------------------------------------
+void EntryResource::removeArchive(Archive* archive)
+{
+	unsigned a = 0;
+	while (a < entries_.size())
+	{
+		auto entry = entries_[a].lock();
+		if (!entry || entry->getParent() == archive)
+			entries_.erase(entries_.begin() + a);
+		else
+			++a;
+	}
+
+	cache_.clear();
 }
 
 // ----------------------------------------------------------------------------
@@ -89,7 +160,8 @@ void EntryResource::remove(ArchiveEntry::SPtr& entry)
 // [nspace]. If [priority] is set, this will prioritize entries from the
 // priority archive. If [nspace] is not empty, this will prioritize entries
 // within that namespace, or if [ns_required] is true, ignore anything not in
-// [nspace]
+// [nspace]. The result is cached until entries are added to or removed from
+// the resource
 // ----------------------------------------------------------------------------
 ArchiveEntry* EntryResource::getEntry(Archive* priority, const string& nspace, bool ns_required)
 {
@@ -97,6 +169,43 @@ ArchiveEntry* EntryResource::getEntry(Archive* priority, const string& nspace, b
 	if (entries_.empty())
 		return nullptr;
 
+	// Check cache
+	for (auto& cached : cache_)
+	{
+		if (cached.priority != priority || cached.ns_required != ns_required || cached.nspace != nspace)
+			continue;
+
+		if (!cached.found)
+			return nullptr;
+
+		// Use the cached entry if it still exists
+		auto entry = cached.entry.lock();
+		if (entry)
+			return entry.get();
+
+		cache_.clear();
+		break;
+	}
+
+	// Not cached, find it
+	auto entry = findEntry(priority, nspace, ns_required);
+
+	// Add to cache (there are usually only a couple of different lookups for
+	// each resource, so don't let it grow too large)
+	if (cache_.size() >= 8)
+		cache_.clear();
+	cache_.push_back({ priority, nspace, ns_required, entry, entry.get() != nullptr });
+
+	return entry.get();
+}
+
+// ----------------------------------------------------------------------------
+// EntryResource::findEntry
+//
+// Finds the most relevant entry for this resource (see getEntry)
+// ----------------------------------------------------------------------------
+ArchiveEntry::SPtr EntryResource::findEntry(Archive* priority, const string& nspace, bool ns_required)
+{
 	ArchiveEntry::SPtr best;
 	auto i = entries_.end();
 	while (i != entries_.begin())
@@ -143,7 +252,7 @@ ArchiveEntry* EntryResource::getEntry(Archive* priority, const string& nspace, b
 			best = entry;
 	}
 
-	return best.get();
+	return best;
 }
 
 
@@ -166,6 +275,7 @@ void TextureResource::add(CTexture* tex, Archive* parent)
 		return;
 
 	textures_.push_back(std::make_unique<Texture>(tex, parent));
+	cached_ = false;
 }
 
 // ----------------------------------------------------------------------------
@@ -184,6 +294,60 @@ void TextureResource::remove(Archive* parent)
 		else
 			++i;
 	}
+
+	cached_ = false;
+}
+
+// ----------------------------------------------------------------------------
+// TextureResource::getTexture
+//
+// Returns the most relevant texture in this resource, or nullptr if none.
+// If [priority] is set, textures in that archive take precedence, and any
+// textures in [ignore] are skipped. The result is cached until textures are
+// added to or removed from the resource
+// ----------------------------------------------------------------------------
+CTexture* TextureResource::getTexture(Archive* priority, Archive* ignore)
+{
+	if (textures_.empty())
+		return nullptr;
+
+	// Check cache
+	if (cached_ && cache_priority_ == priority && cache_ignore_ == ignore)
+		return cache_tex_;
+
+	// Go through resource textures
+	CTexture* tex = &textures_[0].get()->tex;
+	Archive* parent = textures_[0].get()->parent;
+	for (auto& res_tex : textures_)
+	{
+		// Skip if it's in the 'ignore' archive
+		if (res_tex->parent == ignore)
+			continue;
+
+		// If it's in the 'priority' archive, use it
+		if (priority && res_tex->parent == priority)
+		{
+			tex = &res_tex->tex;
+			parent = res_tex->parent;
+			break;
+		}
+
+		// Otherwise, if it's in a 'later' archive than the current resource entry, set it
+		if (App::archiveManager().archiveIndex(parent) <=
+			App::archiveManager().archiveIndex(res_tex->parent))
+		{
+			tex = &res_tex->tex;
+			parent = res_tex->parent;
+		}
+	}
+
+	// Cache the most relevant texture
+	cached_ = true;
+	cache_priority_ = priority;
+	cache_ignore_ = ignore;
+	cache_tex_ = (parent != ignore) ? tex : nullptr;
+
+	return cache_tex_;
 }
 
 
@@ -208,8 +372,11 @@ void ResourceManager::addArchive(Archive* archive)
 	// Go through entries
 	vector<ArchiveEntry::SPtr> entries;
 	archive->getEntryTreeAsList(entries);
-	for (auto& entry : entries)
-		addEntry(entry);
+	{
+		std::lock_guard<std::recursive_mutex> lock(mutex_);
+		for (auto& entry : entries)
+			addEntry(entry);
+	}
 
 	// Listen to the archive
 	listenTo(archive);
@@ -229,16 +396,61 @@ void ResourceManager::removeArchive(Archive* archive)
 	if (!archive)
 		return;
 
-	// Go through entries
-	vector<ArchiveEntry::SPtr> entries;
-	archive->getEntryTreeAsList(entries);
-	for (auto& entry : entries)
-		removeEntry(entry, false, true);
+	{
+		std::lock_guard<std::recursive_mutex> lock(mutex_);
+
+		// Remove entries from all resources the archive has entries in
+		auto entries = archive_entries_.find(archive);
+		if (entries != archive_entries_.end())
+		{
+			for (auto res : entries->second)
+				res->removeArchive(archive);
+			archive_entries_.erase(entries);
+		}
+
+		// Remove composite textures defined in the archive
+		auto textures = archive_textures_.find(archive);
+		if (textures != archive_textures_.end())
+		{
+			for (auto res : textures->second)
+				res->remove(archive);
+			archive_textures_.erase(textures);
+		}
+	}
 
 	// Announce resource update
 	announce("resources_updated");
 }
 
+// ----------------------------------------------------------------------------
+// ResourceManager::announceEntryUpdated
+//
+// Announces a resource update caused by a change to [entry], with a pointer to
+// the entry as the event data
+// ----------------------------------------------------------------------------
+void ResourceManager::announceEntryUpdated(ArchiveEntry* entry)
+{
+	MemChunk mc;
+	wxUIntPtr ptr = wxPtrToUInt(entry);
+	mc.write(&ptr, sizeof(wxUIntPtr));
+	announce("resources_updated", mc);
+}
+
+// ----------------------------------------------------------------------------
+// ResourceManager::addToResource
+//
+// Adds [entry] to the resource matching [name] in [map], and returns the
+// resource
+// ----------------------------------------------------------------------------
+EntryResource& ResourceManager::addToResource(EntryResourceMap& map, const string& name, ArchiveEntry::SPtr& entry)
+{
+	EntryResource& res = map[name];
+	res.add(entry);
+	archive_entries_[entry->getParent()].insert(&res);
+
+	return res;
+}
+
 // ----------------------------------------------------------------------------
 // ResourceManager::getTextureHash
 //
@@ -265,11 +477,14 @@ uint16_t ResourceManager::getTextureHash(const string& name)
 // ----------------------------------------------------------------------------
 void ResourceManager::addEntry(ArchiveEntry::SPtr& entry, bool log)
 {
-	if (!entry.get())
+	if (!entry.get() || !entry->getParent())
 		return;
 
-	// Detect type if unknown
-	if (entry->getType() == EntryType::unknownType())
+	std::lock_guard<std::recursive_mutex> lock(mutex_);
+
+	// Detect type if unknown (unloaded entries should have had their type
+	// detected already, or will be re-added once it is - see DirArchive)
+	if (entry->getType() == EntryType::unknownType() && entry->isLoaded())
 		EntryType::detectEntryType(entry.get());
 
 	// Get entry type
@@ -286,7 +501,7 @@ void ResourceManager::addEntry(ArchiveEntry::SPtr& entry, bool log)
 
 	// Check for palette entry
 	if (type->id() == "palette")
-		palettes_[name].add(entry);
+		addToResource(palettes_, name, entry);
 
 	// Check for various image entries, so only accept images
 	if (type->editor() == "gfx")
@@ -312,13 +527,13 @@ void ResourceManager::addEntry(ArchiveEntry::SPtr& entry, bool log)
 			{
 				addToFpOnly = false;
 			}
-			patches_[name].add(entry);
+			EntryResource& patch = addToResource(patches_, name, entry);
 			if (!entry->getParent()->isTreeless())
 			{
-				patches_fp_[path].add(entry);
-				if ((lname.Len() > 8 || patches_[name].length() > 0) && addToFpOnly)
+				addToResource(patches_fp_, path, entry);
+				if ((lname.Len() > 8 || patch.length() > 0) && addToFpOnly)
 				{
-					patches_fp_only_[path].add(entry);
+					addToResource(patches_fp_only_, path, entry);
 				}
 			}
 		}
@@ -332,13 +547,13 @@ void ResourceManager::addEntry(ArchiveEntry::SPtr& entry, bool log)
 			{
 				addToFpOnly = false;
 			}
-			flats_[name].add(entry);
+			EntryResource& flat = addToResource(flats_, name, entry);
 			if (!entry->getParent()->isTreeless())
 			{
-				flats_fp_[path].add(entry);
-				if ((lname.Len() > 8 || flats_[name].length() > 0) && addToFpOnly)
+				addToResource(flats_fp_, path, entry);
+				if ((lname.Len() > 8 || flat.length() > 0) && addToFpOnly)
 				{
-					flats_fp_only_[path].add(entry);
+					addToResource(flats_fp_only_, path, entry);
 				}
 			}
 		}
@@ -346,10 +561,10 @@ void ResourceManager::addEntry(ArchiveEntry::SPtr& entry, bool log)
 		// Check for stand-alone texture entry
 		if (entry->isInNamespace("textures") || entry->isInNamespace("hires"))
 		{
-			satextures_[name].add(entry);
+			addToResource(satextures_, name, entry);
 			if (!entry->getParent()->isTreeless())
 			{
-				satextures_fp_[path].add(entry);
+				addToResource(satextures_fp_, path, entry);
 			}
 
 			// Add name to hash table
@@ -388,7 +603,9 @@ void ResourceManager::addEntry(ArchiveEntry::SPtr& entry, bool log)
 		for (unsigned a = 0; a < tx.nTextures(); a++)
 		{
 			tex = tx.getTexture(a);
-			textures_[tex->getName()].add(tex, entry->getParent());
+			TextureResource& res = textures_[tex->getName()];
+			res.add(tex, entry->getParent());
+			archive_textures_[entry->getParent()].insert(&res);
 		}
 	}
 }
@@ -399,7 +616,11 @@ void removeEntryFromMap(EntryResourceMap& map, const string& name, ArchiveEntry:
 		for (auto& i : map)
 			i.second.remove(entry);
 	else
-		map[name].remove(entry);
+	{
+		auto i = map.find(name);
+		if (i != map.end())
+			i->second.remove(entry);
+	}
 }
 
 // ----------------------------------------------------------------------------
@@ -412,6 +633,8 @@ void ResourceManager::removeEntry(ArchiveEntry::SPtr& entry, bool log, bool full
 	if (!entry.get())
 		return;
 
+	std::lock_guard<std::recursive_mutex> lock(mutex_);
+
 	// Get resource name (extension cut, uppercase)
 	string name = entry->getUpperNameNoExt().Truncate(8);
 	string path = entry->getPath(true).Upper().Mid(1);
@@ -454,7 +677,11 @@ void ResourceManager::removeEntry(ArchiveEntry::SPtr& entry, bool log, bool full
 
 		// Remove all texture resources
 		for (unsigned a = 0; a < tx.nTextures(); a++)
-			textures_[tx.getTexture(a)->getName()].remove(entry->getParent());
+		{
+			auto i = textures_.find(tx.getTexture(a)->getName());
+			if (i != textures_.end())
+				i->second.remove(entry->getParent());
+		}
 	}
 }
 
@@ -465,12 +692,10 @@ void ResourceManager::removeEntry(ArchiveEntry::SPtr& entry, bool log, bool full
 // ----------------------------------------------------------------------------
 void ResourceManager::listAllPatches()
 {
-	EntryResourceMap::iterator i = patches_.begin();
-	while (i != patches_.end())
-	{
+	std::lock_guard<std::recursive_mutex> lock(mutex_);
+
+	for (auto i : sortedResources(patches_))
 		LOG_MESSAGE(1, "%s (%d)", i->first, i->second.length());
-		++i;
-	}
 }
 
 // ----------------------------------------------------------------------------
@@ -480,9 +705,11 @@ void ResourceManager::listAllPatches()
 // ----------------------------------------------------------------------------
 void ResourceManager::getAllPatchEntries(vector<ArchiveEntry*>& list, Archive* priority, bool fullPath)
 {
-	for (auto& i : patches_)
+	std::lock_guard<std::recursive_mutex> lock(mutex_);
+
+	for (auto i : sortedResources(patches_))
 	{
-		auto entry = i.second.getEntry(priority);
+		auto entry = i->second.getEntry(priority);
 		if (entry)
 			list.push_back(entry);
 	}
@@ -490,9 +717,9 @@ void ResourceManager::getAllPatchEntries(vector<ArchiveEntry*>& list, Archive* p
 	if (!fullPath)
 		return;
 
-	for (auto& i : patches_fp_only_)
+	for (auto i : sortedResources(patches_fp_only_))
 	{
-		auto entry = i.second.getEntry(priority);
+		auto entry = i->second.getEntry(priority);
 		if (entry)
 			list.push_back(entry);
 	}
@@ -505,31 +732,33 @@ void ResourceManager::getAllPatchEntries(vector<ArchiveEntry*>& list, Archive* p
 // ----------------------------------------------------------------------------
 void ResourceManager::getAllTextures(vector<TextureResource::Texture*>& list, Archive* priority, Archive* ignore)
 {
+	std::lock_guard<std::recursive_mutex> lock(mutex_);
+
 	// Add all primary textures to the list
-	for (auto& i : textures_)
+	for (auto i : sortedResources(textures_))
 	{
 		// Skip if no entries
-		if (i.second.length() == 0)
+		if (i->second.length() == 0)
 			continue;
 
 		// Go through resource textures
-		TextureResource::Texture* res = i.second.textures_[0].get();
-		for (int a = 0; a < i.second.length(); a++)
+		TextureResource::Texture* res = i->second.textures_[0].get();
+		for (int a = 0; a < i->second.length(); a++)
 		{
-			res = i.second.textures_[a].get();
+			res = i->second.textures_[a].get();
 
 			// Skip if it's in the 'ignore' archive
 			if (res->parent == ignore)
 				continue;
 
 			// If it's in the 'priority' archive, exit loop
-			if (priority && i.second.textures_[a]->parent == priority)
+			if (priority && i->second.textures_[a]->parent == priority)
 				break;
 
 			// Otherwise, if it's in a 'later' archive than the current resource, set it
 			if (App::archiveManager().archiveIndex(res->parent) <=
-			        App::archiveManager().archiveIndex(i.second.textures_[a]->parent))
-				res = i.second.textures_[a].get();
+			        App::archiveManager().archiveIndex(i->second.textures_[a]->parent))
+				res = i->second.textures_[a].get();
 		}
 
 		// Add texture resource to the list
@@ -545,10 +774,12 @@ void ResourceManager::getAllTextures(vector<TextureResource::Texture*>& list, Ar
 // ----------------------------------------------------------------------------
 void ResourceManager::getAllTextureNames(vector<string>& list)
 {
+	std::lock_guard<std::recursive_mutex> lock(mutex_);
+
 	// Add all primary textures to the list
-	for (auto& i : textures_)
-		if (i.second.length() > 0)	// Ignore if no entries
-			list.push_back(i.first);
+	for (auto i : sortedResources(textures_))
+		if (i->second.length() > 0)	// Ignore if no entries
+			list.push_back(i->first);
 }
 
 // ----------------------------------------------------------------------------
@@ -558,9 +789,11 @@ void ResourceManager::getAllTextureNames(vector<string>& list)
 // ----------------------------------------------------------------------------
 void ResourceManager::getAllFlatEntries(vector<ArchiveEntry*>& list, Archive* priority, bool fullPath)
 {
-	for (auto& i : flats_)
+	std::lock_guard<std::recursive_mutex> lock(mutex_);
+
+	for (auto i : sortedResources(flats_))
 	{
-		auto entry = i.second.getEntry(priority);
+		auto entry = i->second.getEntry(priority);
 		if (entry)
 			list.push_back(entry);
 	}
@@ -568,9 +801,9 @@ void ResourceManager::getAllFlatEntries(vector<ArchiveEntry*>& list, Archive* pr
 	if (!fullPath)
 		return;
 
-	for (auto& i : flats_fp_only_)
+	for (auto i : sortedResources(flats_fp_only_))
 	{
-		auto entry = i.second.getEntry(priority);
+		auto entry = i->second.getEntry(priority);
 		if (entry)
 			list.push_back(entry);
 	}
@@ -583,10 +816,12 @@ void ResourceManager::getAllFlatEntries(vector<ArchiveEntry*>& list, Archive* pr
 // ----------------------------------------------------------------------------
 void ResourceManager::getAllFlatNames(vector<string>& list)
 {
+	std::lock_guard<std::recursive_mutex> lock(mutex_);
+
 	// Add all primary flats to the list
-	for (auto& i : flats_)
-		if (i.second.length() > 0)	// Ignore if no entries
-			list.push_back(i.first);
+	for (auto i : sortedResources(flats_))
+		if (i->second.length() > 0)	// Ignore if no entries
+			list.push_back(i->first);
 }
 
 // ----------------------------------------------------------------------------
@@ -597,7 +832,9 @@ void ResourceManager::getAllFlatNames(vector<string>& list)
 // ----------------------------------------------------------------------------
 ArchiveEntry* ResourceManager::getPaletteEntry(const string& palette, Archive* priority)
 {
-	return palettes_[palette.Upper()].getEntry(priority);
+	std::lock_guard<std::recursive_mutex> lock(mutex_);
+
+	return findEntry(palettes_, palette.Upper(), priority);
 }
 
 // ----------------------------------------------------------------------------
@@ -616,15 +853,14 @@ ArchiveEntry* ResourceManager::getPatchEntry(const string& patch, const string&
 	if (!nspace.CmpNoCase("textures"))
 		return getTextureEntry(patch, "textures", priority);
 
-	ArchiveEntry* entry = patches_[patch.Upper()].getEntry(priority, nspace, true);
-	if (entry)
-		return entry;
+	std::lock_guard<std::recursive_mutex> lock(mutex_);
 
-	entry = patches_fp_[patch.Upper()].getEntry(priority, nspace, true);
+	string name = patch.Upper();
+	ArchiveEntry* entry = findEntry(patches_, name, priority, nspace, true);
 	if (entry)
 		return entry;
 
-	return nullptr;
+	return findEntry(patches_fp_, name, priority, nspace, true);
 }
 
 // ----------------------------------------------------------------------------
@@ -635,19 +871,15 @@ ArchiveEntry* ResourceManager::getPatchEntry(const string& patch, const string&
 // ----------------------------------------------------------------------------
 ArchiveEntry* ResourceManager::getFlatEntry(const string& flat, Archive* priority)
 {
-	// Check resource with matching name exists
-	EntryResource& res = flats_[flat.Upper()];
+	std::lock_guard<std::recursive_mutex> lock(mutex_);
 
 	// Return most relevant entry
-	ArchiveEntry* entry = res.getEntry(priority);
-	if (entry)
-		return entry;
-
-	entry = flats_fp_[flat.Upper()].getEntry(priority, "flats", true);
+	string name = flat.Upper();
+	ArchiveEntry* entry = findEntry(flats_, name, priority);
 	if (entry)
 		return entry;
 
-	return nullptr;
+	return findEntry(flats_fp_, name, priority, "flats", true);
 }
 
 // ----------------------------------------------------------------------------
@@ -658,15 +890,14 @@ ArchiveEntry* ResourceManager::getFlatEntry(const string& flat, Archive* priorit
 // ----------------------------------------------------------------------------
 ArchiveEntry* ResourceManager::getTextureEntry(const string& texture, const string& nspace, Archive* priority)
 {
-	ArchiveEntry* entry = satextures_[texture.Upper()].getEntry(priority, nspace, true);
-	if (entry)
-		return entry;
+	std::lock_guard<std::recursive_mutex> lock(mutex_);
 
-	entry = satextures_fp_[texture.Upper()].getEntry(priority, nspace, true);
+	string name = texture.Upper();
+	ArchiveEntry* entry = findEntry(satextures_, name, priority, nspace, true);
 	if (entry)
 		return entry;
 
-	return nullptr;
+	return findEntry(satextures_fp_, name, priority, nspace, true);
 }
 
 // ----------------------------------------------------------------------------
@@ -677,38 +908,15 @@ ArchiveEntry* ResourceManager::getTextureEntry(const string& texture, const stri
 // ----------------------------------------------------------------------------
 CTexture* ResourceManager::getTexture(const string& texture, Archive* priority, Archive* ignore)
 {
+	std::lock_guard<std::recursive_mutex> lock(mutex_);
+
 	// Check texture resource with matching name exists
-	TextureResource& res = textures_[texture.Upper()];
-	if (res.textures_.empty())
+	auto res = textures_.find(texture.Upper());
+	if (res == textures_.end())
 		return nullptr;
 
-	// Go through resource textures
-	CTexture* tex = &res.textures_[0].get()->tex;
-	Archive* parent = res.textures_[0].get()->parent;
-	for (auto& res_tex : res.textures_)
-	{
-		// Skip if it's in the 'ignore' archive
-		if (res_tex->parent == ignore)
-			continue;
-
-		// If it's in the 'priority' archive, return it
-		if (priority && res_tex->parent == priority)
-			return &res_tex->tex;
-
-		// Otherwise, if it's in a 'later' archive than the current resource entry, set it
-		if (App::archiveManager().archiveIndex(parent) <=
-		        App::archiveManager().archiveIndex(res_tex->parent))
-		{
-			tex = &res_tex->tex;
-			parent = res_tex->parent;
-		}
-	}
-
 	// Return the most relevant texture
-	if (parent != ignore)
-		return tex;
-	else
-		return nullptr;
+	return res->second.getTexture(priority, ignore);
 }
 
 // ----------------------------------------------------------------------------
@@ -729,7 +937,7 @@ void ResourceManager::onAnnouncement(Announcer* announcer, string event_name, Me
 		auto esp = entry->getParent()->entryAtPathShared(entry->getPath(true));
 		removeEntry(esp, true);
 		addEntry(esp, true);
-		announce("resources_updated");
+		announceEntryUpdated(entry);
 	}
 
 	// An entry is removed or renamed
@@ -740,7 +948,7 @@ void ResourceManager::onAnnouncement(Announcer* announcer, string event_name, Me
 		ArchiveEntry* entry = (ArchiveEntry*)wxUIntToPtr(ptr);
 		auto esp = entry->getParent()->entryAtPathShared(entry->getPath(true));
 		removeEntry(esp, true);
-		announce("resources_updated");
+		announceEntryUpdated(entry);
 	}
 
 	// An entry is added
@@ -751,6 +959,27 @@ void ResourceManager::onAnnouncement(Announcer* announcer, string event_name, Me
 		ArchiveEntry* entry = (ArchiveEntry*)wxUIntToPtr(ptr);
 		auto esp = entry->getParent()->entryAtPathShared(entry->getPath(true));
 		addEntry(esp, true);
+		announceEntryUpdated(entry);
+	}
+
+	// The types of a batch of (unloaded) entries were detected in the
+	// background, add them all before announcing a single update
+	if (event_name == "entry_types_detected")
+	{
+		uint32_t count = 0;
+		event_data.read(&count, sizeof(uint32_t));
+		{
+			std::lock_guard<std::recursive_mutex> lock(mutex_);
+			for (uint32_t a = 0; a < count; a++)
+			{
+				wxUIntPtr ptr;
+				event_data.read(&ptr, sizeof(wxUIntPtr));
+				ArchiveEntry* entry = (ArchiveEntry*)wxUIntToPtr(ptr);
+				auto esp = entry->getParent()->entryAtPathShared(entry->getPath(true));
+				removeEntry(esp);
+				addEntry(esp);
+			}
+		}
 		announce("resources_updated");
 	}
 }
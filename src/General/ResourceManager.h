@@ -4,6 +4,9 @@
 #include "Archive/Archive.h"
 #include "General/ListenerAnnouncer.h"
 #include "Graphics/CTexture/CTexture.h"
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 class ResourceManager;
 
@@ -30,13 +33,27 @@ public:
 
 	void	add(ArchiveEntry::SPtr& entry);
 	void	remove(ArchiveEntry::SPtr& entry);
+	void	removeArchive(Archive* archive);
 
 	int		length() override { return entries_.size(); }
 
 	ArchiveEntry*	getEntry(Archive* priority = nullptr, const string& nspace = "", bool ns_required = false);
 
 private:
+	// A previous getEntry result, kept until the entries change
+	struct CachedEntry
+	{
+		Archive*					priority;
+		string						nspace;
+		bool						ns_required;
+		std::weak_ptr<ArchiveEntry>	entry;
+		bool						found;
+	};
+
 	vector<std::weak_ptr<ArchiveEntry>>	entries_;
+	vector<CachedEntry>					cache_;
+
+	ArchiveEntry::SPtr	findEntry(Archive* priority, const string& nspace, bool ns_required);
 };
 
 class TextureResource : public Resource
@@ -63,12 +80,21 @@ public:
 
 	int		length() override { return textures_.size(); }
 
+	CTexture*	getTexture(Archive* priority = nullptr, Archive* ignore = nullptr);
+
 private:
 	vector<std::unique_ptr<Texture>>	textures_;
+
+	// Previous getTexture result, kept until the textures change
+	bool		cached_			= false;
+	Archive*	cache_priority_	= nullptr;
+	Archive*	cache_ignore_	= nullptr;
+	CTexture*	cache_tex_		= nullptr;
 };
 
-typedef std::map<string, EntryResource> EntryResourceMap;
-typedef std::map<string, TextureResource> TextureResourceMap;
+// Resources are keyed by uppercase name
+typedef std::unordered_map<string, EntryResource, wxStringHash, wxStringEqual> EntryResourceMap;
+typedef std::unordered_map<string, TextureResource, wxStringHash, wxStringEqual> TextureResourceMap;
 
 class ResourceManager : public Listener, public Announcer
 {
@@ -124,8 +150,18 @@ private:
 	//EntryResourceMap	satextures_fp_only_; // Probably not needed
 	TextureResourceMap	textures_;		// Composite textures (defined in a TEXTUREx/TEXTURES lump)
 
+	// Resources each archive has entries/textures in (for removeArchive)
+	std::unordered_map<Archive*, std::unordered_set<EntryResource*>>	archive_entries_;
+	std::unordered_map<Archive*, std::unordered_set<TextureResource*>>	archive_textures_;
+
+	// Resources can be looked up from worker threads (eg. browser thumbnails)
+	std::recursive_mutex	mutex_;
+
 	static ResourceManager*	instance_;
 	static string			doom64_hash_table_[65536];
+
+	void			announceEntryUpdated(ArchiveEntry* entry);
+	EntryResource&	addToResource(EntryResourceMap& map, const string& name, ArchiveEntry::SPtr& entry);
 };
 
 // Define for less cumbersome ResourceManager::getInstance()
@@ -34,6 +34,7 @@
 #include "General/Misc.h"
 #include "General/ResourceManager.h"
 #include "Graphics/SImage/SImage.h"
+#include "TextureImageCache.h"
 #include "TextureXList.h"
 #include "Utility/Tokenizer.h"
 
@@ -222,7 +223,7 @@ bool CTPatchEx::parse(Tokenizer& tz, uint8_t type)
 {
 	// Read basic info
 	this->type = type;
-	name = tz.next().text.Upper();
+	name = tz.next().text().Upper();
 	tz.adv();	// Skip ,
 	offset_x = tz.next().asInt();
 	tz.adv();	// Skip ,
@@ -255,13 +256,13 @@ bool CTPatchEx::parse(Tokenizer& tz, uint8_t type)
 			{
 				// Build translation string
 				string translate;
-				string temp = tz.next().text;
+				string temp = tz.next().text();
 				if (temp.Contains("=")) temp = S_FMT("\"%s\"", temp);
 				translate += temp;
 				while (tz.checkNext(","))
 				{
-					translate += tz.next().text; // add ','
-					temp = tz.next().text;
+					translate += tz.next().text(); // add ','
+					temp = tz.next().text();
 					if (temp.Contains("=")) temp = S_FMT("\"%s\"", temp);
 					translate += temp;
 				}
@@ -278,7 +279,7 @@ bool CTPatchEx::parse(Tokenizer& tz, uint8_t type)
 				blendtype = 2;
 
 				// Read first value
-				string first = tz.next().text;
+				string first = tz.next().text();
 
 				// If no second value, it's just a colour string
 				if (!tz.checkNext(","))
@@ -312,7 +313,7 @@ bool CTPatchEx::parse(Tokenizer& tz, uint8_t type)
 						{
 							Log::error(S_FMT(
 								"Invalid TEXTURES definition, expected ',', got '%s'",
-								tz.peek().text
+								tz.peek().text()
 							));
 							return false;
 						}
@@ -329,7 +330,7 @@ bool CTPatchEx::parse(Tokenizer& tz, uint8_t type)
 
 			// Style
 			if (tz.checkNC("Style"))
-				style = tz.next().text;
+				style = tz.next().text();
 
 			// Read next property name
 			tz.adv();
@@ -718,7 +719,7 @@ bool CTexture::parse(Tokenizer& tz, string type)
 	this->type = type;
 	this->extended = true;
 	this->defined = false;
-	name = tz.next().text.Upper();
+	name = tz.next().text().Upper();
 	tz.adv();	// Skip ,
 	width = tz.next().asInt();
 	tz.adv();	// Skip ,
@@ -800,7 +801,7 @@ bool CTexture::parseDefine(Tokenizer& tz)
 	this->type = "Define";
 	this->extended = true;
 	this->defined = true;
-	name = tz.next().text.Upper();
+	name = tz.next().text().Upper();
 	def_width = tz.next().asInt();
 	def_height = tz.next().asInt();
 	width = def_width;
@@ -938,6 +939,11 @@ bool CTexture::convertRegular()
  *******************************************************************/
 bool CTexture::toImage(SImage& image, Archive* parent, Palette* pal, bool force_rgba)
 {
+	// Check for a cached image first
+	string cache_key = imageCacheKey(image, parent, pal, force_rgba);
+	if (!cache_key.IsEmpty() && TextureImageCache::getInstance()->getTexture(cache_key, image))
+		return true;
+
 	// Init image
 	image.clear();
 	image.resize(width, height);
@@ -1044,11 +1050,15 @@ bool CTexture::toImage(SImage& image, Archive* parent, Palette* pal, bool force_
 		for (unsigned a = 0; a < patches.size(); a++)
 		{
 			CTPatch* patch = patches[a];
-			if (Misc::loadImageFromEntry(&p_img, patch->getPatchEntry(parent)))
+			if (TextureImageCache::getInstance()->loadPatch(patch->getPatchEntry(parent), p_img))
 				image.drawImage(p_img, patch->xOffset(), patch->yOffset(), dp, pal, pal);
 		}
 	}
 
+	// Add to cache
+	if (!cache_key.IsEmpty())
+		TextureImageCache::getInstance()->storeTexture(cache_key, image);
+
 	return true;
 }
 
@@ -1064,49 +1074,136 @@ bool CTexture::loadPatchImage(unsigned pindex, SImage& image, Archive* parent, P
 
 	CTPatch* patch = patches[pindex];
 
-	// If the texture is extended, search for textures-as-patches first
-	// (as long as the patch name is different from this texture's name)
-	if (extended && !(S_CMPNOCASE(patch->getName(), name)))
-	{
-		// Search the texture list we're in first
-		if (in_list)
-		{
-			for (unsigned a = 0; a < in_list->nTextures(); a++)
-			{
-				CTexture* tex = in_list->getTexture(a);
-
-				// Don't look past this texture in the list
-				if (tex->getName() == name)
-					break;
-
-				// Check for name match
-				if (S_CMPNOCASE(tex->getName(), patch->getName()))
-				{
-					// Load texture to image
-					return tex->toImage(image, parent, pal);
-				}
-			}
-		}
-
-		// Otherwise, try the resource manager
-		// TODO: Something has to be ignored here. The entire archive or just the current list?
-		CTexture* tex = theResourceManager->getTexture(patch->getName(), parent);
-		if (tex)
-			return tex->toImage(image, parent, pal);
-	}
+	// Check for textures-as-patches first
+	CTexture* tex = getPatchTexture(patch, parent);
+	if (tex)
+		return tex->toImage(image, parent, pal);
 
 	// Get patch entry
 	ArchiveEntry* entry = patch->getPatchEntry(parent);
 
 	// Load entry to image if valid
 	if (entry)
-		return Misc::loadImageFromEntry(&image, entry);
+		return TextureImageCache::getInstance()->loadPatch(entry, image);
 
 	// Maybe it's a texture?
 	entry = theResourceManager->getTextureEntry(patch->getName(), "", parent);
 
 	if (entry)
-		return Misc::loadImageFromEntry(&image, entry);
+		return TextureImageCache::getInstance()->loadPatch(entry, image);
 
 	return false;
 }
+
+/* CTexture::detectPatchTypes
+ * Detects the types of any patch entries used by the texture
+ * (including those of textures used as patches) that don't have one
+ * yet. Entry type detection can't be done on a worker thread, so
+ * this must be called on the main thread before generating the
+ * texture image on one via toImage
+ *******************************************************************/
+void CTexture::detectPatchTypes(Archive* parent)
+{
+	for (unsigned a = 0; a < patches.size(); a++)
+	{
+		// Textures-as-patches
+		CTexture* tex = getPatchTexture(patches[a], parent);
+		if (tex)
+		{
+			tex->detectPatchTypes(parent);
+			continue;
+		}
+
+		// Get patch entry (same as loadPatchImage)
+		ArchiveEntry* entry = patches[a]->getPatchEntry(parent);
+		if (!entry)
+			entry = theResourceManager->getTextureEntry(patches[a]->getName(), "", parent);
+
+		if (entry && entry->getType() == EntryType::unknownType())
+			EntryType::detectEntryType(entry);
+	}
+}
+
+/* CTexture::getPatchTexture
+ * Returns the texture to use for [patch] if this is an extended
+ * texture and the patch refers to another texture rather than a
+ * patch entry (textures-as-patches), or nullptr otherwise
+ *******************************************************************/
+CTexture* CTexture::getPatchTexture(CTPatch* patch, Archive* parent)
+{
+	// Only extended textures can use textures as patches
+	// (as long as the patch name is different from this texture's name)
+	if (!extended || S_CMPNOCASE(patch->getName(), name))
+		return nullptr;
+
+	// Search the texture list we're in first
+	if (in_list)
+	{
+		for (unsigned a = 0; a < in_list->nTextures(); a++)
+		{
+			CTexture* tex = in_list->getTexture(a);
+
+			// Don't look past this texture in the list
+			if (tex->getName() == name)
+				break;
+
+			// Check for name match
+			if (S_CMPNOCASE(tex->getName(), patch->getName()))
+				return tex;
+		}
+	}
+
+	// Otherwise, try the resource manager
+	// TODO: Something has to be ignored here. The entire archive or just the current list?
+	return theResourceManager->getTexture(patch->getName(), parent);
+}
+
+/* CTexture::imageCacheKey
+ * Returns the key to use for the image generated by toImage with
+ * the given parameters in the TextureImageCache, or an empty string
+ * if the image shouldn't be cached
+ *******************************************************************/
+string CTexture::imageCacheKey(SImage& image, Archive* parent, Palette* pal, bool force_rgba)
+{
+	// Defined textures are resized to fit their patch when generated, and
+	// images with their own palette (or no palette given) would be drawn using
+	// the image's palette
+	if (defined || image.hasPalette() || !pal)
+		return "";
+
+	// Palette
+	uint32_t pal_hash = 2166136261u;
+	for (unsigned a = 0; a < 256; a++)
+	{
+		rgba_t col = pal->colour(a);
+		uint8_t rgba[4] = { col.r, col.g, col.b, col.a };
+		for (unsigned c = 0; c < 4; c++)
+			pal_hash = (pal_hash ^ rgba[c]) * 16777619u;
+	}
+
+	string key = S_FMT("%s %d %d %d %d %d %p %08x\n", name, width, height, extended ? 1 : 0, (int)image.getType(), force_rgba ? 1 : 0, parent, pal_hash);
+
+	// Patches
+	for (unsigned a = 0; a < patches.size(); a++)
+	{
+		if (extended)
+		{
+			// Textures used as patches can be changed without any resource
+			// being updated (eg. in the texture editor), so don't cache
+			if (getPatchTexture(patches[a], parent))
+				return "";
+
+			CTPatchEx* patch = (CTPatchEx*)patches[a];
+			rgba_t col = patch->getColour();
+			float alpha = patch->getAlpha();
+			uint32_t alpha_bits;
+			memcpy(&alpha_bits, &alpha, 4);
+			key += patch->asText();
+			key += S_FMT("%d %d %d %d %08x\n", col.r, col.g, col.b, col.a, alpha_bits);
+		}
+		else
+			key += S_FMT("\"%s\" %d %d\n", patches[a]->getName(), patches[a]->xOffset(), patches[a]->yOffset());
+	}
+
+	return key;
+}
@@ -124,6 +124,9 @@ private:
 	uint8_t			state;
 	TextureXList*	in_list;
 
+	CTexture*	getPatchTexture(CTPatch* patch, Archive* parent);
+	string		imageCacheKey(SImage& image, Archive* parent, Palette* pal, bool force_rgba);
+
 public:
 	CTexture(bool extended = false);
 	~CTexture();
@@ -181,6 +184,7 @@ public:
 	bool	convertExtended();
 	bool	convertRegular();
 	bool	loadPatchImage(unsigned pindex, SImage& image, Archive* parent = nullptr, Palette* pal = nullptr);
+	void	detectPatchTypes(Archive* parent = nullptr);
 	bool	toImage(SImage& image, Archive* parent = nullptr, Palette* pal = nullptr, bool force_rgba = false);
 
 	typedef std::unique_ptr<CTexture>	UPtr;
@@ -0,0 +1,260 @@
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    TextureImageCache.cpp
+// Description: TextureImageCache class, keeps decoded patch images and
+//              composited texture images (see CTexture::toImage) in memory,
+//              within a memory budget. Patch images are dropped when their
+//              entry changes, and texture images whenever any resource changes
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "TextureImageCache.h"
+#include "General/Misc.h"
+#include "General/ResourceManager.h"
+#include "Graphics/SImage/SImage.h"
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Int, texture_image_cache_size, 128, CVAR_SAVE)
+TextureImageCache* TextureImageCache::instance_ = nullptr;
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns the (approximate) memory used by [image]
+// -----------------------------------------------------------------------------
+size_t imageSize(SImage& image)
+{
+	size_t pixels = image.getWidth() * image.getHeight();
+	size_t size   = sizeof(SImage) + pixels * image.getBpp();
+	if (image.getType() == PALMASK)
+		size += pixels;
+
+	return size;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the memory budget in bytes
+// -----------------------------------------------------------------------------
+size_t maxSize()
+{
+	return texture_image_cache_size > 0 ? (size_t)texture_image_cache_size * 1024 * 1024 : 0;
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// TextureImageCache Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// TextureImageCache class constructor
+// -----------------------------------------------------------------------------
+TextureImageCache::TextureImageCache() : size_{ 0 }
+{
+	// Listen to the resource manager for changes
+	listenTo(theResourceManager);
+}
+
+// -----------------------------------------------------------------------------
+// TextureImageCache class destructor
+// -----------------------------------------------------------------------------
+TextureImageCache::~TextureImageCache() {}
+
+// -----------------------------------------------------------------------------
+// Loads the image in [entry] into [image], using the cached image if the entry
+// has been loaded before
+// -----------------------------------------------------------------------------
+bool TextureImageCache::loadPatch(ArchiveEntry* entry, SImage& image)
+{
+	if (!entry)
+		return false;
+
+	// Check cache
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto                        i = patches_.find(entry);
+		if (i != patches_.end())
+		{
+			items_.splice(items_.begin(), items_, i->second);
+			return image.copyImage(i->second->image.get());
+		}
+	}
+
+	// Not cached, load it
+	if (!Misc::loadImageFromEntry(&image, entry))
+		return false;
+
+	// Add to cache
+	Item item;
+	item.entry = entry;
+	item.image = std::make_unique<SImage>();
+	item.image->copyImage(&image);
+	add(std::move(item));
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Copies the cached texture image for [key] into [image].
+// Returns false if no image is cached for [key]
+// -----------------------------------------------------------------------------
+bool TextureImageCache::getTexture(const string& key, SImage& image)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	auto i = textures_.find(key);
+	if (i == textures_.end())
+		return false;
+
+	items_.splice(items_.begin(), items_, i->second);
+	return image.copyImage(i->second->image.get());
+}
+
+// -----------------------------------------------------------------------------
+// Adds a copy of the texture [image] to the cache as [key]
+// -----------------------------------------------------------------------------
+void TextureImageCache::storeTexture(const string& key, SImage& image)
+{
+	Item item;
+	item.key   = key;
+	item.image = std::make_unique<SImage>();
+	item.image->copyImage(&image);
+	add(std::move(item));
+}
+
+// -----------------------------------------------------------------------------
+// Clears all cached images
+// -----------------------------------------------------------------------------
+void TextureImageCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	items_.clear();
+	patches_.clear();
+	textures_.clear();
+	size_ = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Adds [item] to the cache as the most recently used image, removing least
+// recently used images if the cache is over its memory budget
+// -----------------------------------------------------------------------------
+void TextureImageCache::add(Item item)
+{
+	item.size = imageSize(*item.image);
+	if (item.size > maxSize())
+		return;
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	// Check it wasn't added while loading (by another thread)
+	if ((item.entry && patches_.find(item.entry) != patches_.end())
+		|| (!item.entry && textures_.find(item.key) != textures_.end()))
+		return;
+
+	// Add it
+	size_ += item.size;
+	items_.push_front(std::move(item));
+	if (items_.front().entry)
+		patches_[items_.front().entry] = items_.begin();
+	else
+		textures_[items_.front().key] = items_.begin();
+
+	// Remove least recently used images until within budget
+	while (size_ > maxSize() && !items_.empty())
+		remove(std::prev(items_.end()));
+}
+
+// -----------------------------------------------------------------------------
+// Removes [item] from the cache
+// -----------------------------------------------------------------------------
+void TextureImageCache::remove(ItemIter item)
+{
+	if (item->entry)
+		patches_.erase(item->entry);
+	else
+		textures_.erase(item->key);
+
+	size_ -= item->size;
+	items_.erase(item);
+}
+
+// -----------------------------------------------------------------------------
+// Removes all cached texture images
+// -----------------------------------------------------------------------------
+void TextureImageCache::clearTextures()
+{
+	for (auto& i : textures_)
+	{
+		size_ -= i.second->size;
+		items_.erase(i.second);
+	}
+	textures_.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Called when an announcement is recieved from the resource manager
+// -----------------------------------------------------------------------------
+void TextureImageCache::onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data)
+{
+	if (announcer != theResourceManager || event_name != "resources_updated")
+		return;
+
+	// A single entry was updated, remove its image
+	wxUIntPtr ptr;
+	event_data.seek(0, SEEK_SET);
+	if (event_data.read(&ptr, sizeof(wxUIntPtr)))
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		auto i = patches_.find((ArchiveEntry*)wxUIntToPtr(ptr));
+		if (i != patches_.end())
+			remove(i->second);
+
+		// Any texture could be affected (through a patch, or a patch being
+		// added that overrides another, etc.)
+		clearTextures();
+	}
+
+	// Otherwise a whole archive was added or removed
+	else
+		clear();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "General/ListenerAnnouncer.h"
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+class ArchiveEntry;
+class SImage;
+
+// Keeps decoded patch images and composited texture images in memory, so
+// patches shared by many textures are only decoded once and textures shown in
+// several places are only composited once. Least recently used images are
+// dropped when over the memory budget (texture_image_cache_size)
+class TextureImageCache : public Listener
+{
+public:
+	TextureImageCache();
+	~TextureImageCache();
+
+	static TextureImageCache* getInstance()
+	{
+		if (!instance_)
+			instance_ = new TextureImageCache();
+
+		return instance_;
+	}
+
+	bool loadPatch(ArchiveEntry* entry, SImage& image);
+	bool getTexture(const string& key, SImage& image);
+	void storeTexture(const string& key, SImage& image);
+	void clear();
+
+	void onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data) override;
+
+private:
+	// A cached image, either a decoded patch entry or a composited texture
+	struct Item
+	{
+		ArchiveEntry*           entry = nullptr; // Patch entry (nullptr for textures)
+		string                  key;             // Texture key (empty for patches)
+		std::unique_ptr<SImage> image;
+		size_t                  size = 0;
+	};
+	typedef std::list<Item>::iterator ItemIter;
+	typedef std::unordered_map<ArchiveEntry*, ItemIter> PatchMap;
+	typedef std::unordered_map<string, ItemIter, wxStringHash, wxStringEqual> TextureMap;
+
+	std::list<Item> items_; // Most recently used first
+	PatchMap        patches_;
+	TextureMap      textures_;
+	size_t          size_;
+	std::mutex      mutex_;
+
+	static TextureImageCache* instance_;
+
+	void add(Item item);
+	void remove(ItemIter item);
+	void clearTextures();
+};
@@ -0,0 +1,219 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    GfxConverter.cpp
+// Description: GfxConverter class, converts and encodes batches of images on
+//              worker threads, handing the results back in order on the
+//              calling thread
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "GfxConverter.h"
+#include "Graphics/Palette/Palette.h"
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns true if palettes [a] and [b] are identical
+// -----------------------------------------------------------------------------
+bool samePalette(Palette& a, Palette& b)
+{
+	if (a.transIndex() != b.transIndex())
+		return false;
+
+	for (unsigned c = 0; c < 256; c++)
+		if (!a.colour(c).equals(b.colour(c), true))
+			return false;
+
+	return true;
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// GfxConverter Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// GfxConverter class constructor
+// -----------------------------------------------------------------------------
+GfxConverter::GfxConverter(unsigned num_threads) : num_done_{ 0 }, pool_{ num_threads } {}
+
+// -----------------------------------------------------------------------------
+// GfxConverter class destructor
+// -----------------------------------------------------------------------------
+GfxConverter::~GfxConverter()
+{
+	pool_.cancelPending();
+	pool_.wait();
+}
+
+// -----------------------------------------------------------------------------
+// Adds a new item to the end of the batch and returns it
+// -----------------------------------------------------------------------------
+GfxConverter::Item& GfxConverter::addItem()
+{
+	items_.push_back(std::make_unique<Item>());
+	return *items_.back();
+}
+
+// -----------------------------------------------------------------------------
+// Returns a copy of [pal] that can be used by items in the batch.
+// Palettes passed in are often shared and changed between items (eg. a
+// PaletteChooser's archive palette), so items need their own copy. The
+// previous copy is reused if it's identical to [pal], which keeps the colour
+// matching cache of the palette warm across items
+// -----------------------------------------------------------------------------
+std::shared_ptr<Palette> GfxConverter::copyPalette(Palette* pal)
+{
+	if (!pal)
+		return nullptr;
+
+	if (!last_palette_ || !samePalette(*last_palette_, *pal))
+	{
+		last_palette_ = std::make_shared<Palette>();
+		last_palette_->copyPalette(pal);
+	}
+
+	return last_palette_;
+}
+
+// -----------------------------------------------------------------------------
+// Processes all items in the batch on the worker threads, calling [on_result]
+// for each item in order as its result becomes available. [on_progress] is
+// called periodically while waiting for results.
+// Returns false if either function returned false to stop the batch early,
+// in which case any remaining unstarted items are discarded
+// -----------------------------------------------------------------------------
+bool GfxConverter::run(const ResultFunc& on_result, const ProgressFunc& on_progress)
+{
+	// Queue everything
+	num_done_ = 0;
+	for (auto& item : items_)
+	{
+		Item* i = item.get();
+		pool_.queue([this, i]() { process(*i); });
+	}
+
+	// Hand back results in order
+	bool   ok    = true;
+	size_t total = items_.size();
+	for (size_t a = 0; a < total && ok; a++)
+	{
+		// Wait for the item to finish
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			while (items_[a]->status == Status::Pending)
+			{
+				if (cv_done_.wait_for(lock, std::chrono::milliseconds(50)) == std::cv_status::timeout && on_progress)
+				{
+					lock.unlock();
+					ok = on_progress(num_done_, total);
+					lock.lock();
+					if (!ok)
+						break;
+				}
+			}
+		}
+		if (!ok)
+			break;
+
+		// Hand it back and free it, it isn't needed anymore
+		ok = on_result(*items_[a], a);
+		items_[a].reset();
+
+		if (on_progress && ok)
+			ok = on_progress(std::max<size_t>(num_done_, a + 1), total);
+	}
+
+	// Discard anything left if stopped
+	if (!ok)
+	{
+		pool_.cancelPending();
+		pool_.wait();
+	}
+
+	items_.clear();
+	last_palette_.reset();
+
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+// Loads, converts and encodes [item] (called on a worker thread)
+// -----------------------------------------------------------------------------
+void GfxConverter::process(Item& item)
+{
+	Status status = Status::Ok;
+	string error;
+
+	// Load image if needed
+	if (!item.image.isValid() && !(item.loader && item.loader(item.image)))
+		status = Status::Invalid;
+
+	// Convert
+	else if (item.convert)
+	{
+		if (!item.format || item.format->canWrite(item.image) == SIFormat::NOTWRITABLE)
+			status = Status::NotWritable;
+		else
+		{
+			item.options.pal_current = item.pal_current.get();
+			item.options.pal_target  = item.pal_target.get();
+			item.format->convertWritable(item.image, item.options);
+		}
+	}
+
+	// Encode
+	if (status == Status::Ok && item.encode)
+	{
+		if (!item.format || !item.format->saveImage(item.image, item.data, item.pal_target.get(), 0, item.compression_level))
+		{
+			status = Status::Failed;
+			error  = Global::error;
+		}
+	}
+
+	// Done (the loader may hold on to things, release them here)
+	item.loader = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		item.status = status;
+		item.error  = error;
+	}
+	++num_done_;
+	cv_done_.notify_all();
+}
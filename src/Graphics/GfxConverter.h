@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Graphics/SImage/SIFormat.h"
+#include "Graphics/SImage/SImage.h"
+#include "Utility/ThreadPool.h"
+#include <atomic>
+
+class Palette;
+
+// Converts and/or encodes a batch of images to image formats on a pool of
+// worker threads. Results are handed back on the calling thread in the order
+// the items were added, so they can be written to entries (or anything else
+// that isn't thread safe) as they come in, and the end result is the same as
+// converting each image one after the other
+class GfxConverter
+{
+public:
+	enum class Status
+	{
+		Pending,
+		Ok,
+		Invalid,     // The image couldn't be loaded
+		NotWritable, // The image can't be written to the target format
+		Failed,      // Writing the image data failed
+	};
+
+	struct Item
+	{
+		// Loads the source image, called on a worker thread if [image] is not
+		// valid when the item is processed
+		std::function<bool(SImage&)> loader;
+
+		SImage                      image;
+		SIFormat*                   format  = nullptr;
+		bool                        convert = false; // Convert [image] with format->convertWritable
+		bool                        encode  = false; // Write [image] to [data] in [format]
+		SIFormat::convert_options_t options;
+		std::shared_ptr<Palette>    pal_current;
+		std::shared_ptr<Palette>    pal_target;
+		int                         compression_level = png_compression_level; // Read when the item is added
+
+		// Results
+		MemChunk data;
+		Status   status = Status::Pending;
+		string   error;
+	};
+
+	// Called for each item, in order. Return false to stop
+	typedef std::function<bool(Item& item, size_t index)> ResultFunc;
+
+	// Called periodically while waiting for results. Return false to stop
+	typedef std::function<bool(size_t done, size_t total)> ProgressFunc;
+
+	GfxConverter(unsigned num_threads = 0);
+	~GfxConverter();
+
+	size_t numItems() const { return items_.size(); }
+
+	Item&                    addItem();
+	std::shared_ptr<Palette> copyPalette(Palette* pal);
+	bool                     run(const ResultFunc& on_result, const ProgressFunc& on_progress = nullptr);
+
+private:
+	vector<std::unique_ptr<Item>> items_;
+	std::shared_ptr<Palette>      last_palette_;
+	std::atomic<size_t>           num_done_;
+	std::mutex                    mutex_;
+	std::condition_variable       cv_done_;
+	ThreadPool                    pool_; // Last, so workers are finished before anything else is destroyed
+
+	void process(Item& item);
+};
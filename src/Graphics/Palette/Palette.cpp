@@ -37,6 +37,8 @@
 #include "Graphics/SImage/SIFormat.h"
 #include "Utility/Tokenizer.h"
 #include "Utility/CIEDeltaEquations.h"
+#include <atomic>
+#include <mutex>
 
 
 // ----------------------------------------------------------------------------
@@ -56,6 +58,133 @@ EXTERN_CVAR(Float, col_greyscale_g);
 EXTERN_CVAR(Float, col_greyscale_b);
 
 
+// ----------------------------------------------------------------------------
+//
+// Palette::MatchCache Struct
+//
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+// Palette::MatchCache
+//
+// Cache of nearestColour results for each colour matching method. Entries are
+// keyed on the full 24-bit RGB value (so results are always identical to a
+// full search) and hold the nearest index + 1, or 0 if the colour hasn't been
+// looked up yet. Entries are split into pages of 65536 (one per red value)
+// which are allocated on first use.
+//
+// Lookups don't lock, so worker threads converting images with the same
+// palette can share (and fill) the cache. Changing the palette itself while
+// it is being used from another thread isn't safe, same as before
+// ----------------------------------------------------------------------------
+struct Palette::MatchCache
+{
+	typedef std::atomic<uint16_t> entry_t;
+
+	static const int N_MODES = (int)ColourMatch::Stop - 1;	// Old..C2K
+	static const int N_WEIGHTS = 6;
+	static const int PAGE_SIZE = 65536;
+
+	std::atomic<entry_t*>	pages[N_MODES][256];
+	std::atomic<double>		weights[N_WEIGHTS];	// col_match_* weights the cache was filled with
+	std::atomic<bool>		filled;
+	std::mutex				mutex;
+
+	MatchCache() : filled{ false }
+	{
+		for (auto& mode : pages)
+			for (auto& page : mode)
+				page.store(nullptr, std::memory_order_relaxed);
+
+		double current[N_WEIGHTS];
+		currentWeights(current);
+		for (int a = 0; a < N_WEIGHTS; a++)
+			weights[a].store(current[a], std::memory_order_relaxed);
+	}
+
+	~MatchCache()
+	{
+		clear();
+	}
+
+	static void currentWeights(double* current)
+	{
+		current[0] = col_match_r;
+		current[1] = col_match_g;
+		current[2] = col_match_b;
+		current[3] = col_match_h;
+		current[4] = col_match_s;
+		current[5] = col_match_l;
+	}
+
+	// Returns the entry page for [red] in [mode], allocating it if needed
+	entry_t* page(int mode, uint8_t red)
+	{
+		entry_t* p = pages[mode][red].load(std::memory_order_acquire);
+		if (p)
+			return p;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		p = pages[mode][red].load(std::memory_order_relaxed);
+		if (!p)
+		{
+			p = new entry_t[PAGE_SIZE];
+			for (int a = 0; a < PAGE_SIZE; a++)
+				p[a].store(0, std::memory_order_relaxed);
+			pages[mode][red].store(p, std::memory_order_release);
+			filled.store(true, std::memory_order_relaxed);
+		}
+
+		return p;
+	}
+
+	// Forgets the cached RGB and HSL results if the col_match_* weights have
+	// changed since they were looked up. Pages are zeroed rather than freed
+	// here since other threads may be reading from them
+	void checkWeights()
+	{
+		double current[N_WEIGHTS];
+		currentWeights(current);
+
+		bool changed = false;
+		for (int a = 0; a < N_WEIGHTS; a++)
+			if (weights[a].load(std::memory_order_relaxed) != current[a])
+				changed = true;
+		if (!changed)
+			return;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		for (int a = 0; a < N_WEIGHTS; a++)
+			weights[a].store(current[a], std::memory_order_relaxed);
+		for (auto mode : { ColourMatch::RGB, ColourMatch::HSL })
+			for (auto& page : pages[(int)mode - 1])
+			{
+				entry_t* p = page.load(std::memory_order_relaxed);
+				if (p)
+					for (int a = 0; a < PAGE_SIZE; a++)
+						p[a].store(0, std::memory_order_relaxed);
+			}
+	}
+
+	// Frees all cached results
+	void clear()
+	{
+		if (!filled.load(std::memory_order_relaxed))
+			return;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto& mode : pages)
+			for (auto& page : mode)
+			{
+				delete[] page.load(std::memory_order_relaxed);
+				page.store(nullptr, std::memory_order_relaxed);
+			}
+		filled.store(false, std::memory_order_relaxed);
+	}
+};
+
+
 // ----------------------------------------------------------------------------
 //
 // Palette Class Functions
@@ -72,7 +201,8 @@ Palette::Palette(unsigned size) :
 	colours_{ size },
 	colours_hsl_{ size },
 	colours_lab_{ size },
-	index_trans_{ -1 }
+	index_trans_{ -1 },
+	match_cache_{ new MatchCache() }
 {
 	// Init palette (to greyscale)
 	for (unsigned a = 0; a < size; a++)
@@ -105,6 +235,7 @@ bool Palette::loadMem(MemChunk& mc)
 		return false;
 
 	// Read in colours
+	clearMatchCache();
 	mc.seek(0, SEEK_SET);
 	int c = 0;
 	for (size_t a = 0; a < mc.getSize(); a += 3)
@@ -141,6 +272,7 @@ bool Palette::loadMem(const uint8_t* data, uint32_t size)
 		return false;
 
 	// Read in colours
+	clearMatchCache();
 	int c = 0;
 	for (size_t a = 0; a < size; a += 3)
 	{
@@ -443,6 +575,7 @@ void Palette::setColour(uint8_t index, rgba_t col)
 {
 	colours_[index].set(col);
 	colours_[index].index = index;
+	clearMatchCache();
 	colours_lab_[index] = Misc::rgbToLab(col.dr(), col.dg(), col.db());
 	colours_hsl_[index] = Misc::rgbToHsl(col.dr(), col.dg(), col.db());
 }
@@ -455,6 +588,7 @@ void Palette::setColour(uint8_t index, rgba_t col)
 void Palette::setColourR(uint8_t index, uint8_t val)
 {
 	colours_[index].r = val;
+	clearMatchCache();
 	colours_lab_[index] = Misc::rgbToLab(colours_[index].dr(), colours_[index].dg(), colours_[index].db());
 	colours_hsl_[index] = Misc::rgbToHsl(colours_[index].dr(), colours_[index].dg(), colours_[index].db());
 }
@@ -467,6 +601,7 @@ void Palette::setColourR(uint8_t index, uint8_t val)
 void Palette::setColourG(uint8_t index, uint8_t val)
 {
 	colours_[index].g = val;
+	clearMatchCache();
 	colours_lab_[index] = Misc::rgbToLab(colours_[index].dr(), colours_[index].dg(), colours_[index].db());
 	colours_hsl_[index] = Misc::rgbToHsl(colours_[index].dr(), colours_[index].dg(), colours_[index].db());
 }
@@ -479,6 +614,7 @@ void Palette::setColourG(uint8_t index, uint8_t val)
 void Palette::setColourB(uint8_t index, uint8_t val)
 {
 	colours_[index].b = val;
+	clearMatchCache();
 	colours_lab_[index] = Misc::rgbToLab(colours_[index].dr(), colours_[index].dg(), colours_[index].db());
 	colours_hsl_[index] = Misc::rgbToHsl(colours_[index].dr(), colours_[index].dg(), colours_[index].db());
 }
@@ -492,6 +628,7 @@ void Palette::setGradient(uint8_t startIndex, uint8_t endIndex, rgba_t startCol,
 {
 	rgba_t gradCol = rgba_t();
 	int range = endIndex - startIndex;
+	clearMatchCache();
 	
 	float r_range = endCol.fr() - startCol.fr();
 	float g_range = endCol.fg() - startCol.fg();
@@ -551,6 +688,17 @@ short Palette::findColour(rgba_t colour)
 	return -1;
 }
 
+// ----------------------------------------------------------------------------
+// Palette::clearMatchCache
+//
+// Clears cached nearestColour results, must be called whenever any colour in
+// the palette is changed
+// ----------------------------------------------------------------------------
+void Palette::clearMatchCache()
+{
+	match_cache_->clear();
+}
+
 // ----------------------------------------------------------------------------
 // Palette::colourDiff
 //
@@ -601,15 +749,12 @@ double Palette::colourDiff(rgba_t& rgb, hsl_t& hsl, lab_t& lab, int index, Colou
 // ----------------------------------------------------------------------------
 // Palette::nearestColour
 //
-// Returns the index of the closest colour in the palette to [colour]
+// Returns the index of the closest colour in the palette to [colour]. Results
+// are cached per matching method, so each distinct colour is only searched for
+// once until the palette changes
 // ----------------------------------------------------------------------------
 short Palette::nearestColour(rgba_t colour, ColourMatch match)
 {
-	double min_d = 999999;
-	short index = 0;
-	hsl_t chsl = Misc::rgbToHsl(colour);
-	lab_t clab = Misc::rgbToLab(colour);
-
 	// Be nice if there was an easier way to convert from int -> enum class,
 	// but then that's kind of the point of them I guess
 	static vector<ColourMatch> cm_convert =
@@ -626,6 +771,37 @@ short Palette::nearestColour(rgba_t colour, ColourMatch match)
 	if (match == ColourMatch::Default)
 		match = cm_convert[col_match];
 
+	// Anything else is matched the same way as Old by colourDiff
+	if (match <= ColourMatch::Default || match >= ColourMatch::Stop)
+		match = ColourMatch::Old;
+
+	// Check the cache first
+	if (match == ColourMatch::RGB || match == ColourMatch::HSL)
+		match_cache_->checkWeights();
+	auto& entry = match_cache_->page((int)match - 1, colour.r)[(colour.g << 8) | colour.b];
+	uint16_t cached = entry.load(std::memory_order_relaxed);
+	if (cached)
+		return cached - 1;
+
+	short index = nearestColourSearch(colour, match);
+	entry.store(index + 1, std::memory_order_relaxed);
+
+	return index;
+}
+
+// ----------------------------------------------------------------------------
+// Palette::nearestColourSearch
+//
+// Returns the index of the closest colour in the palette to [colour], by
+// comparing against every colour in the palette
+// ----------------------------------------------------------------------------
+short Palette::nearestColourSearch(rgba_t colour, ColourMatch match)
+{
+	double min_d = 999999;
+	short index = 0;
+	hsl_t chsl = Misc::rgbToHsl(colour);
+	lab_t clab = Misc::rgbToLab(colour);
+
 	double delta;
 	for (short a = 0; a < 256; a++)
 	{
@@ -42,6 +42,7 @@ public:
 	void	setColourR(uint8_t index, uint8_t val);
 	void	setColourG(uint8_t index, uint8_t val);
 	void	setColourB(uint8_t index, uint8_t val);
+	// (Alpha isn't used for colour matching, so no need to clear the cache)
 	void	setColourA(uint8_t index, uint8_t val)	{ colours_[index].a = val; }
 	void	setTransIndex(short index)				{ index_trans_ = index; }
 	
@@ -71,5 +72,11 @@ private:
 	vector<lab_t>	colours_lab_;
 	short			index_trans_;
 
+	// Cache of nearestColour results (see Palette.cpp)
+	struct MatchCache;
+	std::unique_ptr<MatchCache>	match_cache_;
+
+	void	clearMatchCache();
+	short	nearestColourSearch(rgba_t colour, ColourMatch match);
 	double	colourDiff(rgba_t& rgb, hsl_t& hsl, lab_t& lab, int index, ColourMatch match);
 };
@@ -108,6 +108,79 @@ private:
 
 protected:
 	bool readImage(SImage& image, MemChunk& data, int index)
+	{
+		// Decode directly if possible
+		PNGCodec::Info info;
+		if (PNGCodec::readInfo(data.getData(), data.getSize(), info)
+			&& PNGCodec::canDecode(info)
+			&& readImageDirect(image, data, info))
+			return true;
+
+		// Otherwise (eg. interlaced) go through FreeImage
+		return readImageFreeImage(image, data);
+	}
+
+	// Decodes PNG [data] with [info] straight into [image]. 8-bit paletted
+	// and greyscale images are read as paletted (or alpha maps if there is
+	// an alPh chunk) and everything else as RGBA, as with FreeImage
+	bool readImageDirect(SImage& image, MemChunk& data, PNGCodec::Info& info)
+	{
+		// Get image type and palette
+		SIType type = RGBA;
+		Palette palette;
+		if (info.indexed())
+		{
+			type = info.alph ? ALPHAMAP : PALMASK;
+			if (info.colour_type == PNGCodec::INDEXED)
+			{
+				for (unsigned a = 0; a < info.palette_size; a++)
+					palette.setColour(a, info.palette[a]);
+			}
+			else
+			{
+				for (unsigned a = 0; a < 256; a++)
+					palette.setColour(a, rgba_t(a, a, a, 255));
+			}
+		}
+
+		// Create image and decode to it
+		image.create(info.width, info.height, type, type == RGBA ? nullptr : &palette);
+		uint8_t* img_data = imageData(image);
+		if (!PNGCodec::decode(data.getData(), info, img_data))
+			return false;
+
+		// Set mask
+		if (type == PALMASK)
+		{
+			uint8_t* mask = imageMask(image);
+			unsigned count = info.width * info.height;
+			if (info.trans_size > 0)
+			{
+				uint8_t alphatable[256];
+				memset(alphatable, 255, 256);
+				memcpy(alphatable, info.trans, info.trans_size);
+				for (unsigned a = 0; a < count; a++)
+					mask[a] = alphatable[img_data[a]];
+			}
+			else if (info.trans_key)
+			{
+				for (unsigned a = 0; a < count; a++)
+					mask[a] = img_data[a] == info.key[0] ? 0 : 255;
+			}
+			else
+				image.fillAlpha(255);
+		}
+
+		// Set offsets
+		image.setXOffset(info.xoff);
+		image.setYOffset(info.yoff);
+
+		return true;
+	}
+
+	// Reads PNG [data] to [image] via FreeImage, for images readImageDirect
+	// can't handle
+	bool readImageFreeImage(SImage& image, MemChunk& data)
 	{
 		// Create FreeImage bitmap from entry data
 		FIMEMORY* mem = FreeImage_OpenMemory((BYTE*)data.getData(), data.getSize());
@@ -254,37 +327,46 @@ protected:
 		return true;
 	}
 
-	bool writeImage(SImage& image, MemChunk& data, Palette* pal, int index)
+	bool writeImage(SImage& image, MemChunk& data, Palette* pal, int index, int level)
 	{
 		// Variables
-		FIBITMAP*	bm = nullptr;
 		uint8_t*	img_data = imageData(image);
 		uint8_t*	img_mask = imageMask(image);
 		int			type = image.getType();
 		int			width = image.getWidth();
 		int			height = image.getHeight();
 
+		// Get PNG colour type
+		uint8_t coltype;
 		if (type == RGBA)
-		{
-			// Init 32bpp FIBITMAP
-			bm = FreeImage_Allocate(width, height, 32, 0x0000FF00, 0x00FF0000, 0x000000FF);
-
-			// Write image data
-			uint8_t* bits = FreeImage_GetBits(bm);
-			uint32_t c = 0;
-			for (int a = 0; a < width * height * 4; a += 4)
-			{
-				bits[c++] = img_data[a+2];
-				bits[c++] = img_data[a+1];
-				bits[c++] = img_data[a];
-				bits[c++] = img_data[a+3];
-			}
-		}
+			coltype = PNGCodec::TRUECOLOUR_ALPHA;
 		else if (type == PALMASK)
+			coltype = PNGCodec::INDEXED;
+		else if (type == ALPHAMAP)
+			coltype = PNGCodec::GREYSCALE;
+		else
+			return false;
+
+		// Write PNG header and IHDR
+		data.clear();
+		PNGCodec::writeHeader(data, width, height, 8, coltype);
+
+		// Create grAb chunk with offsets (only if offsets exist)
+		if (image.offset().x != 0 || image.offset().y != 0)
 		{
-			// Init 8bpp FIBITMAP
-			bm = FreeImage_Allocate(width, height, 8);
+			PNGChunk grAb("grAb");
+			grab_chunk_t gc = { wxINT32_SWAP_ON_LE((int32_t)image.offset().x), wxINT32_SWAP_ON_LE((int32_t)image.offset().y) };
+			grAb.setData((const uint8_t*)&gc, 8);
+			grAb.write(data);
+		}
 
+		// Create alPh chunk if it's an alpha map
+		if (type == ALPHAMAP)
+			PNGCodec::writeChunk(data, "alPh", nullptr, 0);
+
+		// Write palette
+		if (type == PALMASK)
+		{
 			// Get palette to use
 			Palette usepal;
 			if (image.hasPalette())
@@ -292,121 +374,55 @@ protected:
 			else if (pal)
 				usepal.copyPalette(pal);
 
-			// Set palette
-			RGBQUAD* bm_pal = FreeImage_GetPalette(bm);
-			for (int a = 0; a < 256; a++)
-			{
-				bm_pal[a].rgbRed = usepal.colour(a).r;
-				bm_pal[a].rgbGreen = usepal.colour(a).g;
-				bm_pal[a].rgbBlue = usepal.colour(a).b;
-			}
-
 			// Handle transparency if needed
-			if (img_mask)
+			if (img_mask && usepal.transIndex() < 0)
 			{
-				if (usepal.transIndex() < 0)
-				{
-					// Find unused colour (for transparency)
-					short unused = image.findUnusedColour();
+				// Find unused colour (for transparency)
+				short unused = image.findUnusedColour();
 
-					// Set any transparent pixels to this colour (if we found an unused colour)
-					bool has_trans = false;
-					if (unused >= 0)
+				// Set any transparent pixels to this colour (if we found an unused colour)
+				bool has_trans = false;
+				if (unused >= 0)
+				{
+					for (int a = 0; a < width * height; a++)
 					{
-						for (int a = 0; a < width * height; a++)
+						if (img_mask[a] == 0)
 						{
-							if (img_mask[a] == 0)
-							{
-								img_data[a] = unused;
-								has_trans = true;
-							}
+							img_data[a] = unused;
+							has_trans = true;
 						}
-
-						// Set palette transparency
-						if (has_trans)
-							usepal.setTransIndex(unused);
 					}
-				}
 
-				// Set freeimage palette transparency if needed
-				if (usepal.transIndex() >= 0)
-					FreeImage_SetTransparentIndex(bm, usepal.transIndex());
-			}
-
-			// Write image data
-			for (int row = 0; row < height; row++)
-			{
-				uint8_t* scanline = FreeImage_GetScanLine(bm, row);
-				memcpy(scanline, img_data + (row * width), width);
+					// Set palette transparency
+					if (has_trans)
+						usepal.setTransIndex(unused);
+				}
 			}
-		}
-		else if (type == ALPHAMAP)
-		{
-			// Init 8bpp FIBITMAP
-			bm = FreeImage_Allocate(width, height, 8);
 
-			// Set palette (greyscale)
-			RGBQUAD* bm_pal = FreeImage_GetPalette(bm);
+			// PLTE chunk
+			uint8_t plte[768];
 			for (int a = 0; a < 256; a++)
 			{
-				bm_pal[a].rgbRed = a;
-				bm_pal[a].rgbGreen = a;
-				bm_pal[a].rgbBlue = a;
+				plte[a * 3] = usepal.colour(a).r;
+				plte[a * 3 + 1] = usepal.colour(a).g;
+				plte[a * 3 + 2] = usepal.colour(a).b;
 			}
+			PNGCodec::writeChunk(data, "PLTE", plte, 768);
 
-			// Write image data
-			for (int row = 0; row < height; row++)
+			// tRNS chunk (only up to the transparent index, the rest are opaque)
+			if (img_mask && usepal.transIndex() >= 0)
 			{
-				uint8_t* scanline = FreeImage_GetScanLine(bm, row);
-				memcpy(scanline, img_data + (row * width), width);
+				uint8_t trns[256];
+				memset(trns, 255, 256);
+				trns[usepal.transIndex()] = 0;
+				PNGCodec::writeChunk(data, "tRNS", trns, usepal.transIndex() + 1);
 			}
 		}
-		else
-			return false;
 
-		// Flip the image
-		FreeImage_FlipVertical(bm);
-
-		// Write the image to a temp file
-		FreeImage_Save(FIF_PNG, bm, CHR(App::path("temp.png", App::Dir::Temp)));
-
-		// Load it into a memchunk
-		MemChunk png;
-		png.importFile(App::path("temp.png", App::Dir::Temp));
-
-		// Check it loaded ok
-		if (png.getSize() == 0)
-		{
-			LOG_MESSAGE(1, "Error reading temporary file");
+		// Write image data
+		if (!PNGCodec::writeImageData(data, img_data, width, height, coltype, level))
 			return false;
-		}
-
-		// Write PNG header and IHDR
-		const uint8_t* png_data = png.getData();
-		data.clear();
-		data.write(png_data, 33);
-
-		// Create grAb chunk with offsets (only if offsets exist)
-		if (image.offset().x != 0 || image.offset().y != 0)
-		{
-			PNGChunk grAb("grAb");
-			grab_chunk_t gc = { wxINT32_SWAP_ON_LE((int32_t)image.offset().x), wxINT32_SWAP_ON_LE((int32_t)image.offset().y) };
-			grAb.setData((const uint8_t*)&gc, 8);
-			grAb.write(data);
-		}
-
-		// Create alPh chunk if it's an alpha map
-		if (type == ALPHAMAP)
-		{
-			PNGChunk alPh("alPh");
-			alPh.write(data);
-		}
-
-		// Write remaining PNG data
-		data.write(png_data + 33, png.getSize() - 33);
-
-		// Clean up
-		wxRemoveFile(App::path("temp.png", App::Dir::Temp));
+		PNGCodec::writeEnd(data);
 
 		// Success
 		return true;
@@ -568,6 +584,6 @@ public:
 		MemChunk mc;
 		image.setXOffset(offset.x);
 		image.setYOffset(offset.y);
-		return (writeImage(image, mc, nullptr, 0) && entry->importMemChunk(mc));
+		return (writeImage(image, mc, nullptr, 0, png_compression_level) && entry->importMemChunk(mc));
 	}
 };
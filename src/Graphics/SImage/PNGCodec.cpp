@@ -0,0 +1,667 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    PNGCodec.cpp
+// Description: Functions to read and write PNG data directly with zlib, without
+//              going through FreeImage bitmaps
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "PNGCodec.h"
+#include "External/zlib/zlib.h"
+
+using namespace PNGCodec;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+const uint8_t png_signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+// Number of samples per pixel for each colour type
+const unsigned channels[7] = { 1, 0, 3, 1, 2, 0, 4 };
+
+// Largest image (in pixels) that will be decoded, so that RGBA buffer sizes
+// always fit in an int (as used by SImage)
+const uint64_t max_pixels = 0x1FFFFFFF;
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Reads a big-endian 32-bit value from [data]
+// -----------------------------------------------------------------------------
+uint32_t readU32(const uint8_t* data)
+{
+	return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+}
+
+// -----------------------------------------------------------------------------
+// Reads a big-endian 16-bit value from [data]
+// -----------------------------------------------------------------------------
+uint16_t readU16(const uint8_t* data)
+{
+	return (uint16_t)((data[0] << 8) | data[1]);
+}
+
+// -----------------------------------------------------------------------------
+// Writes [value] to [out] as a big-endian 32-bit value
+// -----------------------------------------------------------------------------
+void writeU32(uint8_t* out, uint32_t value)
+{
+	out[0] = value >> 24;
+	out[1] = value >> 16;
+	out[2] = value >> 8;
+	out[3] = value;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the [x]th [depth]-bit sample in the packed (< 8-bit) row [row]
+// -----------------------------------------------------------------------------
+inline unsigned sample(const uint8_t* row, unsigned x, unsigned depth)
+{
+	unsigned bit = x * depth;
+	return (row[bit >> 3] >> (8 - depth - (bit & 7))) & ((1 << depth) - 1);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the Paeth predictor for [a] (left), [b] (above) and [c] (above left)
+// -----------------------------------------------------------------------------
+inline uint8_t paeth(int a, int b, int c)
+{
+	int p  = a + b - c;
+	int pa = abs(p - a);
+	int pb = abs(p - b);
+	int pc = abs(p - c);
+
+	if (pa <= pb && pa <= pc)
+		return a;
+	if (pb <= pc)
+		return b;
+	return c;
+}
+
+// -----------------------------------------------------------------------------
+// Reverses [filter] on [row] ([size] bytes), given the previous (unfiltered)
+// row [prev] and [bpp] bytes per pixel. Returns false if [filter] is invalid
+// -----------------------------------------------------------------------------
+bool unfilterRow(uint8_t filter, uint8_t* row, const uint8_t* prev, size_t size, unsigned bpp)
+{
+	switch (filter)
+	{
+	case 0: // None
+		return true;
+
+	case 1: // Sub
+		for (size_t a = bpp; a < size; a++)
+			row[a] += row[a - bpp];
+		return true;
+
+	case 2: // Up
+		for (size_t a = 0; a < size; a++)
+			row[a] += prev[a];
+		return true;
+
+	case 3: // Average
+		for (size_t a = 0; a < bpp; a++)
+			row[a] += prev[a] >> 1;
+		for (size_t a = bpp; a < size; a++)
+			row[a] += (row[a - bpp] + prev[a]) >> 1;
+		return true;
+
+	case 4: // Paeth
+		for (size_t a = 0; a < bpp; a++)
+			row[a] += prev[a];
+		for (size_t a = bpp; a < size; a++)
+			row[a] += paeth(row[a - bpp], prev[a], prev[a - bpp]);
+		return true;
+
+	default: return false;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Applies [filter] to [row] ([size] bytes) into [out], given the previous row
+// [prev] (nullptr for the first row) and [bpp] bytes per pixel.
+// Returns the sum of the filtered bytes as signed values, the usual heuristic
+// for picking a filter
+// -----------------------------------------------------------------------------
+unsigned filterRow(uint8_t filter, const uint8_t* row, const uint8_t* prev, uint8_t* out, size_t size, unsigned bpp)
+{
+	unsigned sum = 0;
+	for (size_t a = 0; a < size; a++)
+	{
+		int left    = a >= bpp ? row[a - bpp] : 0;
+		int up      = prev ? prev[a] : 0;
+		int up_left = (prev && a >= bpp) ? prev[a - bpp] : 0;
+
+		uint8_t v;
+		switch (filter)
+		{
+		case 1: v = row[a] - left; break;
+		case 2: v = row[a] - up; break;
+		case 3: v = row[a] - ((left + up) >> 1); break;
+		case 4: v = row[a] - paeth(left, up, up_left); break;
+		default: v = row[a]; break;
+		}
+
+		out[a] = v;
+		sum += abs((int8_t)v);
+	}
+
+	return sum;
+}
+
+// -----------------------------------------------------------------------------
+// Converts the unfiltered [row] of an image with [info] to RGBA pixels in [out]
+// -----------------------------------------------------------------------------
+void rowToRGBA(const uint8_t* row, const Info& info, uint8_t* out)
+{
+	unsigned depth = info.bit_depth;
+	unsigned width = info.width;
+
+	switch (info.colour_type)
+	{
+	case GREYSCALE:
+		for (unsigned x = 0; x < width; x++, out += 4)
+		{
+			unsigned v, g;
+			if (depth == 16)
+			{
+				v = readU16(row + x * 2);
+				g = v >> 8;
+			}
+			else if (depth == 8)
+				v = g = row[x];
+			else
+			{
+				v = sample(row, x, depth);
+				g = v * 255 / ((1 << depth) - 1);
+			}
+
+			out[0] = out[1] = out[2] = g;
+			out[3] = (info.trans_key && v == info.key[0]) ? 0 : 255;
+		}
+		break;
+
+	case TRUECOLOUR:
+		for (unsigned x = 0; x < width; x++, out += 4)
+		{
+			bool key;
+			if (depth == 16)
+			{
+				const uint8_t* p = row + x * 6;
+				out[0]           = p[0];
+				out[1]           = p[2];
+				out[2]           = p[4];
+				key = info.trans_key && readU16(p) == info.key[0] && readU16(p + 2) == info.key[1]
+					  && readU16(p + 4) == info.key[2];
+			}
+			else
+			{
+				const uint8_t* p = row + x * 3;
+				out[0]           = p[0];
+				out[1]           = p[1];
+				out[2]           = p[2];
+				key = info.trans_key && p[0] == info.key[0] && p[1] == info.key[1] && p[2] == info.key[2];
+			}
+
+			out[3] = key ? 0 : 255;
+		}
+		break;
+
+	case INDEXED:
+		for (unsigned x = 0; x < width; x++, out += 4)
+		{
+			unsigned i = depth == 8 ? row[x] : sample(row, x, depth);
+			if (i < info.palette_size)
+			{
+				out[0] = info.palette[i].r;
+				out[1] = info.palette[i].g;
+				out[2] = info.palette[i].b;
+			}
+			else
+				out[0] = out[1] = out[2] = 0;
+			out[3] = i < info.trans_size ? info.trans[i] : 255;
+		}
+		break;
+
+	case GREYSCALE_ALPHA:
+	{
+		unsigned step = depth == 16 ? 4 : 2;
+		unsigned alpha = depth == 16 ? 2 : 1;
+		for (unsigned x = 0; x < width; x++, out += 4, row += step)
+		{
+			out[0] = out[1] = out[2] = row[0];
+			out[3]                   = row[alpha];
+		}
+		break;
+	}
+
+	case TRUECOLOUR_ALPHA:
+		if (depth == 8)
+			memcpy(out, row, width * 4);
+		else
+		{
+			for (unsigned x = 0; x < width; x++, out += 4, row += 8)
+			{
+				out[0] = row[0];
+				out[1] = row[2];
+				out[2] = row[4];
+				out[3] = row[6];
+			}
+		}
+		break;
+
+	default: break;
+	}
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// PNGCodec Namespace Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Reads image info from the chunks of the PNG [data] ([size] bytes) into
+// [info]. Returns false if the data isn't a valid PNG
+// -----------------------------------------------------------------------------
+bool PNGCodec::readInfo(const uint8_t* data, size_t size, Info& info)
+{
+	if (size < 8 || memcmp(data, png_signature, 8) != 0)
+	{
+		Global::error = "Invalid PNG signature";
+		return false;
+	}
+
+	bool   ihdr = false;
+	size_t pos  = 8;
+	while (pos + 12 <= size)
+	{
+		uint32_t       length = readU32(data + pos);
+		const char*    name   = (const char*)data + pos + 4;
+		const uint8_t* cdata  = data + pos + 8;
+		if (length > size - pos - 12)
+		{
+			Global::error = "Invalid PNG chunk size";
+			return false;
+		}
+
+		// Header
+		if (memcmp(name, "IHDR", 4) == 0)
+		{
+			if (length < 13 || cdata[10] != 0 || cdata[11] != 0)
+			{
+				Global::error = "Invalid PNG header";
+				return false;
+			}
+
+			info.width       = readU32(cdata);
+			info.height      = readU32(cdata + 4);
+			info.bit_depth   = cdata[8];
+			info.colour_type = cdata[9];
+			info.interlace   = cdata[12];
+			ihdr             = true;
+		}
+
+		// Palette
+		else if (memcmp(name, "PLTE", 4) == 0)
+		{
+			info.palette_size = std::min<unsigned>(length / 3, 256);
+			for (unsigned a = 0; a < info.palette_size; a++)
+				info.palette[a] = rgba_t(cdata[a * 3], cdata[a * 3 + 1], cdata[a * 3 + 2], 255);
+		}
+
+		// Transparency
+		else if (memcmp(name, "tRNS", 4) == 0)
+		{
+			if (info.colour_type == INDEXED)
+			{
+				info.trans_size = std::min<unsigned>(length, 256);
+				memcpy(info.trans, cdata, info.trans_size);
+			}
+			else if (info.colour_type == GREYSCALE && length >= 2)
+			{
+				info.key[0]    = readU16(cdata);
+				info.trans_key = true;
+			}
+			else if (info.colour_type == TRUECOLOUR && length >= 6)
+			{
+				info.key[0]    = readU16(cdata);
+				info.key[1]    = readU16(cdata + 2);
+				info.key[2]    = readU16(cdata + 4);
+				info.trans_key = true;
+			}
+		}
+
+		// Offsets (only before image data, as with SIFPng::getInfo)
+		else if (memcmp(name, "grAb", 4) == 0 && info.idat.empty())
+		{
+			if (!info.grab && length >= 8)
+			{
+				info.xoff = (int32_t)readU32(cdata);
+				info.yoff = (int32_t)readU32(cdata + 4);
+				info.grab = true;
+			}
+		}
+
+		// Alpha map
+		else if (memcmp(name, "alPh", 4) == 0 && info.idat.empty())
+			info.alph = true;
+
+		// Image data
+		else if (memcmp(name, "IDAT", 4) == 0)
+			info.idat.push_back({ pos + 8, length });
+
+		// End
+		else if (memcmp(name, "IEND", 4) == 0)
+			break;
+
+		pos += 12 + length;
+	}
+
+	if (!ihdr || info.idat.empty())
+	{
+		Global::error = "Invalid PNG data";
+		return false;
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if an image with [info] can be decoded by decode
+// -----------------------------------------------------------------------------
+bool PNGCodec::canDecode(const Info& info)
+{
+	if (info.width == 0 || info.height == 0 || (uint64_t)info.width * info.height > max_pixels)
+		return false;
+
+	if (info.interlace != 0)
+		return false;
+
+	switch (info.colour_type)
+	{
+	case GREYSCALE:
+		return info.bit_depth == 1 || info.bit_depth == 2 || info.bit_depth == 4 || info.bit_depth == 8
+			   || info.bit_depth == 16;
+	case INDEXED: return info.bit_depth == 1 || info.bit_depth == 2 || info.bit_depth == 4 || info.bit_depth == 8;
+	case TRUECOLOUR:
+	case GREYSCALE_ALPHA:
+	case TRUECOLOUR_ALPHA: return info.bit_depth == 8 || info.bit_depth == 16;
+	default: return false;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Decodes the image data of the PNG [data] (with [info], read by readInfo)
+// into [out], which must be width * height bytes if info.indexed() is true
+// (8-bit palette indices or greyscale values), or width * height * 4 bytes of
+// RGBA otherwise. The data is inflated and unfiltered one row at a time
+// -----------------------------------------------------------------------------
+bool PNGCodec::decode(const uint8_t* data, const Info& info, uint8_t* out)
+{
+	if (!canDecode(info))
+	{
+		Global::error = "Unsupported PNG format";
+		return false;
+	}
+
+	unsigned bits      = channels[info.colour_type] * info.bit_depth;
+	unsigned bpp       = std::max(1u, bits / 8);
+	size_t   row_size  = ((size_t)info.width * bits + 7) / 8;
+	size_t   out_pitch = (size_t)info.width * (info.indexed() ? 1 : 4);
+
+	// Rows, with the filter type byte first
+	vector<uint8_t> row(row_size + 1);
+	vector<uint8_t> prev(row_size + 1, 0);
+
+	z_stream strm;
+	strm.zalloc   = nullptr;
+	strm.zfree    = nullptr;
+	strm.opaque   = nullptr;
+	strm.next_in  = nullptr;
+	strm.avail_in = 0;
+	if (inflateInit(&strm) != Z_OK)
+	{
+		Global::error = "Error initialising zlib";
+		return false;
+	}
+
+	bool   ok   = true;
+	size_t idat = 0;
+	for (unsigned y = 0; y < info.height && ok; y++)
+	{
+		// Inflate the next row, feeding IDAT chunks in as needed
+		strm.next_out  = row.data();
+		strm.avail_out = row.size();
+		while (strm.avail_out > 0)
+		{
+			if (strm.avail_in == 0)
+			{
+				if (idat >= info.idat.size())
+				{
+					ok = false;
+					break;
+				}
+
+				strm.next_in  = (Bytef*)data + info.idat[idat].first;
+				strm.avail_in = info.idat[idat].second;
+				idat++;
+				continue;
+			}
+
+			int ret = inflate(&strm, Z_NO_FLUSH);
+			if ((ret == Z_STREAM_END && strm.avail_out > 0) || (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR))
+			{
+				ok = false;
+				break;
+			}
+		}
+
+		// Unfilter and convert
+		if (ok)
+			ok = unfilterRow(row[0], row.data() + 1, prev.data() + 1, row_size, bpp);
+		if (ok)
+		{
+			if (info.indexed())
+				memcpy(out + y * out_pitch, row.data() + 1, info.width);
+			else
+				rowToRGBA(row.data() + 1, info, out + y * out_pitch);
+		}
+
+		row.swap(prev);
+	}
+
+	inflateEnd(&strm);
+
+	if (!ok)
+		Global::error = "Invalid or truncated PNG image data";
+
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+// Writes the PNG signature and IHDR chunk to [out]
+// -----------------------------------------------------------------------------
+void PNGCodec::writeHeader(MemChunk& out, uint32_t width, uint32_t height, uint8_t bit_depth, uint8_t colour_type)
+{
+	out.write(png_signature, 8);
+
+	uint8_t ihdr[13];
+	writeU32(ihdr, width);
+	writeU32(ihdr + 4, height);
+	ihdr[8]  = bit_depth;
+	ihdr[9]  = colour_type;
+	ihdr[10] = 0; // Compression method
+	ihdr[11] = 0; // Filter method
+	ihdr[12] = 0; // Interlace method
+	writeChunk(out, "IHDR", ihdr, 13);
+}
+
+// -----------------------------------------------------------------------------
+// Writes a chunk named [name] with [size] bytes of [data] to [out]
+// -----------------------------------------------------------------------------
+void PNGCodec::writeChunk(MemChunk& out, const char* name, const uint8_t* data, uint32_t size)
+{
+	uint8_t buf[4];
+	writeU32(buf, size);
+	out.write(buf, 4);
+	out.write(name, 4);
+	if (size > 0)
+		out.write(data, size);
+
+	uint32_t crc = crc32(0, (const Bytef*)name, 4);
+	if (size > 0)
+		crc = crc32(crc, data, size);
+	writeU32(buf, crc);
+	out.write(buf, 4);
+}
+
+// -----------------------------------------------------------------------------
+// Filters and compresses the 8-bit [pixels] of a [width]x[height] image of
+// [colour_type] and writes them to [out] as an IDAT chunk. [level] is the zlib
+// compression level (0-9, or -1 for the zlib default). Like libpng, indexed
+// images are left unfiltered and the filter for other images is chosen per row
+// -----------------------------------------------------------------------------
+bool PNGCodec::writeImageData(
+	MemChunk&      out,
+	const uint8_t* pixels,
+	uint32_t       width,
+	uint32_t       height,
+	uint8_t        colour_type,
+	int            level)
+{
+	if (width == 0 || height == 0)
+	{
+		Global::error = "Invalid image size";
+		return false;
+	}
+
+	unsigned bpp      = channels[colour_type];
+	size_t   row_size = (size_t)width * bpp;
+	bool     adaptive = level != 0 && colour_type != INDEXED;
+
+	z_stream strm;
+	strm.zalloc = nullptr;
+	strm.zfree  = nullptr;
+	strm.opaque = nullptr;
+	if (deflateInit(&strm, std::max(-1, std::min(level, 9))) != Z_OK)
+	{
+		Global::error = "Error initialising zlib";
+		return false;
+	}
+
+	// Output buffer, grown as needed
+	vector<uint8_t> zdata(deflateBound(&strm, (row_size + 1) * height));
+	strm.next_out  = zdata.data();
+	strm.avail_out = zdata.size();
+
+	vector<uint8_t> filtered(row_size + 1);
+	vector<uint8_t> candidate(row_size + 1);
+	bool            ok = true;
+	for (uint32_t y = 0; y < height && ok; y++)
+	{
+		const uint8_t* row  = pixels + y * row_size;
+		const uint8_t* prev = y > 0 ? row - row_size : nullptr;
+
+		// Filter row
+		filtered[0]   = 0;
+		unsigned best = filterRow(0, row, prev, filtered.data() + 1, row_size, bpp);
+		if (adaptive)
+		{
+			for (uint8_t f = 1; f <= 4; f++)
+			{
+				candidate[0] = f;
+				unsigned sum = filterRow(f, row, prev, candidate.data() + 1, row_size, bpp);
+				if (sum < best)
+				{
+					best = sum;
+					filtered.swap(candidate);
+				}
+			}
+		}
+
+		// Compress it
+		int flush     = y == height - 1 ? Z_FINISH : Z_NO_FLUSH;
+		strm.next_in  = filtered.data();
+		strm.avail_in = filtered.size();
+		while (true)
+		{
+			if (strm.avail_out == 0)
+			{
+				size_t used = strm.total_out;
+				zdata.resize(zdata.size() * 2);
+				strm.next_out  = zdata.data() + used;
+				strm.avail_out = zdata.size() - used;
+			}
+
+			int ret = deflate(&strm, flush);
+			if (ret == Z_STREAM_ERROR)
+			{
+				ok = false;
+				break;
+			}
+			if (ret == Z_STREAM_END || (flush != Z_FINISH && strm.avail_in == 0 && strm.avail_out > 0))
+				break;
+		}
+	}
+
+	size_t zsize = strm.total_out;
+	deflateEnd(&strm);
+
+	if (!ok)
+	{
+		Global::error = "Error compressing PNG image data";
+		return false;
+	}
+
+	writeChunk(out, "IDAT", zdata.data(), zsize);
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Writes the IEND chunk to [out]
+// -----------------------------------------------------------------------------
+void PNGCodec::writeEnd(MemChunk& out)
+{
+	writeChunk(out, "IEND", nullptr, 0);
+}
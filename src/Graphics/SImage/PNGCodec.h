@@ -0,0 +1,57 @@
+#pragma once
+
+// Reads and writes PNG data directly with zlib, decoding straight into (and
+// encoding straight from) 8-bit indexed or 32-bit RGBA pixel buffers, one row
+// at a time. Interlaced images aren't supported, callers should fall back to
+// FreeImage for those (see canDecode)
+namespace PNGCodec
+{
+enum ColourType
+{
+	GREYSCALE        = 0,
+	TRUECOLOUR       = 2,
+	INDEXED          = 3,
+	GREYSCALE_ALPHA  = 4,
+	TRUECOLOUR_ALPHA = 6,
+};
+
+// Image info read from the chunks of a PNG
+struct Info
+{
+	uint32_t width       = 0;
+	uint32_t height      = 0;
+	uint8_t  bit_depth   = 0;
+	uint8_t  colour_type = 0;
+	uint8_t  interlace   = 0;
+
+	// PLTE/tRNS
+	rgba_t   palette[256];
+	unsigned palette_size = 0;
+	uint8_t  trans[256]; // Alpha of each palette entry
+	unsigned trans_size = 0;
+	bool     trans_key  = false; // Transparent colour key (greyscale/truecolour)
+	uint16_t key[3];
+
+	// ZDoom grAb/alPh
+	bool    grab = false;
+	int32_t xoff = 0;
+	int32_t yoff = 0;
+	bool    alph = false;
+
+	// Position and size of each IDAT chunk's data
+	vector<std::pair<size_t, uint32_t>> idat;
+
+	// True if the image decodes directly to 8-bit indices (paletted or
+	// greyscale), otherwise it decodes to RGBA
+	bool indexed() const { return bit_depth == 8 && (colour_type == INDEXED || colour_type == GREYSCALE); }
+};
+
+bool readInfo(const uint8_t* data, size_t size, Info& info);
+bool canDecode(const Info& info);
+bool decode(const uint8_t* data, const Info& info, uint8_t* out);
+
+void writeHeader(MemChunk& out, uint32_t width, uint32_t height, uint8_t bit_depth, uint8_t colour_type);
+void writeChunk(MemChunk& out, const char* name, const uint8_t* data, uint32_t size);
+bool writeImageData(MemChunk& out, const uint8_t* pixels, uint32_t width, uint32_t height, uint8_t colour_type, int level);
+void writeEnd(MemChunk& out);
+} // namespace PNGCodec
@@ -34,6 +34,7 @@
 #include "Archive/Archive.h"
 #include "Archive/EntryType/EntryType.h"
 #include "General/Misc.h"
+#include "PNGCodec.h"
 #include "SIFormat.h"
 
 
@@ -45,6 +46,7 @@ SIFormat*			sif_raw = nullptr;
 SIFormat*			sif_flat = nullptr;
 SIFormat*			sif_general = nullptr;
 SIFormat*			sif_unknown = nullptr;
+CVAR(Int, png_compression_level, 6, CVAR_SAVE)
 
 
 /*******************************************************************
@@ -181,7 +183,7 @@ protected:
 		return true;
 	}
 
-	bool writeImage(SImage& image, MemChunk& out, Palette* pal, int index)
+	bool writeImage(SImage& image, MemChunk& out, Palette* pal, int index, int level)
 	{
 		return false;
 	}
@@ -381,7 +383,7 @@ public:
 class SIFRawFlat : public SIFRaw
 {
 protected:
-	bool writeImage(SImage& image, MemChunk& data, Palette* pal, int index)
+	bool writeImage(SImage& image, MemChunk& data, Palette* pal, int index, int level)
 	{
 		// Can't write if RGBA
 		if (image.getType() == RGBA)
@@ -4,6 +4,8 @@
 
 #include "SImage.h"
 
+EXTERN_CVAR(Int, png_compression_level)
+
 class ArchiveEntry;
 class SIFormat
 {
@@ -19,7 +21,7 @@ protected:
 	Palette&	imagePalette(SImage& image) { return image.palette; }
 
 	virtual bool	readImage(SImage& image, MemChunk& data, int index) = 0;
-	virtual bool	writeImage(SImage& image, MemChunk& data, Palette* pal, int index) { return false; }
+	virtual bool	writeImage(SImage& image, MemChunk& data, Palette* pal, int index, int level) { return false; }
 
 public:
 	// Conversion options stuff
@@ -98,10 +100,12 @@ public:
 	virtual bool	convertWritable(SImage& image, convert_options_t opt) { return false; }
 	virtual bool	writeOffset(SImage& image, ArchiveEntry* entry, point2_t offset) { return false; }
 
-	bool saveImage(SImage& image, MemChunk& out, Palette* pal = nullptr, int index = 0)
+	// [level] is the compression level to use (for formats that are compressed,
+	// eg. PNG). Pass it explicitly when saving from a worker thread
+	bool saveImage(SImage& image, MemChunk& out, Palette* pal = nullptr, int index = 0, int level = png_compression_level)
 	{
 		// Attempt to write image data
-		bool ok = writeImage(image, out, pal, index);
+		bool ok = writeImage(image, out, pal, index, level);
 
 		// Set format if successful
 		if (ok)
@@ -35,6 +35,7 @@
 #include "Main.h"
 #include "SImage.h"
 #include "SIFormat.h"
+#include "SImageKernels.h"
 #include "Graphics/Translation.h"
 #include "Utility/MathStuff.h"
 
@@ -47,6 +48,185 @@ EXTERN_CVAR(Float, col_greyscale_r)
 EXTERN_CVAR(Float, col_greyscale_g)
 EXTERN_CVAR(Float, col_greyscale_b)
 
+/*******************************************************************
+ * SIMAGE DRAWING HELPERS
+ *******************************************************************/
+namespace
+{
+	/* blendColour
+	 * Blends [colour] on to [d_colour] with blend mode [B]. The alpha
+	 * of [colour] should already have the draw properties applied
+	 *******************************************************************/
+	template<SIBlendType B> inline void blendColour(rgba_t& d_colour, const rgba_t& colour)
+	{
+		float alpha = (float)colour.a / 255.0f;
+
+		// Additive blending
+		if (B == ADD)
+		{
+			d_colour.set(	MathStuff::clamp(d_colour.r+colour.r*alpha, 0, 255),
+			                MathStuff::clamp(d_colour.g+colour.g*alpha, 0, 255),
+			                MathStuff::clamp(d_colour.b+colour.b*alpha, 0, 255),
+			                MathStuff::clamp(d_colour.a + colour.a, 0, 255));
+		}
+
+		// Subtractive blending
+		else if (B == SUBTRACT)
+		{
+			d_colour.set(	MathStuff::clamp(d_colour.r-colour.r*alpha, 0, 255),
+			                MathStuff::clamp(d_colour.g-colour.g*alpha, 0, 255),
+			                MathStuff::clamp(d_colour.b-colour.b*alpha, 0, 255),
+			                MathStuff::clamp(d_colour.a + colour.a, 0, 255));
+		}
+
+		// Reverse-Subtractive blending
+		else if (B == REVERSE_SUBTRACT)
+		{
+			d_colour.set(	MathStuff::clamp((-d_colour.r)+colour.r*alpha, 0, 255),
+			                MathStuff::clamp((-d_colour.g)+colour.g*alpha, 0, 255),
+			                MathStuff::clamp((-d_colour.b)+colour.b*alpha, 0, 255),
+			                MathStuff::clamp(d_colour.a + colour.a, 0, 255));
+		}
+
+		// 'Modulate' blending
+		else if (B == MODULATE)
+		{
+			d_colour.set(	MathStuff::clamp(colour.r*d_colour.r / 255, 0, 255),
+			                MathStuff::clamp(colour.g*d_colour.g / 255, 0, 255),
+			                MathStuff::clamp(colour.b*d_colour.b / 255, 0, 255),
+			                MathStuff::clamp(d_colour.a + colour.a, 0, 255));
+		}
+
+		// Normal blending
+		else
+		{
+			float inv_alpha = 1.0f - alpha;
+			d_colour.set(	d_colour.r*inv_alpha + colour.r*alpha,
+			                d_colour.g*inv_alpha + colour.g*alpha,
+			                d_colour.b*inv_alpha + colour.b*alpha,
+			                MathStuff::clamp(d_colour.a + colour.a, 0, 255));
+		}
+	}
+
+	// Everything needed to draw a clipped source rectangle on to an image
+	struct blit_t
+	{
+		const uint8_t*	src;		// First source pixel
+		const uint8_t*	src_mask;
+		unsigned		src_stride;
+		uint8_t*		dest;		// First destination pixel
+		uint8_t*		dest_mask;
+		unsigned		dest_stride;
+		int				width;
+		int				height;
+
+		uint8_t			alpha[256];		// Source alpha -> alpha with draw properties applied
+		rgba_t			src_pal[256];	// Source palette (if paletted)
+		rgba_t			dest_pal[256];	// Destination palette (if paletted)
+		int16_t			remap[256];		// Nearest destination index for each source index, -1 if not looked up yet
+		Palette*		pal;			// Destination palette
+	};
+
+	/* blitRows
+	 * Draws the rectangle described in [blit] from a source image of
+	 * type [S] on to a destination image of type [D] (PALMASK or RGBA)
+	 * with blend mode [B]. Gives exactly the same result as drawing
+	 * each pixel with SImage::drawPixel
+	 *******************************************************************/
+	template<SIType S, SIType D, SIBlendType B> void blitRows(blit_t& blit)
+	{
+		const int s_bpp = (S == RGBA) ? 4 : 1;
+		const int d_bpp = (D == RGBA) ? 4 : 1;
+
+		for (int y = 0; y < blit.height; y++)
+		{
+			const uint8_t* src = blit.src + y * blit.src_stride;
+			const uint8_t* src_mask = (S == PALMASK) ? blit.src_mask + y * blit.src_stride : nullptr;
+			uint8_t* dest = blit.dest + y * blit.dest_stride;
+			uint8_t* dest_mask = (D == PALMASK) ? blit.dest_mask + y * blit.dest_stride : nullptr;
+
+			for (int x = 0; x < blit.width; x++, src += s_bpp, dest += d_bpp)
+			{
+				// Skip if source pixel is fully transparent
+				uint8_t s_alpha = (S == PALMASK) ? src_mask[x] : (S == RGBA) ? src[3] : src[0];
+				if (s_alpha == 0)
+					continue;
+
+				// Get source colour, with draw alpha applied
+				rgba_t colour;
+				if (S == PALMASK)
+					colour = blit.src_pal[src[0]];
+				else if (S == RGBA)
+					colour.set(src[0], src[1], src[2]);
+				else
+					colour.set(src[0], src[0], src[0]);
+				colour.a = blit.alpha[s_alpha];
+				if (colour.a == 0)
+					continue;
+
+				// Check for simple case (normal blending, no transparency involved)
+				if (B == NORMAL && colour.a == 255)
+				{
+					if (D == RGBA)
+						colour.write(dest);
+					else
+					{
+						if (S == PALMASK)
+						{
+							if (blit.remap[src[0]] < 0)
+								blit.remap[src[0]] = blit.pal->nearestColour(colour);
+							dest[0] = blit.remap[src[0]];
+						}
+						else
+							dest[0] = blit.pal->nearestColour(colour);
+						dest_mask[x] = colour.a;
+					}
+
+					continue;
+				}
+
+				// Blend with destination colour
+				rgba_t d_colour;
+				if (D == PALMASK)
+					d_colour = blit.dest_pal[dest[0]];
+				else
+					d_colour.set(dest[0], dest[1], dest[2], dest[3]);
+				blendColour<B>(d_colour, colour);
+
+				if (D == PALMASK)
+				{
+					dest[0] = blit.pal->nearestColour(d_colour);
+					dest_mask[x] = d_colour.a;
+				}
+				else
+					d_colour.write(dest);
+			}
+		}
+	}
+
+	template<SIType S, SIType D> void blitBlend(blit_t& blit, SIBlendType blend)
+	{
+		switch (blend)
+		{
+		case ADD:				blitRows<S, D, ADD>(blit); break;
+		case SUBTRACT:			blitRows<S, D, SUBTRACT>(blit); break;
+		case REVERSE_SUBTRACT:	blitRows<S, D, REVERSE_SUBTRACT>(blit); break;
+		case MODULATE:			blitRows<S, D, MODULATE>(blit); break;
+		default:				blitRows<S, D, NORMAL>(blit); break;
+		}
+	}
+
+	template<SIType D> void blitSource(blit_t& blit, SIType src, SIBlendType blend)
+	{
+		switch (src)
+		{
+		case PALMASK:	blitBlend<PALMASK, D>(blit, blend); break;
+		case RGBA:		blitBlend<RGBA, D>(blit, blend); break;
+		case ALPHAMAP:	blitBlend<ALPHAMAP, D>(blit, blend); break;
+		}
+	}
+}
+
 /*******************************************************************
  * SIMAGE CLASS FUNCTIONS
  *******************************************************************/
@@ -104,21 +284,11 @@ bool SImage::getRGBAData(MemChunk& mc, Palette* pal)
 		if (has_palette || !pal)
 			pal = &palette;
 
-		uint8_t rgba[4];
-		for (int a = 0; a < width * height; a++)
-		{
-			// Get colour
-			rgba_t col = pal->colour(data[a]);
-
-			// Set alpha
-			if (mask)
-				col.a = mask[a];
-			else
-				col.a = 255;
-
-			col.write(rgba);	// Write colour to array
-			mc.write(rgba, 4);	// Write array to MemChunk
-		}
+		// Look up each pixel's colour, alpha from the mask (if any)
+		SImageKernels::RGBALut lut;
+		SImageKernels::buildLut(lut, pal);
+		SImageKernels::indexedToRGBA(data, mask, lut, &mc[0], width * height);
+		mc.seek(width * height * 4, SEEK_SET);
 
 		return true;
 	}
@@ -126,16 +296,9 @@ bool SImage::getRGBAData(MemChunk& mc, Palette* pal)
 	// Convert if alpha map
 	else if (type == ALPHAMAP)
 	{
-		uint8_t rgba[4];
-		rgba_t col;
-		for (int a = 0; a < width * height; a++)
-		{
-			// Get pixel as colour (greyscale)
-			col.set(data[a], data[a], data[a], data[a]);
-
-			col.write(rgba);	// Write colour to array
-			mc.write(rgba, 4);	// Write array to MemChunk
-		}
+		// Get pixels as colour (greyscale)
+		SImageKernels::greyToRGBA(data, &mc[0], width * height);
+		mc.seek(width * height * 4, SEEK_SET);
 	}
 
 	return false;	// Invalid image type
@@ -660,16 +823,24 @@ bool SImage::convertRGBA(Palette* pal)
 	if (type == RGBA)
 		return false;
 
-	// Get 32bit data
-	MemChunk rgba_data;
-	getRGBAData(rgba_data, pal);
+	// Convert straight to 32bit data
+	uint8_t* rgba_data = new uint8_t[width * height * 4];
+	if (type == PALMASK)
+	{
+		// Get palette to use
+		if (has_palette || !pal)
+			pal = &palette;
+
+		SImageKernels::RGBALut lut;
+		SImageKernels::buildLut(lut, pal);
+		SImageKernels::indexedToRGBA(data, mask, lut, rgba_data, width * height);
+	}
+	else if (type == ALPHAMAP)
+		SImageKernels::greyToRGBA(data, rgba_data, width * height);
 
 	// Clear current data
 	clearData(true);
-
-	// Copy it
-	data = new uint8_t[width * height * 4];
-	memcpy(data, rgba_data.getData(), width * height * 4);
+	data = rgba_data;
 
 	// Set new type & update variables
 	type = RGBA;
@@ -794,31 +965,18 @@ bool SImage::maskFromColour(rgba_t colour, Palette* pal)
 		if (has_palette || !pal)
 			pal = &palette;
 
-		// Palette+Mask type, go through the mask
-		for (int a = 0; a < width * height; a++)
-		{
-			if (pal->colour(data[a]).equals(colour))
-				mask[a] = 0;
-			else
-				mask[a] = 255;
-		}
+		// Palette+Mask type, build the mask value for each palette index
+		uint8_t lut[256];
+		for (unsigned i = 0; i < 256; i++)
+			lut[i] = pal->colour(i).equals(colour) ? 0 : 255;
+
+		// Go through the mask
+		SImageKernels::remap(data, mask, lut, width * height);
 	}
 	else if (type == RGBA)
 	{
 		// RGBA type, go through alpha channel
-		uint32_t c = 0;
-		for (int a = 0; a < width * height; a++)
-		{
-			rgba_t pix_col(data[c], data[c + 1], data[c + 2], 255);
-
-			if (pix_col.equals(colour))
-				data[c + 3] = 0;
-			else
-				data[c + 3] = 255;
-
-			// Skip to next pixel
-			c += 4;
-		}
+		SImageKernels::maskFromColourRGBA(data, width * height, colour);
 	}
 	else
 		return false;
@@ -841,25 +999,18 @@ bool SImage::maskFromBrightness(Palette* pal)
 		if (has_palette || !pal)
 			pal = &palette;
 
-		// Go through pixel data
-		for (int a = 0; a < width * height; a++)
-		{
-			// Set mask from pixel colour brightness value
-			rgba_t col = pal->colour(data[a]);
-			mask[a] = ((double)col.r*0.3)+((double)col.g*0.59)+((double)col.b*0.11);
-		}
+		// Get brightness value of each palette colour
+		uint8_t lut[256];
+		for (unsigned i = 0; i < 256; i++)
+			lut[i] = SImageKernels::brightness(pal->colour(i));
+
+		// Set mask from pixel colour brightness value
+		SImageKernels::remap(data, mask, lut, width * height);
 	}
 	else if (type == RGBA)
 	{
-		// Go through pixel data
-		unsigned c = 0;
-		for (int a = 0; a < width * height; a++)
-		{
-			// Set alpha from pixel colour brightness value
-			data[c+3] = (double)data[c]*0.3 + (double)data[c+1]*0.59 + (double)data[c+2]*0.11;
-			// Skip alpha
-			c += 4;
-		}
+		// Set alpha from pixel colour brightness value
+		SImageKernels::maskFromBrightnessRGBA(data, width * height);
 	}
 	// ALPHAMASK type is already a brightness mask
 
@@ -879,36 +1030,17 @@ bool SImage::cutoffMask(uint8_t threshold)
 	if (type == PALMASK)
 	{
 		// Paletted, go through mask
-		for (int a = 0; a < width * height; a++)
-		{
-			if (mask[a] > threshold)
-				mask[a] = 255;
-			else
-				mask[a] = 0;
-		}
+		SImageKernels::cutoff(mask, width * height, threshold);
 	}
 	else if (type == RGBA)
 	{
 		// RGBA format, go through alpha channel
-		uint32_t c = 0;
-		for (int a = 3; a < width * height * 4; a += 4)
-		{
-			if (data[a] > threshold)
-				data[a] = 255;
-			else
-				data[a] = 0;
-		}
+		SImageKernels::cutoffRGBA(data, width * height, threshold);
 	}
 	else if (type == ALPHAMAP)
 	{
 		// Alpha map, go through pixels
-		for (int a = 0; a < width * height; a++)
-		{
-			if (data[a] > threshold)
-				data[a] = 255;
-			else
-				data[a] = 0;
-		}
+		SImageKernels::cutoff(data, width * height, threshold);
 	}
 	else
 		return false;
@@ -1057,35 +1189,17 @@ bool SImage::rotate(int angle)
 	else if (type==RGBA)	numbpp = 4;
 	else return false;
 
+	if (angle != 90 && angle != 180 && angle != 270)
+		return false;
+
 	// Create new data and mask
 	nd = new uint8_t[numpixels*numbpp];
-	if (mask) nm = new uint8_t[numpixels*numbpp];
+	if (mask) nm = new uint8_t[numpixels];
 	else nm = nullptr;
 
-	// Remapping loop
-	int i, j, k;
-	for (i = 0; i < numpixels; ++i)
-	{
-		switch (angle)
-		{
-			// Urgh maths...
-		case 90:	j = (((nh - 1) - (i%width)) * nw) + (i/width);	break;
-		case 180:	j = (numpixels - 1) - i;						break;
-		case 270:	j = ((i%width) * nw) + ((nw - 1) - (i/width));	break;
-		default: delete[] nd; if (mask) delete[] nm; return false;
-		}
-		if (j >= numpixels)
-		{
-			LOG_MESSAGE(1, "Pixel %i remapped to %i, how did this even happen?", i, j);
-			delete [] nd; if (mask) delete[] nm;
-			return false;
-		}
-		for (k = 0; k < numbpp; ++k)
-		{
-			nd[(j*numbpp)+k] = data[(i*numbpp)+k];
-			if (mask) nm[(j*numbpp)+k] = mask[(i*numbpp)+k];
-		}
-	}
+	// Rotate data and mask
+	SImageKernels::rotate(data, nd, width, height, numbpp, angle);
+	if (mask) SImageKernels::rotate(mask, nm, width, height, 1, angle);
 
 	// It worked, yay
 	clearData();
@@ -1111,27 +1225,24 @@ bool SImage::mirror(bool vertical)
 
 	// Create new data and mask
 	nd = new uint8_t[numpixels*numbpp];
-	if (mask) nm = new uint8_t[numpixels*numbpp];
+	if (mask) nm = new uint8_t[numpixels];
 	else nm = nullptr;
 
-	// Remapping loop
-	int i, j, k;
-	for (i = 0; i < numpixels; ++i)
+	// Remap a row at a time
+	for (int y = 0; y < height; ++y)
 	{
 		if (vertical)
-			j = (((height - 1) - (i/width)) * width) + (i%width);
-		else // horizontal
-			j = ((i/width) * width) + ((width - 1) - (i%width));
-		if (j >= numpixels)
 		{
-			LOG_MESSAGE(1, "Pixel %i remapped to %i, how did this even happen?", i, j);
-			delete [] nd; if (mask) delete[] nm;
-			return false;
+			// Copy rows in reverse order
+			int src = (height - 1) - y;
+			memcpy(nd + y*width*numbpp, data + src*width*numbpp, width*numbpp);
+			if (mask) memcpy(nm + y*width, mask + src*width, width);
 		}
-		for (k = 0; k < numbpp; ++k)
+		else // horizontal
 		{
-			nd[(j*numbpp)+k] = data[(i*numbpp)+k];
-			if (mask) nm[(j*numbpp)+k] = mask[(i*numbpp)+k];
+			// Reverse the pixels within each row
+			SImageKernels::reverseRow(data + y*width*numbpp, nd + y*width*numbpp, width, numbpp);
+			if (mask) SImageKernels::reverseRow(mask + y*width, nm + y*width, width, 1);
 		}
 	}
 
@@ -1324,6 +1435,10 @@ bool SImage::applyTranslation(Translation* tr, Palette* pal, bool truecolor)
 	}
 	else newdata = data;
 
+	// Paletted pixels only need each palette colour translated once
+	rgba_t pal_trans[256];
+	bool pal_translated[256] = {};
+
 	// Go through pixels
 	for (int p = 0; p < width*height; p++)
 	{
@@ -1335,7 +1450,15 @@ bool SImage::applyTranslation(Translation* tr, Palette* pal, bool truecolor)
 		rgba_t col;
 		int q = p * bpp;
 		if (type == PALMASK)
-			col.set(pal->colour(data[p]));
+		{
+			uint8_t index = data[p];
+			if (!pal_translated[index])
+			{
+				pal_trans[index] = tr->translate(pal->colour(index), pal);
+				pal_translated[index] = true;
+			}
+			col = pal_trans[index];
+		}
 		else if (type == RGBA)
 		{
 			col.set(data[q], data[q + 1], data[q + 2], data[q + 3]);
@@ -1344,9 +1467,9 @@ bool SImage::applyTranslation(Translation* tr, Palette* pal, bool truecolor)
 			col.index = pal->nearestColour(col);
 			if (!col.equals(pal->colour(col.index)))
 				continue;
-		}
 
-		col = tr->translate(col, pal);
+			col = tr->translate(col, pal);
+		}
 
 		if (truecolor)
 		{
@@ -1428,52 +1551,13 @@ bool SImage::drawPixel(int x, int y, rgba_t colour, si_drawprops_t& properties,
 		d_colour = pal->colour(data[p]);
 	else
 		d_colour.set(data[p], data[p+1], data[p+2], data[p+3]);
-	float alpha = (float)colour.a / 255.0f;
-
-	// Additive blending
-	if (properties.blend == ADD)
-	{
-		d_colour.set(	MathStuff::clamp(d_colour.r+colour.r*alpha, 0, 255),
-		                MathStuff::clamp(d_colour.g+colour.g*alpha, 0, 255),
-		                MathStuff::clamp(d_colour.b+colour.b*alpha, 0, 255),
-		                MathStuff::clamp(d_colour.a + colour.a, 0, 255));
-	}
-
-	// Subtractive blending
-	else if (properties.blend == SUBTRACT)
-	{
-		d_colour.set(	MathStuff::clamp(d_colour.r-colour.r*alpha, 0, 255),
-		                MathStuff::clamp(d_colour.g-colour.g*alpha, 0, 255),
-		                MathStuff::clamp(d_colour.b-colour.b*alpha, 0, 255),
-		                MathStuff::clamp(d_colour.a + colour.a, 0, 255));
-	}
-
-	// Reverse-Subtractive blending
-	else if (properties.blend == REVERSE_SUBTRACT)
-	{
-		d_colour.set(	MathStuff::clamp((-d_colour.r)+colour.r*alpha, 0, 255),
-		                MathStuff::clamp((-d_colour.g)+colour.g*alpha, 0, 255),
-		                MathStuff::clamp((-d_colour.b)+colour.b*alpha, 0, 255),
-		                MathStuff::clamp(d_colour.a + colour.a, 0, 255));
-	}
-
-	// 'Modulate' blending
-	else if (properties.blend == MODULATE)
-	{
-		d_colour.set(	MathStuff::clamp(colour.r*d_colour.r / 255, 0, 255),
-		                MathStuff::clamp(colour.g*d_colour.g / 255, 0, 255),
-		                MathStuff::clamp(colour.b*d_colour.b / 255, 0, 255),
-		                MathStuff::clamp(d_colour.a + colour.a, 0, 255));
-	}
-
-	// Normal blending (or unknown blend type)
-	else
+	switch (properties.blend)
 	{
-		float inv_alpha = 1.0f - alpha;
-		d_colour.set(	d_colour.r*inv_alpha + colour.r*alpha,
-		                d_colour.g*inv_alpha + colour.g*alpha,
-		                d_colour.b*inv_alpha + colour.b*alpha,
-		                MathStuff::clamp(d_colour.a + colour.a, 0, 255));
+	case ADD:				blendColour<ADD>(d_colour, colour); break;
+	case SUBTRACT:			blendColour<SUBTRACT>(d_colour, colour); break;
+	case REVERSE_SUBTRACT:	blendColour<REVERSE_SUBTRACT>(d_colour, colour); break;
+	case MODULATE:			blendColour<MODULATE>(d_colour, colour); break;
+	default:				blendColour<NORMAL>(d_colour, colour); break;	// Normal blending (or unknown blend type)
 	}
 
 	// Apply new colour
@@ -1508,28 +1592,68 @@ bool SImage::drawImage(SImage& img, int x_pos, int y_pos, si_drawprops_t& proper
 	if (has_palette || !pal_dest)
 		pal_dest = &palette;
 
-	// Go through pixels
+	// Clip to this image
+	int x_start = MAX(x_pos, 0);
+	int y_start = MAX(y_pos, 0);
+	int x_end = MIN(x_pos + img.width, width);
+	int y_end = MIN(y_pos + img.height, height);
+	if (x_start >= x_end || y_start >= y_end)
+		return true;
+
 	unsigned s_stride = img.getStride();
 	uint8_t s_bpp = img.getBpp();
-	unsigned sp = 0;
-	for (int y = y_pos; y < y_pos + img.height; y++)  		// Rows
-	{
-		// Skip out-of-bounds rows
-		if (y < 0 || y >= height)
+
+	// Draw row-by-row if possible
+	if (type == PALMASK || type == RGBA)
+	{
+		blit_t blit;
+		unsigned s_offset = (y_start - y_pos) * s_stride + (x_start - x_pos) * s_bpp;
+		unsigned d_offset = y_start * getStride() + x_start * getBpp();
+		blit.src = img.data + s_offset;
+		blit.src_mask = (img.type == PALMASK) ? img.mask + s_offset : nullptr;
+		blit.src_stride = s_stride;
+		blit.dest = data + d_offset;
+		blit.dest_mask = (type == PALMASK) ? mask + d_offset : nullptr;
+		blit.dest_stride = getStride();
+		blit.width = x_end - x_start;
+		blit.height = y_end - y_start;
+		blit.pal = pal_dest;
+
+		// Setup alpha
+		for (unsigned a = 0; a < 256; a++)
 		{
-			sp += s_stride;
-			continue;
+			rgba_t colour(0, 0, 0, a);
+			if (properties.src_alpha)
+				colour.a *= properties.alpha;
+			else
+				colour.a = 255*properties.alpha;
+			blit.alpha[a] = colour.a;
 		}
 
-		for (int x = x_pos; x < x_pos + img.width; x++)  	// Columns
+		// Setup palettes
+		for (unsigned a = 0; a < 256; a++)
 		{
-			// Skip out-of-bounds columns
-			if (x < 0 || x >= width)
-			{
-				sp += s_bpp;
-				continue;
-			}
+			if (img.type == PALMASK)
+				blit.src_pal[a] = pal_src->colour(a);
+			if (type == PALMASK)
+				blit.dest_pal[a] = pal_dest->colour(a);
+			blit.remap[a] = -1;
+		}
+
+		if (type == RGBA)
+			blitSource<RGBA>(blit, img.type, properties.blend);
+		else
+			blitSource<PALMASK>(blit, img.type, properties.blend);
 
+		return true;
+	}
+
+	// Otherwise go through pixels
+	for (int y = y_start; y < y_end; y++)  		// Rows
+	{
+		unsigned sp = (y - y_pos) * s_stride + (x_start - x_pos) * s_bpp;
+		for (int x = x_start; x < x_end; x++)  	// Columns
+		{
 			// Skip if source pixel is fully transparent
 			if ((img.type == PALMASK && img.mask[sp] == 0) ||
 			        (img.type == ALPHAMAP && img.data[sp] == 0) ||
@@ -1573,36 +1697,26 @@ bool SImage::colourise(rgba_t colour, Palette* pal, int start, int stop)
 	if (has_palette || !pal)
 		pal = &palette;
 
-	// Go through all pixels
-	uint8_t bpp = getBpp();
-	rgba_t col;
-	for (int a = 0; a < width*height*bpp; a+= bpp)
+	double weights[3] = { col_greyscale_r, col_greyscale_g, col_greyscale_b };
+
+	// Colourise all pixels
+	if (type == RGBA)
+		SImageKernels::colouriseRGBA(data, width*height, colour, weights);
+	else
 	{
-		// Skip colors out of range if desired
-		if (type == PALMASK && start >= 0 && stop >= start && stop < 256) 
+		// Get the colourised colour for each palette index, leaving
+		// colors out of range alone if desired
+		bool range = (start >= 0 && stop >= start && stop < 256);
+		uint8_t lut[256];
+		for (int i = 0; i < 256; i++)
 		{
-			if (data[a] < start || data[a] > stop)
-				continue;
+			if (range && (i < start || i > stop))
+				lut[i] = i;
+			else
+				lut[i] = pal->nearestColour(SImageKernels::colourise(pal->colour(i), colour, weights));
 		}
 
-		// Get current pixel colour
-		if (type == RGBA)
-			col.set(data[a], data[a+1], data[a+2], data[a+3]);
-		else
-			col.set(pal->colour(data[a]));
-
-		// Colourise it
-		float grey = (col.r*col_greyscale_r + col.g*col_greyscale_g + col.b*col_greyscale_b) / 255.0f;
-		if (grey > 1.0) grey = 1.0;
-		col.r = colour.r*grey;
-		col.g = colour.g*grey;
-		col.b = colour.b*grey;
-
-		// Set pixel colour
-		if (type == RGBA)
-			col.write(data+a);
-		else
-			data[a] = pal->nearestColour(col);
+		SImageKernels::remap(data, data, lut, width*height);
 	}
 
 	return true;
@@ -1622,35 +1736,24 @@ bool SImage::tint(rgba_t colour, float amount, Palette* pal, int start, int stop
 	if (has_palette || !pal)
 		pal = &palette;
 
-	// Go through all pixels
-	uint8_t bpp = getBpp();
-	rgba_t col;
-	for (int a = 0; a < width*height*bpp; a+= bpp)
+	// Tint all pixels
+	if (type == RGBA)
+		SImageKernels::tintRGBA(data, width*height, colour, amount);
+	else
 	{
-		// Skip colors out of range if desired
-		if (type == PALMASK && start >= 0 && stop >= start && stop < 256)
+		// Get the tinted colour for each palette index, leaving colors
+		// out of range alone if desired
+		bool range = (start >= 0 && stop >= start && stop < 256);
+		uint8_t lut[256];
+		for (int i = 0; i < 256; i++)
 		{
-			if (data[a] < start || data[a] > stop)
-				continue;
+			if (range && (i < start || i > stop))
+				lut[i] = i;
+			else
+				lut[i] = pal->nearestColour(SImageKernels::tint(pal->colour(i), colour, amount));
 		}
 
-		// Get current pixel colour
-		if (type == RGBA)
-			col.set(data[a], data[a+1], data[a+2], data[a+3]);
-		else
-			col.set(pal->colour(data[a]));
-
-		// Tint it
-		float inv_amt = 1.0f - amount;
-		col.set(col.r*inv_amt + colour.r*amount,
-		        col.g*inv_amt + colour.g*amount,
-		        col.b*inv_amt + colour.b*amount, col.a);
-
-		// Set pixel colour
-		if (type == RGBA)
-			col.write(data+a);
-		else
-			data[a] = pal->nearestColour(col);
+		SImageKernels::remap(data, data, lut, width*height);
 	}
 
 	return true;
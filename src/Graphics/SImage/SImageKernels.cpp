@@ -0,0 +1,1108 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    SImageKernels.cpp
+// Description: Bulk pixel operations for SImage, with scalar, SSE2 and AVX2
+//              implementations selected at runtime
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "SImageKernels.h"
+#include "General/Console/Console.h"
+#include "Graphics/Palette/Palette.h"
+#include <atomic>
+#include <chrono>
+#include <random>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SIK_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// The SSE2/AVX2 functions are compiled for those instruction sets regardless
+// of the compiler flags, and only called if the CPU supports them. MSVC allows
+// intrinsics for any instruction set without this
+#if defined(SIK_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SIK_SSE2 __attribute__((target("sse2")))
+#define SIK_AVX2 __attribute__((target("avx2")))
+#else
+#define SIK_SSE2
+#define SIK_AVX2
+#endif
+
+using namespace SImageKernels;
+
+
+// -----------------------------------------------------------------------------
+//
+// Scalar Implementations
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Reads 4 bytes at [p] as a (native endian) 32-bit value
+// -----------------------------------------------------------------------------
+inline uint32_t load32(const uint8_t* p)
+{
+	uint32_t v;
+	memcpy(&v, p, 4);
+	return v;
+}
+
+void indexedToRGBAScalar(const uint8_t* in, const uint8_t* mask, const RGBALut& lut, uint8_t* out, size_t count)
+{
+	for (size_t a = 0; a < count; a++)
+		memcpy(out + a * 4, lut + in[a] * 4, 4);
+
+	if (mask)
+		for (size_t a = 0; a < count; a++)
+			out[a * 4 + 3] = mask[a];
+}
+
+void greyToRGBAScalar(const uint8_t* in, uint8_t* out, size_t count)
+{
+	for (size_t a = 0; a < count; a++)
+		memset(out + a * 4, in[a], 4);
+}
+
+void maskFromColourRGBAScalar(uint8_t* rgba, size_t count, rgba_t colour)
+{
+	for (size_t a = 0; a < count; a++, rgba += 4)
+		rgba[3] = (rgba[0] == colour.r && rgba[1] == colour.g && rgba[2] == colour.b) ? 0 : 255;
+}
+
+void maskFromBrightnessRGBAScalar(uint8_t* rgba, size_t count)
+{
+	for (size_t a = 0; a < count; a++, rgba += 4)
+		rgba[3] = (double)rgba[0] * 0.3 + (double)rgba[1] * 0.59 + (double)rgba[2] * 0.11;
+}
+
+void cutoffScalar(uint8_t* data, size_t count, uint8_t threshold)
+{
+	for (size_t a = 0; a < count; a++)
+		data[a] = data[a] > threshold ? 255 : 0;
+}
+
+void cutoffRGBAScalar(uint8_t* rgba, size_t count, uint8_t threshold)
+{
+	for (size_t a = 0; a < count; a++)
+		rgba[a * 4 + 3] = rgba[a * 4 + 3] > threshold ? 255 : 0;
+}
+
+void colouriseRGBAScalar(uint8_t* rgba, size_t count, rgba_t colour, const double weights[3])
+{
+	for (size_t a = 0; a < count; a++, rgba += 4)
+	{
+		rgba_t col = SImageKernels::colourise(rgba_t(rgba[0], rgba[1], rgba[2], rgba[3]), colour, weights);
+		rgba[0]    = col.r;
+		rgba[1]    = col.g;
+		rgba[2]    = col.b;
+	}
+}
+
+void tintRGBAScalar(uint8_t* rgba, size_t count, rgba_t colour, float amount)
+{
+	for (size_t a = 0; a < count; a++, rgba += 4)
+	{
+		rgba_t col = SImageKernels::tint(rgba_t(rgba[0], rgba[1], rgba[2], rgba[3]), colour, amount);
+		rgba[0]    = col.r;
+		rgba[1]    = col.g;
+		rgba[2]    = col.b;
+	}
+}
+
+void reverseRowScalar(const uint8_t* in, uint8_t* out, size_t width, unsigned bpp)
+{
+	for (size_t x = 0; x < width; x++)
+		memcpy(out + x * bpp, in + (width - 1 - x) * bpp, bpp);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// SSE2 Implementations
+//
+// Each processes as many pixels as it can with SSE2 and leaves the rest to the
+// scalar version
+//
+// -----------------------------------------------------------------------------
+#ifdef SIK_X86
+
+// -----------------------------------------------------------------------------
+// Splits the 4 RGBA pixels in [v] into separate 32-bit R, G and B lanes
+// -----------------------------------------------------------------------------
+SIK_SSE2 inline void splitRGB(__m128i v, __m128i& r, __m128i& g, __m128i& b)
+{
+	__m128i byte = _mm_set1_epi32(0xFF);
+	r            = _mm_and_si128(v, byte);
+	g            = _mm_and_si128(_mm_srli_epi32(v, 8), byte);
+	b            = _mm_and_si128(_mm_srli_epi32(v, 16), byte);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the weighted sum r * w[0] + g * w[1] + b * w[2] (in that order, in
+// double precision) of the first/last 2 of the 4 lanes of [r], [g] and [b]
+// -----------------------------------------------------------------------------
+SIK_SSE2 inline __m128d weightedSum(__m128i r, __m128i g, __m128i b, const double w[3], bool high)
+{
+	if (high)
+	{
+		r = _mm_shuffle_epi32(r, 0xEE);
+		g = _mm_shuffle_epi32(g, 0xEE);
+		b = _mm_shuffle_epi32(b, 0xEE);
+	}
+
+	__m128d sum = _mm_add_pd(
+		_mm_mul_pd(_mm_cvtepi32_pd(r), _mm_set1_pd(w[0])), _mm_mul_pd(_mm_cvtepi32_pd(g), _mm_set1_pd(w[1])));
+	return _mm_add_pd(sum, _mm_mul_pd(_mm_cvtepi32_pd(b), _mm_set1_pd(w[2])));
+}
+
+// -----------------------------------------------------------------------------
+// Combines 32-bit R, G, B lanes (0-255) with the alpha of [v]
+// -----------------------------------------------------------------------------
+SIK_SSE2 inline __m128i joinRGB(__m128i r, __m128i g, __m128i b, __m128i v)
+{
+	__m128i byte = _mm_set1_epi32(0xFF);
+	__m128i rgb  = _mm_or_si128(
+        _mm_and_si128(r, byte),
+        _mm_or_si128(_mm_slli_epi32(_mm_and_si128(g, byte), 8), _mm_slli_epi32(_mm_and_si128(b, byte), 16)));
+	return _mm_or_si128(rgb, _mm_and_si128(v, _mm_set1_epi32(0xFF000000)));
+}
+
+SIK_SSE2 void indexedToRGBASSE2(const uint8_t* in, const uint8_t* mask, const RGBALut& lut, uint8_t* out, size_t count)
+{
+	__m128i rgb  = _mm_set1_epi32(0x00FFFFFF);
+	__m128i zero = _mm_setzero_si128();
+	size_t  a    = 0;
+	for (; a + 4 <= count; a += 4)
+	{
+		__m128i px = _mm_setr_epi32(
+			load32(lut + in[a] * 4),
+			load32(lut + in[a + 1] * 4),
+			load32(lut + in[a + 2] * 4),
+			load32(lut + in[a + 3] * 4));
+
+		if (mask)
+		{
+			__m128i m = _mm_cvtsi32_si128(load32(mask + a));
+			m         = _mm_unpacklo_epi16(_mm_unpacklo_epi8(m, zero), zero);
+			px        = _mm_or_si128(_mm_and_si128(px, rgb), _mm_slli_epi32(m, 24));
+		}
+
+		_mm_storeu_si128((__m128i*)(out + a * 4), px);
+	}
+
+	indexedToRGBAScalar(in + a, mask ? mask + a : nullptr, lut, out + a * 4, count - a);
+}
+
+SIK_SSE2 void greyToRGBASSE2(const uint8_t* in, uint8_t* out, size_t count)
+{
+	size_t a = 0;
+	for (; a + 16 <= count; a += 16)
+	{
+		__m128i v  = _mm_loadu_si128((const __m128i*)(in + a));
+		__m128i lo = _mm_unpacklo_epi8(v, v);
+		__m128i hi = _mm_unpackhi_epi8(v, v);
+		_mm_storeu_si128((__m128i*)(out + a * 4), _mm_unpacklo_epi16(lo, lo));
+		_mm_storeu_si128((__m128i*)(out + a * 4 + 16), _mm_unpackhi_epi16(lo, lo));
+		_mm_storeu_si128((__m128i*)(out + a * 4 + 32), _mm_unpacklo_epi16(hi, hi));
+		_mm_storeu_si128((__m128i*)(out + a * 4 + 48), _mm_unpackhi_epi16(hi, hi));
+	}
+
+	greyToRGBAScalar(in + a, out + a * 4, count - a);
+}
+
+SIK_SSE2 void maskFromColourRGBASSE2(uint8_t* rgba, size_t count, rgba_t colour)
+{
+	__m128i rgb   = _mm_set1_epi32(0x00FFFFFF);
+	__m128i alpha = _mm_set1_epi32(0xFF000000);
+	__m128i key   = _mm_set1_epi32(colour.r | (colour.g << 8) | (colour.b << 16));
+	size_t  a     = 0;
+	for (; a + 4 <= count; a += 4)
+	{
+		__m128i v  = _mm_and_si128(_mm_loadu_si128((const __m128i*)(rgba + a * 4)), rgb);
+		__m128i eq = _mm_cmpeq_epi32(v, key);
+		_mm_storeu_si128((__m128i*)(rgba + a * 4), _mm_or_si128(v, _mm_andnot_si128(eq, alpha)));
+	}
+
+	maskFromColourRGBAScalar(rgba + a * 4, count - a, colour);
+}
+
+SIK_SSE2 void maskFromBrightnessRGBASSE2(uint8_t* rgba, size_t count)
+{
+	const double weights[3] = { 0.3, 0.59, 0.11 };
+	size_t       a          = 0;
+	for (; a + 4 <= count; a += 4)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)(rgba + a * 4));
+		__m128i r, g, b;
+		splitRGB(v, r, g, b);
+
+		__m128i lo  = _mm_cvttpd_epi32(weightedSum(r, g, b, weights, false));
+		__m128i hi  = _mm_cvttpd_epi32(weightedSum(r, g, b, weights, true));
+		__m128i lum = _mm_unpacklo_epi64(lo, hi);
+
+		v = _mm_or_si128(_mm_and_si128(v, _mm_set1_epi32(0x00FFFFFF)), _mm_slli_epi32(lum, 24));
+		_mm_storeu_si128((__m128i*)(rgba + a * 4), v);
+	}
+
+	maskFromBrightnessRGBAScalar(rgba + a * 4, count - a);
+}
+
+SIK_SSE2 void cutoffSSE2(uint8_t* data, size_t count, uint8_t threshold)
+{
+	// Unsigned comparison, via signed comparison with the sign bit flipped
+	__m128i bias = _mm_set1_epi8((char)0x80);
+	__m128i t    = _mm_set1_epi8((char)(threshold ^ 0x80));
+	size_t  a    = 0;
+	for (; a + 16 <= count; a += 16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)(data + a));
+		_mm_storeu_si128((__m128i*)(data + a), _mm_cmpgt_epi8(_mm_xor_si128(v, bias), t));
+	}
+
+	cutoffScalar(data + a, count - a, threshold);
+}
+
+SIK_SSE2 void cutoffRGBASSE2(uint8_t* rgba, size_t count, uint8_t threshold)
+{
+	__m128i bias  = _mm_set1_epi8((char)0x80);
+	__m128i t     = _mm_set1_epi8((char)(threshold ^ 0x80));
+	__m128i alpha = _mm_set1_epi32(0xFF000000);
+	size_t  a     = 0;
+	for (; a + 4 <= count; a += 4)
+	{
+		__m128i v  = _mm_loadu_si128((const __m128i*)(rgba + a * 4));
+		__m128i gt = _mm_cmpgt_epi8(_mm_xor_si128(v, bias), t);
+		v          = _mm_or_si128(_mm_andnot_si128(alpha, v), _mm_and_si128(gt, alpha));
+		_mm_storeu_si128((__m128i*)(rgba + a * 4), v);
+	}
+
+	cutoffRGBAScalar(rgba + a * 4, count - a, threshold);
+}
+
+SIK_SSE2 void colouriseRGBASSE2(uint8_t* rgba, size_t count, rgba_t colour, const double weights[3])
+{
+	__m128d div = _mm_set1_pd(255.0f);
+	__m128  one = _mm_set1_ps(1.0f);
+	__m128  cr  = _mm_set1_ps((float)colour.r);
+	__m128  cg  = _mm_set1_ps((float)colour.g);
+	__m128  cb  = _mm_set1_ps((float)colour.b);
+	size_t  a   = 0;
+	for (; a + 4 <= count; a += 4)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)(rgba + a * 4));
+		__m128i r, g, b;
+		splitRGB(v, r, g, b);
+
+		// Grey level, computed in double precision and then rounded to float
+		// as in SImageKernels::colourise
+		__m128 grey = _mm_movelh_ps(
+			_mm_cvtpd_ps(_mm_div_pd(weightedSum(r, g, b, weights, false), div)),
+			_mm_cvtpd_ps(_mm_div_pd(weightedSum(r, g, b, weights, true), div)));
+		grey = _mm_min_ps(grey, one);
+
+		r = _mm_cvttps_epi32(_mm_mul_ps(cr, grey));
+		g = _mm_cvttps_epi32(_mm_mul_ps(cg, grey));
+		b = _mm_cvttps_epi32(_mm_mul_ps(cb, grey));
+		_mm_storeu_si128((__m128i*)(rgba + a * 4), joinRGB(r, g, b, v));
+	}
+
+	colouriseRGBAScalar(rgba + a * 4, count - a, colour, weights);
+}
+
+SIK_SSE2 void tintRGBASSE2(uint8_t* rgba, size_t count, rgba_t colour, float amount)
+{
+	__m128 inv = _mm_set1_ps(1.0f - amount);
+	__m128 tr  = _mm_set1_ps(colour.r * amount);
+	__m128 tg  = _mm_set1_ps(colour.g * amount);
+	__m128 tb  = _mm_set1_ps(colour.b * amount);
+	size_t a   = 0;
+	for (; a + 4 <= count; a += 4)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)(rgba + a * 4));
+		__m128i r, g, b;
+		splitRGB(v, r, g, b);
+
+		r = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(r), inv), tr));
+		g = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(g), inv), tg));
+		b = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(b), inv), tb));
+		_mm_storeu_si128((__m128i*)(rgba + a * 4), joinRGB(r, g, b, v));
+	}
+
+	tintRGBAScalar(rgba + a * 4, count - a, colour, amount);
+}
+
+SIK_SSE2 void reverseRowSSE2(const uint8_t* in, uint8_t* out, size_t width, unsigned bpp)
+{
+	size_t x = 0;
+	if (bpp == 4)
+	{
+		for (; x + 4 <= width; x += 4)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)(in + (width - x - 4) * 4));
+			_mm_storeu_si128((__m128i*)(out + x * 4), _mm_shuffle_epi32(v, 0x1B));
+		}
+	}
+	else if (bpp == 1)
+	{
+		for (; x + 16 <= width; x += 16)
+		{
+			// Swap bytes in each word, then reverse the words
+			__m128i v = _mm_loadu_si128((const __m128i*)(in + width - x - 16));
+			v         = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+			v         = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0x1B), 0x1B);
+			_mm_storeu_si128((__m128i*)(out + x), _mm_shuffle_epi32(v, 0x4E));
+		}
+	}
+
+	reverseRowScalar(in, out + x * bpp, width - x, bpp);
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// AVX2 Implementations
+//
+// As above, each processes as much as it can with AVX2 and leaves the rest to
+// the SSE2 version
+//
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Returns the weighted sum r * w[0] + g * w[1] + b * w[2] (in double precision)
+// of the first/last 4 of the 8 lanes of [r], [g] and [b]
+// -----------------------------------------------------------------------------
+SIK_AVX2 inline __m256d weightedSum8(__m256i r, __m256i g, __m256i b, const double w[3], bool high)
+{
+	__m128i r4 = high ? _mm256_extracti128_si256(r, 1) : _mm256_castsi256_si128(r);
+	__m128i g4 = high ? _mm256_extracti128_si256(g, 1) : _mm256_castsi256_si128(g);
+	__m128i b4 = high ? _mm256_extracti128_si256(b, 1) : _mm256_castsi256_si128(b);
+
+	__m256d sum = _mm256_add_pd(
+		_mm256_mul_pd(_mm256_cvtepi32_pd(r4), _mm256_set1_pd(w[0])),
+		_mm256_mul_pd(_mm256_cvtepi32_pd(g4), _mm256_set1_pd(w[1])));
+	return _mm256_add_pd(sum, _mm256_mul_pd(_mm256_cvtepi32_pd(b4), _mm256_set1_pd(w[2])));
+}
+
+SIK_AVX2 inline void splitRGB8(__m256i v, __m256i& r, __m256i& g, __m256i& b)
+{
+	__m256i byte = _mm256_set1_epi32(0xFF);
+	r            = _mm256_and_si256(v, byte);
+	g            = _mm256_and_si256(_mm256_srli_epi32(v, 8), byte);
+	b            = _mm256_and_si256(_mm256_srli_epi32(v, 16), byte);
+}
+
+SIK_AVX2 inline __m256i joinRGB8(__m256i r, __m256i g, __m256i b, __m256i v)
+{
+	__m256i byte = _mm256_set1_epi32(0xFF);
+	__m256i rgb  = _mm256_or_si256(
+        _mm256_and_si256(r, byte),
+        _mm256_or_si256(
+            _mm256_slli_epi32(_mm256_and_si256(g, byte), 8), _mm256_slli_epi32(_mm256_and_si256(b, byte), 16)));
+	return _mm256_or_si256(rgb, _mm256_and_si256(v, _mm256_set1_epi32(0xFF000000)));
+}
+
+SIK_AVX2 inline __m256i join128(__m128i lo, __m128i hi)
+{
+	return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+SIK_AVX2 void indexedToRGBAAVX2(const uint8_t* in, const uint8_t* mask, const RGBALut& lut, uint8_t* out, size_t count)
+{
+	__m256i rgb = _mm256_set1_epi32(0x00FFFFFF);
+	size_t  a   = 0;
+	for (; a + 8 <= count; a += 8)
+	{
+		__m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(in + a)));
+		__m256i px  = _mm256_i32gather_epi32((const int*)lut, idx, 4);
+
+		if (mask)
+		{
+			__m256i m = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(mask + a)));
+			px        = _mm256_or_si256(_mm256_and_si256(px, rgb), _mm256_slli_epi32(m, 24));
+		}
+
+		_mm256_storeu_si256((__m256i*)(out + a * 4), px);
+	}
+
+	indexedToRGBASSE2(in + a, mask ? mask + a : nullptr, lut, out + a * 4, count - a);
+}
+
+SIK_AVX2 void greyToRGBAAVX2(const uint8_t* in, uint8_t* out, size_t count)
+{
+	__m256i spread = _mm256_set1_epi32(0x01010101);
+	size_t  a      = 0;
+	for (; a + 8 <= count; a += 8)
+	{
+		__m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(in + a)));
+		_mm256_storeu_si256((__m256i*)(out + a * 4), _mm256_mullo_epi32(v, spread));
+	}
+
+	greyToRGBASSE2(in + a, out + a * 4, count - a);
+}
+
+SIK_AVX2 void maskFromColourRGBAAVX2(uint8_t* rgba, size_t count, rgba_t colour)
+{
+	__m256i rgb   = _mm256_set1_epi32(0x00FFFFFF);
+	__m256i alpha = _mm256_set1_epi32(0xFF000000);
+	__m256i key   = _mm256_set1_epi32(colour.r | (colour.g << 8) | (colour.b << 16));
+	size_t  a     = 0;
+	for (; a + 8 <= count; a += 8)
+	{
+		__m256i v  = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(rgba + a * 4)), rgb);
+		__m256i eq = _mm256_cmpeq_epi32(v, key);
+		_mm256_storeu_si256((__m256i*)(rgba + a * 4), _mm256_or_si256(v, _mm256_andnot_si256(eq, alpha)));
+	}
+
+	maskFromColourRGBASSE2(rgba + a * 4, count - a, colour);
+}
+
+SIK_AVX2 void maskFromBrightnessRGBAAVX2(uint8_t* rgba, size_t count)
+{
+	const double weights[3] = { 0.3, 0.59, 0.11 };
+	size_t       a          = 0;
+	for (; a + 8 <= count; a += 8)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i*)(rgba + a * 4));
+		__m256i r, g, b;
+		splitRGB8(v, r, g, b);
+
+		__m256i lum = join128(
+			_mm256_cvttpd_epi32(weightedSum8(r, g, b, weights, false)),
+			_mm256_cvttpd_epi32(weightedSum8(r, g, b, weights, true)));
+
+		v = _mm256_or_si256(_mm256_and_si256(v, _mm256_set1_epi32(0x00FFFFFF)), _mm256_slli_epi32(lum, 24));
+		_mm256_storeu_si256((__m256i*)(rgba + a * 4), v);
+	}
+
+	maskFromBrightnessRGBASSE2(rgba + a * 4, count - a);
+}
+
+SIK_AVX2 void cutoffAVX2(uint8_t* data, size_t count, uint8_t threshold)
+{
+	__m256i bias = _mm256_set1_epi8((char)0x80);
+	__m256i t    = _mm256_set1_epi8((char)(threshold ^ 0x80));
+	size_t  a    = 0;
+	for (; a + 32 <= count; a += 32)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i*)(data + a));
+		_mm256_storeu_si256((__m256i*)(data + a), _mm256_cmpgt_epi8(_mm256_xor_si256(v, bias), t));
+	}
+
+	cutoffSSE2(data + a, count - a, threshold);
+}
+
+SIK_AVX2 void cutoffRGBAAVX2(uint8_t* rgba, size_t count, uint8_t threshold)
+{
+	__m256i bias  = _mm256_set1_epi8((char)0x80);
+	__m256i t     = _mm256_set1_epi8((char)(threshold ^ 0x80));
+	__m256i alpha = _mm256_set1_epi32(0xFF000000);
+	size_t  a     = 0;
+	for (; a + 8 <= count; a += 8)
+	{
+		__m256i v  = _mm256_loadu_si256((const __m256i*)(rgba + a * 4));
+		__m256i gt = _mm256_cmpgt_epi8(_mm256_xor_si256(v, bias), t);
+		v          = _mm256_or_si256(_mm256_andnot_si256(alpha, v), _mm256_and_si256(gt, alpha));
+		_mm256_storeu_si256((__m256i*)(rgba + a * 4), v);
+	}
+
+	cutoffRGBASSE2(rgba + a * 4, count - a, threshold);
+}
+
+SIK_AVX2 void colouriseRGBAAVX2(uint8_t* rgba, size_t count, rgba_t colour, const double weights[3])
+{
+	__m256d div = _mm256_set1_pd(255.0f);
+	__m256  one = _mm256_set1_ps(1.0f);
+	__m256  cr  = _mm256_set1_ps((float)colour.r);
+	__m256  cg  = _mm256_set1_ps((float)colour.g);
+	__m256  cb  = _mm256_set1_ps((float)colour.b);
+	size_t  a   = 0;
+	for (; a + 8 <= count; a += 8)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i*)(rgba + a * 4));
+		__m256i r, g, b;
+		splitRGB8(v, r, g, b);
+
+		__m256 grey = _mm256_insertf128_ps(
+			_mm256_castps128_ps256(_mm256_cvtpd_ps(_mm256_div_pd(weightedSum8(r, g, b, weights, false), div))),
+			_mm256_cvtpd_ps(_mm256_div_pd(weightedSum8(r, g, b, weights, true), div)),
+			1);
+		grey = _mm256_min_ps(grey, one);
+
+		r = _mm256_cvttps_epi32(_mm256_mul_ps(cr, grey));
+		g = _mm256_cvttps_epi32(_mm256_mul_ps(cg, grey));
+		b = _mm256_cvttps_epi32(_mm256_mul_ps(cb, grey));
+		_mm256_storeu_si256((__m256i*)(rgba + a * 4), joinRGB8(r, g, b, v));
+	}
+
+	colouriseRGBASSE2(rgba + a * 4, count - a, colour, weights);
+}
+
+SIK_AVX2 void tintRGBAAVX2(uint8_t* rgba, size_t count, rgba_t colour, float amount)
+{
+	__m256 inv = _mm256_set1_ps(1.0f - amount);
+	__m256 tr  = _mm256_set1_ps(colour.r * amount);
+	__m256 tg  = _mm256_set1_ps(colour.g * amount);
+	__m256 tb  = _mm256_set1_ps(colour.b * amount);
+	size_t a   = 0;
+	for (; a + 8 <= count; a += 8)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i*)(rgba + a * 4));
+		__m256i r, g, b;
+		splitRGB8(v, r, g, b);
+
+		r = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(r), inv), tr));
+		g = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(g), inv), tg));
+		b = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(b), inv), tb));
+		_mm256_storeu_si256((__m256i*)(rgba + a * 4), joinRGB8(r, g, b, v));
+	}
+
+	tintRGBASSE2(rgba + a * 4, count - a, colour, amount);
+}
+
+SIK_AVX2 void reverseRowAVX2(const uint8_t* in, uint8_t* out, size_t width, unsigned bpp)
+{
+	size_t x = 0;
+	if (bpp == 4)
+	{
+		__m256i rev = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+		for (; x + 8 <= width; x += 8)
+		{
+			__m256i v = _mm256_loadu_si256((const __m256i*)(in + (width - x - 8) * 4));
+			_mm256_storeu_si256((__m256i*)(out + x * 4), _mm256_permutevar8x32_epi32(v, rev));
+		}
+	}
+	else if (bpp == 1)
+	{
+		// Reverse bytes within each 128-bit lane, then swap the lanes
+		__m256i rev = _mm256_setr_epi8(
+			15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+		for (; x + 32 <= width; x += 32)
+		{
+			__m256i v = _mm256_loadu_si256((const __m256i*)(in + width - x - 32));
+			v         = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, rev), 0x4E);
+			_mm256_storeu_si256((__m256i*)(out + x), v);
+		}
+	}
+
+	reverseRowSSE2(in, out + x * bpp, width - x, bpp);
+}
+
+#endif // SIK_X86
+
+
+// -----------------------------------------------------------------------------
+//
+// Dispatch
+//
+// -----------------------------------------------------------------------------
+
+// The set of implementations for an instruction set
+struct Kernels
+{
+	Isa isa;
+	void (*indexedToRGBA)(const uint8_t*, const uint8_t*, const RGBALut&, uint8_t*, size_t);
+	void (*greyToRGBA)(const uint8_t*, uint8_t*, size_t);
+	void (*maskFromColourRGBA)(uint8_t*, size_t, rgba_t);
+	void (*maskFromBrightnessRGBA)(uint8_t*, size_t);
+	void (*cutoff)(uint8_t*, size_t, uint8_t);
+	void (*cutoffRGBA)(uint8_t*, size_t, uint8_t);
+	void (*colouriseRGBA)(uint8_t*, size_t, rgba_t, const double[3]);
+	void (*tintRGBA)(uint8_t*, size_t, rgba_t, float);
+	void (*reverseRow)(const uint8_t*, uint8_t*, size_t, unsigned);
+};
+
+const Kernels kernels_scalar = { Isa::Scalar,
+								 indexedToRGBAScalar,
+								 greyToRGBAScalar,
+								 maskFromColourRGBAScalar,
+								 maskFromBrightnessRGBAScalar,
+								 cutoffScalar,
+								 cutoffRGBAScalar,
+								 colouriseRGBAScalar,
+								 tintRGBAScalar,
+								 reverseRowScalar };
+
+#ifdef SIK_X86
+const Kernels kernels_sse2 = { Isa::SSE2,
+							   indexedToRGBASSE2,
+							   greyToRGBASSE2,
+							   maskFromColourRGBASSE2,
+							   maskFromBrightnessRGBASSE2,
+							   cutoffSSE2,
+							   cutoffRGBASSE2,
+							   colouriseRGBASSE2,
+							   tintRGBASSE2,
+							   reverseRowSSE2 };
+
+const Kernels kernels_avx2 = { Isa::AVX2,
+							   indexedToRGBAAVX2,
+							   greyToRGBAAVX2,
+							   maskFromColourRGBAAVX2,
+							   maskFromBrightnessRGBAAVX2,
+							   cutoffAVX2,
+							   cutoffRGBAAVX2,
+							   colouriseRGBAAVX2,
+							   tintRGBAAVX2,
+							   reverseRowAVX2 };
+#endif
+
+// -----------------------------------------------------------------------------
+// Returns true if the CPU (and OS) supports [isa]
+// -----------------------------------------------------------------------------
+bool cpuSupports(Isa isa)
+{
+	if (isa == Isa::Scalar)
+		return true;
+
+#if defined(SIK_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int max_leaf = info[0];
+
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	if (isa == Isa::SSE2)
+		return sse2;
+
+	// AVX2 needs OS support for saving the AVX registers (OSXSAVE + XCR0)
+	bool osxsave = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0;
+	if (!osxsave || max_leaf < 7 || (_xgetbv(0) & 6) != 6)
+		return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#elif defined(SIK_X86)
+	__builtin_cpu_init();
+	if (isa == Isa::SSE2)
+		return __builtin_cpu_supports("sse2");
+	return __builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// Returns the implementations for [isa]
+// -----------------------------------------------------------------------------
+const Kernels* kernelsFor(Isa isa)
+{
+#ifdef SIK_X86
+	if (isa == Isa::AVX2)
+		return &kernels_avx2;
+	if (isa == Isa::SSE2)
+		return &kernels_sse2;
+#endif
+	return &kernels_scalar;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the implementations for the best instruction set the CPU supports
+// -----------------------------------------------------------------------------
+const Kernels* bestKernels()
+{
+	if (cpuSupports(Isa::AVX2))
+		return kernelsFor(Isa::AVX2);
+	if (cpuSupports(Isa::SSE2))
+		return kernelsFor(Isa::SSE2);
+	return &kernels_scalar;
+}
+
+std::atomic<const Kernels*> active_kernels{ nullptr };
+
+// -----------------------------------------------------------------------------
+// Returns the implementations currently in use
+// -----------------------------------------------------------------------------
+const Kernels& kernels()
+{
+	auto k = active_kernels.load(std::memory_order_relaxed);
+	if (!k)
+	{
+		k = bestKernels();
+		active_kernels.store(k, std::memory_order_relaxed);
+	}
+
+	return *k;
+}
+
+// -----------------------------------------------------------------------------
+// Rotates [width]x[height] pixels of type T by [angle] (see SImage::rotate),
+// in blocks so both the source and destination stay in cache
+// -----------------------------------------------------------------------------
+template<typename T> void rotatePixels(const T* in, T* out, int width, int height, int angle)
+{
+	const int block = 32;
+	for (int by = 0; by < height; by += block)
+	{
+		int ey = std::min(by + block, height);
+		for (int bx = 0; bx < width; bx += block)
+		{
+			int ex = std::min(bx + block, width);
+			for (int y = by; y < ey; y++)
+			{
+				const T* row = in + y * width;
+				if (angle == 90)
+				{
+					for (int x = bx; x < ex; x++)
+						out[(width - 1 - x) * height + y] = row[x];
+				}
+				else
+				{
+					for (int x = bx; x < ex; x++)
+						out[x * height + (height - 1 - y)] = row[x];
+				}
+			}
+		}
+	}
+}
+
+// 4-byte pixel type for rotatePixels
+struct Pixel32
+{
+	uint8_t bytes[4];
+};
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// SImageKernels Namespace Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Returns the instruction set currently in use
+// -----------------------------------------------------------------------------
+Isa SImageKernels::activeIsa()
+{
+	return kernels().isa;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if [isa] can be used on this CPU
+// -----------------------------------------------------------------------------
+bool SImageKernels::isaSupported(Isa isa)
+{
+	return kernelsFor(isa)->isa == isa && cpuSupports(isa);
+}
+
+// -----------------------------------------------------------------------------
+// Switches to the implementations for [isa] (mostly for testing).
+// Returns false if [isa] isn't supported
+// -----------------------------------------------------------------------------
+bool SImageKernels::setIsa(Isa isa)
+{
+	if (!isaSupported(isa))
+		return false;
+
+	active_kernels.store(kernelsFor(isa));
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the name of [isa]
+// -----------------------------------------------------------------------------
+const char* SImageKernels::isaName(Isa isa)
+{
+	switch (isa)
+	{
+	case Isa::SSE2: return "SSE2";
+	case Isa::AVX2: return "AVX2";
+	default: return "Scalar";
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Fills [lut] with the colours in [pal], fully opaque
+// -----------------------------------------------------------------------------
+void SImageKernels::buildLut(RGBALut& lut, Palette* pal)
+{
+	for (unsigned a = 0; a < 256; a++)
+	{
+		rgba_t col     = pal->colour(a);
+		lut[a * 4]     = col.r;
+		lut[a * 4 + 1] = col.g;
+		lut[a * 4 + 2] = col.b;
+		lut[a * 4 + 3] = 255;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Converts [count] palette indices at [in] to RGBA pixels at [out], with
+// colours from [lut] and alpha from [mask] (fully opaque if [mask] is null)
+// -----------------------------------------------------------------------------
+void SImageKernels::indexedToRGBA(
+	const uint8_t* in,
+	const uint8_t* mask,
+	const RGBALut& lut,
+	uint8_t*       out,
+	size_t         count)
+{
+	kernels().indexedToRGBA(in, mask, lut, out, count);
+}
+
+// -----------------------------------------------------------------------------
+// Converts [count] greyscale values at [in] to RGBA pixels at [out], with the
+// value in all four channels (as for alpha maps)
+// -----------------------------------------------------------------------------
+void SImageKernels::greyToRGBA(const uint8_t* in, uint8_t* out, size_t count)
+{
+	kernels().greyToRGBA(in, out, count);
+}
+
+// -----------------------------------------------------------------------------
+// Sets each of the [count] bytes at [out] to [lut] indexed by the matching
+// byte at [in] ([in] and [out] can be the same)
+// -----------------------------------------------------------------------------
+void SImageKernels::remap(const uint8_t* in, uint8_t* out, const uint8_t* lut, size_t count)
+{
+	size_t a = 0;
+	for (; a + 4 <= count; a += 4)
+	{
+		uint8_t v0 = lut[in[a]];
+		uint8_t v1 = lut[in[a + 1]];
+		uint8_t v2 = lut[in[a + 2]];
+		uint8_t v3 = lut[in[a + 3]];
+		out[a]     = v0;
+		out[a + 1] = v1;
+		out[a + 2] = v2;
+		out[a + 3] = v3;
+	}
+	for (; a < count; a++)
+		out[a] = lut[in[a]];
+}
+
+// -----------------------------------------------------------------------------
+// Sets the alpha of [count] RGBA pixels at [rgba] to 0 where the pixel colour
+// matches [colour] (ignoring alpha), and 255 otherwise
+// -----------------------------------------------------------------------------
+void SImageKernels::maskFromColourRGBA(uint8_t* rgba, size_t count, rgba_t colour)
+{
+	kernels().maskFromColourRGBA(rgba, count, colour);
+}
+
+// -----------------------------------------------------------------------------
+// Sets the alpha of [count] RGBA pixels at [rgba] to their brightness
+// -----------------------------------------------------------------------------
+void SImageKernels::maskFromBrightnessRGBA(uint8_t* rgba, size_t count)
+{
+	kernels().maskFromBrightnessRGBA(rgba, count);
+}
+
+// -----------------------------------------------------------------------------
+// Sets each of the [count] bytes at [data] to 255 if it is greater than
+// [threshold], and 0 otherwise
+// -----------------------------------------------------------------------------
+void SImageKernels::cutoff(uint8_t* data, size_t count, uint8_t threshold)
+{
+	kernels().cutoff(data, count, threshold);
+}
+
+// -----------------------------------------------------------------------------
+// As cutoff, for the alpha of [count] RGBA pixels at [rgba]
+// -----------------------------------------------------------------------------
+void SImageKernels::cutoffRGBA(uint8_t* rgba, size_t count, uint8_t threshold)
+{
+	kernels().cutoffRGBA(rgba, count, threshold);
+}
+
+// -----------------------------------------------------------------------------
+// Colourises [count] RGBA pixels at [rgba] to [colour] (see colourise)
+// -----------------------------------------------------------------------------
+void SImageKernels::colouriseRGBA(uint8_t* rgba, size_t count, rgba_t colour, const double weights[3])
+{
+	kernels().colouriseRGBA(rgba, count, colour, weights);
+}
+
+// -----------------------------------------------------------------------------
+// Tints [count] RGBA pixels at [rgba] to [colour] by [amount] (see tint)
+// -----------------------------------------------------------------------------
+void SImageKernels::tintRGBA(uint8_t* rgba, size_t count, rgba_t colour, float amount)
+{
+	kernels().tintRGBA(rgba, count, colour, amount);
+}
+
+// -----------------------------------------------------------------------------
+// Writes the [width] pixels ([bpp] bytes each) at [in] to [out] in reverse
+// order. [in] and [out] must not overlap
+// -----------------------------------------------------------------------------
+void SImageKernels::reverseRow(const uint8_t* in, uint8_t* out, size_t width, unsigned bpp)
+{
+	kernels().reverseRow(in, out, width, bpp);
+}
+
+// -----------------------------------------------------------------------------
+// Writes the [width]x[height] pixels ([bpp] bytes each) at [in] to [out],
+// rotated by [angle] (90, 180 or 270, clockwise - see SImage::rotate)
+// -----------------------------------------------------------------------------
+void SImageKernels::rotate(const uint8_t* in, uint8_t* out, int width, int height, unsigned bpp, int angle)
+{
+	if (angle == 180)
+		reverseRow(in, out, (size_t)width * height, bpp);
+	else if (bpp == 4)
+		rotatePixels((const Pixel32*)in, (Pixel32*)out, width, height, angle);
+	else if (bpp == 1)
+		rotatePixels(in, out, width, height, angle);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the brightness of [colour], as used for alpha by
+// SImage::maskFromBrightness
+// -----------------------------------------------------------------------------
+uint8_t SImageKernels::brightness(rgba_t colour)
+{
+	return (double)colour.r * 0.3 + (double)colour.g * 0.59 + (double)colour.b * 0.11;
+}
+
+// -----------------------------------------------------------------------------
+// Returns [col] colourised to [colour], using [weights] for each channel to get
+// the grey level of [col]
+// -----------------------------------------------------------------------------
+rgba_t SImageKernels::colourise(rgba_t col, rgba_t colour, const double weights[3])
+{
+	float grey = (col.r * weights[0] + col.g * weights[1] + col.b * weights[2]) / 255.0f;
+	if (grey > 1.0)
+		grey = 1.0;
+	col.r = colour.r * grey;
+	col.g = colour.g * grey;
+	col.b = colour.b * grey;
+
+	return col;
+}
+
+// -----------------------------------------------------------------------------
+// Returns [col] tinted to [colour] by [amount]
+// -----------------------------------------------------------------------------
+rgba_t SImageKernels::tint(rgba_t col, rgba_t colour, float amount)
+{
+	float inv_amt = 1.0f - amount;
+	col.set(
+		col.r * inv_amt + colour.r * amount, col.g * inv_amt + colour.g * amount, col.b * inv_amt + colour.b * amount, col.a);
+
+	return col;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Benchmarks each kernel with each supported instruction set on random pixel
+// data, and checks the results are identical to the scalar versions.
+// Optionally takes the number of times to run each kernel (default 20)
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(test_simage_kernels, 0, false)
+{
+	long iterations = 20;
+	if (!args.empty())
+		args[0].ToLong(&iterations);
+	if (iterations < 1)
+		iterations = 1;
+
+	// Random test data (odd size, to test the scalar tails)
+	const int       width = 1023, height = 517;
+	const size_t    count = (size_t)width * height;
+	std::mt19937    rng(1234);
+	vector<uint8_t> indexed(count), mask(count), rgba(count * 4);
+	for (auto& v : indexed)
+		v = rng();
+	for (auto& v : mask)
+		v = rng();
+	for (auto& v : rgba)
+		v = rng();
+
+	// Make sure some pixels match the masked colour
+	rgba_t key(rgba[0], rgba[1], rgba[2]);
+	for (size_t a = 0; a < count; a += 7)
+		memcpy(&rgba[a * 4], &rgba[0], 3);
+
+	Palette pal;
+	for (unsigned a = 0; a < 256; a++)
+		pal.setColour(a, rgba_t(rng(), rng(), rng(), 255));
+	RGBALut lut;
+	buildLut(lut, &pal);
+
+	const double weights[3] = { 0.299, 0.587, 0.114 };
+	rgba_t       colour(200, 100, 50);
+
+	// Kernels to test, each takes the input and writes to the output buffer
+	typedef std::function<void(vector<uint8_t>&)> Kernel;
+	vector<std::pair<string, Kernel>> tests = {
+		{ "indexedToRGBA", [&](vector<uint8_t>& out) { indexedToRGBA(indexed.data(), mask.data(), lut, out.data(), count); } },
+		{ "greyToRGBA", [&](vector<uint8_t>& out) { greyToRGBA(indexed.data(), out.data(), count); } },
+		{ "maskFromColour", [&](vector<uint8_t>& out) { out = rgba; maskFromColourRGBA(out.data(), count, key); } },
+		{ "maskFromBrightness", [&](vector<uint8_t>& out) { out = rgba; maskFromBrightnessRGBA(out.data(), count); } },
+		{ "cutoff", [&](vector<uint8_t>& out) { out = mask; cutoff(out.data(), count, 127); } },
+		{ "cutoffRGBA", [&](vector<uint8_t>& out) { out = rgba; cutoffRGBA(out.data(), count, 127); } },
+		{ "colourise", [&](vector<uint8_t>& out) { out = rgba; colouriseRGBA(out.data(), count, colour, weights); } },
+		{ "tint", [&](vector<uint8_t>& out) { out = rgba; tintRGBA(out.data(), count, colour, 0.37f); } },
+		{ "mirror (RGBA)",
+		  [&](vector<uint8_t>& out) {
+			  for (int y = 0; y < height; y++)
+				  reverseRow(&rgba[y * width * 4], &out[y * width * 4], width, 4);
+		  } },
+		{ "mirror (paletted)",
+		  [&](vector<uint8_t>& out) {
+			  for (int y = 0; y < height; y++)
+				  reverseRow(&indexed[y * width], &out[y * width], width, 1);
+		  } },
+		{ "rotate (RGBA)", [&](vector<uint8_t>& out) { rotate(rgba.data(), out.data(), width, height, 4, 90); } },
+	};
+
+	Isa isa_prev = activeIsa();
+	for (auto& test : tests)
+	{
+		string          line = S_FMT("%-20s", CHR(test.first));
+		vector<uint8_t> expected(count * 4), out(count * 4);
+		for (auto isa : { Isa::Scalar, Isa::SSE2, Isa::AVX2 })
+		{
+			if (!setIsa(isa))
+				continue;
+
+			auto start = std::chrono::steady_clock::now();
+			for (long a = 0; a < iterations; a++)
+				test.second(out);
+			auto   end = std::chrono::steady_clock::now();
+			double ms  = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+
+			if (isa == Isa::Scalar)
+				expected = out;
+			line += S_FMT(" %s %.3fms%s", isaName(isa), ms, (out == expected) ? "" : " (MISMATCH)");
+		}
+		Log::console(line);
+	}
+	setIsa(isa_prev);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+class Palette;
+
+// Bulk pixel operations used by SImage, with SSE2 and AVX2 implementations
+// selected at runtime depending on what the CPU supports (and a scalar
+// fallback for everything else). All implementations give exactly the same
+// results as the scalar ones, including for the floating point operations
+namespace SImageKernels
+{
+enum class Isa
+{
+	Scalar,
+	SSE2,
+	AVX2,
+};
+
+Isa         activeIsa();
+bool        isaSupported(Isa isa);
+bool        setIsa(Isa isa);
+const char* isaName(Isa isa);
+
+// Palette lookup table for indexedToRGBA, 4 bytes (RGBA) for each index
+typedef uint8_t RGBALut[256 * 4];
+void buildLut(RGBALut& lut, Palette* pal);
+
+// Conversion
+void indexedToRGBA(const uint8_t* in, const uint8_t* mask, const RGBALut& lut, uint8_t* out, size_t count);
+void greyToRGBA(const uint8_t* in, uint8_t* out, size_t count);
+void remap(const uint8_t* in, uint8_t* out, const uint8_t* lut, size_t count);
+
+// Alpha/mask
+void maskFromColourRGBA(uint8_t* rgba, size_t count, rgba_t colour);
+void maskFromBrightnessRGBA(uint8_t* rgba, size_t count);
+void cutoff(uint8_t* data, size_t count, uint8_t threshold);
+void cutoffRGBA(uint8_t* rgba, size_t count, uint8_t threshold);
+
+// Colour
+void colouriseRGBA(uint8_t* rgba, size_t count, rgba_t colour, const double weights[3]);
+void tintRGBA(uint8_t* rgba, size_t count, rgba_t colour, float amount);
+
+// Geometry
+void reverseRow(const uint8_t* in, uint8_t* out, size_t width, unsigned bpp);
+void rotate(const uint8_t* in, uint8_t* out, int width, int height, unsigned bpp, int angle);
+
+// Scalar reference versions of the per-pixel formulas, for paletted images
+uint8_t brightness(rgba_t colour);
+rgba_t  colourise(rgba_t col, rgba_t colour, const double weights[3]);
+rgba_t  tint(rgba_t col, rgba_t colour, float amount);
+} // namespace SImageKernels
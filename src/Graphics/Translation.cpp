@@ -183,9 +183,9 @@ void Translation::parse(string def)
 	Tokenizer tz;
 	tz.setSpecialCharacters(",");
 	tz.openString(def);
-	parseRange(tz.current().text);
+	parseRange(tz.current().text());
 	while (tz.advIfNext(','))
-		parseRange(tz.next().text);
+		parseRange(tz.next().text());
 }
 
 // ----------------------------------------------------------------------------
@@ -359,7 +359,7 @@ void Translation::parseRange(string range)
 		TransRangeSpecial* tr = new TransRangeSpecial();
 		tr->o_start = o_start;
 		tr->o_end = o_end;
-		tr->special = tz.next().text; //special;
+		tr->special = tz.next().text(); //special;
 		translations.push_back(tr);
 	}
 	else
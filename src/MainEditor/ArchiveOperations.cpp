@@ -295,6 +295,43 @@ void ArchiveOperations::removeEntriesUnchangedFromIWAD(Archive* archive)
 	msg.ShowModal();
 }
 
+/* ArchiveOperations::compactWad
+ * Saves [archive] (if it is a wad file), rewriting the whole file to
+ * remove any unused space left by previous in-place saves
+ *******************************************************************/
+bool ArchiveOperations::compactWad(Archive* archive)
+{
+	if (!archive)
+		return false;
+
+	if (archive->formatId() != "wad")
+	{
+		wxMessageBox("Only Doom Wad format archives can be compacted", "Compact Wad", wxICON_ERROR);
+		return false;
+	}
+
+	if (!archive->canSave())
+	{
+		wxMessageBox("The archive must be saved to a file first", "Compact Wad", wxICON_ERROR);
+		return false;
+	}
+
+	// Rewrite the wad
+	wxULongLong old_size = wxFileName::GetSize(archive->filename());
+	if (!((WadArchive*)archive)->compact())
+	{
+		wxMessageBox(S_FMT("Error:\n%s", Global::error), "Error", wxICON_ERROR);
+		return false;
+	}
+
+	wxULongLong new_size = wxFileName::GetSize(archive->filename());
+	if (old_size != wxInvalidSize && new_size != wxInvalidSize && old_size > new_size)
+		LOG_MESSAGE(1, "Compacted %s, removed %s of unused space", archive->filename(false),
+			wxFileName::GetHumanReadableSize(old_size - new_size));
+
+	return true;
+}
+
 /* ArchiveOperations::checkDuplicateEntryContent
  * Checks [archive] for multiple entries with the same data, and
  * displays a list of the duplicate entries' names if any are found
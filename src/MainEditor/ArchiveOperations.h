@@ -12,6 +12,7 @@ namespace ArchiveOperations
 	void	removeUnusedTextures(Archive* archive);
 	void	removeUnusedFlats(Archive* archive);
 	void	removeEntriesUnchangedFromIWAD(Archive* archive);
+	bool	compactWad(Archive* archive);
 
 	// Search and replace in maps
 	size_t	replaceThings(Archive* archive, int oldtype, int newtype);
@@ -84,9 +84,12 @@ DirArchiveCheck::DirArchiveCheck(wxEvtHandler* handler, DirArchive* archive)
 {
 	this->handler_ = handler;
 	dir_path_ = archive->filename();
-	removed_files_ = archive->removedFiles();
+	removed_files_.insert(archive->removedFiles().begin(), archive->removedFiles().end());
 	change_list_.archive = archive;
 
+	// Get paths changed since the last check, if the archive is being watched
+	watched_ = archive->changedPaths(changed_paths_, renamed_paths_);
+
 	// Get flat entry list
 	vector<ArchiveEntry*> entries;
 	archive->getEntryTreeAsList(entries);
@@ -100,6 +103,9 @@ DirArchiveCheck::DirArchiveCheck(wxEvtHandler* handler, DirArchive* archive)
 		inf.is_dir = (entries[a]->getType() == EntryType::folderType());
 		inf.file_modified = archive->fileModificationTime(entries[a]);
 		entry_info_.push_back(inf);
+
+		if (!inf.file_path.IsEmpty())
+			entry_index_.emplace(inf.file_path, entry_info_.size() - 1);
 	}
 }
 
@@ -124,11 +130,23 @@ void DirArchiveCheck::addChange(DirEntryChange change)
 }
 
 // ----------------------------------------------------------------------------
-// DirArchiveCheck::Entry
+// DirArchiveCheck::entryInfo
 //
-// DirArchiveCheck thread entry function
+// Returns the info for the entry at [file_path] on disk, or null if no entry
+// in the archive is at that path
 // ----------------------------------------------------------------------------
-wxThread::ExitCode DirArchiveCheck::Entry()
+const DirArchiveCheck::EntryInfo* DirArchiveCheck::entryInfo(const string& file_path) const
+{
+	auto i = entry_index_.find(file_path);
+	return i == entry_index_.end() ? nullptr : &entry_info_[i->second];
+}
+
+// ----------------------------------------------------------------------------
+// DirArchiveCheck::checkAll
+//
+// Checks the whole directory tree for changes
+// ----------------------------------------------------------------------------
+void DirArchiveCheck::checkAll()
 {
 	// Get current directory structure
 	vector<string> files, dirs;
@@ -161,57 +179,189 @@ wxThread::ExitCode DirArchiveCheck::Entry()
 	for (unsigned a = 0; a < files.size(); a++)
 	{
 		// Ignore files removed from archive since last save
-		if (VECTOR_EXISTS(removed_files_, files[a]))
+		if (removed_files_.count(files[a]))
 			continue;
 
 		// Find file in archive
-		EntryInfo inf;
-		bool found = false;
-		for (unsigned b = 0; b < entry_info_.size(); b++)
-		{
-			if (entry_info_[b].file_path == files[a])
-			{
-				inf = entry_info_[b];
-				found = true;
-				break;
-			}
-		}
+		auto inf = entryInfo(files[a]);
 
 		time_t mod = wxFileModificationTime(files[a]);
 		// No match, added to archive
-		if (!found)
+		if (!inf)
 			addChange(DirEntryChange(DirEntryChange::ADDED_FILE, files[a], "", mod));
 		// Matched, check modification time
-		else if (mod > inf.file_modified)
-			addChange(DirEntryChange(DirEntryChange::UPDATED, files[a], inf.entry_path, mod));
+		else if (mod > inf->file_modified)
+			addChange(DirEntryChange(DirEntryChange::UPDATED, files[a], inf->entry_path, mod));
 	}
 
 	// Check for new dirs
 	for (unsigned a = 0; a < dirs.size(); a++)
 	{
 		// Ignore dirs removed from archive since last save
-		if (VECTOR_EXISTS(removed_files_, dirs[a]))
+		if (removed_files_.count(dirs[a]))
 			continue;
 
-		// Find dir in archive
-		EntryInfo inf;
-		bool found = false;
-		for (unsigned b = 0; b < entry_info_.size(); b++)
+		time_t mod = wxDateTime::Now().GetTicks();
+		// Not in archive, added
+		if (!entryInfo(dirs[a]))
+			addChange(DirEntryChange(DirEntryChange::ADDED_DIR, dirs[a], "", mod));
+	}
+}
+
+// ----------------------------------------------------------------------------
+// DirArchiveCheck::renameEntry
+//
+// Adds a change to [changes] renaming the entry (or directory) at [path] on
+// disk to [new_path], and updates the info of the entry and anything in it to
+// match. Returns false if the rename can't be applied to the archive as-is, in
+// which case both paths should be checked for changes instead
+// ----------------------------------------------------------------------------
+bool DirArchiveCheck::renameEntry(const string& path, const string& new_path, vector<DirEntryChange>& changes)
+{
+	// Only renames within the same directory keep the entry, the archive has no
+	// way to move entries (or directories) into a different directory
+	auto i = entry_index_.find(path);
+	if (i == entry_index_.end() || entry_index_.count(new_path) || removed_files_.count(path)
+		|| removed_files_.count(new_path) || wxFileName(path).GetPath() != wxFileName(new_path).GetPath())
+		return false;
+
+	size_t index = i->second;
+	string entry_path = entry_info_[index].entry_path;
+	string new_entry_path = entry_path.BeforeLast('/') + "/" + wxFileName(new_path).GetFullName();
+	changes.emplace_back(
+		entry_info_[index].is_dir ? DirEntryChange::RENAMED_DIR : DirEntryChange::RENAMED_FILE,
+		new_path,
+		entry_path,
+		entry_info_[index].file_modified);
+
+	// Update paths of the entry and anything in it, so any later changes are
+	// checked against the renamed entries
+	string sub_path = path + wxFileName::GetPathSeparator();
+	for (size_t a = 0; a < entry_info_.size(); a++)
+	{
+		EntryInfo& inf = entry_info_[a];
+		if (inf.file_path != path && !inf.file_path.StartsWith(sub_path))
+			continue;
+
+		entry_index_.erase(inf.file_path);
+		inf.file_path = new_path + inf.file_path.Mid(path.size());
+		inf.entry_path = new_entry_path + inf.entry_path.Mid(entry_path.size());
+		entry_index_.emplace(inf.file_path, a);
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+// DirArchiveCheck::checkChangedPaths
+//
+// Checks only the paths the archive's watcher reported as changed, giving the
+// same results (and order of changes) as checkAll would, other than renames
+// ----------------------------------------------------------------------------
+void DirArchiveCheck::checkChangedPaths()
+{
+	vector<DirEntryChange> renamed, deleted, files, dirs;
+
+	// Renames go first, in the order they happened on disk
+	for (auto& rename : renamed_paths_)
+	{
+		if (renameEntry(rename.key, rename.value, renamed))
+			continue;
+
+		// Can't rename, check both paths (and anything in the directory, if
+		// it is one) as changed instead
+		changed_paths_.push_back(rename.key);
+		changed_paths_.push_back(rename.value);
+		if (wxDirExists(rename.value))
 		{
-			if (entry_info_[b].file_path == dirs[a])
-			{
-				inf = entry_info_[b];
-				found = true;
-				break;
-			}
+			vector<string> dir_files, dir_dirs;
+			DirArchiveTraverser traverser(dir_files, dir_dirs);
+			wxDir dir(rename.value);
+			dir.Traverse(traverser, "", wxDIR_FILES | wxDIR_DIRS);
+			changed_paths_.insert(changed_paths_.end(), dir_files.begin(), dir_files.end());
+			changed_paths_.insert(changed_paths_.end(), dir_dirs.begin(), dir_dirs.end());
 		}
+	}
+	if (!renamed_paths_.empty())
+	{
+		std::sort(changed_paths_.begin(), changed_paths_.end());
+		changed_paths_.erase(std::unique(changed_paths_.begin(), changed_paths_.end()), changed_paths_.end());
+	}
 
-		time_t mod = wxDateTime::Now().GetTicks();
-		// No match, added to archive
-		if (!found)
-			addChange(DirEntryChange(DirEntryChange::ADDED_DIR, dirs[a], "", mod));
+	PathSet deleted_paths;
+	for (auto& path : changed_paths_)
+	{
+		auto inf = entryInfo(path);
+
+		if (wxFileExists(path))
+		{
+			// Ignore files removed from archive since last save
+			if (removed_files_.count(path))
+				continue;
+
+			time_t mod = wxFileModificationTime(path);
+			// No match, added to archive
+			if (!inf)
+				files.emplace_back(DirEntryChange::ADDED_FILE, path, "", mod);
+			// Matched, check modification time
+			else if (!inf->is_dir && mod > inf->file_modified)
+				files.emplace_back(DirEntryChange::UPDATED, path, inf->entry_path, mod);
+		}
+		else if (wxDirExists(path))
+		{
+			// Not in archive (and not removed since last save), added
+			if (!inf && !removed_files_.count(path))
+				dirs.emplace_back(DirEntryChange::ADDED_DIR, path, "", wxDateTime::Now().GetTicks());
+		}
+		else if (inf)
+		{
+			// In archive but no longer on disk, deleted
+			deleted_paths.insert(path);
+		}
+	}
+
+	// Anything in a deleted (or moved away) directory is gone too, list these
+	// in the same order as checkAll does
+	if (!deleted_paths.empty())
+	{
+		for (auto& inf : entry_info_)
+		{
+			string path = inf.file_path;
+			while (path.size() > dir_path_.size() && !deleted_paths.count(path))
+				path = path.BeforeLast(wxFileName::GetPathSeparator());
+			if (path.size() <= dir_path_.size())
+				continue;
+
+			deleted.emplace_back(
+				inf.is_dir ? DirEntryChange::DELETED_DIR : DirEntryChange::DELETED_FILE,
+				inf.file_path,
+				inf.entry_path);
+		}
 	}
 
+	for (auto& change : renamed)
+		addChange(change);
+	for (auto& change : deleted)
+		addChange(change);
+	for (auto& change : files)
+		addChange(change);
+	for (auto& change : dirs)
+		addChange(change);
+}
+
+// ----------------------------------------------------------------------------
+// DirArchiveCheck::Entry
+//
+// DirArchiveCheck thread entry function
+// ----------------------------------------------------------------------------
+wxThread::ExitCode DirArchiveCheck::Entry()
+{
+	// Check for changes
+	if (watched_)
+		checkChangedPaths();
+	else
+		checkAll();
+
 	// Send changes via event
 	wxThreadEvent* event = new wxThreadEvent(wxEVT_COMMAND_DIRARCHIVECHECK_COMPLETED);
 	event->SetPayload<DirArchiveChangeList>(change_list_);
@@ -5,6 +5,7 @@
 #include "General/SAction.h"
 #include "UI/Controls/DockPanel.h"
 #include "UI/Lists/ListView.h"
+#include <unordered_set>
 
 class ArchiveManagerPanel;
 class ArchivePanel;
@@ -38,13 +39,24 @@ private:
 		time_t	file_modified;
 	};
 
+	typedef std::unordered_map<string, size_t, wxStringHash, wxStringEqual> PathIndex;
+	typedef std::unordered_set<string, wxStringHash, wxStringEqual> PathSet;
+
 	wxEvtHandler*			handler_;
 	string					dir_path_;
 	vector<EntryInfo>		entry_info_;
-	vector<string>			removed_files_;
+	PathIndex				entry_index_;	// file_path -> entry_info_ index
+	PathSet					removed_files_;
+	bool					watched_;		// Only changed_paths_ need to be checked
+	vector<string>			changed_paths_;
+	vector<key_value_t>		renamed_paths_;	// Old path -> new path, in order
 	DirArchiveChangeList	change_list_;
 
-	void addChange(DirEntryChange change);
+	void				addChange(DirEntryChange change);
+	const EntryInfo*	entryInfo(const string& file_path) const;
+	bool				renameEntry(const string& path, const string& new_path, vector<DirEntryChange>& changes);
+	void				checkAll();
+	void				checkChangedPaths();
 };
 
 class WMFileBrowser : public wxGenericDirCtrl
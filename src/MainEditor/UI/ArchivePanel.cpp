@@ -60,6 +60,7 @@
 #include "General/KeyBind.h"
 #include "General/Misc.h"
 #include "General/UI.h"
+#include "Graphics/GfxConverter.h"
 #include "Graphics/Icons.h"
 #include "Graphics/Palette/PaletteManager.h"
 #include "MainEditor/ArchiveOperations.h"
@@ -521,6 +522,7 @@ void ArchivePanel::addMenus()
 		SAction::fromId("arch_check_duplicates")->addToMenu(menu_clean);
 		SAction::fromId("arch_check_duplicates2")->addToMenu(menu_clean);
 		SAction::fromId("arch_replace_maps")->addToMenu(menu_clean);
+		SAction::fromId("arch_compact")->addToMenu(menu_clean);
 		menu_archive->AppendSubMenu(menu_clean, "&Maintenance");
 		auto menu_scripts = new wxMenu();
 		ScriptManager::populateEditorScriptMenu(menu_scripts, ScriptManager::ScriptType::Archive, "arch_script");
@@ -1955,38 +1957,56 @@ bool ArchivePanel::gfxConvert()
 	gcd.ShowModal();
 
 	// Show splash window
-	UI::showSplash("Writing converted image data...", true);
+	UI::showSplash("Writing converted image data... (Esc to cancel)", true);
 
 	// Begin recording undo level
 	undo_manager_->beginRecord("Gfx Format Conversion");
 
-	// Write any changes
-	entry_list_->setEntriesAutoUpdate(false);
+	// Encode converted images in the background
+	GfxConverter converter;
+	vector<ArchiveEntry*> entries;
 	for (unsigned a = 0; a < selection.size(); a++)
 	{
-		if (a == selection.size()-1)
-			entry_list_->setEntriesAutoUpdate(true);
-
-		// Update splash window
-		UI::setSplashProgressMessage(selection[a]->getName());
-		UI::setSplashProgress((float)a / (float)selection.size());
-
 		// Skip if the image wasn't converted
 		if (!gcd.itemModified(a))
 			continue;
 
-		// Get image and conversion info
 		SImage* image = gcd.getItemImage(a);
-		SIFormat* format = gcd.getItemFormat(a);
-
-		// Write converted image back to entry
-		MemChunk mc;
-		format->saveImage(*image, mc, gcd.getItemPalette(a));
-		selection[a]->importMemChunk(mc);
-		EntryType::detectEntryType(selection[a]);
-		selection[a]->setExtensionByType();
+		auto& conv = converter.addItem();
+		conv.format = gcd.getItemFormat(a);
+		conv.encode = true;
+		conv.pal_target = converter.copyPalette(gcd.getItemPalette(a));
+		conv.loader = [image](SImage& img) { return img.copyImage(image); };
+		entries.push_back(selection[a]);
 	}
+
+	// Write converted image data back to entries, in order
+	entry_list_->setEntriesAutoUpdate(false);
+	converter.run(
+		[&](GfxConverter::Item& conv, size_t index)
+		{
+			ArchiveEntry* entry = entries[index];
+			if (conv.status != GfxConverter::Status::Ok)
+			{
+				LOG_MESSAGE(1, "Unable to write converted image %s: %s", entry->getName(), conv.error);
+				return true;
+			}
+
+			entry->importMemChunk(conv.data);
+			EntryType::detectEntryType(entry);
+			entry->setExtensionByType();
+			return true;
+		},
+		[&](size_t done, size_t total)
+		{
+			// Update splash window
+			UI::setSplashProgressMessage(S_FMT("%lu of %lu", done, total));
+			UI::setSplashProgress((float)done / (float)total);
+			return !wxGetKeyState(WXK_ESCAPE);
+		});
 	entry_list_->setEntriesAutoUpdate(true);
+	if (!entries.empty())
+		entry_list_->applyFilter();
 
 	// Finish recording undo level
 	undo_manager_->endRecord(true);
@@ -3190,6 +3210,10 @@ bool ArchivePanel::handleAction(string id)
 	else if (id == "arch_clean_iwaddupes")
 		ArchiveOperations::removeEntriesUnchangedFromIWAD(archive_);
 
+	// Archive->Maintenance->Compact Wad
+	else if (id == "arch_compact")
+		ArchiveOperations::compactWad(archive_);
+
 	// Archive->Maintenance->Replace in Maps
 	else if (id == "arch_replace_maps")
 	{
@@ -71,19 +71,36 @@ PatchBrowserItem::~PatchBrowserItem()
 // ----------------------------------------------------------------------------
 bool PatchBrowserItem::loadImage()
 {
+	auto loader = imageLoader();
+	if (!loader)
+		return false;
+
 	SImage img;
+	loader(img);
+	return setImage(img);
+}
 
+// ----------------------------------------------------------------------------
+// PatchBrowserItem::imageLoader
+//
+// Returns a function that loads the item's image from its associated entry
+// or texture (if any)
+// ----------------------------------------------------------------------------
+BrowserItem::ImageLoader PatchBrowserItem::imageLoader()
+{
 	// Load patch image
 	if (type_ == 0)
 	{
 		// Find patch entry
 		ArchiveEntry* entry = theResourceManager->getPatchEntry(name_, nspace_, archive_);
+		if (!entry)
+			return nullptr;
 
-		// Load entry to image, if it exists
-		if (entry)
-			Misc::loadImageFromEntry(&img, entry);
-		else
-			return false;
+		// Detect entry type here, it can't be done on a worker thread
+		if (entry->getType() == EntryType::unknownType())
+			EntryType::detectEntryType(entry);
+
+		return [entry](SImage& img) { return Misc::loadImageFromEntry(&img, entry); };
 	}
 
 	// Or, load texture image
@@ -91,18 +108,33 @@ bool PatchBrowserItem::loadImage()
 	{
 		// Find texture
 		CTexture* tex = theResourceManager->getTexture(name_, archive_);
+		if (!tex)
+			return nullptr;
 
-		// Load texture to image, if it exists
-		if (tex)
-			tex->toImage(img, archive_, parent_->getPalette());
-		else
-			return false;
+		// Detect patch entry types here, as above
+		tex->detectPatchTypes(archive_);
+
+		// Copy the palette, the browser's palette could change while loading
+		auto pal = std::make_shared<Palette>();
+		pal->copyPalette(parent_->getPalette());
+		Archive* archive = archive_;
+
+		return [tex, archive, pal](SImage& img) { return tex->toImage(img, archive, pal.get()); };
 	}
 
-	// Create gl texture from image
+	return nullptr;
+}
+
+// ----------------------------------------------------------------------------
+// PatchBrowserItem::setImage
+//
+// Creates the item's gl texture from [image]
+// ----------------------------------------------------------------------------
+bool PatchBrowserItem::setImage(SImage& image)
+{
 	if (image_) delete image_;
 	image_ = new GLTexture();
-	return image_->loadImage(&img, parent_->getPalette());
+	return image_->loadImage(&image, parent_->getPalette());
 }
 
 // ----------------------------------------------------------------------------
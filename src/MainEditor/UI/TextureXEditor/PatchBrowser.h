@@ -23,8 +23,10 @@ public:
 
 	~PatchBrowserItem();
 
-	bool	loadImage() override;
-	string	itemInfo() override;
+	bool		loadImage() override;
+	ImageLoader	imageLoader() override;
+	bool		setImage(SImage& image) override;
+	string		itemInfo() override;
 
 private:
 	Archive*	archive_;
@@ -0,0 +1,769 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MapImage.cpp
+// Description: Software rendering of map overview images, straight from the
+//              map lumps in an archive (no OpenGL or map editor needed)
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "MapImage.h"
+#include "Archive/Formats/WadArchive.h"
+#include "General/ColourConfiguration.h"
+#include "General/Console/Console.h"
+#include "Graphics/SImage/SIFormat.h"
+#include "Graphics/SImage/SImage.h"
+#include "MainEditor/MainEditor.h"
+#include "MapEditor/SLADEMap/MapLine.h"
+#include "MapEditor/SLADEMap/MapSector.h"
+#include "MapEditor/SLADEMap/MapSide.h"
+#include "MapEditor/SLADEMap/MapThing.h"
+#include "MapEditor/SLADEMap/MapVertex.h"
+#include "Utility/ThreadPool.h"
+#include "Utility/Tokenizer.h"
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Float, map_image_thickness, 1.5, CVAR_SAVE)
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// Largest image width/height that will be rendered
+const int MAX_SIZE = 16384;
+
+// -----------------------------------------------------------------------------
+// Reads [count] structs of type [T] from [mc], calling [func] for each
+// -----------------------------------------------------------------------------
+template<typename T, typename F> void readStructs(const MemChunk& mc, F func)
+{
+	unsigned count = mc.getSize() / sizeof(T);
+	T        item;
+	for (unsigned a = 0; a < count; a++)
+	{
+		memcpy(&item, mc.getData() + a * sizeof(T), sizeof(T));
+		func(item);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Reads the sector index of each side in [mc], sides of type [T]
+// -----------------------------------------------------------------------------
+template<typename T> vector<int> readSideSectors(const MemChunk& mc)
+{
+	vector<int> sectors;
+	readStructs<T>(mc, [&](const T& side) { sectors.push_back(side.sector); });
+	return sectors;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the sector index of side [side] in [sides], or -1 if it's invalid
+// -----------------------------------------------------------------------------
+int sideSector(const vector<int>& sides, unsigned side)
+{
+	return side < sides.size() ? sides[side] : -1;
+}
+
+// -----------------------------------------------------------------------------
+// Reads UDMF map data from [lumps] into [data]
+// -----------------------------------------------------------------------------
+bool readUDMF(const MapImage::MapLumps& lumps, MapImage::MapData& data)
+{
+	Tokenizer tz;
+	if (!tz.openMem(lumps.textmap, lumps.name))
+		return false;
+
+	vector<int> side_sectors;
+	while (tz.current().valid)
+	{
+		string block = tz.current().text();
+		tz.adv();
+
+		// Skip global assignments (namespace etc.)
+		if (tz.check('='))
+		{
+			while (tz.current().valid && !tz.check(';'))
+				tz.adv();
+			tz.adv();
+			continue;
+		}
+
+		if (!tz.check('{'))
+		{
+			Global::error = S_FMT("Bad syntax for %s block in UDMF map data", CHR(block));
+			return false;
+		}
+		tz.adv();
+
+		// Read the fields we're interested in
+		MapImage::Point point{ 0., 0. };
+		MapImage::Line  line;
+		int             v1 = -1, v2 = -1, side1 = -1, side2 = -1, sector = -1, light = 160;
+		bool            got_x = false, got_y = false;
+		while (tz.current().valid && !tz.check('}'))
+		{
+			Tokenizer::Token key = tz.current();
+			tz.adv();
+			if (!tz.check('='))
+			{
+				Global::error = S_FMT("Bad syntax for %s block in UDMF map data", CHR(block));
+				return false;
+			}
+			tz.adv();
+
+			const Tokenizer::Token& value = tz.current();
+			if (key.equalsNC("x"))
+				point.x = value.asFloat(), got_x = true;
+			else if (key.equalsNC("y"))
+				point.y = value.asFloat(), got_y = true;
+			else if (key.equalsNC("v1"))
+				v1 = value.asInt();
+			else if (key.equalsNC("v2"))
+				v2 = value.asInt();
+			else if (key.equalsNC("sidefront"))
+				side1 = value.asInt();
+			else if (key.equalsNC("sideback"))
+				side2 = value.asInt();
+			else if (key.equalsNC("special"))
+				line.special = value.asInt() != 0;
+			else if (key.equalsNC("sector"))
+				sector = value.asInt();
+			else if (key.equalsNC("lightlevel"))
+				light = value.asInt();
+
+			// Skip to end of field
+			while (tz.current().valid && !tz.check(';') && !tz.check('}'))
+				tz.adv();
+			if (tz.check(';'))
+				tz.adv();
+		}
+		tz.adv();
+
+		// Add the object
+		if (S_CMPNOCASE(block, "vertex"))
+		{
+			if (!got_x || !got_y)
+			{
+				Global::error = S_FMT("Vertex %d in UDMF map data has no position", (int)data.vertices.size());
+				return false;
+			}
+			data.vertices.push_back(point);
+		}
+		else if (S_CMPNOCASE(block, "linedef"))
+		{
+			if (v1 < 0 || v2 < 0)
+			{
+				Global::error = S_FMT("Line %d in UDMF map data has no vertices", (int)data.lines.size());
+				return false;
+			}
+			line.v1       = v1;
+			line.v2       = v2;
+			line.sector1  = side1;
+			line.sector2  = side2; // Side indices for now, resolved to sectors below
+			line.twosided = side2 >= 0;
+			data.lines.push_back(line);
+		}
+		else if (S_CMPNOCASE(block, "sidedef"))
+			side_sectors.push_back(sector);
+		else if (S_CMPNOCASE(block, "sector"))
+			data.sector_light.push_back(std::max(0, std::min(light, 255)));
+		else if (S_CMPNOCASE(block, "thing") && got_x && got_y)
+			data.things.push_back(point);
+	}
+
+	// Sides can be defined after the lines that use them
+	for (auto& line : data.lines)
+	{
+		line.sector1 = line.sector1 >= 0 ? sideSector(side_sectors, line.sector1) : -1;
+		line.sector2 = line.sector2 >= 0 ? sideSector(side_sectors, line.sector2) : -1;
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads binary (Doom/Hexen/Doom64) map data from [lumps] into [data]
+// -----------------------------------------------------------------------------
+bool readBinary(const MapImage::MapLumps& lumps, MapImage::MapData& data)
+{
+	// Can't do anything without vertices and lines
+	if (lumps.vertexes.getSize() == 0 || lumps.linedefs.getSize() == 0)
+	{
+		Global::error = "Map has no VERTEXES or LINEDEFS";
+		return false;
+	}
+
+	bool d64 = lumps.format == MAP_DOOM64;
+
+	// Vertices
+	if (d64)
+		readStructs<doom64vertex_t>(lumps.vertexes, [&](const doom64vertex_t& v) {
+			data.vertices.push_back({ (double)v.x / 65536, (double)v.y / 65536 });
+		});
+	else
+		readStructs<doomvertex_t>(
+			lumps.vertexes, [&](const doomvertex_t& v) { data.vertices.push_back({ (double)v.x, (double)v.y }); });
+
+	// Sides (sector references only)
+	vector<int> sides =
+		d64 ? readSideSectors<doom64side_t>(lumps.sidedefs) : readSideSectors<doomside_t>(lumps.sidedefs);
+
+	// Lines
+	auto add_line = [&](unsigned v1, unsigned v2, unsigned side1, unsigned side2, bool special, bool macro) {
+		MapImage::Line line;
+		line.v1       = v1;
+		line.v2       = v2;
+		line.sector1  = side1 != 0xFFFF ? sideSector(sides, side1) : -1;
+		line.sector2  = side2 != 0xFFFF ? sideSector(sides, side2) : -1;
+		line.twosided = side2 != 0xFFFF;
+		line.special  = special;
+		line.macro    = macro;
+		data.lines.push_back(line);
+	};
+	if (lumps.format == MAP_DOOM)
+		readStructs<doomline_t>(lumps.linedefs, [&](const doomline_t& l) {
+			add_line(l.vertex1, l.vertex2, l.side1, l.side2, l.type > 0, false);
+		});
+	else if (lumps.format == MAP_HEXEN)
+		readStructs<hexenline_t>(lumps.linedefs, [&](const hexenline_t& l) {
+			add_line(l.vertex1, l.vertex2, l.side1, l.side2, l.type > 0, false);
+		});
+	else if (d64)
+		readStructs<doom64line_t>(lumps.linedefs, [&](const doom64line_t& l) {
+			bool macro = l.type > 0 && (l.type & 0x100);
+			add_line(l.vertex1, l.vertex2, l.side1, l.side2, l.type > 0 && !macro, macro);
+		});
+
+	// Sectors (light level only, Doom64 sectors use coloured lighting so are
+	// just shown fully lit)
+	if (d64)
+		data.sector_light.resize(lumps.sectors.getSize() / sizeof(doom64sector_t), 255);
+	else
+		readStructs<doomsector_t>(lumps.sectors, [&](const doomsector_t& s) {
+			data.sector_light.push_back(std::max<int>(0, std::min<int>(s.light, 255)));
+		});
+
+	// Things
+	auto add_thing = [&](double x, double y) { data.things.push_back({ x, y }); };
+	if (lumps.format == MAP_DOOM)
+		readStructs<doomthing_t>(lumps.things, [&](const doomthing_t& t) { add_thing(t.x, t.y); });
+	else if (lumps.format == MAP_HEXEN)
+		readStructs<hexenthing_t>(lumps.things, [&](const hexenthing_t& t) { add_thing(t.x, t.y); });
+	else if (d64)
+		readStructs<doom64thing_t>(lumps.things, [&](const doom64thing_t& t) { add_thing(t.x, t.y); });
+
+	return true;
+}
+
+
+// -----------------------------------------------------------------------------
+// An RGBA image to draw on, with (0,0) at the top left
+// -----------------------------------------------------------------------------
+struct Canvas
+{
+	uint8_t* data;
+	int      width;
+	int      height;
+
+	// -------------------------------------------------------------------------
+	// Blends [col] over the pixel at [x],[y], with [coverage] (0-1) of the
+	// pixel covered
+	// -------------------------------------------------------------------------
+	void blend(int x, int y, const rgba_t& col, float coverage)
+	{
+		if (x < 0 || y < 0 || x >= width || y >= height || coverage <= 0.f)
+			return;
+
+		uint8_t* p     = data + (y * width + x) * 4;
+		float    alpha = (col.a / 255.f) * std::min(coverage, 1.f);
+		float    dst_a = (p[3] / 255.f) * (1.f - alpha);
+		float    out_a = alpha + dst_a;
+		if (out_a <= 0.f)
+			return;
+
+		p[0] = (col.r * alpha + p[0] * dst_a) / out_a + 0.5f;
+		p[1] = (col.g * alpha + p[1] * dst_a) / out_a + 0.5f;
+		p[2] = (col.b * alpha + p[2] * dst_a) / out_a + 0.5f;
+		p[3] = out_a * 255.f + 0.5f;
+	}
+
+	// -------------------------------------------------------------------------
+	// Draws an antialiased line from [p1] to [p2], [thickness] pixels wide
+	// -------------------------------------------------------------------------
+	void drawLine(fpoint2_t p1, fpoint2_t p2, double thickness, const rgba_t& col)
+	{
+		// Lines thinner than a pixel are drawn a pixel wide but fainter
+		float  fade   = thickness < 1. ? thickness : 1.f;
+		double radius = std::max(thickness, 1.) * 0.5;
+
+		// Work along the major axis ([u]), so there are only a few pixels to
+		// check across the line ([v]) at each step
+		bool steep = fabs(p2.y - p1.y) > fabs(p2.x - p1.x);
+		if (steep)
+		{
+			std::swap(p1.x, p1.y);
+			std::swap(p2.x, p2.y);
+		}
+		if (p1.x > p2.x)
+			std::swap(p1, p2);
+
+		double du     = p2.x - p1.x;
+		double dv     = p2.y - p1.y;
+		double len_sq = du * du + dv * dv;
+		if (len_sq <= 0.)
+			return;
+		double slope  = dv / du;
+		double extent = radius * sqrt(len_sq) / du + 1.;
+
+		int u_end = std::min<int>(ceil(p2.x + radius), steep ? height - 1 : width - 1);
+		for (int u = std::max<int>(floor(p1.x - radius), 0); u <= u_end; u++)
+		{
+			double uc = u + 0.5;
+			double vc = p1.y + slope * (MathStuff::clamp(uc, p1.x, p2.x) - p1.x);
+			for (int v = floor(vc - extent); v <= ceil(vc + extent); v++)
+			{
+				// Distance from the pixel centre to the line
+				double vv = v + 0.5;
+				double t  = MathStuff::clamp(((uc - p1.x) * du + (vv - p1.y) * dv) / len_sq, 0., 1.);
+				double dx = uc - (p1.x + du * t);
+				double dy = vv - (p1.y + dv * t);
+				float  c  = (radius + 0.5 - sqrt(dx * dx + dy * dy)) * fade;
+
+				if (steep)
+					blend(v, u, col, c);
+				else
+					blend(u, v, col, c);
+			}
+		}
+	}
+
+	// -------------------------------------------------------------------------
+	// Draws an antialiased filled circle at [centre] with [radius] (pixels)
+	// -------------------------------------------------------------------------
+	void drawCircle(fpoint2_t centre, double radius, const rgba_t& col)
+	{
+		int x_end = std::min<int>(ceil(centre.x + radius), width - 1);
+		int y_end = std::min<int>(ceil(centre.y + radius), height - 1);
+		for (int y = std::max<int>(floor(centre.y - radius), 0); y <= y_end; y++)
+			for (int x = std::max<int>(floor(centre.x - radius), 0); x <= x_end; x++)
+			{
+				double dx = x + 0.5 - centre.x;
+				double dy = y + 0.5 - centre.y;
+				blend(x, y, col, radius + 0.5 - sqrt(dx * dx + dy * dy));
+			}
+	}
+
+	// -------------------------------------------------------------------------
+	// Fills the polygon(s) made up of [edges] with [col], using the even-odd
+	// rule (so holes are left unfilled)
+	// -------------------------------------------------------------------------
+	void fillPolygon(const vector<std::pair<fpoint2_t, fpoint2_t>>& edges, const rgba_t& col)
+	{
+		if (edges.empty())
+			return;
+
+		// Get vertical extent
+		double min_y = edges[0].first.y;
+		double max_y = min_y;
+		for (auto& edge : edges)
+		{
+			min_y = std::min({ min_y, edge.first.y, edge.second.y });
+			max_y = std::max({ max_y, edge.first.y, edge.second.y });
+		}
+
+		// Go through each row, filling between pairs of edge crossings
+		vector<double> crossings;
+		int            y_end = std::min<int>(ceil(max_y), height - 1);
+		for (int y = std::max<int>(floor(min_y), 0); y <= y_end; y++)
+		{
+			double yc = y + 0.5;
+			crossings.clear();
+			for (auto& edge : edges)
+			{
+				const fpoint2_t& a = edge.first;
+				const fpoint2_t& b = edge.second;
+				if ((a.y <= yc) != (b.y <= yc))
+					crossings.push_back(a.x + (yc - a.y) * (b.x - a.x) / (b.y - a.y));
+			}
+			std::sort(crossings.begin(), crossings.end());
+
+			for (unsigned c = 0; c + 1 < crossings.size(); c += 2)
+			{
+				int x_end = std::min<int>(ceil(crossings[c + 1] - 0.5), width);
+				for (int x = std::max<int>(ceil(crossings[c] - 0.5), 0); x < x_end; x++)
+					blend(x, y, col, 1.f);
+			}
+		}
+	}
+};
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// MapImage::Options Struct Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Sets the thickness and colours from the map image cvars and colour
+// configuration
+// -----------------------------------------------------------------------------
+void MapImage::Options::loadConfig()
+{
+	thickness        = map_image_thickness;
+	col_background   = ColourConfiguration::getColour("map_image_background");
+	col_line_1s      = ColourConfiguration::getColour("map_image_line_1s");
+	col_line_2s      = ColourConfiguration::getColour("map_image_line_2s");
+	col_line_special = ColourConfiguration::getColour("map_image_line_special");
+	col_line_macro   = ColourConfiguration::getColour("map_image_line_macro");
+	col_thing        = ColourConfiguration::getColour("map_image_thing");
+	col_sector       = ColourConfiguration::getColour("map_image_sector");
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// MapImage Namespace Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Copies the lumps of [map] needed to render it into [lumps]. If the map is
+// in its own wad (eg. in a zip), the first map in the wad is used.
+// This reads from the archive so must be done on the main thread
+// -----------------------------------------------------------------------------
+bool MapImage::readLumps(Archive::MapDesc map, MapLumps& lumps)
+{
+	lumps.name = map.name;
+
+	// Open the wad if the map is in one
+	WadArchive temp_wad;
+	if (map.archive)
+	{
+		Archive& temp = temp_wad;
+		if (!temp.open(map.head))
+			return false;
+
+		vector<Archive::MapDesc> maps = temp_wad.detectMaps();
+		if (maps.empty())
+		{
+			Global::error = "No map found in map archive";
+			return false;
+		}
+		map = maps[0];
+	}
+	lumps.format = map.format;
+
+	// Copy the map lumps
+	for (ArchiveEntry* entry = map.head; entry; entry = entry->nextEntry())
+	{
+		EntryType* type = entry->getType();
+		MemChunk*  mc   = nullptr;
+		if (type == EntryType::fromId("map_vertexes"))
+			mc = &lumps.vertexes;
+		else if (type == EntryType::fromId("map_linedefs"))
+			mc = &lumps.linedefs;
+		else if (type == EntryType::fromId("map_sidedefs"))
+			mc = &lumps.sidedefs;
+		else if (type == EntryType::fromId("map_sectors"))
+			mc = &lumps.sectors;
+		else if (type == EntryType::fromId("map_things"))
+			mc = &lumps.things;
+		else if (type == EntryType::fromId("udmf_textmap"))
+			mc = &lumps.textmap;
+
+		if (mc && mc->getSize() == 0 && entry->getSize() > 0)
+			mc->importMem(entry->getData(true), entry->getSize());
+
+		if (entry == map.end)
+			break;
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads the map geometry from [lumps] into [data]
+// -----------------------------------------------------------------------------
+bool MapImage::readMap(const MapLumps& lumps, MapData& data)
+{
+	if (lumps.format == MAP_UDMF)
+		return readUDMF(lumps, data);
+	else if (lumps.format == MAP_DOOM || lumps.format == MAP_HEXEN || lumps.format == MAP_DOOM64)
+		return readBinary(lumps, data);
+
+	Global::error = "Unknown map format";
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// Renders [data] to [image] as RGBA, scaled to fit. If the width or height in
+// [options] is negative, it's the number of map units per pixel instead
+// -----------------------------------------------------------------------------
+bool MapImage::render(const MapData& data, const Options& options, SImage& image)
+{
+	if (data.vertices.empty())
+	{
+		Global::error = "Map has no vertices";
+		return false;
+	}
+
+	// Find extents of map
+	fpoint2_t m_min(data.vertices[0].x, data.vertices[0].y);
+	fpoint2_t m_max = m_min;
+	for (auto& vertex : data.vertices)
+	{
+		m_min.x = std::min(m_min.x, vertex.x);
+		m_min.y = std::min(m_min.y, vertex.y);
+		m_max.x = std::max(m_max.x, vertex.x);
+		m_max.y = std::max(m_max.y, vertex.y);
+	}
+	double map_width  = std::max(m_max.x - m_min.x, 1.);
+	double map_height = std::max(m_max.y - m_min.y, 1.);
+
+	// Determine image size
+	int width  = options.width ? options.width : -5;
+	int height = options.height ? options.height : -5;
+	if (width < 0)
+		width = map_width / abs(width);
+	if (height < 0)
+		height = map_height / abs(height);
+	width  = MathStuff::clamp(width, 1, MAX_SIZE);
+	height = MathStuff::clamp(height, 1, MAX_SIZE);
+
+	// Zoom to fit the whole map, centered
+	double    zoom   = std::min(width / map_width, height / map_height) * 0.95;
+	fpoint2_t offset = (m_min + m_max) * 0.5;
+	auto      point  = [&](double x, double y) {
+		return fpoint2_t((x - offset.x) * zoom + width * 0.5, height * 0.5 - (y - offset.y) * zoom);
+	};
+
+	// Clear to background colour
+	Canvas canvas{ new uint8_t[width * height * 4], width, height };
+	rgba_t background = options.col_background;
+	for (int a = 0; a < width * height; a++)
+		background.write(canvas.data + a * 4);
+
+	// Sectors
+	if (options.sectors)
+	{
+		// Get the edges of each sector (lines with the same sector on both
+		// sides are inside the sector so don't count)
+		vector<vector<std::pair<fpoint2_t, fpoint2_t>>> sector_edges(data.sector_light.size());
+		for (auto& line : data.lines)
+		{
+			if (line.v1 >= data.vertices.size() || line.v2 >= data.vertices.size() || line.sector1 == line.sector2)
+				continue;
+
+			auto edge = std::make_pair(
+				point(data.vertices[line.v1].x, data.vertices[line.v1].y),
+				point(data.vertices[line.v2].x, data.vertices[line.v2].y));
+			if (line.sector1 >= 0 && line.sector1 < (int)sector_edges.size())
+				sector_edges[line.sector1].push_back(edge);
+			if (line.sector2 >= 0 && line.sector2 < (int)sector_edges.size())
+				sector_edges[line.sector2].push_back(edge);
+		}
+
+		// Fill each sector, shaded by its light level
+		for (unsigned a = 0; a < sector_edges.size(); a++)
+		{
+			rgba_t col    = options.col_sector;
+			double bright = data.sector_light[a] / 255.;
+			col.r *= bright;
+			col.g *= bright;
+			col.b *= bright;
+			canvas.fillPolygon(sector_edges[a], col);
+		}
+	}
+
+	// Lines (2-sided first, so 1-sided lines are drawn over them)
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (auto& line : data.lines)
+		{
+			if (line.twosided != (pass == 0))
+				continue;
+
+			// Check ends
+			if (line.v1 >= data.vertices.size() || line.v2 >= data.vertices.size())
+				continue;
+
+			// Get colour
+			const rgba_t* col;
+			if (line.special)
+				col = &options.col_line_special;
+			else if (line.macro)
+				col = &options.col_line_macro;
+			else if (line.twosided)
+				col = &options.col_line_2s;
+			else
+				col = &options.col_line_1s;
+
+			canvas.drawLine(
+				point(data.vertices[line.v1].x, data.vertices[line.v1].y),
+				point(data.vertices[line.v2].x, data.vertices[line.v2].y),
+				options.thickness,
+				*col);
+		}
+	}
+
+	// Things
+	if (options.things)
+	{
+		double radius = std::max(20. * zoom, options.thickness);
+		for (auto& thing : data.things)
+			canvas.drawCircle(point(thing.x, thing.y), radius, options.col_thing);
+	}
+
+	image.setImageData(canvas.data, width, height, RGBA);
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Renders every map in [archive] to a png file in the directory [path] (named
+// after the map), reading and rendering the maps in parallel.
+// Returns the number of map images written
+// -----------------------------------------------------------------------------
+int MapImage::renderArchive(Archive* archive, const Options& options, const string& path)
+{
+	if (!archive)
+		return 0;
+
+	struct Job
+	{
+		MapLumps lumps;
+		MemChunk png;
+		bool     ok = false;
+		string   error;
+	};
+
+	// Copy the map lumps (needs to be done on this thread)
+	vector<std::unique_ptr<Job>> jobs;
+	for (auto& map : archive->detectMaps())
+	{
+		jobs.push_back(std::make_unique<Job>());
+		if (!readLumps(map, jobs.back()->lumps))
+		{
+			Log::warning(S_FMT("Unable to read map %s: %s", CHR(map.name), CHR(Global::error)));
+			jobs.pop_back();
+		}
+	}
+
+	// Read, render and encode each map on the worker threads
+	{
+		int        level = png_compression_level;
+		ThreadPool pool;
+		for (auto& job : jobs)
+		{
+			Job* j = job.get();
+			pool.queue([j, &options, level]() {
+				MapData data;
+				SImage  image;
+				j->ok = readMap(j->lumps, data) && render(data, options, image)
+						&& SIFormat::getFormat("png")->saveImage(image, j->png, nullptr, 0, level);
+				if (!j->ok)
+					j->error = Global::error;
+			});
+		}
+		pool.wait();
+	}
+
+	// Write the images in order
+	int count = 0;
+	for (auto& job : jobs)
+	{
+		string filename = S_FMT("%s/%s.png", CHR(path), CHR(job->lumps.name));
+		if (!job->ok)
+			Log::warning(S_FMT("Unable to render map %s: %s", CHR(job->lumps.name), CHR(job->error)));
+		else if (!job->png.exportFile(filename))
+			Log::warning(S_FMT("Unable to write %s", CHR(filename)));
+		else
+			count++;
+	}
+
+	return count;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Renders all maps in the current archive to png files in a directory.
+// Usage: map_images <path> [width] [height] [things] [sectors]
+// (width/height are map units per pixel if negative)
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(map_images, 1, true)
+{
+	Archive* archive = MainEditor::currentArchive();
+	if (!archive)
+	{
+		Log::console("No archive open");
+		return;
+	}
+
+	MapImage::Options options;
+	options.loadConfig();
+
+	bool got_width = false;
+	for (unsigned a = 1; a < args.size(); a++)
+	{
+		long value;
+		if (S_CMPNOCASE(args[a], "things"))
+			options.things = true;
+		else if (S_CMPNOCASE(args[a], "sectors"))
+			options.sectors = true;
+		else if (args[a].ToLong(&value))
+		{
+			if (got_width)
+				options.height = value;
+			else
+				options.width = value;
+			got_width = true;
+		}
+	}
+
+	int count = MapImage::renderArchive(archive, options, args[0]);
+	Log::console(S_FMT("Wrote %d map images to %s", count, CHR(args[0])));
+}
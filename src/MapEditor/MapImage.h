@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Archive/Archive.h"
+
+class SImage;
+
+// Software rendering of map overview images, straight from the lumps of a map
+// in an archive. Doesn't need OpenGL or the map to be opened in the map
+// editor, and everything other than readLumps can be done on any thread
+namespace MapImage
+{
+// What to draw, and how
+struct Options
+{
+	int    width     = -5;  // Image width in pixels, or map units per pixel if negative
+	int    height    = -5;  // Image height in pixels, or map units per pixel if negative
+	double thickness = 1.5; // Line thickness in pixels
+	bool   things    = false;
+	bool   sectors   = false; // Fill sectors, shaded by light level
+
+	rgba_t col_background;
+	rgba_t col_line_1s;
+	rgba_t col_line_2s;
+	rgba_t col_line_special;
+	rgba_t col_line_macro;
+	rgba_t col_thing;
+	rgba_t col_sector;
+
+	// Sets the thickness and colours from the map image cvars and colour
+	// configuration (main thread only)
+	void loadConfig();
+};
+
+// Basic map geometry
+struct Point
+{
+	double x;
+	double y;
+};
+
+struct Line
+{
+	unsigned v1;
+	unsigned v2;
+	int      sector1  = -1; // Front sector index, -1 if none
+	int      sector2  = -1; // Back sector index, -1 if none
+	bool     twosided = false;
+	bool     special  = false;
+	bool     macro    = false;
+};
+
+struct MapData
+{
+	vector<Point>   vertices;
+	vector<Line>    lines;
+	vector<Point>   things;
+	vector<uint8_t> sector_light; // Light level of each sector
+};
+
+// Copies of the lumps of a map (and what it's called), so it can be read
+// without touching the archive
+struct MapLumps
+{
+	string   name;
+	uint8_t  format = MAP_UNKNOWN;
+	MemChunk vertexes;
+	MemChunk linedefs;
+	MemChunk sidedefs;
+	MemChunk sectors;
+	MemChunk things;
+	MemChunk textmap;
+};
+
+bool readLumps(Archive::MapDesc map, MapLumps& lumps);
+bool readMap(const MapLumps& lumps, MapData& data);
+bool render(const MapData& data, const Options& options, SImage& image);
+int  renderArchive(Archive* archive, const Options& options, const string& path);
+} // namespace MapImage
@@ -332,7 +332,7 @@ void MapSpecials::processACSScripts(ArchiveEntry* entry)
 						int b = -1;
 						for (unsigned a = 0; a < parameters.size(); a++)
 						{
-							if (parameters[a].text.ToLong(&val))
+							if (parameters[a].text().ToLong(&val))
 							{
 								if (tag < 0)
 									tag = val;
@@ -373,7 +373,7 @@ void MapSpecials::processACSScripts(ArchiveEntry* entry)
 						int b = -1;
 						for (unsigned a = 0; a < parameters.size(); a++)
 						{
-							if (parameters[a].text.ToLong(&val))
+							if (parameters[a].text().ToLong(&val))
 							{
 								if (tag < 0)
 									tag = val;
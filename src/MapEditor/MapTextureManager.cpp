@@ -48,6 +48,7 @@
  * VARIABLES
  *******************************************************************/
 CVAR(Int, map_tex_filter, 0, CVAR_SAVE)
+CVAR(Int, map_tex_vram_budget, 0, CVAR_SAVE)	// In MB, 0 = unlimited
 
 
 /*******************************************************************
@@ -63,6 +64,7 @@ MapTextureManager::MapTextureManager(Archive* archive)
 	this->archive = archive;
 	editor_images_loaded = false;
 	palette = new Palette();
+	budget_tick = 0;
 }
 
 /* MapTextureManager::~MapTextureManager
@@ -104,43 +106,63 @@ Palette* MapTextureManager::getResourcePalette()
 		return theMainWindow->getPaletteChooser()->getSelectedPalette();
 }
 
-/* MapTextureManager::getTexture
- * Returns the texture matching [name]. Loads it from resources if
- * necessary. If [mixed] is true, flats are also searched if no
- * matching texture is found
+/* MapTextureManager::textureFilter
+ * Returns the GLTexture filter type to use for map textures
  *******************************************************************/
-GLTexture* MapTextureManager::getTexture(string name, bool mixed)
+int MapTextureManager::textureFilter()
 {
-	// Get texture matching name
-	map_tex_t& mtex = textures[name.Upper()];
-
-	// Get desired filter type
-	int filter = 1;
 	if (map_tex_filter == 0)
-		filter = GLTexture::NEAREST_LINEAR_MIN;
+		return GLTexture::NEAREST_LINEAR_MIN;
 	else if (map_tex_filter == 1)
-		filter = GLTexture::LINEAR;
+		return GLTexture::LINEAR;
 	else if (map_tex_filter == 2)
-		filter = GLTexture::LINEAR_MIPMAP;
+		return GLTexture::LINEAR_MIPMAP;
 	else if (map_tex_filter == 3)
-		filter = GLTexture::NEAREST_MIPMAP;
+		return GLTexture::NEAREST_MIPMAP;
 
-	// If the texture is loaded
-	if (mtex.texture)
+	return 1;
+}
+
+/* MapTextureManager::createTexture
+ * Creates a new GLTexture from [image], with the current filter,
+ * resource palette and [scale]. The texture [name] and [flat]/
+ * [mixed] options it was loaded with are used to reload the texture
+ * if it is unloaded to keep within the video memory budget
+ *******************************************************************/
+GLTexture* MapTextureManager::createTexture(SImage& image, fpoint2_t scale, string name, bool flat, bool mixed)
+{
+	GLTexture* texture = new GLTexture(false);
+	texture->setFilter(textureFilter());
+	texture->loadImage(&image, palette);
+	texture->setScale(scale.x, scale.y);
+
+	// Set reloader
+	texture->setReloader([this, name, flat, mixed](GLTexture* tex)
 	{
-		// If the texture filter matches the desired one, return it
-		if (mtex.texture->getFilter() == filter)
-			return mtex.texture;
-		else
-		{
-			// Otherwise, reload the texture
-			if (mtex.texture != &(GLTexture::missingTex())) delete mtex.texture;
-			mtex.texture = nullptr;
-		}
-	}
+		SImage image;
+		fpoint2_t scale;
+		if (flat && !loadFlatImage(name, mixed, image, scale))
+			return false;
+		else if (!flat && !loadTextureImage(name, image, scale))
+			return false;
 
-	// Texture not found or unloaded, look for it
-	//Palette8bit* pal = getResourcePalette();
+		return tex->loadImage(&image, palette);
+	});
+
+	return texture;
+}
+
+/* MapTextureManager::loadTextureImage
+ * Loads the texture matching [name] from resources into [image],
+ * and its scale into [scale]. Returns false if no matching texture
+ * could be loaded. Doesn't use or modify any loaded textures, so
+ * can be called from a worker thread as long as resources aren't
+ * being modified at the same time
+ *******************************************************************/
+bool MapTextureManager::loadTextureImage(string name, SImage& image, fpoint2_t& scale)
+{
+	bool found = false;
+	scale.set(1, 1);
 
 	// Look for stand-alone textures first
 	ArchiveEntry* etex = theResourceManager->getTextureEntry(name, "hires", archive);
@@ -150,32 +172,25 @@ GLTexture* MapTextureManager::getTexture(string name, bool mixed)
 		etex = theResourceManager->getTextureEntry(name, "textures", archive);
 		textypefound = TEXTYPE_TEXTURE;
 	}
-	if (etex)
+	if (etex && Misc::loadImageFromEntry(&image, etex))
 	{
-		SImage image;
-		// Get image format hint from type, if any
-		if (Misc::loadImageFromEntry(&image, etex))
-		{
-			mtex.texture = new GLTexture(false);
-			mtex.texture->setFilter(filter);
-			mtex.texture->loadImage(&image, palette);
+		found = true;
 
-			// Handle hires texture scale
-			if (textypefound == TEXTYPE_HIRES)
+		// Handle hires texture scale
+		if (textypefound == TEXTYPE_HIRES)
+		{
+			ArchiveEntry* ref = theResourceManager->getTextureEntry(name, "textures", archive);
+			if (ref)
 			{
-				ArchiveEntry* ref = theResourceManager->getTextureEntry(name, "textures", archive);
-				if (ref)
+				SImage imgref;
+				if (Misc::loadImageFromEntry(&imgref, ref))
 				{
-					SImage imgref;
-					if (Misc::loadImageFromEntry(&imgref, ref))
-					{
-						int w, h, sw, sh;
-						w = image.getWidth();
-						h = image.getHeight();
-						sw = imgref.getWidth();
-						sh = imgref.getHeight();
-						mtex.texture->setScale((double)sw/(double)w, (double)sh/(double)h);
-					}
+					int w, h, sw, sh;
+					w = image.getWidth();
+					h = image.getHeight();
+					sw = imgref.getWidth();
+					sh = imgref.getHeight();
+					scale.set((double)sw/(double)w, (double)sh/(double)h);
 				}
 			}
 		}
@@ -185,19 +200,164 @@ GLTexture* MapTextureManager::getTexture(string name, bool mixed)
 	CTexture* ctex = theResourceManager->getTexture(name, archive);
 	if (ctex) // Composite textures take precedence over the textures directory
 	{
-		textypefound = TEXTYPE_WALLTEXTURE;
-		SImage image;
-		if (ctex->toImage(image, archive, palette, true))
+		SImage cimage;
+		if (ctex->toImage(cimage, archive, palette, true))
 		{
-			mtex.texture = new GLTexture(false);
-			mtex.texture->setFilter(filter);
-			mtex.texture->loadImage(&image, palette);
+			image.copyImage(&cimage);
 			double sx = ctex->getScaleX(); if (sx == 0) sx = 1.0;
 			double sy = ctex->getScaleY(); if (sy == 0) sy = 1.0;
-			mtex.texture->setScale(1.0/sx, 1.0/sy);
+			scale.set(1.0/sx, 1.0/sy);
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+/* MapTextureManager::loadFlatImage
+ * Loads the flat matching [name] from resources into [image], and
+ * its scale into [scale]. If [mixed] is true, extended composite
+ * textures (other than WallTextures) are also searched. Returns
+ * false if no matching flat could be loaded. As with
+ * loadTextureImage, this can be called from a worker thread
+ *******************************************************************/
+bool MapTextureManager::loadFlatImage(string name, bool mixed, SImage& image, fpoint2_t& scale)
+{
+	scale.set(1, 1);
+
+	if (mixed)
+	{
+		CTexture* ctex = theResourceManager->getTexture(name, archive);
+		if (ctex && ctex->isExtended() && ctex->getType() != "WallTexture")
+		{
+			if (ctex->toImage(image, archive, palette, true))
+			{
+				double sx = ctex->getScaleX(); if (sx == 0) sx = 1.0;
+				double sy = ctex->getScaleY(); if (sy == 0) sy = 1.0;
+				scale.set(1.0/sx, 1.0/sy);
+				return true;
+			}
+		}
+	}
+
+	// Look for flat
+	ArchiveEntry* entry = theResourceManager->getTextureEntry(name, "hires", archive);
+	if (entry == nullptr)
+		entry = theResourceManager->getTextureEntry(name, "flats", archive);
+	if (entry == nullptr)
+		entry = theResourceManager->getFlatEntry(name, archive);
+
+	return entry && Misc::loadImageFromEntry(&image, entry);
+}
+
+/* MapTextureManager::detectImageTypes
+ * Detects the types of any entries that loadTextureImage (or
+ * loadFlatImage if [flat] is true) would load [name] from, if they
+ * don't have one yet. Entry type detection can't be done on a
+ * worker thread, so this must be called on the main thread before
+ * loading the image on one
+ *******************************************************************/
+void MapTextureManager::detectImageTypes(string name, bool flat, bool mixed)
+{
+	vector<ArchiveEntry*> entries;
+	CTexture* ctex = nullptr;
+	if (flat)
+	{
+		if (mixed)
+		{
+			ctex = theResourceManager->getTexture(name, archive);
+			if (ctex && (!ctex->isExtended() || ctex->getType() == "WallTexture"))
+				ctex = nullptr;
+		}
+
+		ArchiveEntry* entry = theResourceManager->getTextureEntry(name, "hires", archive);
+		if (entry == nullptr)
+			entry = theResourceManager->getTextureEntry(name, "flats", archive);
+		if (entry == nullptr)
+			entry = theResourceManager->getFlatEntry(name, archive);
+		entries.push_back(entry);
+	}
+	else
+	{
+		entries.push_back(theResourceManager->getTextureEntry(name, "hires", archive));
+		entries.push_back(theResourceManager->getTextureEntry(name, "textures", archive));
+		ctex = theResourceManager->getTexture(name, archive);
+	}
+
+	for (auto entry : entries)
+		if (entry && entry->getType() == EntryType::unknownType())
+			EntryType::detectEntryType(entry);
+
+	if (ctex)
+		ctex->detectPatchTypes(archive);
+}
+
+/* MapTextureManager::isLoaded
+ * Returns true if the texture (or flat if [flat] is true) matching
+ * [name] is already loaded with the current filter
+ *******************************************************************/
+bool MapTextureManager::isLoaded(string name, bool flat)
+{
+	MapTexHashMap& map = flat ? flats : textures;
+	MapTexHashMap::iterator i = map.find(name.Upper());
+
+	return i != map.end() && i->second.texture && i->second.texture->getFilter() == textureFilter();
+}
+
+/* MapTextureManager::setImage
+ * Sets the texture (or flat if [flat] is true) matching [name] to
+ * [image] with [scale], as previously loaded via loadTextureImage
+ * or loadFlatImage, unless it is already loaded. Returns the
+ * texture
+ *******************************************************************/
+GLTexture* MapTextureManager::setImage(string name, bool flat, SImage& image, fpoint2_t scale)
+{
+	map_tex_t& mtex = flat ? flats[name.Upper()] : textures[name.Upper()];
+
+	// Keep the existing texture if it was loaded in the meantime
+	if (mtex.texture)
+	{
+		if (mtex.texture->getFilter() == textureFilter())
+			return mtex.texture;
+		else if (mtex.texture != &(GLTexture::missingTex()))
+			delete mtex.texture;
+	}
+
+	mtex.texture = createTexture(image, scale, name, flat, false);
+
+	return mtex.texture;
+}
+
+/* MapTextureManager::getTexture
+ * Returns the texture matching [name]. Loads it from resources if
+ * necessary. If [mixed] is true, flats are also searched if no
+ * matching texture is found
+ *******************************************************************/
+GLTexture* MapTextureManager::getTexture(string name, bool mixed)
+{
+	// Get texture matching name
+	map_tex_t& mtex = textures[name.Upper()];
+
+	// If the texture is loaded
+	if (mtex.texture)
+	{
+		// If the texture filter matches the desired one, return it
+		if (mtex.texture->getFilter() == textureFilter())
+			return mtex.texture;
+		else
+		{
+			// Otherwise, reload the texture
+			if (mtex.texture != &(GLTexture::missingTex())) delete mtex.texture;
+			mtex.texture = nullptr;
 		}
 	}
 
+	// Texture not found or unloaded, look for it
+	SImage image;
+	fpoint2_t scale;
+	if (loadTextureImage(name, image, scale))
+		mtex.texture = createTexture(image, scale, name, false, false);
+
 	// Not found
 	if (!mtex.texture)
 	{
@@ -223,22 +383,11 @@ GLTexture* MapTextureManager::getFlat(string name, bool mixed)
 	// Get flat matching name
 	map_tex_t& mtex = flats[name.Upper()];
 
-	// Get desired filter type
-	int filter = 1;
-	if (map_tex_filter == 0)
-		filter = GLTexture::NEAREST_LINEAR_MIN;
-	else if (map_tex_filter == 1)
-		filter = GLTexture::LINEAR;
-	else if (map_tex_filter == 2)
-		filter = GLTexture::LINEAR_MIPMAP;
-	else if (map_tex_filter == 3)
-		filter = GLTexture::NEAREST_MIPMAP;
-
 	// If the texture is loaded
 	if (mtex.texture)
 	{
 		// If the texture filter matches the desired one, return it
-		if (mtex.texture->getFilter() == filter)
+		if (mtex.texture->getFilter() == textureFilter())
 			return mtex.texture;
 		else
 		{
@@ -248,45 +397,11 @@ GLTexture* MapTextureManager::getFlat(string name, bool mixed)
 		}
 	}
 
-	if (mixed)
-	{
-		CTexture* ctex = theResourceManager->getTexture(name, archive);
-		if (ctex && ctex->isExtended() && ctex->getType() != "WallTexture")
-		{
-			SImage image;
-			if (ctex->toImage(image, archive, palette, true))
-			{
-				mtex.texture = new GLTexture(false);
-				mtex.texture->setFilter(filter);
-				mtex.texture->loadImage(&image, palette);
-				double sx = ctex->getScaleX(); if (sx == 0) sx = 1.0;
-				double sy = ctex->getScaleY(); if (sy == 0) sy = 1.0;
-				mtex.texture->setScale(1.0/sx, 1.0/sy);
-				return mtex.texture;
-			}
-		}
-	}
-
-	// Flat not found, look for it
-	//Palette8bit* pal = getResourcePalette();
-	if (!mtex.texture)
-	{
-		ArchiveEntry* entry = theResourceManager->getTextureEntry(name, "hires", archive);
-		if (entry == nullptr)
-			entry = theResourceManager->getTextureEntry(name, "flats", archive);
-		if (entry == nullptr)
-			entry = theResourceManager->getFlatEntry(name, archive);
-		if (entry)
-		{
-			SImage image;
-			if (Misc::loadImageFromEntry(&image, entry))
-			{
-				mtex.texture = new GLTexture(false);
-				mtex.texture->setFilter(filter);
-				mtex.texture->loadImage(&image, palette);
-			}
-		}
-	}
+	// Flat not found or unloaded, look for it
+	SImage image;
+	fpoint2_t scale;
+	if (loadFlatImage(name, mixed, image, scale))
+		mtex.texture = createTexture(image, scale, name, true, mixed);
 
 	// Not found
 	if (!mtex.texture)
@@ -303,6 +418,55 @@ GLTexture* MapTextureManager::getFlat(string name, bool mixed)
 	return mtex.texture;
 }
 
+/* MapTextureManager::enforceBudget
+ * Unloads the video memory of the least recently used textures and
+ * flats until the total is within the budget set by the
+ * map_tex_vram_budget cvar (unloaded textures are reloaded when
+ * next used). Textures used since the last call are kept, so this
+ * should be called once per frame
+ *******************************************************************/
+void MapTextureManager::enforceBudget()
+{
+	uint64_t frame_start = budget_tick;
+	budget_tick = GLTexture::useCounter();
+
+	if (map_tex_vram_budget <= 0)
+		return;
+
+	// Get total memory used and textures not used in the last frame
+	size_t total = 0;
+	vector<GLTexture*> unused;
+	MapTexHashMap* maps[] = { &textures, &flats };
+	for (unsigned a = 0; a < 2; a++)
+	{
+		for (MapTexHashMap::iterator i = maps[a]->begin(); i != maps[a]->end(); ++i)
+		{
+			GLTexture* tex = i->second.texture;
+			if (!tex || tex == &(GLTexture::missingTex()) || !tex->isResident())
+				continue;
+
+			total += tex->memUsage();
+			if (tex->lastUsed() <= frame_start)
+				unused.push_back(tex);
+		}
+	}
+
+	size_t budget = (size_t)map_tex_vram_budget * 1024 * 1024;
+	if (total <= budget)
+		return;
+
+	// Unload least recently used first
+	std::sort(unused.begin(), unused.end(), [](GLTexture* left, GLTexture* right)
+	{
+		return left->lastUsed() < right->lastUsed();
+	});
+	for (unsigned a = 0; a < unused.size() && total > budget; a++)
+	{
+		total -= unused[a]->memUsage();
+		unused[a]->unloadData();
+	}
+}
+
 /* MapTextureManager::getSprite
  * Returns the sprite matching [name]. Loads it from resources if
  * necessary. Sprite name also supports wildcards (?)
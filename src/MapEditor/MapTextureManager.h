@@ -32,6 +32,7 @@ struct map_texinfo_t
 typedef std::map<string, map_tex_t> MapTexHashMap;
 
 class Palette;
+class SImage;
 class MapTextureManager : public Listener
 {
 private:
@@ -44,6 +45,10 @@ private:
 	Palette*			palette;
 	vector<map_texinfo_t>	tex_info;
 	vector<map_texinfo_t>	flat_info;
+	uint64_t				budget_tick;
+
+	int			textureFilter();
+	GLTexture*	createTexture(SImage& image, fpoint2_t scale, string name, bool flat, bool mixed);
 
 public:
 	enum
@@ -67,6 +72,12 @@ public:
 	Palette*	getResourcePalette();
 	GLTexture*		getTexture(string name, bool mixed);
 	GLTexture*		getFlat(string name, bool mixed);
+	bool			loadTextureImage(string name, SImage& image, fpoint2_t& scale);
+	bool			loadFlatImage(string name, bool mixed, SImage& image, fpoint2_t& scale);
+	void			detectImageTypes(string name, bool flat, bool mixed);
+	bool			isLoaded(string name, bool flat);
+	GLTexture*		setImage(string name, bool flat, SImage& image, fpoint2_t scale);
+	void			enforceBudget();
 	GLTexture*		getSprite(string name, string translation = "", string palette = "");
 	GLTexture*		getEditorImage(string name);
 	int				getVerticalOffset(string name);
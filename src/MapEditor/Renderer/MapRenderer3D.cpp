@@ -73,6 +73,19 @@ EXTERN_CVAR(Bool, flats_use_vbo)
 EXTERN_CVAR(Bool, use_zeth_icons)
 
 
+/*******************************************************************
+ * FUNCTIONS
+ *******************************************************************/
+
+/* sortByTexture
+ * Sorting function to sort flats or quads by their texture
+ *******************************************************************/
+template<class T> bool sortByTexture(T* left, T* right)
+{
+	return std::less<GLTexture*>()(left->texture, right->texture);
+}
+
+
 /*******************************************************************
  * MAPRENDERER3D CLASS FUNCTIONS
  *******************************************************************/
@@ -1140,50 +1153,30 @@ void MapRenderer3D::renderFlats()
 	// Init textures
 	glEnable(GL_TEXTURE_2D);
 
-	// Render all visible opaque flats, ordered by texture
-	unsigned a = 0;
+	// Move translucent flats to the end (keeping their order), and sort
+	// opaque flats by texture so each texture is only bound once
 	flat_last = 0;
-	while (n_flats > 0)
-	{
-		tex_last = nullptr;
-		a = 0;
-		while (a < n_flats)
-		{
-			// Skip different textures on this loop, and save all translucent
-			// flats for last
-			if ((tex_last && flats[a]->texture != tex_last) ||
-				flats[a]->base_alpha < 1.0f)
-			{
-				a++;
-				continue;
-			}
-
-			// Check texture
-			if (!tex_last)
-				tex_last = flats[a]->texture;
-			if (tex_last)
-				flats[a]->texture->bind();
-
-			// Render flat
-			renderFlat(flats[a]);
-			flats[a] = flats[n_flats-1];
-			n_flats--;
-		}
-		if (tex_last == NULL)
-			break;
-	}
+	vector<flat_3d_t*>::iterator translucent = std::stable_partition(
+		flats.begin(),
+		flats.begin() + n_flats,
+		[](flat_3d_t* flat) { return flat->base_alpha >= 1.0f; }
+	);
+	std::sort(flats.begin(), translucent, sortByTexture<flat_3d_t>);
 
-	// Render any remaining translucent flats, ordered by depth
-	// TODO order by depth?  how??  sector distance, then plane height?  (note
-	// that sloped and translucent is forbidden even in gzdoom)
-	for (unsigned b = 0; b < n_flats; b++)
+	// Render all visible opaque flats, then any translucent flats
+	// TODO order translucent flats by depth?  how??  sector distance, then
+	// plane height?  (note that sloped and translucent is forbidden even in
+	// gzdoom)
+	tex_last = nullptr;
+	for (unsigned a = 0; a < n_flats; a++)
 	{
-		if (tex_last != flats[b]->texture)
+		if (tex_last != flats[a]->texture)
 		{
-			tex_last = flats[b]->texture;
-			tex_last->bind();
+			tex_last = flats[a]->texture;
+			if (tex_last)
+				tex_last->bind();
 		}
-		renderFlat(flats[b]);
+		renderFlat(flats[a]);
 	}
 	n_flats = 0;
 
@@ -1901,41 +1894,31 @@ void MapRenderer3D::renderWalls()
 	glEnable(GL_TEXTURE_2D);
 	glCullFace(GL_BACK);
 
-	// Render all visible quads, ordered by texture
-	unsigned a = 0;
-	while (n_quads > 0)
+	// Save transparent quads for later
+	unsigned n_opaque = 0;
+	for (unsigned a = 0; a < n_quads; a++)
 	{
-		tex_last = nullptr;
-		a = 0;
-		while (a < n_quads)
-		{
-			// Check alpha
-			if (quads[a]->colour.a < 255)
-			{
-				quads_transparent.push_back(quads[a]);
-				quads[a] = quads[n_quads-1];
-				n_quads--;
-				continue;
-			}
-
-			// Check texture
-			if (!tex_last && quads[a]->texture)
-			{
-				tex_last = quads[a]->texture;
-				quads[a]->texture->bind();
-			}
-			if (quads[a]->texture != tex_last)
-			{
-				a++;
-				continue;
-			}
+		if (quads[a]->colour.a < 255)
+			quads_transparent.push_back(quads[a]);
+		else
+			quads[n_opaque++] = quads[a];
+	}
 
-			// Render quad
-			renderQuad(quads[a], quads[a]->alpha);
-			quads[a] = quads[n_quads-1];
-			n_quads--;
+	// Render all visible opaque quads, ordered by texture so each texture
+	// is only bound once
+	std::sort(quads, quads + n_opaque, sortByTexture<quad_3d_t>);
+	tex_last = nullptr;
+	for (unsigned a = 0; a < n_opaque; a++)
+	{
+		if (quads[a]->texture != tex_last)
+		{
+			tex_last = quads[a]->texture;
+			if (tex_last)
+				tex_last->bind();
 		}
+		renderQuad(quads[a], quads[a]->alpha);
 	}
+	n_quads = 0;
 
 	glDisable(GL_TEXTURE_2D);
 }
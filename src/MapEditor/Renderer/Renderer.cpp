@@ -35,6 +35,8 @@
 #include "General/ColourConfiguration.h"
 #include "MapEditor/Edit/LineDraw.h"
 #include "MapEditor/MapEditContext.h"
+#include "MapEditor/MapEditor.h"
+#include "MapEditor/MapTextureManager.h"
 #include "OpenGL/Drawing.h"
 #include "OpenGL/OpenGL.h"
 #include "Overlays/MCOverlay.h"
@@ -1236,6 +1238,9 @@ void Renderer::draw()
 	else
 		drawMap2d();
 
+	// Unload least recently used textures if over the video memory budget
+	MapEditor::textureManager().enforceBudget();
+
 	// Draw info overlay
 	glDisable(GL_CULL_FACE);
 	glDisable(GL_DEPTH_TEST);
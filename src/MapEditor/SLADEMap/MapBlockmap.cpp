@@ -0,0 +1,556 @@
+
+/*******************************************************************
+ * SLADE - It's a Doom Editor
+ * Copyright (C) 2008-2014 Simon Judd
+ *
+ * Email:       sirjuddington@gmail.com
+ * Web:         http://slade.mancubus.net
+ * Filename:    MapBlockmap.cpp
+ * Description: MapBlockmap class, a spatial index (uniform grid of
+ *              blocks) of a SLADEMap's objects, used to quickly get
+ *              the objects near a point for hit-testing
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *******************************************************************/
+
+
+/*******************************************************************
+ * INCLUDES
+ *******************************************************************/
+#include "Main.h"
+#include "MapBlockmap.h"
+#include "SLADEMap.h"
+
+
+/*******************************************************************
+ * VARIABLES
+ *******************************************************************/
+namespace
+{
+	const double	BLOCK_SIZE_MIN	= 128;		// Smallest block size (map units)
+	const double	MAX_BLOCKS		= 65536;	// Maximum number of blocks in the grid
+	const double	MARGIN_MIN		= 1024;		// Minimum space around the map extents
+}
+
+
+/*******************************************************************
+ * FUNCTIONS
+ *******************************************************************/
+namespace
+{
+	/* sortByIndex
+	 * Used to sort map objects by index
+	 *******************************************************************/
+	bool sortByIndex(MapObject* left, MapObject* right)
+	{
+		return left->getIndex() < right->getIndex();
+	}
+
+	/* removeFromList
+	 * Removes [object] from [list] (order isn't kept)
+	 *******************************************************************/
+	template<typename T> void removeFromList(vector<T*>& list, MapObject* object)
+	{
+		for (unsigned a = 0; a < list.size(); a++)
+		{
+			if (list[a] == object)
+			{
+				list[a] = list.back();
+				list.pop_back();
+				return;
+			}
+		}
+	}
+}
+
+
+/*******************************************************************
+ * MAPBLOCKMAP CLASS FUNCTIONS
+ *******************************************************************/
+
+/* MapBlockmap::MapBlockmap
+ * MapBlockmap class constructor
+ *******************************************************************/
+MapBlockmap::MapBlockmap(SLADEMap* map) :
+	map_(map),
+	valid_(false),
+	origin_x_(0),
+	origin_y_(0),
+	block_size_(BLOCK_SIZE_MIN),
+	width_(0),
+	height_(0)
+{
+}
+
+/* MapBlockmap::~MapBlockmap
+ * MapBlockmap class destructor
+ *******************************************************************/
+MapBlockmap::~MapBlockmap()
+{
+}
+
+/* MapBlockmap::invalidate
+ * Clears the blockmap, it will be rebuilt from the map next time it
+ * is queried. Should be called when large changes are made to the
+ * map (opening, undo/redo etc.)
+ *******************************************************************/
+void MapBlockmap::invalidate()
+{
+	valid_ = false;
+	blocks_.clear();
+	ranges_.clear();
+	modified_.clear();
+	unbounded_sectors_.clear();
+}
+
+/* MapBlockmap::objectModified
+ * Flags [object] to be re-indexed next time the blockmap is queried.
+ * This is called *before* the object is modified (see
+ * MapObject::setModified), and also when it is added to or removed
+ * from the map
+ *******************************************************************/
+void MapBlockmap::objectModified(MapObject* object)
+{
+	if (!valid_)
+		return;
+
+	// Sides aren't indexed
+	if (object->getObjType() == MOBJ_SIDE)
+		return;
+
+	// If most of the map has been modified, just rebuild it
+	if (modified_.size() > ranges_.size() / 2 + 64)
+	{
+		invalidate();
+		return;
+	}
+
+	modified_.push_back(object);
+}
+
+/* MapBlockmap::verticesNear
+ * Adds all vertices within [radius] (on each axis) of [point] to
+ * [list], along with possibly some further away. Returns true if
+ * [list] contains all map vertices
+ *******************************************************************/
+bool MapBlockmap::verticesNear(fpoint2_t point, double radius, vector<MapVertex*>& list)
+{
+	update();
+	list.clear();
+
+	// Check everything if it would be quicker
+	block_range_t range;
+	if (!queryRange(point, radius, map_->nVertices() / 4, range))
+	{
+		list = map_->vertices();
+		return true;
+	}
+
+	for (int y = range.y1; y <= range.y2; y++)
+	{
+		for (int x = range.x1; x <= range.x2; x++)
+		{
+			block_t& block = blocks_[y * width_ + x];
+			list.insert(list.end(), block.vertices.begin(), block.vertices.end());
+		}
+	}
+
+	return (range.x1 == 0 && range.y1 == 0 && range.x2 == width_ - 1 && range.y2 == height_ - 1);
+}
+
+/* MapBlockmap::linesNear
+ * Adds all lines with bounding boxes within [radius] (on each axis) of
+ * [point] to [list], along with possibly some further away. The list
+ * is sorted by line index. Returns true if [list] contains all map
+ * lines
+ *******************************************************************/
+bool MapBlockmap::linesNear(fpoint2_t point, double radius, vector<MapLine*>& list)
+{
+	update();
+	list.clear();
+
+	// Check everything if it would be quicker (lines can be in multiple
+	// blocks, so the list needs sorting)
+	block_range_t range;
+	if (!queryRange(point, radius, map_->nLines() / 16, range))
+	{
+		list = map_->lines();
+		return true;
+	}
+
+	for (int y = range.y1; y <= range.y2; y++)
+	{
+		for (int x = range.x1; x <= range.x2; x++)
+		{
+			block_t& block = blocks_[y * width_ + x];
+			list.insert(list.end(), block.lines.begin(), block.lines.end());
+		}
+	}
+
+	// Lines can be in multiple blocks
+	std::sort(list.begin(), list.end(), sortByIndex);
+	list.erase(std::unique(list.begin(), list.end()), list.end());
+
+	return (range.x1 == 0 && range.y1 == 0 && range.x2 == width_ - 1 && range.y2 == height_ - 1);
+}
+
+/* MapBlockmap::thingsNear
+ * Adds all things within [radius] (on each axis) of [point] to
+ * [list], along with possibly some further away. Returns true if
+ * [list] contains all map things
+ *******************************************************************/
+bool MapBlockmap::thingsNear(fpoint2_t point, double radius, vector<MapThing*>& list)
+{
+	update();
+	list.clear();
+
+	// Check everything if it would be quicker
+	block_range_t range;
+	if (!queryRange(point, radius, map_->nThings() / 4, range))
+	{
+		list = map_->things();
+		return true;
+	}
+
+	for (int y = range.y1; y <= range.y2; y++)
+	{
+		for (int x = range.x1; x <= range.x2; x++)
+		{
+			block_t& block = blocks_[y * width_ + x];
+			list.insert(list.end(), block.things.begin(), block.things.end());
+		}
+	}
+
+	return (range.x1 == 0 && range.y1 == 0 && range.x2 == width_ - 1 && range.y2 == height_ - 1);
+}
+
+/* MapBlockmap::sectorsAt
+ * Adds all sectors with bounding boxes that could contain [point] to
+ * [list], sorted by sector index. Returns false if there are none
+ *******************************************************************/
+bool MapBlockmap::sectorsAt(fpoint2_t point, vector<MapSector*>& list)
+{
+	update();
+	list = unbounded_sectors_;
+
+	block_range_t range;
+	if (queryRange(point, 0, blocks_.size(), range) && range.x1 <= range.x2 && range.y1 <= range.y2)
+	{
+		block_t& block = blocks_[range.y1 * width_ + range.x1];
+		list.insert(list.end(), block.sectors.begin(), block.sectors.end());
+	}
+
+	std::sort(list.begin(), list.end(), sortByIndex);
+	list.erase(std::unique(list.begin(), list.end()), list.end());
+
+	return !list.empty();
+}
+
+/* MapBlockmap::update
+ * Builds the blockmap if needed, otherwise re-indexes any objects
+ * modified since the last update
+ *******************************************************************/
+void MapBlockmap::update()
+{
+	if (!valid_)
+	{
+		build();
+		return;
+	}
+
+	if (modified_.empty())
+		return;
+
+	vector<MapObject*> modified;
+	modified.swap(modified_);
+
+	// Lines connected to modified vertices need updating too
+	unsigned n_modified = modified.size();
+	for (unsigned a = 0; a < n_modified; a++)
+	{
+		if (modified[a]->getObjType() == MOBJ_VERTEX)
+		{
+			const vector<MapLine*>& lines = ((MapVertex*)modified[a])->connectedLines();
+			modified.insert(modified.end(), lines.begin(), lines.end());
+		}
+	}
+	std::sort(modified.begin(), modified.end());
+	modified.erase(std::unique(modified.begin(), modified.end()), modified.end());
+
+	for (unsigned a = 0; a < modified.size(); a++)
+	{
+		remove(modified[a]);
+
+		// Rebuild if an object is now outside the blockmap
+		if (inMap(modified[a]) && !add(modified[a]))
+		{
+			build();
+			return;
+		}
+	}
+}
+
+/* MapBlockmap::build
+ * (Re)builds the blockmap from all objects currently in the map
+ *******************************************************************/
+void MapBlockmap::build()
+{
+	invalidate();
+
+	// Determine map extents (vertices and things, and sector bounding
+	// boxes in case any are out of date)
+	double min_x = 0;
+	double min_y = 0;
+	double max_x = 0;
+	double max_y = 0;
+	bool first = true;
+	auto extend = [&](double x, double y)
+	{
+		if (first)
+		{
+			min_x = max_x = x;
+			min_y = max_y = y;
+			first = false;
+			return;
+		}
+
+		min_x = MIN(min_x, x);
+		min_y = MIN(min_y, y);
+		max_x = MAX(max_x, x);
+		max_y = MAX(max_y, y);
+	};
+	for (auto vertex : map_->vertices())
+		extend(vertex->xPos(), vertex->yPos());
+	for (auto thing : map_->things())
+		extend(thing->xPos(), thing->yPos());
+	for (auto sector : map_->sectors())
+	{
+		bbox_t bbox = sector->boundingBox();
+		if (bbox.is_valid())
+		{
+			extend(bbox.min.x, bbox.min.y);
+			extend(bbox.max.x, bbox.max.y);
+		}
+	}
+
+	// Leave some space around the map so it doesn't need rebuilding
+	// every time something is drawn outside it
+	double margin = MAX(MARGIN_MIN, MAX(max_x - min_x, max_y - min_y) * 0.125);
+	origin_x_ = min_x - margin;
+	origin_y_ = min_y - margin;
+	double width = max_x - min_x + margin * 2;
+	double height = max_y - min_y + margin * 2;
+
+	// Determine block size
+	block_size_ = BLOCK_SIZE_MIN;
+	while ((floor(width / block_size_) + 1) * (floor(height / block_size_) + 1) > MAX_BLOCKS)
+		block_size_ *= 2;
+	width_ = (int)floor(width / block_size_) + 1;
+	height_ = (int)floor(height / block_size_) + 1;
+	blocks_.resize(width_ * height_);
+	valid_ = true;
+
+	// Add objects
+	ranges_.reserve(map_->nVertices() + map_->nLines() + map_->nSectors() + map_->nThings());
+	for (auto vertex : map_->vertices())
+		add(vertex);
+	for (auto line : map_->lines())
+		add(line);
+	for (auto sector : map_->sectors())
+		add(sector);
+	for (auto thing : map_->things())
+		add(thing);
+}
+
+/* MapBlockmap::getRange
+ * Sets [range] to the blocks covering the area [x1,y1] to [x2,y2].
+ * Returns false if the area isn't entirely within the blockmap
+ *******************************************************************/
+bool MapBlockmap::getRange(double x1, double y1, double x2, double y2, block_range_t& range)
+{
+	double bx1 = floor((x1 - origin_x_) / block_size_);
+	double by1 = floor((y1 - origin_y_) / block_size_);
+	double bx2 = floor((x2 - origin_x_) / block_size_);
+	double by2 = floor((y2 - origin_y_) / block_size_);
+
+	// Check range (written so that NaN positions fail)
+	if (!(bx1 >= 0 && by1 >= 0 && bx2 < width_ && by2 < height_))
+		return false;
+
+	range.x1 = (int)bx1;
+	range.y1 = (int)by1;
+	range.x2 = (int)bx2;
+	range.y2 = (int)by2;
+
+	return true;
+}
+
+/* MapBlockmap::queryRange
+ * Sets [range] to the blocks covering the area within [radius] of
+ * [point], clipped to the blockmap (x1 > x2 or y1 > y2 if the area is
+ * outside it). Returns false if the area covers more than [max_blocks]
+ * blocks, in which case it will be quicker to check all objects
+ *******************************************************************/
+bool MapBlockmap::queryRange(fpoint2_t point, double radius, size_t max_blocks, block_range_t& range)
+{
+	double bx1 = MAX(floor((point.x - radius - origin_x_) / block_size_), 0);
+	double by1 = MAX(floor((point.y - radius - origin_y_) / block_size_), 0);
+	double bx2 = MIN(floor((point.x + radius - origin_x_) / block_size_), width_ - 1);
+	double by2 = MIN(floor((point.y + radius - origin_y_) / block_size_), height_ - 1);
+
+	// Check for area outside the blockmap
+	if (!(bx1 <= bx2 && by1 <= by2))
+	{
+		range.x1 = range.y1 = 0;
+		range.x2 = range.y2 = -1;
+		return true;
+	}
+
+	if ((bx2 - bx1 + 1) * (by2 - by1 + 1) > max_blocks)
+		return false;
+
+	range.x1 = (int)bx1;
+	range.y1 = (int)by1;
+	range.x2 = (int)bx2;
+	range.y2 = (int)by2;
+
+	return true;
+}
+
+/* MapBlockmap::inMap
+ * Returns true if [object] is currently part of the map
+ *******************************************************************/
+bool MapBlockmap::inMap(MapObject* object)
+{
+	unsigned index = object->getIndex();
+	switch (object->getObjType())
+	{
+	case MOBJ_VERTEX:
+		return index < map_->nVertices() && map_->vertices()[index] == object;
+	case MOBJ_LINE:
+		return index < map_->nLines() && map_->lines()[index] == object;
+	case MOBJ_SECTOR:
+		return index < map_->nSectors() && map_->sectors()[index] == object;
+	case MOBJ_THING:
+		return index < map_->nThings() && map_->things()[index] == object;
+	default:
+		return false;
+	}
+}
+
+/* MapBlockmap::add
+ * Adds [object] to the blocks it is within. Returns false if it is
+ * outside the blockmap
+ *******************************************************************/
+bool MapBlockmap::add(MapObject* object)
+{
+	block_range_t range;
+
+	switch (object->getObjType())
+	{
+	case MOBJ_VERTEX:
+	{
+		MapVertex* vertex = (MapVertex*)object;
+		if (!getRange(vertex->xPos(), vertex->yPos(), vertex->xPos(), vertex->yPos(), range))
+			return false;
+		blocks_[range.y1 * width_ + range.x1].vertices.push_back(vertex);
+		break;
+	}
+	case MOBJ_LINE:
+	{
+		MapLine* line = (MapLine*)object;
+		double x1 = line->x1();
+		double y1 = line->y1();
+		double x2 = line->x2();
+		double y2 = line->y2();
+		if (!getRange(MIN(x1, x2), MIN(y1, y2), MAX(x1, x2), MAX(y1, y2), range))
+			return false;
+		for (int y = range.y1; y <= range.y2; y++)
+			for (int x = range.x1; x <= range.x2; x++)
+				blocks_[y * width_ + x].lines.push_back(line);
+		break;
+	}
+	case MOBJ_SECTOR:
+	{
+		// Sectors are added by bounding box (the same one used by
+		// MapSector::isWithin), if it's invalid they are always checked
+		MapSector* sector = (MapSector*)object;
+		bbox_t bbox = sector->boundingBox();
+		if (!bbox.is_valid())
+		{
+			range.x1 = range.y1 = range.x2 = range.y2 = -1;
+			unbounded_sectors_.push_back(sector);
+			break;
+		}
+		if (!getRange(bbox.min.x, bbox.min.y, bbox.max.x, bbox.max.y, range))
+			return false;
+		for (int y = range.y1; y <= range.y2; y++)
+			for (int x = range.x1; x <= range.x2; x++)
+				blocks_[y * width_ + x].sectors.push_back(sector);
+		break;
+	}
+	case MOBJ_THING:
+	{
+		MapThing* thing = (MapThing*)object;
+		if (!getRange(thing->xPos(), thing->yPos(), thing->xPos(), thing->yPos(), range))
+			return false;
+		blocks_[range.y1 * width_ + range.x1].things.push_back(thing);
+		break;
+	}
+	default:
+		return true;
+	}
+
+	ranges_[object] = range;
+
+	return true;
+}
+
+/* MapBlockmap::remove
+ * Removes [object] from the blocks it was added to
+ *******************************************************************/
+void MapBlockmap::remove(MapObject* object)
+{
+	auto i = ranges_.find(object);
+	if (i == ranges_.end())
+		return;
+
+	block_range_t range = i->second;
+	ranges_.erase(i);
+
+	// Not in any block
+	if (range.x1 < 0)
+	{
+		if (object->getObjType() == MOBJ_SECTOR)
+			removeFromList(unbounded_sectors_, object);
+		return;
+	}
+
+	for (int y = range.y1; y <= range.y2; y++)
+	{
+		for (int x = range.x1; x <= range.x2; x++)
+		{
+			block_t& block = blocks_[y * width_ + x];
+			switch (object->getObjType())
+			{
+			case MOBJ_VERTEX: removeFromList(block.vertices, object); break;
+			case MOBJ_LINE: removeFromList(block.lines, object); break;
+			case MOBJ_SECTOR: removeFromList(block.sectors, object); break;
+			case MOBJ_THING: removeFromList(block.things, object); break;
+			default: break;
+			}
+		}
+	}
+}
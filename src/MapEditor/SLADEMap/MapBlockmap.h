@@ -0,0 +1,70 @@
+#ifndef __MAPBLOCKMAP_H__
+#define __MAPBLOCKMAP_H__
+
+#include <unordered_map>
+
+class SLADEMap;
+class MapObject;
+class MapVertex;
+class MapLine;
+class MapSector;
+class MapThing;
+
+// A uniform grid of 'blocks' over a SLADEMap, each listing the map objects
+// (vertices, lines, sectors and things) within it, used to speed up
+// hit-testing queries (nearest vertex, sector at point etc.) on large maps.
+// It is built when first queried, and objects are re-indexed when they are
+// modified (see SLADEMap::updateBlockmap)
+class MapBlockmap
+{
+public:
+	MapBlockmap(SLADEMap* map);
+	~MapBlockmap();
+
+	void	invalidate();
+	void	objectModified(MapObject* object);
+
+	bool	verticesNear(fpoint2_t point, double radius, vector<MapVertex*>& list);
+	bool	linesNear(fpoint2_t point, double radius, vector<MapLine*>& list);
+	bool	thingsNear(fpoint2_t point, double radius, vector<MapThing*>& list);
+	bool	sectorsAt(fpoint2_t point, vector<MapSector*>& list);
+
+private:
+	struct block_t
+	{
+		vector<MapVertex*>	vertices;
+		vector<MapLine*>	lines;
+		vector<MapSector*>	sectors;
+		vector<MapThing*>	things;
+	};
+
+	// Range of blocks an object is in (x1 < 0 if the object isn't in any
+	// block, eg. a sector with an invalid bounding box)
+	struct block_range_t
+	{
+		int	x1, y1, x2, y2;
+	};
+
+	SLADEMap*	map_;
+	bool		valid_;
+	double		origin_x_;
+	double		origin_y_;
+	double		block_size_;
+	int			width_;
+	int			height_;
+
+	vector<block_t>								blocks_;
+	std::unordered_map<MapObject*, block_range_t>	ranges_;
+	vector<MapObject*>							modified_;
+	vector<MapSector*>							unbounded_sectors_;
+
+	void	update();
+	void	build();
+	bool	getRange(double x1, double y1, double x2, double y2, block_range_t& range);
+	bool	queryRange(fpoint2_t point, double radius, size_t max_blocks, block_range_t& range);
+	bool	inMap(MapObject* object);
+	bool	add(MapObject* object);
+	void	remove(MapObject* object);
+};
+
+#endif//__MAPBLOCKMAP_H__
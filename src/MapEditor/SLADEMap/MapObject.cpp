@@ -119,6 +119,10 @@ void MapObject::setModified()
 	}
 
 	modified_time = App::runTimer();
+
+	// Update in map blockmap
+	if (parent_map)
+		parent_map->updateBlockmap(this);
 }
 
 /* MapObject::copy
@@ -151,8 +155,9 @@ void MapObject::copy(MapObject* c)
 bool MapObject::boolProperty(const string& key)
 {
 	// If the property exists already, return it
-	if (properties[key].hasValue())
-		return properties[key].getBoolValue();
+	auto value = properties.find(key);
+	if (value && value->hasValue())
+		return value->getBoolValue();
 
 	// Otherwise check the game configuration for a default value
 	else
@@ -171,8 +176,9 @@ bool MapObject::boolProperty(const string& key)
 int MapObject::intProperty(const string& key)
 {
 	// If the property exists already, return it
-	if (properties[key].hasValue())
-		return properties[key].getIntValue();
+	auto value = properties.find(key);
+	if (value && value->hasValue())
+		return value->getIntValue();
 
 	// Otherwise check the game configuration for a default value
 	else
@@ -191,8 +197,9 @@ int MapObject::intProperty(const string& key)
 double MapObject::floatProperty(const string& key)
 {
 	// If the property exists already, return it
-	if (properties[key].hasValue())
-		return properties[key].getFloatValue();
+	auto value = properties.find(key);
+	if (value && value->hasValue())
+		return value->getFloatValue();
 
 	// Otherwise check the game configuration for a default value
 	else
@@ -211,8 +218,9 @@ double MapObject::floatProperty(const string& key)
 string MapObject::stringProperty(const string& key)
 {
 	// If the property exists already, return it
-	if (properties[key].hasValue())
-		return properties[key].getStringValue();
+	auto value = properties.find(key);
+	if (value && value->hasValue())
+		return value->getStringValue();
 
 	// Otherwise check the game configuration for a default value
 	else
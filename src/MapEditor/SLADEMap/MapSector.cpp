@@ -287,6 +287,19 @@ void MapSector::updateBBox()
 	setGeometryUpdated();
 }
 
+/* MapSector::resetBBox
+ * Resets the sector bounding box, it will be recalculated next time
+ * it is needed
+ *******************************************************************/
+void MapSector::resetBBox()
+{
+	bbox.reset();
+
+	// Update in map blockmap
+	if (parent_map)
+		parent_map->updateBlockmap(this);
+}
+
 /* MapSector::boundingBox
  * Returns the sector bounding box
  *******************************************************************/
@@ -149,7 +149,7 @@ public:
 	void	setPlane(plane_t plane);
 
 	fpoint2_t			getPoint(uint8_t point) override;
-	void				resetBBox() { bbox.reset(); }
+	void				resetBBox();
 	bbox_t				boundingBox();
 	vector<MapSide*>&	connectedSides() { return connected_sides; }
 	void				resetPolygon() { poly_needsupdate = true; }
@@ -6,7 +6,8 @@
  * Web:         http://slade.mancubus.net
  * Filename:    MobjPropertyList.cpp
  * Description: A special version of the PropertyList class that
- *              uses a vector rather than a map to store properties
+ *              uses a vector rather than a map to store properties,
+ *              with names kept once in a shared key table
  *
  * This program is free software; you can redistribute it and/or
  * modify it under the terms of the GNU General Public License
@@ -30,6 +31,20 @@
 #include "Main.h"
 #include "MobjPropertyList.h"
 #include "Utility/StringUtils.h"
+#include <deque>
+#include <unordered_map>
+
+
+/*******************************************************************
+ * VARIABLES
+ *******************************************************************/
+namespace
+{
+	// Shared key table. Keys are only ever added (from the main thread),
+	// and a deque is used so existing names are never moved
+	std::deque<string>												key_names;
+	std::unordered_map<string, unsigned, wxStringHash, wxStringEqual>	key_ids;
+}
 
 
 /*******************************************************************
@@ -50,34 +65,49 @@ MobjPropertyList::~MobjPropertyList()
 {
 }
 
-/* MobjPropertyList::propertyExists
- * Returns true if a property with the given name exists, false
- * otherwise
+/* MobjPropertyList::find
+ * Returns the property with the given name, or nullptr if it doesn't
+ * exist. Unlike operator[], a missing property isn't added
  *******************************************************************/
-bool MobjPropertyList::propertyExists(string key)
+Property* MobjPropertyList::find(const string& key)
 {
-	for (unsigned a = 0; a < properties.size(); ++a)
+	int id = findKeyId(key);
+	if (id < 0)
+		return nullptr;
+
+	for (auto& prop : properties)
 	{
-		if (properties[a].name == key)
-			return true;
+		if (prop.key == (unsigned)id)
+			return &prop.value;
 	}
 
-	return false;
+	return nullptr;
+}
+
+/* MobjPropertyList::propertyExists
+ * Returns true if a property with the given name exists, false
+ * otherwise
+ *******************************************************************/
+bool MobjPropertyList::propertyExists(const string& key)
+{
+	return find(key) != nullptr;
 }
 
 /* MobjPropertyList::removeProperty
  * Removes a property value, returns true if [key] was removed
  * or false if key didn't exist
  *******************************************************************/
-bool MobjPropertyList::removeProperty(string key)
+bool MobjPropertyList::removeProperty(const string& key)
 {
-	//return properties.erase(key) > 0;
+	int id = findKeyId(key);
+	if (id < 0)
+		return false;
+
 	for (unsigned a = 0; a < properties.size(); ++a)
 	{
-		if (properties[a].name == key)
+		if (properties[a].key == (unsigned)id)
 		{
-			properties[a] = properties.back();
-			properties.pop_back();
+			properties.erase(properties.begin() + a);
 			return true;
 		}
 	}
@@ -90,20 +120,16 @@ bool MobjPropertyList::removeProperty(string key)
  *******************************************************************/
 void MobjPropertyList::copyTo(MobjPropertyList& list)
 {
-	// Clear given list
-	list.clear();
-
-	for (unsigned a = 0; a < properties.size(); ++a)
-		list.properties.push_back(prop_t(properties[a].name, properties[a].value));
+	list.properties = properties;
 }
 
 /* MobjPropertyList::addFlag
  * Adds a 'flag' property [key]
  *******************************************************************/
-void MobjPropertyList::addFlag(string key)
+void MobjPropertyList::addFlag(const string& key)
 {
 	Property flag;
-	properties.push_back(prop_t(key, flag));
+	properties.push_back(prop_t(keyId(key), flag));
 }
 
 /* MobjPropertyList::toString
@@ -121,7 +147,7 @@ string MobjPropertyList::toString(bool condensed)
 			continue;
 
 		// Add "key = value;\n" to the return string
-		string key = properties[a].name;
+		const string& key = properties[a].name();
 		string val = properties[a].value.getStringValue();
 
 		if (properties[a].value.getType() == PROP_STRING)
@@ -138,3 +164,46 @@ string MobjPropertyList::toString(bool condensed)
 
 	return ret;
 }
+
+
+/*******************************************************************
+ * MOBJPROPERTYLIST CLASS STATIC FUNCTIONS
+ *******************************************************************/
+
+/* MobjPropertyList::keyId
+ * Returns the id of property name [name] in the shared key table,
+ * adding it if needed. Must only be called from the main thread
+ *******************************************************************/
+unsigned MobjPropertyList::keyId(const string& name)
+{
+	auto i = key_ids.find(name);
+	if (i != key_ids.end())
+		return i->second;
+
+	unsigned id = key_names.size();
+	key_names.push_back(name);
+	key_ids[name] = id;
+
+	return id;
+}
+
+/* MobjPropertyList::findKeyId
+ * Returns the id of property name [name] in the shared key table, or
+ * -1 if no property with that name has been used
+ *******************************************************************/
+int MobjPropertyList::findKeyId(const string& name)
+{
+	auto i = key_ids.find(name);
+	if (i != key_ids.end())
+		return i->second;
+
+	return -1;
+}
+
+/* MobjPropertyList::keyName
+ * Returns the property name for key id [key]
+ *******************************************************************/
+const string& MobjPropertyList::keyName(unsigned key)
+{
+	return key_names[key];
+}
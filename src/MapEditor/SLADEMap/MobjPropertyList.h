@@ -7,29 +7,32 @@
 class MobjPropertyList
 {
 public:
+	// A property, named by its id in the shared key table (see keyId),
+	// so each object doesn't need to keep its own copy of the name
 	struct prop_t
 	{
-		string		name;
+		unsigned	key;
 		Property	value;
 
-		prop_t(string name) { this->name = name; }
-		prop_t(string name, Property value)
-		{
-			this->name = name;
-			this->value = value;
-		}
+		prop_t(unsigned key) : key{ key } {}
+		prop_t(unsigned key, const Property& value) : key{ key }, value{ value } {}
+
+		const string&	name() const { return keyName(key); }
 	};
 
 	MobjPropertyList();
 	~MobjPropertyList();
 
 	// Operator for direct access to hash map
-	Property& operator[](string key)
+	Property& operator[](const string& key) { return get(keyId(key)); }
+
+	// Returns the property with key id [key], adding it if it doesn't exist
+	Property& get(unsigned key)
 	{
-		for (unsigned a = 0; a < properties.size(); ++a)
+		for (auto& prop : properties)
 		{
-			if (properties[a].name == key)
-				return properties[a].value;
+			if (prop.key == key)
+				return prop.value;
 		}
 
 		properties.push_back(prop_t(key));
@@ -38,15 +41,21 @@ public:
 
 	vector<prop_t>&	allProperties() { return properties; }
 
-	void	clear() { properties.clear(); }
-	bool	propertyExists(string key);
-	bool	removeProperty(string key);
-	void	copyTo(MobjPropertyList& list);
-	void	addFlag(string key);
-	bool	isEmpty() { return properties.empty(); }
+	void		clear() { properties.clear(); }
+	Property*	find(const string& key);
+	bool		propertyExists(const string& key);
+	bool		removeProperty(const string& key);
+	void		copyTo(MobjPropertyList& list);
+	void		addFlag(const string& key);
+	bool		isEmpty() { return properties.empty(); }
 
 	string	toString(bool condensed = false);
 
+	// Shared key table
+	static unsigned			keyId(const string& name);
+	static int				findKeyId(const string& name);
+	static const string&	keyName(unsigned key);
+
 private:
 	vector<prop_t>	properties;
 };
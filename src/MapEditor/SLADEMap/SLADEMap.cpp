@@ -37,7 +37,7 @@
 #include "MapEditor/SectorBuilder.h"
 #include "SLADEMap.h"
 #include "Utility/MathStuff.h"
-#include "Utility/Parser.h"
+#include "Utility/ThreadPool.h"
 
 #define IDEQ(x) (((x) != 0) && ((x) == id))
 
@@ -55,7 +55,7 @@ CVAR(Bool, map_split_auto_offset, true, CVAR_SAVE)
 /* SLADEMap::SLADEMap
  * SLADEMap class constructor
  *******************************************************************/
-SLADEMap::SLADEMap()
+SLADEMap::SLADEMap() : blockmap_(this)
 {
 	// Init variables
 	this->geometry_updated_ = 0;
@@ -203,6 +203,7 @@ void SLADEMap::addMapObject(MapObject* object)
 	all_objects_.push_back(mobj_holder_t(object, true));
 	object->id = all_objects_.size() - 1;
 	created_deleted_objects_.push_back(mobj_cd_t(object->id, true));
+	blockmap_.objectModified(object);
 }
 
 /* SLADEMap::removeMapObject
@@ -213,6 +214,7 @@ void SLADEMap::removeMapObject(MapObject* object)
 {
 	all_objects_[object->id].in_map = false;
 	created_deleted_objects_.push_back(mobj_cd_t(object->id, false));
+	blockmap_.objectModified(object);
 }
 
 /* SLADEMap::getObjectIdList
@@ -253,6 +255,9 @@ void SLADEMap::getObjectIdList(uint8_t type, vector<unsigned>& list)
  *******************************************************************/
 void SLADEMap::restoreObjectIdList(uint8_t type, vector<unsigned>& list)
 {
+	// Blockmap will need rebuilding
+	blockmap_.invalidate();
+
 	if (type == MOBJ_VERTEX)
 	{
 		// Clear
@@ -336,6 +341,7 @@ void SLADEMap::restoreObjectIdList(uint8_t type, vector<unsigned>& list)
 bool SLADEMap::readMap(Archive::MapDesc map)
 {
 	Archive::MapDesc omap = map;
+	blockmap_.invalidate();
 
 	// Check for map archive
 	Archive* tempwad = nullptr;
@@ -1410,13 +1416,13 @@ bool SLADEMap::readDoom64Map(Archive::MapDesc map)
 }
 
 /* SLADEMap::addVertex
- * Adds a vertex to the map from parsed UDMF vertex definition [def]
+ * Adds a vertex to the map from UDMF vertex definition [def]
  *******************************************************************/
-bool SLADEMap::addVertex(ParseTreeNode* def)
+bool SLADEMap::addVertex(const UDMFReader::def_t& def)
 {
 	// Check for required properties
-	auto prop_x = def->getChildPTN("x");
-	auto prop_y = def->getChildPTN("y");
+	auto prop_x = UDMFReader::findProp(def, "x");
+	auto prop_y = UDMFReader::findProp(def, "y");
 	if (!prop_x || !prop_y)
 		return false;
 
@@ -1424,16 +1430,13 @@ bool SLADEMap::addVertex(ParseTreeNode* def)
 	MapVertex* nv = new MapVertex(prop_x->floatValue(), prop_y->floatValue(), this);
 
 	// Add extra vertex info
-	ParseTreeNode* prop = nullptr;
-	for (unsigned a = 0; a < def->nChildren(); a++)
+	for (auto& prop : def)
 	{
-		prop = def->getChildPTN(a);
-
 		// Skip required properties
-		if (prop == prop_x || prop == prop_y)
+		if (&prop == prop_x || &prop == prop_y)
 			continue;
 
-		nv->properties[prop->getName()] = prop->value();
+		nv->properties.get(prop.key) = prop.value;
 	}
 
 	// Add vertex to map
@@ -1443,12 +1446,12 @@ bool SLADEMap::addVertex(ParseTreeNode* def)
 }
 
 /* SLADEMap::addSide
- * Adds a side to the map from parsed UDMF side definition [def]
+ * Adds a side to the map from UDMF side definition [def]
  *******************************************************************/
-bool SLADEMap::addSide(ParseTreeNode* def)
+bool SLADEMap::addSide(const UDMFReader::def_t& def)
 {
 	// Check for required properties
-	auto prop_sector = def->getChildPTN("sector");
+	auto prop_sector = UDMFReader::findProp(def, "sector");
 	if (!prop_sector)
 		return false;
 
@@ -1468,28 +1471,24 @@ bool SLADEMap::addSide(ParseTreeNode* def)
 	ns->tex_lower = "-";
 
 	// Add extra side info
-	ParseTreeNode* prop = nullptr;
-	for (unsigned a = 0; a < def->nChildren(); a++)
+	for (auto& prop : def)
 	{
-		prop = def->getChildPTN(a);
-
 		// Skip required properties
-		if (prop == prop_sector)
+		if (&prop == prop_sector)
 			continue;
 
-		if (S_CMPNOCASE(prop->getName(), "texturetop"))
-			ns->tex_upper = prop->stringValue();
-		else if (S_CMPNOCASE(prop->getName(), "texturemiddle"))
-			ns->tex_middle = prop->stringValue();
-		else if (S_CMPNOCASE(prop->getName(), "texturebottom"))
-			ns->tex_lower = prop->stringValue();
-		else if (S_CMPNOCASE(prop->getName(), "offsetx"))
-			ns->offset_x = prop->intValue();
-		else if (S_CMPNOCASE(prop->getName(), "offsety"))
-			ns->offset_y = prop->intValue();
+		if (S_CMPNOCASE(*prop.name, "texturetop"))
+			ns->tex_upper = prop.stringValue();
+		else if (S_CMPNOCASE(*prop.name, "texturemiddle"))
+			ns->tex_middle = prop.stringValue();
+		else if (S_CMPNOCASE(*prop.name, "texturebottom"))
+			ns->tex_lower = prop.stringValue();
+		else if (S_CMPNOCASE(*prop.name, "offsetx"))
+			ns->offset_x = prop.intValue();
+		else if (S_CMPNOCASE(*prop.name, "offsety"))
+			ns->offset_y = prop.intValue();
 		else
-			ns->properties[prop->getName()] = prop->value();
-		//LOG_MESSAGE(1, "Property %s type %s (%s)", prop->getName(), prop->getValue().typeString(), prop->getValue().getStringValue());
+			ns->properties.get(prop.key) = prop.value;
 	}
 
 	// Update texture counts
@@ -1504,14 +1503,14 @@ bool SLADEMap::addSide(ParseTreeNode* def)
 }
 
 /* SLADEMap::addLine
- * Adds a line to the map from parsed UDMF line definition [def]
+ * Adds a line to the map from UDMF line definition [def]
  *******************************************************************/
-bool SLADEMap::addLine(ParseTreeNode* def)
+bool SLADEMap::addLine(const UDMFReader::def_t& def)
 {
 	// Check for required properties
-	auto prop_v1 = def->getChildPTN("v1");
-	auto prop_v2 = def->getChildPTN("v2");
-	auto prop_s1 = def->getChildPTN("sidefront");
+	auto prop_v1 = UDMFReader::findProp(def, "v1");
+	auto prop_v2 = UDMFReader::findProp(def, "v2");
+	auto prop_s1 = UDMFReader::findProp(def, "sidefront");
 	if (!prop_v1 || !prop_v2 || !prop_s1)
 		return false;
 
@@ -1528,7 +1527,7 @@ bool SLADEMap::addLine(ParseTreeNode* def)
 
 	// Get second side if any
 	MapSide* side2 = nullptr;
-	auto prop_s2 = def->getChildPTN("sideback");
+	auto prop_s2 = UDMFReader::findProp(def, "sideback");
 	if (prop_s2) side2 = getSide(prop_s2->intValue());
 
 	// Create new line
@@ -1539,21 +1538,18 @@ bool SLADEMap::addLine(ParseTreeNode* def)
 	nl->line_id = 0;
 
 	// Add extra line info
-	ParseTreeNode* prop = nullptr;
-	for (unsigned a = 0; a < def->nChildren(); a++)
+	for (auto& prop : def)
 	{
-		prop = def->getChildPTN(a);
-
 		// Skip required properties
-		if (prop == prop_v1 || prop == prop_v2 || prop == prop_s1 || prop == prop_s2)
+		if (&prop == prop_v1 || &prop == prop_v2 || &prop == prop_s1 || &prop == prop_s2)
 			continue;
 
-		if (prop->getName() == "special")
-			nl->special = prop->intValue();
-		else if (prop->getName() == "id")
-			nl->line_id = prop->intValue();
+		if (*prop.name == "special")
+			nl->special = prop.intValue();
+		else if (*prop.name == "id")
+			nl->line_id = prop.intValue();
 		else
-			nl->properties[prop->getName()] = prop->value();
+			nl->properties.get(prop.key) = prop.value;
 	}
 
 	// Add line to map
@@ -1563,13 +1559,13 @@ bool SLADEMap::addLine(ParseTreeNode* def)
 }
 
 /* SLADEMap::addSector
- * Adds a sector to the map from parsed UDMF sector definition [def]
+ * Adds a sector to the map from UDMF sector definition [def]
  *******************************************************************/
-bool SLADEMap::addSector(ParseTreeNode* def)
+bool SLADEMap::addSector(const UDMFReader::def_t& def)
 {
 	// Check for required properties
-	auto prop_ftex = def->getChildPTN("texturefloor");
-	auto prop_ctex = def->getChildPTN("textureceiling");
+	auto prop_ftex = UDMFReader::findProp(def, "texturefloor");
+	auto prop_ctex = UDMFReader::findProp(def, "textureceiling");
 	if (!prop_ftex || !prop_ctex)
 		return false;
 
@@ -1586,27 +1582,24 @@ bool SLADEMap::addSector(ParseTreeNode* def)
 	ns->tag = 0;
 
 	// Add extra sector info
-	ParseTreeNode* prop = nullptr;
-	for (unsigned a = 0; a < def->nChildren(); a++)
+	for (auto& prop : def)
 	{
-		prop = def->getChildPTN(a);
-
 		// Skip required properties
-		if (prop == prop_ftex || prop == prop_ctex)
+		if (&prop == prop_ftex || &prop == prop_ctex)
 			continue;
 
-		if (S_CMPNOCASE(prop->getName(), "heightfloor"))
-			ns->setFloorHeight(prop->intValue());
-		else if (S_CMPNOCASE(prop->getName(), "heightceiling"))
-			ns->setCeilingHeight(prop->intValue());
-		else if (S_CMPNOCASE(prop->getName(), "lightlevel"))
-			ns->light = prop->intValue();
-		else if (S_CMPNOCASE(prop->getName(), "special"))
-			ns->special = prop->intValue();
-		else if (S_CMPNOCASE(prop->getName(), "id"))
-			ns->tag = prop->intValue();
+		if (S_CMPNOCASE(*prop.name, "heightfloor"))
+			ns->setFloorHeight(prop.intValue());
+		else if (S_CMPNOCASE(*prop.name, "heightceiling"))
+			ns->setCeilingHeight(prop.intValue());
+		else if (S_CMPNOCASE(*prop.name, "lightlevel"))
+			ns->light = prop.intValue();
+		else if (S_CMPNOCASE(*prop.name, "special"))
+			ns->special = prop.intValue();
+		else if (S_CMPNOCASE(*prop.name, "id"))
+			ns->tag = prop.intValue();
 		else
-			ns->properties[prop->getName()] = prop->value();
+			ns->properties.get(prop.key) = prop.value;
 	}
 
 	// Add sector to map
@@ -1616,14 +1609,14 @@ bool SLADEMap::addSector(ParseTreeNode* def)
 }
 
 /* SLADEMap::addThing
- * Adds a thing to the map from parsed UDMF thing definition [def]
+ * Adds a thing to the map from UDMF thing definition [def]
  *******************************************************************/
-bool SLADEMap::addThing(ParseTreeNode* def)
+bool SLADEMap::addThing(const UDMFReader::def_t& def)
 {
 	// Check for required properties
-	auto prop_x = def->getChildPTN("x");
-	auto prop_y = def->getChildPTN("y");
-	auto prop_type = def->getChildPTN("type");
+	auto prop_x = UDMFReader::findProp(def, "x");
+	auto prop_y = UDMFReader::findProp(def, "y");
+	auto prop_type = UDMFReader::findProp(def, "type");
 	if (!prop_x || !prop_y || !prop_type)
 		return false;
 
@@ -1631,20 +1624,17 @@ bool SLADEMap::addThing(ParseTreeNode* def)
 	MapThing* nt = new MapThing(prop_x->floatValue(), prop_y->floatValue(), prop_type->intValue(), this);
 
 	// Add extra thing info
-	ParseTreeNode* prop = nullptr;
-	for (unsigned a = 0; a < def->nChildren(); a++)
+	for (auto& prop : def)
 	{
-		prop = def->getChildPTN(a);
-
 		// Skip required properties
-		if (prop == prop_x || prop == prop_y || prop == prop_type)
+		if (&prop == prop_x || &prop == prop_y || &prop == prop_type)
 			continue;
 
 		// Builtin properties
-		if (S_CMPNOCASE(prop->getName(), "angle"))
-			nt->angle = prop->intValue();
+		if (S_CMPNOCASE(*prop.name, "angle"))
+			nt->angle = prop.intValue();
 		else
-			nt->properties[prop->getName()] = prop->value();
+			nt->properties.get(prop.key) = prop.value;
 	}
 
 	// Add thing to map
@@ -1664,106 +1654,63 @@ bool SLADEMap::readUDMFMap(Archive::MapDesc map)
 	// --- Parse UDMF text ---
 	UI::setSplashProgressMessage("Parsing TEXTMAP");
 	UI::setSplashProgress(-100.0f);
-	Parser parser;
-	if (!parser.parseText(textmap->getMCData()))
+	UDMFReader reader;
+	if (!reader.parse(textmap->getMCData()))
 		return false;
 
 	// --- Process parsed data ---
 
-	// First we have to sort the definition blocks by type so they can
-	// be created in the correct order (verts->sides->lines->sectors->things),
-	// even if they aren't defined in that order.
-	// Unknown definitions are also kept, just in case
-	UI::setSplashProgressMessage("Sorting definitions");
-	ParseTreeNode* root = parser.parseTreeRoot();
-	vector<ParseTreeNode*> defs_vertices;
-	vector<ParseTreeNode*> defs_lines;
-	vector<ParseTreeNode*> defs_sides;
-	vector<ParseTreeNode*> defs_sectors;
-	vector<ParseTreeNode*> defs_things;
-	vector<ParseTreeNode*> defs_other;
-	for (unsigned a = 0; a < root->nChildren(); a++)
-	{
-		UI::setSplashProgress((float)a / root->nChildren());
-
-		auto node = root->getChildPTN(a);
-
-		// Vertex definition
-		if (S_CMPNOCASE(node->getName(), "vertex"))
-			defs_vertices.push_back(node);
-
-		// Line definition
-		else if (S_CMPNOCASE(node->getName(), "linedef"))
-			defs_lines.push_back(node);
-
-		// Side definition
-		else if (S_CMPNOCASE(node->getName(), "sidedef"))
-			defs_sides.push_back(node);
-
-		// Sector definition
-		else if (S_CMPNOCASE(node->getName(), "sector"))
-			defs_sectors.push_back(node);
-
-		// Thing definition
-		else if (S_CMPNOCASE(node->getName(), "thing"))
-			defs_things.push_back(node);
-
-		// Namespace
-		else if (S_CMPNOCASE(node->getName(), "namespace"))
-			udmf_namespace_ = node->stringValue();
-
-		// Unknown
-		else
-			defs_other.push_back(node);
-	}
-
-	// Now create map structures from parsed data, in the right order
-
-	// Create vertices from parsed data
-	UI::setSplashProgressMessage("Reading Vertices");
-	for (unsigned a = 0; a < defs_vertices.size(); a++)
-	{
-		UI::setSplashProgress(((float)a / defs_vertices.size()) * 0.2f);
-		addVertex(defs_vertices[a]);
-	}
-
-	// Create sectors from parsed data
-	UI::setSplashProgressMessage("Reading Sectors");
-	for (unsigned a = 0; a < defs_sectors.size(); a++)
-	{
-		UI::setSplashProgress(0.2f + ((float)a / defs_sectors.size()) * 0.2f);
-		addSector(defs_sectors[a]);
-	}
+	// Map structures are created from the definition blocks by type, in
+	// the correct order (verts->sectors->sides->lines->things), even if
+	// they aren't defined in that order
+	struct { uint8_t type; const char* message; } passes[] =
+	{
+		{ MOBJ_VERTEX,	"Reading Vertices" },
+		{ MOBJ_SECTOR,	"Reading Sectors" },
+		{ MOBJ_SIDE,	"Reading Sides" },
+		{ MOBJ_LINE,	"Reading Lines" },
+		{ MOBJ_THING,	"Reading Things" },
+	};
+	UDMFReader::def_t def;
+	for (unsigned p = 0; p < 5; p++)
+	{
+		UI::setSplashProgressMessage(passes[p].message);
+		unsigned count = reader.countBlocks(passes[p].type);
+		unsigned index = 0;
+		for (auto& block : reader.blocks())
+		{
+			if (block.type != passes[p].type || block.value >= 0)
+				continue;
 
-	// Create sides from parsed data
-	UI::setSplashProgressMessage("Reading Sides");
-	for (unsigned a = 0; a < defs_sides.size(); a++)
-	{
-		UI::setSplashProgress(0.4f + ((float)a / defs_sides.size()) * 0.2f);
-		addSide(defs_sides[a]);
+			UI::setSplashProgress(0.2f * p + ((float)index++ / count) * 0.2f);
+			reader.getDefinition(block, def);
+			switch (block.type)
+			{
+			case MOBJ_VERTEX:	addVertex(def); break;
+			case MOBJ_SECTOR:	addSector(def); break;
+			case MOBJ_SIDE:		addSide(def); break;
+			case MOBJ_LINE:		addLine(def); break;
+			case MOBJ_THING:	addThing(def); break;
+			default: break;
+			}
+		}
 	}
 
-	// Create lines from parsed data
-	UI::setSplashProgressMessage("Reading Lines");
-	for (unsigned a = 0; a < defs_lines.size(); a++)
+	// Keep namespace and map-scope values
+	Property value;
+	for (auto& block : reader.blocks())
 	{
-		UI::setSplashProgress(0.6f + ((float)a / defs_lines.size()) * 0.2f);
-		addLine(defs_lines[a]);
-	}
+		if (block.type != MOBJ_UNKNOWN)
+			continue;
 
-	// Create things from parsed data
-	UI::setSplashProgressMessage("Reading Things");
-	for (unsigned a = 0; a < defs_things.size(); a++)
-	{
-		UI::setSplashProgress(0.8f + ((float)a / defs_things.size()) * 0.2f);
-		addThing(defs_things[a]);
-	}
+		// Namespace
+		auto& name = reader.name(block.name);
+		if (S_CMPNOCASE(name, "namespace"))
+			udmf_namespace_ = reader.getValue(block, value) ? value.getStringValue() : wxEmptyString;
 
-	// Keep map-scope values
-	for (auto node : defs_other)
-	{
-		if (node->nValues() > 0)
-			udmf_props_[node->getName()] = node->value();
+		// Map-scope value
+		else if (reader.getValue(block, value))
+			udmf_props_[name] = value;
 
 		// TODO: Unknown blocks
 	}
@@ -2346,169 +2293,188 @@ bool SLADEMap::writeDoom64Map(vector<ArchiveEntry*>& map_entries)
 	return true;
 }
 
-/* SLADEMap::writeUDMFMap
- * Writes map as UDMF format text to [textmap]
+/* SLADEMap::writeUDMFObjects
+ * Writes UDMF definitions of the map objects of [type] from index
+ * [start] to [end] (exclusive) to [out], as UTF-8 text. Called from
+ * worker threads, so must not modify the map
  *******************************************************************/
-bool SLADEMap::writeUDMFMap(ArchiveEntry* textmap)
+void SLADEMap::writeUDMFObjects(int type, unsigned start, unsigned end, std::string& out)
 {
-	// Check entry was given
-	if (!textmap)
-		return false;
-
-	// Open temp text file
-	wxFile tempfile(App::path("sladetemp.txt", App::Dir::Temp), wxFile::write);
-
-	// Write map namespace
-	tempfile.Write("// Written by SLADE3\n");
-	tempfile.Write(S_FMT("namespace=\"%s\";\n", udmf_namespace_));
-
-	// Write map-scope props
-	tempfile.Write(udmf_props_.toString(true));
-	tempfile.Write("\n");
-
-	//sf::Clock clock;
-
-	// Locale for float number format
-	setlocale(LC_NUMERIC, "C");
-
-	// Write things
 	string object_def;
-	for (unsigned a = 0; a < things_.size(); a++)
+	for (unsigned a = start; a < end; a++)
 	{
-		object_def = S_FMT("thing//#%u\n{\n", a);
+		if (type == MOBJ_THING)
+		{
+			object_def = S_FMT("thing//#%u\n{\n", a);
 
-		// Basic properties
-		object_def += S_FMT("x=%1.3f;\ny=%1.3f;\ntype=%d;\n", things_[a]->x, things_[a]->y, things_[a]->type);
-		if (things_[a]->angle != 0) object_def += S_FMT("angle=%d;\n", things_[a]->angle);
+			// Basic properties
+			object_def += S_FMT("x=%1.3f;\ny=%1.3f;\ntype=%d;\n", things_[a]->x, things_[a]->y, things_[a]->type);
+			if (things_[a]->angle != 0) object_def += S_FMT("angle=%d;\n", things_[a]->angle);
 
-		// Remove internal 'flags' property if it exists
-		things_[a]->props().removeProperty("flags");
-
-		// Other properties
-		if (!things_[a]->properties.isEmpty())
+			// Other properties
+			if (!things_[a]->properties.isEmpty())
+				object_def += things_[a]->properties.toString(true);
+		}
+		else if (type == MOBJ_LINE)
 		{
-			Game::configuration().cleanObjectUDMFProps(things_[a]);
-			object_def += things_[a]->properties.toString(true);
+			object_def = S_FMT("linedef//#%u\n{\n", a);
+
+			// Basic properties
+			object_def += S_FMT("v1=%d;\nv2=%d;\nsidefront=%d;\n", lines_[a]->v1Index(), lines_[a]->v2Index(), lines_[a]->s1Index());
+			if (lines_[a]->s2())
+				object_def += S_FMT("sideback=%d;\n", lines_[a]->s2Index());
+			if (lines_[a]->special != 0)
+				object_def += S_FMT("special=%d;\n", lines_[a]->special);
+			if (lines_[a]->line_id != 0)
+				object_def += S_FMT("id=%d;\n", lines_[a]->line_id);
+
+			// Other properties
+			if (!lines_[a]->properties.isEmpty())
+				object_def += lines_[a]->properties.toString(true);
 		}
-
-		object_def += "}\n\n";
-		tempfile.Write(object_def);
-	}
-	//LOG_MESSAGE(1, "Writing things took %dms", clock.getElapsedTime().asMilliseconds());
-
-	// Write lines
-	//clock.restart();
-	for (unsigned a = 0; a < lines_.size(); a++)
-	{
-		object_def = S_FMT("linedef//#%u\n{\n", a);
-
-		// Basic properties
-		object_def += S_FMT("v1=%d;\nv2=%d;\nsidefront=%d;\n", lines_[a]->v1Index(), lines_[a]->v2Index(), lines_[a]->s1Index());
-		if (lines_[a]->s2())
-			object_def += S_FMT("sideback=%d;\n", lines_[a]->s2Index());
-		if (lines_[a]->special != 0)
-			object_def += S_FMT("special=%d;\n", lines_[a]->special);
-		if (lines_[a]->line_id != 0)
-			object_def += S_FMT("id=%d;\n", lines_[a]->line_id);
-
-		// Remove internal 'flags' property if it exists
-		lines_[a]->props().removeProperty("flags");
-
-		// Other properties
-		if (!lines_[a]->properties.isEmpty())
+		else if (type == MOBJ_SIDE)
 		{
-			Game::configuration().cleanObjectUDMFProps(lines_[a]);
-			object_def += lines_[a]->properties.toString(true);
+			object_def = S_FMT("sidedef//#%u\n{\n", a);
+
+			// Basic properties
+			object_def += S_FMT("sector=%u;\n", sides_[a]->sector->getIndex());
+			if (sides_[a]->tex_upper != "-")
+				object_def += S_FMT("texturetop=\"%s\";\n", sides_[a]->tex_upper);
+			if (sides_[a]->tex_middle != "-")
+				object_def += S_FMT("texturemiddle=\"%s\";\n", sides_[a]->tex_middle);
+			if (sides_[a]->tex_lower != "-")
+				object_def += S_FMT("texturebottom=\"%s\";\n", sides_[a]->tex_lower);
+			if (sides_[a]->offset_x != 0)
+				object_def += S_FMT("offsetx=%d;\n", sides_[a]->offset_x);
+			if (sides_[a]->offset_y != 0)
+				object_def += S_FMT("offsety=%d;\n", sides_[a]->offset_y);
+
+			// Other properties
+			if (!sides_[a]->properties.isEmpty())
+				object_def += sides_[a]->properties.toString(true);
 		}
+		else if (type == MOBJ_VERTEX)
+		{
+			object_def = S_FMT("vertex//#%u\n{\n", a);
 
-		object_def += "}\n\n";
-		tempfile.Write(object_def);
-	}
-	//LOG_MESSAGE(1, "Writing lines took %dms", clock.getElapsedTime().asMilliseconds());
+			// Basic properties
+			object_def += S_FMT("x=%1.3f;\ny=%1.3f;\n", vertices_[a]->x, vertices_[a]->y);
 
-	// Write sides
-	//clock.restart();
-	for (unsigned a = 0; a < sides_.size(); a++)
-	{
-		object_def = S_FMT("sidedef//#%u\n{\n", a);
-
-		// Basic properties
-		object_def += S_FMT("sector=%u;\n", sides_[a]->sector->getIndex());
-		if (sides_[a]->tex_upper != "-")
-			object_def += S_FMT("texturetop=\"%s\";\n", sides_[a]->tex_upper);
-		if (sides_[a]->tex_middle != "-")
-			object_def += S_FMT("texturemiddle=\"%s\";\n", sides_[a]->tex_middle);
-		if (sides_[a]->tex_lower != "-")
-			object_def += S_FMT("texturebottom=\"%s\";\n", sides_[a]->tex_lower);
-		if (sides_[a]->offset_x != 0)
-			object_def += S_FMT("offsetx=%d;\n", sides_[a]->offset_x);
-		if (sides_[a]->offset_y != 0)
-			object_def += S_FMT("offsety=%d;\n", sides_[a]->offset_y);
-
-		// Other properties
-		if (!sides_[a]->properties.isEmpty())
+			// Other properties
+			if (!vertices_[a]->properties.isEmpty())
+				object_def += vertices_[a]->properties.toString(true);
+		}
+		else if (type == MOBJ_SECTOR)
 		{
-			Game::configuration().cleanObjectUDMFProps(sides_[a]);
-			object_def += sides_[a]->properties.toString(true);
+			object_def = S_FMT("sector//#%u\n{\n", a);
+
+			// Basic properties
+			object_def += S_FMT("texturefloor=\"%s\";\ntextureceiling=\"%s\";\n", sectors_[a]->f_tex, sectors_[a]->c_tex);
+			if (sectors_[a]->f_height != 0) object_def += S_FMT("heightfloor=%d;\n", sectors_[a]->f_height);
+			if (sectors_[a]->c_height != 0) object_def += S_FMT("heightceiling=%d;\n", sectors_[a]->c_height);
+			if (sectors_[a]->light != 160) object_def += S_FMT("lightlevel=%d;\n", sectors_[a]->light);
+			if (sectors_[a]->special != 0) object_def += S_FMT("special=%d;\n", sectors_[a]->special);
+			if (sectors_[a]->tag != 0) object_def += S_FMT("id=%d;\n", sectors_[a]->tag);
+
+			// Other properties
+			if (!sectors_[a]->properties.isEmpty())
+				object_def += sectors_[a]->properties.toString(true);
 		}
 
 		object_def += "}\n\n";
-		tempfile.Write(object_def);
-	}
-	//LOG_MESSAGE(1, "Writing sides took %dms", clock.getElapsedTime().asMilliseconds());
 
-	// Write vertices
-	//clock.restart();
-	for (unsigned a = 0; a < vertices_.size(); a++)
-	{
-		object_def = S_FMT("vertex//#%u\n{\n", a);
+		// Each definition is converted separately (as wxFile::Write did)
+		auto utf8 = object_def.ToUTF8();
+		out.append(utf8.data(), utf8.length());
+	}
+}
 
-		// Basic properties
-		object_def += S_FMT("x=%1.3f;\ny=%1.3f;\n", vertices_[a]->x, vertices_[a]->y);
+/* SLADEMap::writeUDMFMap
+ * Writes map as UDMF format text to [textmap]
+ *******************************************************************/
+bool SLADEMap::writeUDMFMap(ArchiveEntry* textmap)
+{
+	// Check entry was given
+	if (!textmap)
+		return false;
 
-		// Other properties
-		if (!vertices_[a]->properties.isEmpty())
-		{
-			Game::configuration().cleanObjectUDMFProps(vertices_[a]);
-			object_def += vertices_[a]->properties.toString(true);
-		}
+	// Locale for float number format
+	setlocale(LC_NUMERIC, "C");
 
-		object_def += "}\n\n";
-		tempfile.Write(object_def);
+	// Clean up object properties first, since the definitions are
+	// written from multiple threads below
+	for (auto thing : things_)
+	{
+		// Remove internal 'flags' property if it exists
+		thing->props().removeProperty("flags");
+		if (!thing->properties.isEmpty())
+			Game::configuration().cleanObjectUDMFProps(thing);
 	}
-	//LOG_MESSAGE(1, "Writing vertices took %dms", clock.getElapsedTime().asMilliseconds());
-
-	// Write sectors
-	//clock.restart();
-	for (unsigned a = 0; a < sectors_.size(); a++)
+	for (auto line : lines_)
 	{
-		object_def = S_FMT("sector//#%u\n{\n", a);
-
-		// Basic properties
-		object_def += S_FMT("texturefloor=\"%s\";\ntextureceiling=\"%s\";\n", sectors_[a]->f_tex, sectors_[a]->c_tex);
-		if (sectors_[a]->f_height != 0) object_def += S_FMT("heightfloor=%d;\n", sectors_[a]->f_height);
-		if (sectors_[a]->c_height != 0) object_def += S_FMT("heightceiling=%d;\n", sectors_[a]->c_height);
-		if (sectors_[a]->light != 160) object_def += S_FMT("lightlevel=%d;\n", sectors_[a]->light);
-		if (sectors_[a]->special != 0) object_def += S_FMT("special=%d;\n", sectors_[a]->special);
-		if (sectors_[a]->tag != 0) object_def += S_FMT("id=%d;\n", sectors_[a]->tag);
-
-		// Other properties
-		if (!sectors_[a]->properties.isEmpty())
+		// Remove internal 'flags' property if it exists
+		line->props().removeProperty("flags");
+		if (!line->properties.isEmpty())
+			Game::configuration().cleanObjectUDMFProps(line);
+	}
+	for (auto side : sides_)
+		if (!side->properties.isEmpty())
+			Game::configuration().cleanObjectUDMFProps(side);
+	for (auto vertex : vertices_)
+		if (!vertex->properties.isEmpty())
+			Game::configuration().cleanObjectUDMFProps(vertex);
+	for (auto sector : sectors_)
+		if (!sector->properties.isEmpty())
+			Game::configuration().cleanObjectUDMFProps(sector);
+
+	// Split objects into blocks to be written to separate buffers, in
+	// the order they are written (things, lines, sides, vertices, sectors)
+	struct block_t { int type; unsigned start; unsigned end; };
+	vector<block_t> blocks;
+	struct { int type; unsigned count; } types[] =
+	{
+		{ MOBJ_THING,	(unsigned)things_.size() },
+		{ MOBJ_LINE,	(unsigned)lines_.size() },
+		{ MOBJ_SIDE,	(unsigned)sides_.size() },
+		{ MOBJ_VERTEX,	(unsigned)vertices_.size() },
+		{ MOBJ_SECTOR,	(unsigned)sectors_.size() },
+	};
+	for (auto& t : types)
+		for (unsigned a = 0; a < t.count; a += 1024)
+			blocks.push_back({ t.type, a, MIN(a + 1024, t.count) });
+
+	// The first buffer is for the map namespace and map-scope props
+	if (udmf_write_buffers_.size() < blocks.size() + 1)
+		udmf_write_buffers_.resize(blocks.size() + 1);
+	for (auto& buffer : udmf_write_buffers_)
+		buffer.clear();
+	auto& header = udmf_write_buffers_[0];
+	for (auto text : { string("// Written by SLADE3\n"), S_FMT("namespace=\"%s\";\n", udmf_namespace_), udmf_props_.toString(true), string("\n") })
+	{
+		auto utf8 = text.ToUTF8();
+		header.append(utf8.data(), utf8.length());
+	}
+
+	// Write object definitions
+	{
+		ThreadPool pool;
+		for (unsigned a = 0; a < blocks.size(); a++)
 		{
-			Game::configuration().cleanObjectUDMFProps(sectors_[a]);
-			object_def += sectors_[a]->properties.toString(true);
+			auto& block = blocks[a];
+			auto& buffer = udmf_write_buffers_[a + 1];
+			pool.queue([this, &block, &buffer]() { writeUDMFObjects(block.type, block.start, block.end, buffer); });
 		}
-
-		object_def += "}\n\n";
-		tempfile.Write(object_def);
+		pool.wait();
 	}
-	//LOG_MESSAGE(1, "Writing sectors took %dms", clock.getElapsedTime().asMilliseconds());
-
-	// Close file
-	tempfile.Close();
 
-	// Load file to entry
-	textmap->importFile(App::path("sladetemp.txt", App::Dir::Temp));
+	// Write buffers to entry, in order
+	size_t size = 0;
+	for (auto& buffer : udmf_write_buffers_)
+		size += buffer.size();
+	MemChunk mc(size);
+	for (auto& buffer : udmf_write_buffers_)
+		mc.write(buffer.data(), buffer.size());
+	textmap->importMemChunk(mc);
 
 	return true;
 }
@@ -2519,6 +2485,7 @@ bool SLADEMap::writeUDMFMap(ArchiveEntry* textmap)
 void SLADEMap::clearMap()
 {
 	map_specials_.reset();
+	blockmap_.invalidate();
 
 	// Clear vectors
 	sides_.clear();
@@ -2832,22 +2799,29 @@ bool SLADEMap::removeThing(unsigned index)
  *******************************************************************/
 int SLADEMap::nearestVertex(fpoint2_t point, double min)
 {
+	// Get vertices near the point from the blockmap. A vertex further
+	// than [min]*1.5 on either axis is too far away even if it is the
+	// closest, so there's no need to check any others
+	vector<MapVertex*> list;
+	blockmap_.verticesNear(point, min * 1.5, list);
+
 	// Go through vertices
 	double min_dist = 999999999;
 	MapVertex* v = nullptr;
 	double dist = 0;
 	int index = -1;
-	for (unsigned a = 0; a < vertices_.size(); a++)
+	for (unsigned a = 0; a < list.size(); a++)
 	{
-		v = vertices_[a];
+		v = list[a];
 
 		// Get 'quick' distance (no need to get real distance)
 		dist = point.taxicab_distance_to(v->point());
 
 		// Check if it's nearer than the previous nearest
-		if (dist < min_dist)
+		// (lowest index first if the same distance)
+		if (dist < min_dist || (dist == min_dist && (int)v->index < index))
 		{
-			index = a;
+			index = v->index;
 			min_dist = dist;
 		}
 	}
@@ -2871,14 +2845,18 @@ int SLADEMap::nearestVertex(fpoint2_t point, double min)
  *******************************************************************/
 int SLADEMap::nearestLine(fpoint2_t point, double mindist)
 {
+	// Get lines near the point from the blockmap (sorted by index)
+	vector<MapLine*> list;
+	blockmap_.linesNear(point, mindist + 1, list);
+
 	// Go through lines
 	double min_dist = mindist;
 	double dist = 0;
 	int index = -1;
 	MapLine* l;
-	for (unsigned a = 0; a < lines_.size(); a++)
+	for (unsigned a = 0; a < list.size(); a++)
 	{
-		l = lines_[a];
+		l = list[a];
 
 		// Check with line bounding box first (since we have a minimum distance)
 		fseg2_t bbox = l->seg();
@@ -2892,7 +2870,7 @@ int SLADEMap::nearestLine(fpoint2_t point, double mindist)
 		// Check if it's nearer than the previous nearest
 		if (dist < min_dist && dist < mindist)
 		{
-			index = a;
+			index = l->index;
 			min_dist = dist;
 		}
 	}
@@ -2906,22 +2884,27 @@ int SLADEMap::nearestLine(fpoint2_t point, double mindist)
  *******************************************************************/
 int SLADEMap::nearestThing(fpoint2_t point, double min)
 {
+	// Get things near the point from the blockmap (see nearestVertex)
+	vector<MapThing*> list;
+	blockmap_.thingsNear(point, min * 1.5, list);
+
 	// Go through things
 	double min_dist = 999999999;
 	MapThing* t = nullptr;
 	double dist = 0;
 	int index = -1;
-	for (unsigned a = 0; a < things_.size(); a++)
+	for (unsigned a = 0; a < list.size(); a++)
 	{
-		t = things_[a];
+		t = list[a];
 
 		// Get 'quick' distance (no need to get real distance)
 		dist = point.taxicab_distance_to(t->point());
 
 		// Check if it's nearer than the previous nearest
-		if (dist < min_dist)
+		// (lowest index first if the same distance)
+		if (dist < min_dist || (dist == min_dist && (int)t->index < index))
 		{
-			index = a;
+			index = t->index;
 			min_dist = dist;
 		}
 	}
@@ -2945,29 +2928,46 @@ int SLADEMap::nearestThing(fpoint2_t point, double min)
  *******************************************************************/
 vector<int> SLADEMap::nearestThingMulti(fpoint2_t point)
 {
-	// Go through things
 	vector<int> ret;
-	double min_dist = 999999999;
-	MapThing* t = nullptr;
-	double dist = 0;
-	for (unsigned a = 0; a < things_.size(); a++)
-	{
-		t = things_[a];
+	vector<MapThing*> list;
+	double radius = 64;
+	while (true)
+	{
+		// Get things near the point from the blockmap
+		bool all = blockmap_.thingsNear(point, radius + 1, list);
+
+		// Go through things
+		ret.clear();
+		double min_dist = 999999999;
+		MapThing* t = nullptr;
+		double dist = 0;
+		for (unsigned a = 0; a < list.size(); a++)
+		{
+			t = list[a];
 
-		// Get 'quick' distance (no need to get real distance)
-		dist = point.taxicab_distance_to(t->point());
+			// Get 'quick' distance (no need to get real distance)
+			dist = point.taxicab_distance_to(t->point());
 
-		// Check if it's nearer than the previous nearest
-		if (dist < min_dist)
-		{
-			ret.clear();
-			ret.push_back(a);
-			min_dist = dist;
+			// Check if it's nearer than the previous nearest
+			if (dist < min_dist)
+			{
+				ret.clear();
+				ret.push_back(t->index);
+				min_dist = dist;
+			}
+			else if (dist == min_dist)
+				ret.push_back(t->index);
 		}
-		else if (dist == min_dist)
-			ret.push_back(a);
+
+		// Done if all things at least as close as the nearest were
+		// checked, otherwise search further out
+		if (all || (!ret.empty() && min_dist <= radius))
+			break;
+		radius *= 4;
 	}
 
+	std::sort(ret.begin(), ret.end());
+
 	return ret;
 }
 
@@ -2977,12 +2977,17 @@ vector<int> SLADEMap::nearestThingMulti(fpoint2_t point)
  *******************************************************************/
 int SLADEMap::sectorAt(fpoint2_t point)
 {
+	// Get sectors that could contain the point from the blockmap
+	// (sorted by index)
+	vector<MapSector*> list;
+	blockmap_.sectorsAt(point, list);
+
 	// Go through sectors
-	for (unsigned a = 0; a < sectors_.size(); a++)
+	for (unsigned a = 0; a < list.size(); a++)
 	{
 		// Check if point is within sector
-		if (sectors_[a]->isWithin(point))
-			return a;
+		if (list[a]->isWithin(point))
+			return list[a]->index;
 	}
 
 	// Not within a sector
@@ -3025,15 +3030,19 @@ bbox_t SLADEMap::getMapBBox()
  *******************************************************************/
 MapVertex* SLADEMap::vertexAt(double x, double y)
 {
-	// Go through all vertices
-	for (unsigned a = 0; a < vertices_.size(); a++)
+	// Get vertices in the blockmap block at [x,y]
+	vector<MapVertex*> list;
+	blockmap_.verticesNear(fpoint2_t(x, y), 0, list);
+
+	// Go through them (lowest index first if there are multiple)
+	MapVertex* vertex = nullptr;
+	for (unsigned a = 0; a < list.size(); a++)
 	{
-		if (vertices_[a]->x == x && vertices_[a]->y == y)
-			return vertices_[a];
+		if (list[a]->x == x && list[a]->y == y && (!vertex || list[a]->index < vertex->index))
+			vertex = list[a];
 	}
 
-	// No vertex at [x,y]
-	return nullptr;
+	return vertex;
 }
 
 // Sorting functions for SLADEMap::cutLines
@@ -4095,11 +4104,9 @@ MapVertex* SLADEMap::createVertex(double x, double y, double split_dist)
 	fpoint2_t point(x, y);
 
 	// First check that it won't overlap any other vertex
-	for (unsigned a = 0; a < vertices_.size(); a++)
-	{
-		if (vertices_[a]->x == x && vertices_[a]->y == y)
-			return vertices_[a];
-	}
+	MapVertex* existing = vertexAt(x, y);
+	if (existing)
+		return existing;
 
 	// Create the vertex
 	MapVertex* nv = new MapVertex(x, y, this);
@@ -5401,6 +5408,8 @@ void SLADEMap::rebuildConnectedLines()
 		lines_[a]->vertex1->connected_lines.push_back(lines_[a]);
 		lines_[a]->vertex2->connected_lines.push_back(lines_[a]);
 	}
+
+	blockmap_.invalidate();
 }
 
 /* SLADEMap::rebuildConnectedSides
@@ -5418,6 +5427,8 @@ void SLADEMap::rebuildConnectedSides()
 		if (sides_[a]->sector)
 			sides_[a]->sector->connected_sides.push_back(sides_[a]);
 	}
+
+	blockmap_.invalidate();
 }
 
 /* SLADEMap::updateTexUsage
@@ -7,6 +7,8 @@
 #include "MapSector.h"
 #include "MapVertex.h"
 #include "MapThing.h"
+#include "MapBlockmap.h"
+#include "UDMFReader.h"
 #include "Archive/Archive.h"
 #include "Utility/PropertyList/PropertyList.h"
 #include "MapEditor/MapSpecials.h"
@@ -38,7 +40,6 @@ struct mobj_cd_t
 	}
 };
 
-class ParseTreeNode;
 namespace Game { enum class TagType; }
 
 class SLADEMap
@@ -94,6 +95,9 @@ public:
 	void		getObjectIdList(uint8_t type, vector<unsigned>& list);
 	void		restoreObjectIdList(uint8_t type, vector<unsigned>& list);
 
+	// Blockmap (spatial index for hit-testing)
+	void	updateBlockmap(MapObject* object) { blockmap_.objectModified(object); }
+
 	void	refreshIndices();
 	bool	readMap(Archive::MapDesc map);
 	void	clearMap();
@@ -235,6 +239,7 @@ private:
 	bool				specials_expired_;
 
 	vector<ArchiveEntry*>	udmf_extra_entries_;	// UDMF Extras
+	vector<std::string>		udmf_write_buffers_;	// Kept between saves to avoid reallocation
 
 	// For undo/redo
 	vector<mobj_holder_t>	all_objects_;
@@ -245,6 +250,9 @@ private:
 	long	geometry_updated_;	// The last time the map geometry was updated
 	long	things_updated_;	// The last time the thing list was modified
 
+	// Spatial index for nearestVertex, sectorAt etc.
+	MapBlockmap	blockmap_;
+
 	// Usage counts
 	std::map<string, int>	usage_tex_;
 	std::map<string, int>	usage_flat_;
@@ -299,11 +307,12 @@ private:
 	bool	writeDoom64Things(ArchiveEntry* entry);
 
 	// UDMF
-	bool	addVertex(ParseTreeNode* def);
-	bool	addSide(ParseTreeNode* def);
-	bool	addLine(ParseTreeNode* def);
-	bool	addSector(ParseTreeNode* def);
-	bool	addThing(ParseTreeNode* def);
+	bool	addVertex(const UDMFReader::def_t& def);
+	bool	addSide(const UDMFReader::def_t& def);
+	bool	addLine(const UDMFReader::def_t& def);
+	bool	addSector(const UDMFReader::def_t& def);
+	bool	addThing(const UDMFReader::def_t& def);
+	void	writeUDMFObjects(int type, unsigned start, unsigned end, std::string& out);
 };
 
 #endif //__SLADEMAP_H__
@@ -0,0 +1,818 @@
+/*******************************************************************
+ * SLADE - It's a Doom Editor
+ * Copyright (C) 2008-2014 Simon Judd
+ *
+ * Email:       sirjuddington@gmail.com
+ * Web:         http://slade.mancubus.net
+ * Filename:    UDMFReader.cpp
+ * Description: UDMFReader class, a single-pass reader for UDMF
+ *              TEXTMAP data that SLADEMap creates map objects from
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *******************************************************************/
+
+
+/*******************************************************************
+ * INCLUDES
+ *******************************************************************/
+#include "Main.h"
+#include "UDMFReader.h"
+#include "MapObject.h"
+#include "MobjPropertyList.h"
+#include "Utility/Parser.h"
+
+
+/*******************************************************************
+ * VARIABLES
+ *******************************************************************/
+namespace
+{
+	// Results of UDMFReader::readToken
+	enum
+	{
+		TOKEN_ERROR = -1,
+		TOKEN_END,
+		TOKEN_TEXT,
+		TOKEN_SPECIAL,
+	};
+}
+
+
+/*******************************************************************
+ * FUNCTIONS
+ *******************************************************************/
+namespace
+{
+	/* The character classes below match the defaults of Tokenizer
+	 * (as used by Parser), so that tokens are split the same way
+	 *******************************************************************/
+	inline bool isWhitespace(char c)
+	{
+		return c == '\n' || c == '\r' || c == ' ' || c == '\t';
+	}
+
+	inline bool isSpecial(char c)
+	{
+		switch (c)
+		{
+		case ';': case ',': case ':': case '|': case '=': case '{': case '}': case '/':
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	inline bool isDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	inline bool isHexDigit(char c)
+	{
+		return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+	}
+
+	// Returns true if [c] can be used as-is in a (wx)string built from
+	// plain ASCII (anything else is appended char-by-char as Tokenizer does)
+	inline bool isPlainAscii(char c)
+	{
+		return c > 0 && c < 127;
+	}
+
+	/* isInteger
+	 * Returns true if [str] is an integer, as StringUtils::isInteger
+	 * would (^[+-]?[0-9]+$)
+	 *******************************************************************/
+	bool isInteger(const std::string& str)
+	{
+		size_t p = 0;
+		if (p < str.size() && (str[p] == '+' || str[p] == '-'))
+			p++;
+		if (p == str.size())
+			return false;
+		for (; p < str.size(); p++)
+			if (!isDigit(str[p]))
+				return false;
+		return true;
+	}
+
+	/* isHex
+	 * Returns true if [str] is a hex number, as StringUtils::isHex
+	 * would (^0x[0-9A-Fa-f]+$)
+	 *******************************************************************/
+	bool isHex(const std::string& str)
+	{
+		if (str.size() < 3 || str[0] != '0' || str[1] != 'x')
+			return false;
+		for (size_t p = 2; p < str.size(); p++)
+			if (!isHexDigit(str[p]))
+				return false;
+		return true;
+	}
+
+	/* isFloat
+	 * Returns true if [str] is a floating point number, as
+	 * StringUtils::isFloat would. Note that its regex
+	 * (^[-+]?[0-9]*.?[0-9]+([eE][-+]?[0-9]+)?$) has an unescaped '.',
+	 * so any character is allowed in place of the decimal point
+	 *******************************************************************/
+	bool isFloat(const std::string& str)
+	{
+		size_t start = 0;
+		if (!str.empty() && (str[0] == '-' || str[0] == '+'))
+			start = 1;
+
+		// Count leading digits
+		size_t digits = start;
+		while (digits < str.size() && isDigit(str[digits]))
+			digits++;
+
+		// Try each possible end of the [0-9]*.? part, the rest must be
+		// [0-9]+([eE][-+]?[0-9]+)?
+		for (size_t split = start; split <= digits + 1 && split < str.size(); split++)
+		{
+			size_t p = split;
+			if (!isDigit(str[p]))
+				continue;
+			while (p < str.size() && isDigit(str[p]))
+				p++;
+			if (p == str.size())
+				return true;
+
+			// Exponent
+			if (str[p] != 'e' && str[p] != 'E')
+				continue;
+			p++;
+			if (p < str.size() && (str[p] == '-' || str[p] == '+'))
+				p++;
+			if (p == str.size() || !isDigit(str[p]))
+				continue;
+			while (p < str.size() && isDigit(str[p]))
+				p++;
+			if (p == str.size())
+				return true;
+		}
+
+		return false;
+	}
+
+	/* typeFromName
+	 * Returns the map object type for top-level blocks named [name]
+	 *******************************************************************/
+	uint8_t typeFromName(const string& name)
+	{
+		if (S_CMPNOCASE(name, "vertex"))
+			return MOBJ_VERTEX;
+		else if (S_CMPNOCASE(name, "linedef"))
+			return MOBJ_LINE;
+		else if (S_CMPNOCASE(name, "sidedef"))
+			return MOBJ_SIDE;
+		else if (S_CMPNOCASE(name, "sector"))
+			return MOBJ_SECTOR;
+		else if (S_CMPNOCASE(name, "thing"))
+			return MOBJ_THING;
+		else
+			return MOBJ_UNKNOWN;
+	}
+}
+
+
+/*******************************************************************
+ * UDMFREADER CLASS FUNCTIONS
+ *******************************************************************/
+
+/* UDMFReader::UDMFReader
+ * UDMFReader class constructor
+ *******************************************************************/
+UDMFReader::UDMFReader() : data_(nullptr), size_(0), name_prev_(0xFFFFFFFF)
+{
+}
+
+/* UDMFReader::~UDMFReader
+ * UDMFReader class destructor
+ *******************************************************************/
+UDMFReader::~UDMFReader()
+{
+}
+
+/* UDMFReader::parse
+ * Reads UDMF TEXTMAP data from [mc], which must not be modified
+ * while the reader is in use. Returns false if the data couldn't be
+ * parsed
+ *******************************************************************/
+bool UDMFReader::parse(MemChunk& mc)
+{
+	clear();
+	data_ = (const char*)mc.getData();
+	size_ = mc.getSize();
+
+	if (parseData())
+		return true;
+
+	// Use the generic parser for anything the reader doesn't handle
+	LOG_MESSAGE(2, "TEXTMAP uses non-standard syntax, reading with generic parser");
+	clear();
+	return parseTree(mc);
+}
+
+/* UDMFReader::countBlocks
+ * Returns the number of top-level blocks of [type]
+ *******************************************************************/
+unsigned UDMFReader::countBlocks(uint8_t type) const
+{
+	unsigned count = 0;
+	for (auto& block : blocks_)
+		if (block.type == type && block.value < 0)
+			count++;
+
+	return count;
+}
+
+/* UDMFReader::getDefinition
+ * Writes the properties of [block] to [def], in the order they were
+ * defined
+ *******************************************************************/
+void UDMFReader::getDefinition(const block_t& block, def_t& def)
+{
+	def.resize(block.count);
+	for (unsigned a = 0; a < block.count; a++)
+	{
+		auto& field = fields_[block.first + a];
+		def[a].name = &names_[field.name];
+		def[a].key = name_keys_[field.name];
+		def[a].value = fieldValue(field);
+		def[a].empty = (field.type == FIELD_EMPTY);
+	}
+}
+
+/* UDMFReader::getValue
+ * Writes the value assigned to top-level [block] to [value].
+ * Returns false if [block] is a block rather than an assignment
+ *******************************************************************/
+bool UDMFReader::getValue(const block_t& block, Property& value)
+{
+	if (block.value < 0)
+		return false;
+
+	value = fieldValue(fields_[block.value]);
+	return true;
+}
+
+/* UDMFReader::findProp
+ * Returns the first property in [def] named [name] (case-insensitive),
+ * or nullptr if there is none
+ *******************************************************************/
+const UDMFReader::prop_t* UDMFReader::findProp(const def_t& def, const char* name)
+{
+	for (auto& prop : def)
+		if (S_CMPNOCASE(*prop.name, name))
+			return &prop;
+
+	return nullptr;
+}
+
+/* UDMFReader::clear
+ * Clears all parsed data
+ *******************************************************************/
+void UDMFReader::clear()
+{
+	blocks_.clear();
+	fields_.clear();
+	names_.clear();
+	keys_.clear();
+	name_types_.clear();
+	name_keys_.clear();
+	name_next_.clear();
+	name_prev_ = 0xFFFFFFFF;
+	strings_.clear();
+	name_ids_.clear();
+}
+
+/* UDMFReader::parseData
+ * Reads the TEXTMAP data directly. Returns false if it is invalid or
+ * uses syntax other than 'name = value;' and 'name { ... }' blocks of
+ * assignments, which is left to the generic parser
+ *******************************************************************/
+bool UDMFReader::parseData()
+{
+	fields_.reserve(size_ / 20);
+	blocks_.reserve(size_ / 100);
+
+	size_t pos = 0;
+	size_t start, end;
+	bool quoted;
+	uint32_t name;
+	while (true)
+	{
+		// Name
+		int token = readToken(pos, start, end, quoted);
+		if (token == TOKEN_END)
+			return true;
+		if (token != TOKEN_TEXT || !readName(start, end, quoted, name))
+			return false;
+
+		block_t block;
+		block.type = name_types_[name];
+		block.name = name;
+		block.first = fields_.size();
+		block.count = 0;
+		block.value = -1;
+
+		// Assignment or block
+		if (readToken(pos, start, end, quoted) != TOKEN_SPECIAL)
+			return false;
+
+		// Assignment
+		if (data_[start] == '=')
+		{
+			if (readToken(pos, start, end, quoted) != TOKEN_TEXT || !readValue(start, end, quoted, name))
+				return false;
+			if (readToken(pos, start, end, quoted) != TOKEN_SPECIAL || data_[start] != ';')
+				return false;
+
+			block.value = block.first;
+			blocks_.push_back(block);
+			continue;
+		}
+
+		// Block
+		if (data_[start] != '{')
+			return false;
+		while (true)
+		{
+			// Field name or end of block
+			token = readToken(pos, start, end, quoted);
+			if (token == TOKEN_SPECIAL && data_[start] == '}')
+				break;
+			if (token != TOKEN_TEXT || !readName(start, end, quoted, name))
+				return false;
+
+			// = value ;
+			if (readToken(pos, start, end, quoted) != TOKEN_SPECIAL || data_[start] != '=')
+				return false;
+			if (readToken(pos, start, end, quoted) != TOKEN_TEXT || !readValue(start, end, quoted, name))
+				return false;
+			if (readToken(pos, start, end, quoted) != TOKEN_SPECIAL || data_[start] != ';')
+				return false;
+
+			block.count++;
+		}
+
+		blocks_.push_back(block);
+	}
+}
+
+/* UDMFReader::parseTree
+ * Parses [mc] with the generic parser and adds the blocks from the
+ * resulting tree. Returns false if parsing failed
+ *******************************************************************/
+bool UDMFReader::parseTree(MemChunk& mc)
+{
+	Parser parser;
+	if (!parser.parseText(mc))
+		return false;
+
+	auto root = parser.parseTreeRoot();
+	for (unsigned a = 0; a < root->nChildren(); a++)
+	{
+		auto node = root->getChildPTN(a);
+
+		block_t block;
+		block.name = internName(std::string(node->getName().ToUTF8()));
+		block.type = name_types_[block.name];
+		block.first = fields_.size();
+		block.count = 0;
+		block.value = -1;
+
+		// Assigned value
+		if (node->nValues() > 0)
+		{
+			block.value = fields_.size();
+			addParsedValue(block.name, node);
+			block.first = fields_.size();
+		}
+
+		// Fields
+		for (unsigned c = 0; c < node->nChildren(); c++)
+		{
+			auto child = node->getChildPTN(c);
+			addParsedValue(internName(std::string(child->getName().ToUTF8())), child);
+			block.count++;
+		}
+
+		blocks_.push_back(block);
+	}
+
+	return true;
+}
+
+/* UDMFReader::readToken
+ * Reads the next token from the data at [pos], splitting tokens and
+ * skipping comments the same way Tokenizer does. The token text is
+ * from [start] to [end] (excluding quotes, if [quoted]). Returns
+ * TOKEN_END at the end of the data, TOKEN_ERROR for an unterminated
+ * quoted string
+ *******************************************************************/
+int UDMFReader::readToken(size_t& pos, size_t& start, size_t& end, bool& quoted)
+{
+	while (pos < size_)
+	{
+		char c = data_[pos];
+
+		// Whitespace
+		if (isWhitespace(c))
+		{
+			pos++;
+			continue;
+		}
+
+		// C-style comment
+		if (c == '/' && pos + 1 < size_ && data_[pos + 1] == '*')
+		{
+			pos += 2;
+			while (pos + 1 < size_ && !(data_[pos] == '*' && data_[pos + 1] == '/'))
+				pos++;
+			pos = MIN(pos + 2, size_);
+			continue;
+		}
+
+		// Line comment (// or ##)
+		if ((c == '/' || c == '#') && pos + 1 < size_ && data_[pos + 1] == c)
+		{
+			auto eol = (const char*)memchr(data_ + pos + 2, '\n', size_ - pos - 2);
+			pos = eol ? eol - data_ + 1 : size_;
+			continue;
+		}
+
+		// Special character
+		quoted = false;
+		if (isSpecial(c))
+		{
+			start = pos++;
+			end = pos;
+			return TOKEN_SPECIAL;
+		}
+
+		// Quoted string
+		if (c == '\"')
+		{
+			start = ++pos;
+			while (pos < size_ && data_[pos] != '\"')
+			{
+				if (data_[pos] == '\\')
+					pos++;
+				pos++;
+			}
+			if (pos >= size_)
+				return TOKEN_ERROR;
+
+			end = pos++;
+			quoted = true;
+
+			// Tokenizer compares single-character tokens to special
+			// characters regardless of quotes
+			if (end - start == 1 && isSpecial(data_[start]))
+				return TOKEN_ERROR;
+
+			return TOKEN_TEXT;
+		}
+
+		// Token, ends at whitespace, special character or comment
+		start = pos;
+		while (pos < size_)
+		{
+			c = data_[pos];
+			if (isWhitespace(c) || isSpecial(c) || (c == '#' && pos + 1 < size_ && data_[pos + 1] == '#'))
+				break;
+			pos++;
+		}
+		end = pos;
+		return TOKEN_TEXT;
+	}
+
+	return TOKEN_END;
+}
+
+/* UDMFReader::readName
+ * Reads the name token from [start] to [end] and writes its interned
+ * index to [name]. Returns false if it isn't a name that the generic
+ * parser would read as a plain name
+ *******************************************************************/
+bool UDMFReader::readName(size_t start, size_t end, bool quoted, uint32_t& name)
+{
+	// Fields are usually in the same order in each block, so check for
+	// the name that followed the previous one last time first
+	if (!quoted && name_prev_ < name_next_.size() && matchesName(start, end, name_next_[name_prev_]))
+	{
+		name = name_prev_ = name_next_[name_prev_];
+		return true;
+	}
+
+	if (quoted)
+		unescape(start, end);
+	else
+		buffer_.assign(data_ + start, end - start);
+
+	// Names can't be empty, start with a special character or be a
+	// preprocessor directive
+	if (buffer_.empty() || isSpecial(buffer_[0]) || buffer_[0] == '#')
+		return false;
+
+	// Lowercase unquoted names (any non-ASCII characters are left to
+	// the generic parser)
+	for (auto& c : buffer_)
+	{
+		if (!isPlainAscii(c))
+			return false;
+		if (!quoted && c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+	}
+
+	name = internName(buffer_);
+	if (name_prev_ < name_next_.size())
+		name_next_[name_prev_] = name;
+	name_prev_ = name;
+
+	return true;
+}
+
+/* UDMFReader::readValue
+ * Reads the value token from [start] to [end] and adds it as a field
+ * named [name]. The value type is detected the same way as in
+ * ParseTreeNode::parseAssignment. Returns false if the value isn't
+ * supported
+ *******************************************************************/
+bool UDMFReader::readValue(size_t start, size_t end, bool quoted, uint32_t name)
+{
+	field_t field;
+	field.name = name;
+	field.length = end - start;
+	field.value.Offset = start;
+
+	// Quoted string
+	if (quoted)
+	{
+		field.type = FIELD_STRING;
+		fields_.push_back(field);
+		return true;
+	}
+
+	// Plain numbers can be read directly
+	if (readNumber(start, end, field))
+	{
+		fields_.push_back(field);
+		return true;
+	}
+
+	// Lowercase
+	buffer_.assign(data_ + start, end - start);
+	for (auto& c : buffer_)
+	{
+		if (!isPlainAscii(c))
+			return false;
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+	}
+
+	// Detect type
+	if (buffer_ == "true")
+	{
+		field.type = FIELD_BOOL;
+		field.value.Boolean = true;
+	}
+	else if (buffer_ == "false")
+	{
+		field.type = FIELD_BOOL;
+		field.value.Boolean = false;
+	}
+	else if (isInteger(buffer_))
+	{
+		field.type = FIELD_INT;
+		field.value.Integer = (int)strtol(buffer_.c_str(), nullptr, 10);
+	}
+	else if (isHex(buffer_))
+	{
+		field.type = FIELD_INT;
+		field.value.Integer = (int)strtol(buffer_.c_str(), nullptr, 0);
+	}
+	else if (isFloat(buffer_))
+	{
+		field.type = FIELD_FLOAT;
+		field.value.Floating = strtod(buffer_.c_str(), nullptr);
+	}
+	else
+		field.type = FIELD_IDENTIFIER;
+
+	fields_.push_back(field);
+	return true;
+}
+
+/* UDMFReader::readNumber
+ * Reads a plain integer or decimal number ([+-]123 or [+-]123.456)
+ * from [start] to [end] into [field], giving the same value as the
+ * generic parser would. Returns false for anything else (including
+ * numbers too long to convert exactly here)
+ *******************************************************************/
+bool UDMFReader::readNumber(size_t start, size_t end, field_t& field) const
+{
+	static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15 };
+
+	const char* c = data_ + start;
+	const char* e = data_ + end;
+	bool negative = false;
+	if (c < e && (*c == '-' || *c == '+'))
+		negative = (*c++ == '-');
+
+	// Integer part
+	int64_t mantissa = 0;
+	int digits = 0;
+	for (; c < e && isDigit(*c) && digits < 18; c++, digits++)
+		mantissa = mantissa * 10 + (*c - '0');
+	if (digits == 0)
+		return false;
+
+	// Integer (clamped to the range of long as strtol does)
+	if (c == e)
+	{
+		int64_t value = negative ? -mantissa : mantissa;
+		field.type = FIELD_INT;
+		field.value.Integer = (int)MAX(MIN(value, (int64_t)LONG_MAX), (int64_t)LONG_MIN);
+		return true;
+	}
+
+	// Fraction
+	if (*c++ != '.')
+		return false;
+	int decimals = 0;
+	for (; c < e && isDigit(*c) && digits < 15; c++, digits++, decimals++)
+		mantissa = mantissa * 10 + (*c - '0');
+	if (c != e || decimals == 0 || digits > 15)
+		return false;
+
+	// Both the mantissa and power of 10 are exact as doubles, so the
+	// result is correctly rounded (same as strtod)
+	double value = (double)mantissa / pow10[decimals];
+	field.type = FIELD_FLOAT;
+	field.value.Floating = negative ? -value : value;
+	return true;
+}
+
+/* UDMFReader::matchesName
+ * Returns true if the unquoted token from [start] to [end] is the
+ * (lowercase) name at [name] in the names list
+ *******************************************************************/
+bool UDMFReader::matchesName(size_t start, size_t end, uint32_t name) const
+{
+	if (name >= keys_.size() || keys_[name].size() != end - start)
+		return false;
+
+	auto& key = keys_[name];
+	for (size_t a = 0; a < key.size(); a++)
+	{
+		char c = data_[start + a];
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		if (c != key[a])
+			return false;
+	}
+
+	return true;
+}
+
+/* UDMFReader::addParsedValue
+ * Adds the (first) value of parsed [node] as a field named [name]
+ *******************************************************************/
+void UDMFReader::addParsedValue(uint32_t name, ParseTreeNode* node)
+{
+	field_t field;
+	field.name = name;
+	field.length = 0;
+
+	if (node->nValues() == 0)
+	{
+		field.type = FIELD_EMPTY;
+		field.value.Boolean = false;
+		fields_.push_back(field);
+		return;
+	}
+
+	auto value = node->value();
+	switch (value.getType())
+	{
+	case PROP_BOOL:
+		field.type = FIELD_BOOL;
+		field.value.Boolean = value.getBoolValue();
+		break;
+	case PROP_INT:
+		field.type = FIELD_INT;
+		field.value.Integer = value.getIntValue();
+		break;
+	case PROP_FLOAT:
+		field.type = FIELD_FLOAT;
+		field.value.Floating = value.getFloatValue();
+		break;
+	default:
+		field.type = FIELD_PARSED;
+		field.value.Offset = strings_.size();
+		strings_.push_back(value.getStringValue());
+		break;
+	}
+
+	fields_.push_back(field);
+}
+
+/* UDMFReader::internName
+ * Returns the index of [name] (UTF-8) in the names list, adding it if
+ * it isn't there yet
+ *******************************************************************/
+uint32_t UDMFReader::internName(const std::string& name)
+{
+	auto i = name_ids_.find(name);
+	if (i != name_ids_.end())
+		return i->second;
+
+	uint32_t index = names_.size();
+	names_.push_back(wxString::FromUTF8(name.data(), name.size()));
+	keys_.push_back(name);
+	name_types_.push_back(typeFromName(names_.back()));
+	name_keys_.push_back(MobjPropertyList::keyId(names_.back()));
+	name_next_.push_back(0xFFFFFFFF);
+	name_ids_[name] = index;
+
+	return index;
+}
+
+/* UDMFReader::unescape
+ * Writes the quoted string from [start] to [end] to the buffer,
+ * removing escape backslashes
+ *******************************************************************/
+void UDMFReader::unescape(size_t start, size_t end)
+{
+	buffer_.clear();
+	for (size_t a = start; a < end; a++)
+	{
+		if (data_[a] == '\\')
+			a++;
+
+		buffer_ += data_[a];
+	}
+}
+
+/* UDMFReader::fieldString
+ * Returns the string value of [field], as the generic parser would
+ * have read it
+ *******************************************************************/
+string UDMFReader::fieldString(const field_t& field)
+{
+	if (field.type == FIELD_PARSED)
+		return strings_[field.value.Offset];
+
+	if (field.type == FIELD_STRING)
+		unescape(field.value.Offset, field.value.Offset + field.length);
+	else
+	{
+		buffer_.assign(data_ + field.value.Offset, field.length);
+		for (auto& c : buffer_)
+			if (c >= 'A' && c <= 'Z')
+				c += 'a' - 'A';
+	}
+
+	// Non-ASCII characters are added one at a time, like Tokenizer
+	for (auto c : buffer_)
+		if (!isPlainAscii(c))
+		{
+			string str;
+			for (auto ch : buffer_)
+				str += ch;
+			return str;
+		}
+
+	return wxString::FromAscii(buffer_.data(), buffer_.size());
+}
+
+/* UDMFReader::fieldValue
+ * Returns the value of [field] as a Property
+ *******************************************************************/
+Property UDMFReader::fieldValue(const field_t& field)
+{
+	switch (field.type)
+	{
+	case FIELD_BOOL:	return Property(field.value.Boolean);
+	case FIELD_INT:		return Property(field.value.Integer);
+	case FIELD_FLOAT:	return Property(field.value.Floating);
+	case FIELD_EMPTY:	return Property(false);
+	default:			return Property(fieldString(field));
+	}
+}
@@ -0,0 +1,105 @@
+#ifndef __UDMFREADER_H__
+#define __UDMFREADER_H__
+
+#include "Utility/PropertyList/Property.h"
+#include <unordered_map>
+
+class ParseTreeNode;
+
+// Reads UDMF TEXTMAP data in a single pass into a compact list of definition
+// blocks, without building a generic ParseTreeNode tree. Field names are
+// interned and values are kept as typed fields (strings are read from the
+// TEXTMAP data as needed), so SLADEMap can create map objects directly from
+// the definitions. Anything other than plain 'name = value;' assignments and
+// 'name { ... }' blocks of them is handed to the generic Parser instead, so
+// the result is always the same as parsing with Parser
+class UDMFReader
+{
+public:
+	// A property of a definition block
+	struct prop_t
+	{
+		const string*	name;
+		unsigned		key;	// Property key id (see MobjPropertyList::keyId)
+		Property		value;
+		bool			empty;	// True if no value was given (only possible via the generic parser)
+
+		string	stringValue() const { return empty ? wxEmptyString : value.getStringValue(); }
+		int		intValue() const { return value.getIntValue(); }
+		double	floatValue() const { return value.getFloatValue(); }
+	};
+	typedef vector<prop_t> def_t;
+
+	// A top-level block ('name { ... }') or assignment ('name = value;')
+	struct block_t
+	{
+		uint8_t		type;	// MOBJ_* type from the block name, MOBJ_UNKNOWN for anything else
+		uint32_t	name;	// Interned name index
+		uint32_t	first;	// Index of the first field
+		uint32_t	count;	// Number of fields
+		int32_t		value;	// Index of the assigned value field, -1 if this is a block
+	};
+
+	UDMFReader();
+	~UDMFReader();
+
+	bool					parse(MemChunk& mc);
+	const vector<block_t>&	blocks() const { return blocks_; }
+	const string&			name(uint32_t index) const { return names_[index]; }
+	unsigned				countBlocks(uint8_t type) const;
+	void					getDefinition(const block_t& block, def_t& def);
+	bool					getValue(const block_t& block, Property& value);
+
+	static const prop_t*	findProp(const def_t& def, const char* name);
+
+private:
+	enum
+	{
+		FIELD_BOOL,
+		FIELD_INT,
+		FIELD_FLOAT,
+		FIELD_STRING,		// Quoted string in the data (may contain escapes)
+		FIELD_IDENTIFIER,	// Unquoted string in the data (read as lowercase)
+		FIELD_PARSED,		// String value from the generic parser (in strings_)
+		FIELD_EMPTY,		// No value (generic parser only)
+	};
+
+	struct field_t
+	{
+		uint32_t	name : 28;
+		uint32_t	type : 4;
+		uint32_t	length;
+		union { bool Boolean; int Integer; double Floating; uint32_t Offset; } value;
+	};
+
+	const char*			data_;
+	size_t				size_;
+	vector<block_t>		blocks_;
+	vector<field_t>		fields_;
+	vector<string>		names_;
+	vector<std::string>	keys_;			// Names as read (UTF-8), for lookup
+	vector<uint8_t>		name_types_;
+	vector<unsigned>	name_keys_;
+	vector<uint32_t>	name_next_;		// The name that last followed each name
+	uint32_t			name_prev_;
+	vector<string>		strings_;
+	std::string			buffer_;
+
+	std::unordered_map<std::string, uint32_t>	name_ids_;
+
+	void		clear();
+	bool		parseData();
+	bool		parseTree(MemChunk& mc);
+	int			readToken(size_t& pos, size_t& start, size_t& end, bool& quoted);
+	bool		readName(size_t start, size_t end, bool quoted, uint32_t& name);
+	bool		readValue(size_t start, size_t end, bool quoted, uint32_t name);
+	bool		readNumber(size_t start, size_t end, field_t& field) const;
+	bool		matchesName(size_t start, size_t end, uint32_t name) const;
+	void		addParsedValue(uint32_t name, ParseTreeNode* node);
+	uint32_t	internName(const std::string& name);
+	void		unescape(size_t start, size_t end);
+	string		fieldString(const field_t& field);
+	Property	fieldValue(const field_t& field);
+};
+
+#endif//__UDMFREADER_H__
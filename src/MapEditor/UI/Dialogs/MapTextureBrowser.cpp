@@ -94,6 +94,51 @@ bool MapTexBrowserItem::loadImage()
 		return false;
 }
 
+/* MapTexBrowserItem::imageLoader
+ * Returns a function that loads the texture/flat image, or nothing
+ * if it is already loaded
+ *******************************************************************/
+BrowserItem::ImageLoader MapTexBrowserItem::imageLoader()
+{
+	bool flat = (type_ == "flat");
+	if (type_ != "texture" && !flat)
+		return nullptr;
+
+	// Already loaded, no need to load in the background
+	if (MapEditor::textureManager().isLoaded(name_, flat))
+		return nullptr;
+
+	// Detect the types of the entries to load from here, since it can't be
+	// done on the worker thread
+	MapEditor::textureManager().detectImageTypes(name_, flat, false);
+
+	// Scale is passed back to setImage separately
+	auto scale = std::make_shared<fpoint2_t>();
+	load_scale = scale;
+
+	string name = name_;
+	return [name, flat, scale](SImage& image)
+	{
+		if (flat)
+			return MapEditor::textureManager().loadFlatImage(name, false, image, *scale);
+		else
+			return MapEditor::textureManager().loadTextureImage(name, image, *scale);
+	};
+}
+
+/* MapTexBrowserItem::setImage
+ * Sets the texture/flat image to [image], as loaded by the function
+ * from imageLoader
+ *******************************************************************/
+bool MapTexBrowserItem::setImage(SImage& image)
+{
+	if (!load_scale)
+		return false;
+
+	image_ = MapEditor::textureManager().setImage(name_, type_ == "flat", image, *load_scale);
+	return true;
+}
+
 /* MapTexBrowserItem::itemInfo
  * Returns a string with extra information about the texture/flat
  *******************************************************************/
@@ -10,13 +10,16 @@ class Archive;
 class MapTexBrowserItem : public BrowserItem
 {
 private:
-	int	usage_count;
+	int							usage_count;
+	std::shared_ptr<fpoint2_t>	load_scale;
 
 public:
 	MapTexBrowserItem(string name, int type, unsigned index = 0);
 	~MapTexBrowserItem();
 
-	bool	loadImage();
+	bool		loadImage();
+	ImageLoader	imageLoader();
+	bool		setImage(SImage& image);
 	string	itemInfo();
 	int		usageCount() { return usage_count; }
 	void	setUsage(int count) { usage_count = count; }
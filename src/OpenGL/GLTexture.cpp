@@ -38,6 +38,7 @@
  *******************************************************************/
 GLTexture GLTexture::tex_background;
 GLTexture GLTexture::tex_missing;
+uint64_t GLTexture::use_counter = 0;
 CVAR(String, bgtx_colour1, "#404050", CVAR_SAVE)
 CVAR(String, bgtx_colour2, "#505060", CVAR_SAVE)
 
@@ -57,6 +58,8 @@ GLTexture::GLTexture(bool allow_split)
 	this->tiling = true;
 	this->scale_x = 1.0;
 	this->scale_y = 1.0;
+	this->evicted = false;
+	this->last_used = 0;
 }
 
 /* GLTexture::~GLTexture
@@ -153,6 +156,7 @@ bool GLTexture::loadData(const uint8_t* data, uint32_t width, uint32_t height, b
 
 	// Update variables
 	loaded = true;
+	evicted = false;
 	this->width = width;
 	this->height = height;
 	this->scale_x = 1.0;
@@ -375,11 +379,74 @@ bool GLTexture::clear()
 	width = 0;
 	height = 0;
 	loaded = false;
+	evicted = false;
 	scale_x = scale_y = 1.0;
 
 	return true;
 }
 
+/* GLTexture::unloadData
+ * Frees the opengl texture data but keeps everything else (size,
+ * scale, etc.), so the texture still appears loaded. The data is
+ * loaded again via the texture's reloader function the next time
+ * it is used. Returns false if the texture isn't loaded or has no
+ * reloader function
+ *******************************************************************/
+bool GLTexture::unloadData()
+{
+	if (!loaded || evicted || !reloader)
+		return false;
+
+	for (size_t a = 0; a < tex.size(); a++)
+		glDeleteTextures(1, &tex[a].id);
+	tex.clear();
+	evicted = true;
+
+	return true;
+}
+
+/* GLTexture::makeResident
+ * Marks the texture as used, reloading its data if it was unloaded
+ * with unloadData. Returns false if the texture isn't loaded (or
+ * couldn't be reloaded), true otherwise
+ *******************************************************************/
+bool GLTexture::makeResident()
+{
+	last_used = ++use_counter;
+
+	if (evicted)
+	{
+		// Reload data (this resets the scale, so keep it)
+		double sx = scale_x;
+		double sy = scale_y;
+		evicted = false;
+		if (reloader(this))
+		{
+			scale_x = sx;
+			scale_y = sy;
+		}
+	}
+
+	return loaded && !tex.empty();
+}
+
+/* GLTexture::memUsage
+ * Returns the (approximate) amount of video memory used by the
+ * texture, in bytes
+ *******************************************************************/
+size_t GLTexture::memUsage()
+{
+	size_t size = 0;
+	for (size_t a = 0; a < tex.size(); a++)
+		size += tex[a].width * tex[a].height * 4;
+
+	// Mipmaps add roughly a third
+	if (filter == MIPMAP || filter == LINEAR_MIPMAP || filter == NEAREST_MIPMAP)
+		size += size / 3;
+
+	return size;
+}
+
 /* GLTexture::genChequeredTexture
  * Generates a chequered pattern, with each square being [size] and
  * alternating between [col1] and [col2]
@@ -452,7 +519,7 @@ bool GLTexture::genChequeredTexture(uint8_t block_size, rgba_t col1, rgba_t col2
 bool GLTexture::bind()
 {
 	// Check texture is loaded
-	if (!loaded || tex.empty())
+	if (!makeResident())
 		return false;
 
 	// Bind the texture
@@ -468,7 +535,7 @@ bool GLTexture::bind()
 bool GLTexture::draw2d(double x, double y, bool flipx, bool flipy)
 {
 	// Can't draw if texture not loaded
-	if (!loaded || tex.empty())
+	if (!makeResident())
 		return false;
 
 	// Flipping?
@@ -559,7 +626,7 @@ bool GLTexture::draw2d(double x, double y, bool flipx, bool flipy)
 bool GLTexture::draw2dTiled(uint32_t width, uint32_t height)
 {
 	// Can't draw if texture not loaded
-	if (!loaded || tex.empty())
+	if (!makeResident())
 		return false;
 
 	// If the texture isn't split, just draw it straight
@@ -611,7 +678,7 @@ bool GLTexture::draw2dTiled(uint32_t width, uint32_t height)
 rgba_t GLTexture::averageColour(rect_t area)
 {
 	// Check texture is loaded
-	if (!loaded || tex.empty())
+	if (!makeResident())
 		return COL_BLACK;
 
 	// Empty area rect means full texture
@@ -25,6 +25,13 @@ private:
 	double				scale_x;
 	double				scale_y;
 
+	// Residency (see unloadData)
+	typedef std::function<bool(GLTexture*)> Reloader;
+	bool				evicted;
+	uint64_t			last_used;
+	Reloader			reloader;
+	static uint64_t		use_counter;
+
 	// Some generic/global textures
 	static GLTexture	tex_background;	// Checkerboard background texture
 	static GLTexture	tex_missing;	// Checkerboard 'missing' texture
@@ -32,6 +39,7 @@ private:
 	// Stuff used internally
 	bool	loadData(const uint8_t* data, uint32_t width, uint32_t height, bool add = false);
 	bool	loadImagePortion(SImage* image, rect_t rect, Palette* pal = nullptr, bool add = false);
+	bool	makeResident();
 
 public:
 	enum
@@ -56,15 +64,20 @@ public:
 	double		getScaleY() { return scale_y; }
 	bool		isTiling() { return tiling; }
 	unsigned	glId() { if (!tex.empty()) return tex[0].id; else return 0; }
+	bool		isResident() { return loaded && !evicted; }
+	uint64_t	lastUsed() { return last_used; }
+	size_t		memUsage();
 
 	void		setFilter(int filter) { this->filter = filter; }
 	void		setTiling(bool tiling) { this->tiling = tiling; }
 	void		setScale(double sx, double sy) { this->scale_x = sx; this->scale_y = sy; }
+	void		setReloader(Reloader reloader) { this->reloader = reloader; }
 
 	bool	loadImage(SImage* image, Palette* pal = nullptr);
 	bool	loadRawData(const uint8_t* data, uint32_t width, uint32_t height);
 
 	bool	clear();
+	bool	unloadData();
 	bool	genChequeredTexture(uint8_t block_size, rgba_t col1, rgba_t col2);
 
 	bool	bind();
@@ -76,6 +89,7 @@ public:
 	static GLTexture&	bgTex();
 	static GLTexture&	missingTex();
 	static void			resetBgTex();
+	static uint64_t		useCounter() { return use_counter; }
 };
 
 #endif//__GLTEXTURE_H__
@@ -44,6 +44,23 @@ ArchiveEntry* archiveCreateEntryInNamespace(Archive& self, const string& name, c
 	return self.addNewEntry(name, ns);
 }
 
+int archiveRenderMapImages(
+	Archive& self,
+	const string& path,
+	int width,
+	int height,
+	bool things,
+	bool sectors)
+{
+	MapImage::Options options;
+	options.loadConfig();
+	options.width = width;
+	options.height = height;
+	options.things = things;
+	options.sectors = sectors;
+	return MapImage::renderArchive(&self, options, path);
+}
+
 vector<ArchiveEntry*> archiveDirEntries(ArchiveTreeNode& self)
 {
 	vector<ArchiveEntry*> list;
@@ -101,6 +118,10 @@ void registerArchive(sol::state& lua)
 		"createEntryInNamespace",	&archiveCreateEntryInNamespace,
 		"removeEntry",				&Archive::removeEntry,
 		"renameEntry",				&Archive::renameEntry,
+		"renderMapImages", sol::overload(
+			[](Archive& self, const string& path) { return archiveRenderMapImages(self, path, -5, -5, false, false); },
+			&archiveRenderMapImages
+		),
 		"save", sol::overload(
 			[](Archive& self) { return self.save(); },
 			[](Archive& self, const string& filename) { return self.save(filename); }
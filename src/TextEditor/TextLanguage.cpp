@@ -142,7 +142,7 @@ void TLFunction::addContext(
 	{
 		while (!tz.check(","))
 		{
-			arg_tokens.push_back(tz.current().text);
+			arg_tokens.push_back(tz.current().text());
 			if (tz.atEnd())
 				break;
 			tz.adv();
@@ -35,6 +35,10 @@
 #include "BrowserCanvas.h"
 #include "OpenGL/Drawing.h"
 #include "General/UI.h"
+#include "Graphics/SImage/SImage.h"
+#include "Utility/ThreadPool.h"
+#include <atomic>
+#include <unordered_set>
 
 
 // ----------------------------------------------------------------------------
@@ -44,9 +48,30 @@
 // ----------------------------------------------------------------------------
 CVAR(Int, browser_bg_type, false, CVAR_SAVE)
 CVAR(Int, browser_item_size, 96, CVAR_SAVE)
+CVAR(Int, browser_prefetch_rows, 4, CVAR_SAVE)
 DEFINE_EVENT_TYPE(wxEVT_BROWSERCANVAS_SELECTION_CHANGED)
 
 
+// ----------------------------------------------------------------------------
+//
+// BrowserCanvas::LoadJob Struct
+//
+// ----------------------------------------------------------------------------
+
+// An item image being loaded in the background. The item itself is only
+// accessed on the main thread, and only if its load token is still alive
+struct BrowserCanvas::LoadJob
+{
+	BrowserItem*				item;
+	std::weak_ptr<bool>			token;
+	BrowserItem::ImageLoader	loader;
+	SImage						image;
+	bool						ok = false;
+	std::atomic<bool>			started{ false };
+	std::atomic<bool>			cancelled{ false };
+};
+
+
 // ----------------------------------------------------------------------------
 //
 // BrowserCanvas Class Functions
@@ -78,6 +103,17 @@ BrowserCanvas::BrowserCanvas(wxWindow* parent) :
 	Bind(wxEVT_KEY_DOWN, &BrowserCanvas::onKeyDown, this);
 }
 
+// ----------------------------------------------------------------------------
+// BrowserCanvas::~BrowserCanvas
+//
+// BrowserCanvas class destructor
+// ----------------------------------------------------------------------------
+BrowserCanvas::~BrowserCanvas()
+{
+	// Stop any background loading before the canvas goes away
+	enableImageLoading(false);
+}
+
 // ----------------------------------------------------------------------------
 // BrowserCanvas::getViewedIndex
 //
@@ -221,11 +257,16 @@ void BrowserCanvas::draw()
 	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
 	glLineWidth(2.0f);
 
+	// Apply any images loaded in the background since the last draw
+	applyLoadedImages();
+
 	// Draw items
+	vector<LoadJobPtr> wanted;
 	int x = item_border_;
 	int y = item_border_;
 	int col_width = GetSize().x / num_cols_;
 	int col = 0;
+	int last_index = -1;
 	top_index_ = -1;
 	for (unsigned a = 0; a < items_filter_.size(); a++)
 	{
@@ -289,6 +330,10 @@ void BrowserCanvas::draw()
 			glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
 		}
 
+		// Request the item image (visible items get loaded first)
+		requestImage(items_[items_filter_[a]], wanted);
+		last_index = a;
+
 		// Draw item
 		if (item_size_ <= 0)
 			items_[items_filter_[a]]->draw(browser_item_size, x, y - yoff_, font_, show_names_, item_type_, col_text, text_shadow);
@@ -308,6 +353,19 @@ void BrowserCanvas::draw()
 		}
 	}
 
+	// Prefetch images for rows just outside the view, below then above
+	if (top_index_ >= 0 && browser_prefetch_rows > 0)
+	{
+		int count = browser_prefetch_rows * num_cols_;
+		for (int a = last_index + 1; a <= last_index + count && a < (int)items_filter_.size(); a++)
+			requestImage(items_[items_filter_[a]], wanted);
+		for (int a = top_index_ - 1; a >= top_index_ - count && a >= 0; a--)
+			requestImage(items_[items_filter_[a]], wanted);
+	}
+
+	// Queue background loading of requested images
+	queueImageLoads(wanted);
+
 	// Swap Buffers
 	SwapBuffers();
 }
@@ -621,6 +679,157 @@ int BrowserCanvas::longestItemTextWidth()
 // ----------------------------------------------------------------------------
 
 
+// ----------------------------------------------------------------------------
+// BrowserCanvas::enableImageLoading
+//
+// Enables or disables loading item images on background threads. When
+// disabled, images are loaded as items are drawn, and any pending background
+// loads are discarded
+// ----------------------------------------------------------------------------
+void BrowserCanvas::enableImageLoading(bool enable)
+{
+	if (enable)
+	{
+		if (!load_pool_)
+			load_pool_ = std::make_unique<ThreadPool>();
+		return;
+	}
+
+	// Stop workers (waits for any currently running loads to finish)
+	load_pool_.reset();
+
+	// Discard any outstanding jobs
+	for (auto& i : load_jobs_)
+		if (!i.second->token.expired())
+			i.first->loading_ = false;
+	load_jobs_.clear();
+	loaded_.clear();
+}
+
+// ----------------------------------------------------------------------------
+// BrowserCanvas::requestImage
+//
+// Adds a background load job for [item]'s image to [wanted], if it needs one
+// ----------------------------------------------------------------------------
+void BrowserCanvas::requestImage(BrowserItem* item, vector<LoadJobPtr>& wanted)
+{
+	if (!load_pool_ || item->blank_ || item->load_failed_)
+		return;
+
+	// Check for an existing job
+	auto i = load_jobs_.find(item);
+	if (i != load_jobs_.end())
+	{
+		if (!i->second->token.expired())
+		{
+			if (!i->second->started)
+				wanted.push_back(i->second);
+			return;
+		}
+
+		// Job was for a deleted item at the same address
+		i->second->cancelled = true;
+		load_jobs_.erase(i);
+	}
+
+	// Check the image isn't already loaded
+	if (item->image_ && item->image_->isLoaded())
+		return;
+
+	// Get image loader (if none, the image is loaded when the item is drawn)
+	auto loader = item->imageLoader();
+	if (!loader)
+		return;
+
+	// Add job
+	auto job = std::make_shared<LoadJob>();
+	job->item = item;
+	job->token = item->load_token_;
+	job->loader = loader;
+	load_jobs_[item] = job;
+	item->loading_ = true;
+	wanted.push_back(job);
+}
+
+// ----------------------------------------------------------------------------
+// BrowserCanvas::queueImageLoads
+//
+// Queues the [wanted] load jobs in order of priority, cancelling any other
+// jobs that haven't started yet (eg. for items scrolled out of view)
+// ----------------------------------------------------------------------------
+void BrowserCanvas::queueImageLoads(vector<LoadJobPtr>& wanted)
+{
+	if (!load_pool_)
+		return;
+
+	// Cancel jobs no longer wanted
+	load_pool_->cancelPending();
+	std::unordered_set<LoadJob*> wanted_set;
+	for (auto& job : wanted)
+		wanted_set.insert(job.get());
+	for (auto i = load_jobs_.begin(); i != load_jobs_.end();)
+	{
+		auto& job = i->second;
+		if (!job->started && wanted_set.count(job.get()) == 0)
+		{
+			job->cancelled = true;
+			if (!job->token.expired())
+				job->item->loading_ = false;
+			i = load_jobs_.erase(i);
+		}
+		else
+			++i;
+	}
+
+	// Queue wanted jobs
+	for (auto& job : wanted)
+	{
+		load_pool_->queue([this, job]()
+		{
+			if (job->cancelled || job->started.exchange(true))
+				return;
+
+			job->ok = job->loader(job->image);
+
+			std::lock_guard<std::mutex> lock(loaded_mutex_);
+			loaded_.push_back(job);
+			CallAfter(&BrowserCanvas::onImageLoaded);
+		});
+	}
+}
+
+// ----------------------------------------------------------------------------
+// BrowserCanvas::applyLoadedImages
+//
+// Passes any images finished loading in the background to their items (this
+// must be done on the main thread as it may involve uploading to OpenGL)
+// ----------------------------------------------------------------------------
+void BrowserCanvas::applyLoadedImages()
+{
+	vector<LoadJobPtr> loaded;
+	{
+		std::lock_guard<std::mutex> lock(loaded_mutex_);
+		loaded.swap(loaded_);
+	}
+
+	for (auto& job : loaded)
+	{
+		// Ignore if the job was cancelled or replaced
+		auto i = load_jobs_.find(job->item);
+		if (i == load_jobs_.end() || i->second != job)
+			continue;
+		load_jobs_.erase(i);
+
+		// Ignore if the item was deleted
+		if (job->token.expired())
+			continue;
+
+		job->item->loading_ = false;
+		if (!job->ok || !job->item->setImage(job->image))
+			job->item->load_failed_ = true;
+	}
+}
+
 // ----------------------------------------------------------------------------
 // BrowserCanvas::onSize
 //
@@ -2,14 +2,16 @@
 
 #include "UI/Canvas/OGLCanvas.h"
 #include "BrowserItem.h"
+#include <mutex>
 
 class wxScrollBar;
+class ThreadPool;
 
 class BrowserCanvas : public OGLCanvas
 {
 public:
 	BrowserCanvas(wxWindow* parent);
-	~BrowserCanvas() {}
+	~BrowserCanvas();
 
 	enum
 	{
@@ -44,6 +46,7 @@ public:
 	void					setItemSize(int size) { this->item_size_ = size; }
 	void					setItemViewType(int type) { this->item_type_ = type; }
 	int						longestItemTextWidth();
+	void					enableImageLoading(bool enable);
 
 	// Events
 	void	onSize(wxSizeEvent& e);
@@ -73,6 +76,19 @@ private:
 	int top_y_			= 0;
 	int	item_type_		= 0;
 	int	num_cols_		= 0;
+
+	// Background image loading
+	struct LoadJob;
+	typedef std::shared_ptr<LoadJob> LoadJobPtr;
+	std::unique_ptr<ThreadPool>			load_pool_;
+	std::map<BrowserItem*, LoadJobPtr>	load_jobs_;
+	vector<LoadJobPtr>					loaded_;
+	std::mutex							loaded_mutex_;
+
+	void	requestImage(BrowserItem* item, vector<LoadJobPtr>& wanted);
+	void	queueImageLoads(vector<LoadJobPtr>& wanted);
+	void	applyLoadedImages();
+	void	onImageLoaded() { Refresh(); }
 };
 
 DECLARE_EVENT_TYPE(wxEVT_BROWSERCANVAS_SELECTION_CHANGED, -1)
@@ -127,6 +127,26 @@ void BrowserItem::draw(int size, int x, int y, int font, int nametype, int viewt
 	if (blank_)
 		return;
 
+	// If the image is being loaded in the background, draw a placeholder box
+	if (loading_)
+	{
+		glPushAttrib(GL_ENABLE_BIT|GL_CURRENT_BIT);
+
+		glColor4f(0.5f, 0.5f, 0.5f, 0.5f);
+		glDisable(GL_TEXTURE_2D);
+
+		glBegin(GL_LINE_LOOP);
+		glVertex2i(x, y);
+		glVertex2i(x, y+size);
+		glVertex2i(x+size, y+size);
+		glVertex2i(x+size, y);
+		glEnd();
+
+		glPopAttrib();
+
+		return;
+	}
+
 	// Try to load image if it isn't already
 	if (!image_ || (image_ && !image_->isLoaded()))
 		loadImage();
@@ -217,4 +237,9 @@ void BrowserItem::draw(int size, int x, int y, int font, int nametype, int viewt
 void BrowserItem::clearImage()
 {
 	if (image_) image_->clear();
+
+	// Discard any image currently being loaded in the background
+	load_token_ = std::make_shared<bool>(true);
+	loading_ = false;
+	load_failed_ = false;
 }
@@ -7,14 +7,20 @@ class TextBox;
 class BrowserItem
 {
 	friend class BrowserWindow;
+	friend class BrowserCanvas;
 public:
 	BrowserItem(string name, unsigned index = 0, string type = "item");
 	virtual ~BrowserItem();
 
+	// Loads an item image into an SImage, can be run on a worker thread
+	typedef std::function<bool(SImage&)> ImageLoader;
+
 	string		name() const { return name_; }
 	unsigned	index() const { return index_; }
 
-	virtual bool	loadImage();
+	virtual bool		loadImage();
+	virtual ImageLoader	imageLoader() { return nullptr; }
+	virtual bool		setImage(SImage& image) { return false; }
 	void			draw(
 						int size,
 						int x,
@@ -36,4 +42,9 @@ protected:
 	BrowserWindow*	parent_		= nullptr;
 	bool			blank_		= false;
 	TextBox*		text_box_	= nullptr;
+
+	// Background loading (see BrowserCanvas)
+	bool					loading_		= false;
+	bool					load_failed_	= false;
+	std::shared_ptr<bool>	load_token_		= std::make_shared<bool>(true);
 };
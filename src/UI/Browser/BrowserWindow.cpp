@@ -272,6 +272,22 @@ BrowserWindow::~BrowserWindow()
 		Misc::setWindowInfo("browser", GetClientSize().x, GetClientSize().y, GetPosition().x, GetPosition().y);
 }
 
+// ----------------------------------------------------------------------------
+// BrowserWindow::ShowModal
+//
+// Shows the browser modally. Item images are only loaded in the background
+// while the browser is shown this way, since nothing else (that might modify
+// the resources being loaded) can happen at the same time
+// ----------------------------------------------------------------------------
+int BrowserWindow::ShowModal()
+{
+	canvas_->enableImageLoading(true);
+	int result = wxDialog::ShowModal();
+	canvas_->enableImageLoading(false);
+
+	return result;
+}
+
 // ----------------------------------------------------------------------------
 // BrowserWindow::addItem
 //
@@ -19,7 +19,7 @@ public:
 
 	string			getName() override { return name_; }
 	wxTreeListItem	treeId() { return tree_id_; }
-	void			setName(string name) override { this->name_ = name; }
+	void			setName(string name) override { string old = name_; name_ = name; renamed(old); }
 	void			setTreeId(wxTreeListItem id) { this->tree_id_ = id; }
 
 	void			clearItems();
@@ -47,6 +47,7 @@ public:
 	~BrowserWindow();
 
 	bool	truncateNames() { return truncate_names_; }
+	int		ShowModal() override;
 
 	Palette*	getPalette() { return &palette_; }
 	void		setPalette(Palette* pal) { palette_.copyPalette(pal); }
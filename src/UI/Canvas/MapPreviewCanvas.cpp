@@ -35,6 +35,7 @@
 #include "General/ColourConfiguration.h"
 #include "Graphics/SImage/SIFormat.h"
 #include "Graphics/SImage/SImage.h"
+#include "MapEditor/MapImage.h"
 #include "MapEditor/SLADEMap/MapLine.h"
 #include "MapEditor/SLADEMap/MapThing.h"
 #include "MapEditor/SLADEMap/MapVertex.h"
@@ -45,7 +46,6 @@
 /*******************************************************************
  * VARIABLES
  *******************************************************************/
-CVAR(Float, map_image_thickness, 1.5, CVAR_SAVE)
 CVAR(Bool, map_view_things, true, CVAR_SAVE)
 
 
@@ -774,185 +774,34 @@ void MapPreviewCanvas::draw()
 
 
 /* MapPreviewCanvas::createImage
- * Draws the map in an image
- * TODO: Factorize code with normal draw() and showMap() functions.
- * TODO: Find a way to generate an arbitrary-sized image through
- * tiled rendering.
+ * Draws the map in an image (see MapImage::render)
  *******************************************************************/
 void MapPreviewCanvas::createImage(ArchiveEntry& ae, int width, int height)
 {
-	// Find extents of map
-	mep_vertex_t m_min(999999.0, 999999.0);
-	mep_vertex_t m_max(-999999.0, -999999.0);
+	// Get map data
+	MapImage::MapData data;
 	for (unsigned a = 0; a < verts.size(); a++)
-	{
-		if (verts[a].x < m_min.x)
-			m_min.x = verts[a].x;
-		if (verts[a].x > m_max.x)
-			m_max.x = verts[a].x;
-		if (verts[a].y < m_min.y)
-			m_min.y = verts[a].y;
-		if (verts[a].y > m_max.y)
-			m_max.y = verts[a].y;
-	}
-	double mapwidth = m_max.x - m_min.x;
-	double mapheight = m_max.y - m_min.y;
-
-	if (width == 0) width = -5;
-	if (height == 0) height = -5;
-	if (width < 0)
-		width = mapwidth / abs(width);
-	if (height < 0)
-		height = mapheight / abs(height);
-
-	// Setup colours
-	rgba_t col_save_background = ColourConfiguration::getColour("map_image_background");
-	rgba_t col_save_line_1s = ColourConfiguration::getColour("map_image_line_1s");
-	rgba_t col_save_line_2s = ColourConfiguration::getColour("map_image_line_2s");
-	rgba_t col_save_line_special = ColourConfiguration::getColour("map_image_line_special");
-	rgba_t col_save_line_macro = ColourConfiguration::getColour("map_image_line_macro");
-
-	// Setup OpenGL rigmarole
-	GLuint texID, fboID;
-	if (GLEW_ARB_framebuffer_object)
-	{
-		glGenTextures(1, &texID);
-		glBindTexture(GL_TEXTURE_2D, texID);
-		// We don't use mipmaps, but OpenGL will refuse to attach
-		// the texture to the framebuffer if they are not present
-		glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-		glBindTexture(GL_TEXTURE_2D, 0);
-		glGenFramebuffersEXT(1, &fboID);
-		glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, fboID);
-		glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, texID, 0);
-		GLenum status = glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT);
-	}
-
-	glViewport(0, 0, width, height);
-
-	// Setup the screen projection
-	glMatrixMode(GL_PROJECTION);
-	glLoadIdentity();
-	glOrtho(0, width, 0, height, -1, 1);
-
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
-
-	// Clear
-	glClearColor(((double)col_save_background.r)/255.f, ((double)col_save_background.g)/255.f,
-	             ((double)col_save_background.b)/255.f, ((double)col_save_background.a)/255.f);
-	glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
-
-	// Translate to inside of pixel (otherwise inaccuracies can occur on certain gl implementations)
-	if (OpenGL::accuracyTweak())
-		glTranslatef(0.375f, 0.375f, 0);
-
-	// Zoom/offset to show full map
-	// Offset to center of map
-	offset_x = m_min.x + (mapwidth * 0.5);
-	offset_y = m_min.y + (mapheight * 0.5);
-
-	// Zoom to fit whole map
-	double x_scale = ((double)width) / mapwidth;
-	double y_scale = ((double)height) / mapheight;
-	zoom = MIN(x_scale, y_scale);
-	zoom *= 0.95;
-
-	// Translate to middle of canvas
-	glTranslated(width>>1, height>>1, 0);
-
-	// Zoom
-	glScaled(zoom, zoom, 1);
-
-	// Translate to offset
-	glTranslated(-offset_x, -offset_y, 0);
-
-	// Setup drawing
-	glDisable(GL_TEXTURE_2D);
-	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
-	glLineWidth(map_image_thickness);
-	glEnable(GL_LINE_SMOOTH);
-
-	// Draw 2s lines
-	for (unsigned a = 0; a < lines.size(); a++)
-	{
-		mep_line_t line = lines[a];
-
-		if (!line.twosided)
-			continue;
-
-		// Check ends
-		if (line.v1 >= verts.size() || line.v2 >= verts.size())
-			continue;
-
-		// Get vertices
-		mep_vertex_t v1 = verts[lines[a].v1];
-		mep_vertex_t v2 = verts[lines[a].v2];
-
-		// Set colour
-		if (line.special)
-			OpenGL::setColour(col_save_line_special);
-		else if (line.macro)
-			OpenGL::setColour(col_save_line_macro);
-		else if (line.twosided)
-			OpenGL::setColour(col_save_line_2s);
-		else
-			OpenGL::setColour(col_save_line_1s);
-
-		// Draw line
-		glBegin(GL_LINES);
-		glVertex2d(v1.x, v1.y);
-		glVertex2d(v2.x, v2.y);
-		glEnd();
-	}
-
-	// Draw 1s lines
+		data.vertices.push_back({ verts[a].x, verts[a].y });
 	for (unsigned a = 0; a < lines.size(); a++)
 	{
-		mep_line_t line = lines[a];
-
-		if (line.twosided)
-			continue;
-
-		// Check ends
-		if (line.v1 >= verts.size() || line.v2 >= verts.size())
-			continue;
-
-		// Get vertices
-		mep_vertex_t v1 = verts[lines[a].v1];
-		mep_vertex_t v2 = verts[lines[a].v2];
-
-		// Set colour
-		if (line.special)
-			OpenGL::setColour(col_save_line_special);
-		else if (line.macro)
-			OpenGL::setColour(col_save_line_macro);
-		else
-			OpenGL::setColour(col_save_line_1s);
-
-		// Draw line
-		glBegin(GL_LINES);
-		glVertex2d(v1.x, v1.y);
-		glVertex2d(v2.x, v2.y);
-		glEnd();
+		MapImage::Line line;
+		line.v1 = lines[a].v1;
+		line.v2 = lines[a].v2;
+		line.twosided = lines[a].twosided;
+		line.special = lines[a].special;
+		line.macro = lines[a].macro;
+		data.lines.push_back(line);
 	}
 
-	glLineWidth(1.0f);
-	glDisable(GL_LINE_SMOOTH);
-
-	uint8_t* ImageBuffer = new uint8_t[width * height * 4];
-	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, ImageBuffer);
-
-	if (GLEW_ARB_framebuffer_object)
-	{
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		glDeleteTextures( 1, &texID );
-		glDeleteFramebuffersEXT( 1, &fboID );
-	}
+	// Draw it
+	MapImage::Options options;
+	options.loadConfig();
+	options.width = width;
+	options.height = height;
 	SImage img;
-	img.setImageData(ImageBuffer, width, height, RGBA);
-	img.mirror(true);
+	if (!MapImage::render(data, options, img))
+		return;
+
 	MemChunk mc;
 	SIFormat::getFormat("png")->saveImage(img, mc);
 	ae.importMemChunk(mc);
@@ -139,6 +139,34 @@ bool Compression::ZipInflate(MemChunk& in, MemChunk& out, size_t maxsize)
 	return ret;
 }
 
+/* Compression::ZipInflate
+ * Inflates [in_size] bytes of raw zip stream data at [in] directly
+ * into the [out_size] byte buffer at [out]. Used when the inflated
+ * size is already known (eg. from a zip directory), avoids any
+ * intermediate buffering and does no logging, so it is safe to call
+ * from worker threads
+ *******************************************************************/
+bool Compression::ZipInflate(const uint8_t* in, uint32_t in_size, uint8_t* out, uint32_t out_size)
+{
+	z_stream strm;
+	strm.zalloc = nullptr;
+	strm.zfree = nullptr;
+	strm.opaque = nullptr;
+	strm.next_in = (Bytef*)in;
+	strm.avail_in = in_size;
+	strm.next_out = out;
+	strm.avail_out = out_size;
+
+	if (inflateInit2(&strm, -MAX_WBITS) != Z_OK)
+		return false;
+
+	int ret = inflate(&strm, Z_FINISH);
+	bool ok = (ret == Z_STREAM_END || (ret == Z_OK && strm.avail_out == 0)) && strm.total_out == out_size;
+	inflateEnd(&strm);
+
+	return ok;
+}
+
 /* Compression::GZipInflate
  * Deflates the content of <in> as a gzip stream to <out>
  * GZip streams use a windowbits size of MAX_WBITS (15)
@@ -149,6 +177,43 @@ bool Compression::ZipDeflate(MemChunk& in, MemChunk& out, int level)
 	return Compression::GenericDeflate(in, out, level, -MAX_WBITS, "ZipDeflate");
 }
 
+/* Compression::ZipDeflate
+ * Deflates [in_size] bytes at [in] as a raw zip stream to <out>,
+ * in one pass. Does no logging, so it is safe to call from worker
+ * threads
+ *******************************************************************/
+bool Compression::ZipDeflate(const uint8_t* in, uint32_t in_size, vector<uint8_t>& out, int level)
+{
+	z_stream strm;
+	strm.zalloc = nullptr;
+	strm.zfree = nullptr;
+	strm.opaque = nullptr;
+	if (deflateInit2(&strm, level, Z_DEFLATED, -MAX_WBITS, 9, Z_DEFAULT_STRATEGY) != Z_OK)
+		return false;
+
+	// Allocate enough space for the worst case, then trim
+	out.resize(deflateBound(&strm, in_size));
+	strm.next_in = (Bytef*)in;
+	strm.avail_in = in_size;
+	strm.next_out = out.data();
+	strm.avail_out = out.size();
+
+	int ret = deflate(&strm, Z_FINISH);
+	out.resize(strm.total_out);
+	deflateEnd(&strm);
+
+	return ret == Z_STREAM_END;
+}
+
+/* Compression::ZipCRC
+ * Returns the CRC-32 checksum of [size] bytes at [data], as used in
+ * zip archives. [crc] can be given to continue a previous checksum
+ *******************************************************************/
+uint32_t Compression::ZipCRC(const uint8_t* data, uint32_t size, uint32_t crc)
+{
+	return crc32(crc, data, size);
+}
+
 /* Compression::GZipInflate
  * Inflates the content of <in> as a gzip stream to <out>
  * GZip streams use a windowbits size of MAX_WBITS (15)
@@ -12,7 +12,10 @@ namespace Compression
 	bool GZipInflate(MemChunk& in, MemChunk& out, size_t maxsize = 0);
 	bool GZipDeflate(MemChunk& in, MemChunk& out, int level = -1);
 	bool ZipInflate(MemChunk& in, MemChunk& out, size_t maxsize = 0);
+	bool ZipInflate(const uint8_t* in, uint32_t in_size, uint8_t* out, uint32_t out_size);
 	bool ZipDeflate(MemChunk& in, MemChunk& out, int level = -1);
+	bool ZipDeflate(const uint8_t* in, uint32_t in_size, vector<uint8_t>& out, int level = -1);
+	uint32_t ZipCRC(const uint8_t* data, uint32_t size, uint32_t crc = 0);
 	bool ZlibInflate(MemChunk& in, MemChunk& out, size_t maxsize = 0);
 	bool ZlibDeflate(MemChunk& in, MemChunk& out, int level = -1);
 	bool ZipExplode(MemChunk& in, MemChunk& out, size_t size, int flags);
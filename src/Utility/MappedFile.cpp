@@ -0,0 +1,390 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    MappedFile.cpp
+// Description: MappedFile class, a read-only memory mapping of a whole file.
+//              Data from the mapping can be shared by MemChunks without
+//              copying it (see MemChunk::importShared)
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "MappedFile.h"
+#ifdef __WXMSW__
+#include <wx/msw/wrapwin.h>
+#else
+#include <atomic>
+#include <fcntl.h>
+#include <mutex>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/vfs.h>
+#elif defined(__APPLE__)
+#include <sys/mount.h>
+#include <sys/param.h>
+#endif
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+#ifndef __WXMSW__
+// Address ranges of all current mappings, for the SIGBUS handler. This is a
+// fixed size array of atomics so the handler never needs to lock anything
+const int              MAX_GUARDED_MAPPINGS = 256;
+std::atomic<uintptr_t> guarded_start[MAX_GUARDED_MAPPINGS];
+std::atomic<uintptr_t> guarded_end[MAX_GUARDED_MAPPINGS];
+std::atomic<bool>      guarded_faulted[MAX_GUARDED_MAPPINGS];
+std::once_flag         sigbus_handler_installed;
+struct sigaction       prev_sigbus_action;
+uintptr_t              page_size = 4096;
+#endif
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+#ifdef __WXMSW__
+// -----------------------------------------------------------------------------
+// Returns true if [filename] is on a fixed local drive. Files on network or
+// removable drives aren't mapped, since reading from the mapping raises an
+// exception if the drive goes away
+// -----------------------------------------------------------------------------
+bool isOnLocalDrive(const string& filename)
+{
+	wchar_t volume[MAX_PATH];
+	if (!GetVolumePathNameW(filename.wc_str(), volume, MAX_PATH))
+		return false;
+
+	UINT type = GetDriveTypeW(volume);
+	return type == DRIVE_FIXED || type == DRIVE_RAMDISK;
+}
+#else
+// -----------------------------------------------------------------------------
+// Returns true if the file open as [fd] is on a local (and as far as can be
+// told, non-removable) filesystem. Files on network or removable filesystems
+// aren't mapped, since they can go away or change under the mapping at any
+// time
+// -----------------------------------------------------------------------------
+bool isOnLocalFilesystem(int fd)
+{
+#ifdef __linux__
+	struct statfs fs;
+	if (fstatfs(fd, &fs) != 0)
+		return false;
+
+	switch ((unsigned long)fs.f_type)
+	{
+	case 0x6969:     // NFS
+	case 0x517B:     // SMB
+	case 0xFF534D42: // CIFS
+	case 0xFE534D42: // SMB2
+	case 0x01021997: // 9P
+	case 0x65735546: // FUSE (sshfs etc.)
+	case 0x00C36400: // Ceph
+	case 0x5346414F: // AFS
+	case 0x4D44:     // FAT (usually removable media)
+	case 0x2011BAB0: // exFAT
+	case 0x9660:     // ISO 9660
+	case 0x15013346: // UDF
+		return false;
+	default: return true;
+	}
+#elif defined(__APPLE__)
+	struct statfs fs;
+	if (fstatfs(fd, &fs) != 0 || !(fs.f_flags & MNT_LOCAL))
+		return false;
+#ifdef MNT_REMOVABLE
+	if (fs.f_flags & MNT_REMOVABLE)
+		return false;
+#endif
+	return true;
+#else
+	return true;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// SIGBUS handler. Reading a mapping past the end of its file (if it was
+// truncated by another program) raises SIGBUS, if the address is within one of
+// our mappings the page is replaced with zeroes so the read can continue, and
+// the mapping is flagged as changed (see MappedFile::changed).
+// Anything else is passed on to the previous handler
+// -----------------------------------------------------------------------------
+void sigbusHandler(int sig, siginfo_t* info, void* context)
+{
+	auto address = (uintptr_t)info->si_addr;
+	for (int a = 0; a < MAX_GUARDED_MAPPINGS; a++)
+	{
+		if (address < guarded_start[a] || address >= guarded_end[a])
+			continue;
+
+		void* page = (void*)(address & ~(page_size - 1));
+		if (mmap(page, page_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != MAP_FAILED)
+		{
+			guarded_faulted[a] = true;
+			return;
+		}
+		break;
+	}
+
+	if (prev_sigbus_action.sa_flags & SA_SIGINFO)
+		prev_sigbus_action.sa_sigaction(sig, info, context);
+	else if (prev_sigbus_action.sa_handler != SIG_DFL && prev_sigbus_action.sa_handler != SIG_IGN)
+		prev_sigbus_action.sa_handler(sig);
+	else
+		signal(sig, SIG_DFL); // Crash as normal when the read is retried
+}
+
+// -----------------------------------------------------------------------------
+// Installs the SIGBUS handler (the first time a file is mapped)
+// -----------------------------------------------------------------------------
+void installSigbusHandler()
+{
+	std::call_once(sigbus_handler_installed, []() {
+		page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		action.sa_sigaction = sigbusHandler;
+		action.sa_flags     = SA_SIGINFO;
+		sigemptyset(&action.sa_mask);
+		sigaction(SIGBUS, &action, &prev_sigbus_action);
+	});
+}
+
+// -----------------------------------------------------------------------------
+// Adds [size] bytes at [data] to the ranges checked by the SIGBUS handler.
+// Returns the slot used, or -1 if there are no free slots
+// -----------------------------------------------------------------------------
+int guardMapping(const uint8_t* data, uint32_t size)
+{
+	installSigbusHandler();
+
+	for (int a = 0; a < MAX_GUARDED_MAPPINGS; a++)
+	{
+		uintptr_t expected = 0;
+		if (!guarded_start[a].compare_exchange_strong(expected, (uintptr_t)data))
+			continue;
+
+		guarded_faulted[a] = false;
+		guarded_end[a]     = (uintptr_t)data + size;
+		return a;
+	}
+
+	return -1;
+}
+
+// -----------------------------------------------------------------------------
+// Removes the mapping in [slot] from the ranges checked by the SIGBUS handler
+// -----------------------------------------------------------------------------
+void unguardMapping(int slot)
+{
+	guarded_end[slot]   = 0;
+	guarded_start[slot] = 0;
+}
+#endif
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// MappedFile Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// MappedFile class constructor
+// -----------------------------------------------------------------------------
+MappedFile::MappedFile() : data_{ nullptr }, size_{ 0 }, file_size_{ 0 }, mod_time_{ 0 }, guard_slot_{ -1 }
+{
+#ifdef __WXMSW__
+	mapping_ = nullptr;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// MappedFile class destructor, unmaps the file
+// -----------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+	if (!data_)
+		return;
+
+#ifdef __WXMSW__
+	UnmapViewOfFile(data_);
+	CloseHandle((HANDLE)mapping_);
+#else
+	if (guard_slot_ >= 0)
+		unguardMapping(guard_slot_);
+	munmap(data_, size_);
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the file was changed (or removed) on disk since it was
+// mapped (or since updateFileInfo was last called).
+// If the file was truncated, mapped data past its new end reads as zeroes (on
+// POSIX systems, see sigbusHandler), so the mapping should no longer be used
+// if this is true
+// -----------------------------------------------------------------------------
+bool MappedFile::changed() const
+{
+#ifndef __WXMSW__
+	if (guard_slot_ >= 0 && guarded_faulted[guard_slot_])
+		return true;
+#endif
+
+	wxStructStat info;
+	if (wxStat(filename_, &info) != 0)
+		return true;
+
+	return (uint64_t)info.st_size != file_size_ || info.st_mtime != mod_time_;
+}
+
+// -----------------------------------------------------------------------------
+// Records the current size and modification time of the file, for when the
+// owner of the mapping has written to the file itself (without truncating it)
+// -----------------------------------------------------------------------------
+void MappedFile::updateFileInfo()
+{
+	wxStructStat info;
+	if (wxStat(filename_, &info) != 0)
+		return;
+
+	file_size_ = info.st_size;
+	mod_time_  = info.st_mtime;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// MappedFile Class Static Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Maps the whole of [filename] into memory (read-only).
+// Returns nullptr if the file couldn't be mapped (doesn't exist, is empty, too
+// large or not on a local drive), in which case it should be read normally
+// -----------------------------------------------------------------------------
+MappedFile::SPtr MappedFile::open(const string& filename)
+{
+	SPtr mf(new MappedFile());
+	mf->filename_ = filename;
+
+#ifdef __WXMSW__
+	HANDLE file = CreateFileW(
+		filename.wc_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL,
+		nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	if (!isOnLocalDrive(filename))
+	{
+		CloseHandle(file);
+		return nullptr;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 || size.QuadPart > 0xFFFFFFFF)
+	{
+		CloseHandle(file);
+		return nullptr;
+	}
+
+	// The mapping keeps the file open, so the file handle isn't needed after this
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping)
+		return nullptr;
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		CloseHandle(mapping);
+		return nullptr;
+	}
+
+	mf->mapping_ = mapping;
+	mf->data_    = (uint8_t*)data;
+	mf->size_    = (uint32_t)size.QuadPart;
+#else
+	int fd = ::open(filename.fn_str(), O_RDONLY);
+	if (fd < 0)
+		return nullptr;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0 || (uint64_t)st.st_size > 0xFFFFFFFF || !isOnLocalFilesystem(fd))
+	{
+		close(fd);
+		return nullptr;
+	}
+
+	// The mapping stays valid after the file descriptor is closed
+	void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return nullptr;
+
+	mf->data_ = (uint8_t*)data;
+	mf->size_ = (uint32_t)st.st_size;
+
+	// Guard against the file being truncated while mapped
+	mf->guard_slot_ = guardMapping(mf->data_, mf->size_);
+	if (mf->guard_slot_ < 0)
+		return nullptr;
+#endif
+
+	// Remember the file's size and modification time, so external changes can
+	// be detected (see changed)
+	mf->updateFileInfo();
+
+	return mf;
+}
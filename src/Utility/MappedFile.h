@@ -0,0 +1,31 @@
+#pragma once
+
+class MappedFile
+{
+public:
+	typedef std::shared_ptr<MappedFile> SPtr;
+
+	~MappedFile();
+
+	const string&  filename() const { return filename_; }
+	const uint8_t* data() const { return data_; }
+	uint32_t       size() const { return size_; }
+
+	bool changed() const;
+	void updateFileInfo();
+
+	static SPtr open(const string& filename);
+
+private:
+	string   filename_;
+	uint8_t* data_;
+	uint32_t size_;
+	uint64_t file_size_;  // Size of the file when it was mapped
+	time_t   mod_time_;   // Modification time of the file when it was mapped
+	int      guard_slot_; // Slot in the SIGBUS handler's list of mappings (not used on Windows)
+#ifdef __WXMSW__
+	void* mapping_;
+#endif
+
+	MappedFile();
+};
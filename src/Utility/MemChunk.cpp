@@ -73,7 +73,7 @@ MemChunk::MemChunk(const uint8_t* data, uint32_t size)
 MemChunk::~MemChunk()
 {
 	// Free memory
-	if (data)
+	if (data && !shared)
 		delete[] data;
 }
 
@@ -96,7 +96,10 @@ bool MemChunk::clear()
 {
 	if (hasData())
 	{
-		delete[] data;
+		if (shared)
+			shared.reset();
+		else
+			delete[] data;
 		data = nullptr;
 		size = 0;
 		cur_ptr = 0;
@@ -127,8 +130,11 @@ bool MemChunk::reSize(uint32_t new_size, bool preserve_data)
 	// Preserve existing data if specified
 	if (preserve_data)
 	{
-		memcpy(ndata, data, size * sizeof(uint8_t));
-		delete[] data;
+		memcpy(ndata, data, MIN(size, new_size) * sizeof(uint8_t));
+		if (shared)
+			shared.reset();
+		else
+			delete[] data;
 		data = ndata;
 	}
 	else
@@ -249,7 +255,9 @@ bool MemChunk::importMem(const uint8_t* start, uint32_t len)
 	if (!start)
 		return false;
 
-	// Clear current data if it exists
+	// Clear current data if it exists (keeping any shared data alive until
+	// the copy is done, in case [start] points into it)
+	std::shared_ptr<const void> keep = shared;
 	clear();
 
 	// Setup variables
@@ -267,6 +275,33 @@ bool MemChunk::importMem(const uint8_t* start, uint32_t len)
 	return true;
 }
 
+/* MemChunk::importShared
+ * Makes the MemChunk refer to [len] bytes at [start] without copying
+ * them. [owner] is kept alive while the data is in use and must
+ * own the memory at [start]. The data is treated as read-only, a
+ * private copy is made first if the MemChunk is modified
+ * Returns false if size or data pointer is invalid, true otherwise
+ *******************************************************************/
+bool MemChunk::importShared(std::shared_ptr<const void> owner, const uint8_t* start, uint32_t len)
+{
+	// Check that length & data to be loaded are valid
+	if (!start || !owner)
+		return false;
+
+	// Clear current data if it exists
+	clear();
+
+	// Refer to the shared data (nothing to share if empty)
+	if (len > 0)
+	{
+		data = const_cast<uint8_t*>(start);
+		size = len;
+		shared = owner;
+	}
+
+	return true;
+}
+
 /* MemChunk::exportFile
  * Writes the MemChunk data to a new file of [filename], starting
  * from [start] to [start+size]. If [size] is 0, writes from [start]
@@ -335,6 +370,10 @@ bool MemChunk::write(const void* data, uint32_t size)
 	if (!data)
 		return false;
 
+	// Make a private copy of shared data before modifying it
+	if (!detach())
+		return false;
+
 	// If we're trying to write past the end of the memory chunk,
 	// resize it so we can write at this point
 	if (cur_ptr + size > this->size)
@@ -452,7 +491,7 @@ bool MemChunk::readMC(MemChunk& mc, uint32_t size)
 bool MemChunk::fillData(uint8_t val)
 {
 	// Check data exists
-	if (!hasData())
+	if (!hasData() || !detach())
 		return false;
 
 	// Fill data with value
@@ -506,3 +545,24 @@ uint8_t* MemChunk::allocData(uint32_t size, bool set_data)
 
 	return ndata;
 }
+
+/* MemChunk::detach
+ * If the MemChunk refers to shared data, replaces it with a private
+ * copy that can be modified.
+ * Returns false if the copy couldn't be allocated, true otherwise
+ *******************************************************************/
+bool MemChunk::detach()
+{
+	if (!shared)
+		return true;
+
+	uint8_t* ndata = allocData(size, false);
+	if (!ndata)
+		return false;
+
+	memcpy(ndata, data, size);
+	data = ndata;
+	shared.reset();
+
+	return true;
+}
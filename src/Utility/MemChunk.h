@@ -8,6 +8,10 @@ protected:
 	uint32_t	cur_ptr;
 	uint32_t	size;
 
+	// If set, data is read-only and belongs to this object (eg. a memory
+	// mapped file), a private copy is made before it is modified
+	std::shared_ptr<const void>	shared;
+
 	uint8_t*	allocData(uint32_t size, bool set_data = true);
 
 public:
@@ -15,13 +19,16 @@ public:
 	MemChunk(const uint8_t* data, uint32_t size);
 	~MemChunk();
 
-	uint8_t& operator[](int a) { return data[a]; }
+	uint8_t&		operator[](int a) { detach(); return data[a]; }
+	const uint8_t&	operator[](int a) const { return data[a]; }
 
 	// Accessors
 	const uint8_t*	getData() const { return data; }
 	uint32_t		getSize() const { return size; }
 
 	bool hasData();
+	bool isShared() const { return (bool)shared; }
+	bool detach();
 
 	bool clear();
 	bool reSize(uint32_t new_size, bool preserve_data = true);
@@ -30,6 +37,7 @@ public:
 	bool	importFile(string filename, uint32_t offset = 0, uint32_t len = 0);
 	bool	importFileStream(wxFile& file, uint32_t len = 0);
 	bool	importMem(const uint8_t* start, uint32_t len);
+	bool	importShared(std::shared_ptr<const void> owner, const uint8_t* start, uint32_t len);
 
 	// Data export
 	bool	exportFile(string filename, uint32_t start = 0, uint32_t size = 0);
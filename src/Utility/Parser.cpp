@@ -201,7 +201,7 @@ bool ParseTreeNode::parsePreprocessor(Tokenizer& tz)
 
 	// #define
 	if (tz.current() == "#define")
-		parser_->define(tz.next().text);
+		parser_->define(tz.next().text());
 
 	// #if(n)def
 	else if (tz.current() == "#ifdef" || tz.current() == "#ifndef")
@@ -210,7 +210,7 @@ bool ParseTreeNode::parsePreprocessor(Tokenizer& tz)
 		bool test = true;
 		if (tz.current() == "#ifndef")
 			test = false;
-		string define = tz.next().text;
+		string define = tz.next().text();
 		if (parser_->defined(define) == test)
 			return true;
 
@@ -239,7 +239,7 @@ bool ParseTreeNode::parsePreprocessor(Tokenizer& tz)
 		if (archive_dir_)
 		{
 			// Get entry to include
-			auto inc_path = tz.next().text;
+			auto inc_path = tz.next().text();
 			auto archive = archive_dir_->archive();
 			auto inc_entry = archive->entryAtPath(archive_dir_->getPath() + inc_path);
 			if (!inc_entry) // Try absolute path
@@ -278,7 +278,7 @@ bool ParseTreeNode::parsePreprocessor(Tokenizer& tz)
 
 	// Unrecognised
 	else
-		logError(tz, S_FMT("Unrecognised preprocessor directive \"%s\"", CHR(tz.current().text)));
+		logError(tz, S_FMT("Unrecognised preprocessor directive \"%s\"", CHR(tz.current().text())));
 
 	return true;
 }
@@ -312,31 +312,23 @@ bool ParseTreeNode::parseAssignment(Tokenizer& tz, ParseTreeNode* child) const
 
 		// Detect value type
 		if (token.quoted_string)	// Quoted string
-			value = token.text;
+			value = token.text();
 		else if (token == "true")	// Boolean (true)
 			value = true;
 		else if (token == "false")	// Boolean (false)
 			value = false;
 		else if (token.isInteger())	// Integer
-		{
-			long val;
-			token.text.ToLong(&val);
-			value = (int)val;
-		}
+			value = token.asInt();
 		else if (token.isHex())  	// Hex (0xXXXXXX)
 		{
 			long val;
-			token.text.ToLong(&val, 0);
+			token.text().ToLong(&val, 0);
 			value = (int)val;
 		}
 		else if (token.isFloat())	// Floating point
-		{
-			double val;
-			token.text.ToDouble(&val);
-			value = val;
-		}
+			value = token.asFloat();
 		else						// Unknown, just treat as string
-			value = token.text;
+			value = token.text();
 
 		// Add value
 		child->values_.push_back(value);
@@ -348,7 +340,7 @@ bool ParseTreeNode::parseAssignment(Tokenizer& tz, ParseTreeNode* child) const
 		{
 			logError(
 				tz,
-				S_FMT("Expected \",\" or \"%c\", got \"%s\"", list_end, CHR(tz.peek().text))
+				S_FMT("Expected \",\" or \"%c\", got \"%s\"", list_end, CHR(tz.peek().text()))
 			);
 			return false;
 		}
@@ -389,14 +381,14 @@ bool ParseTreeNode::parse(Tokenizer& tz)
 		}
 
 		// If it's a special character (ie not a valid name), parsing fails
-		if (tz.isSpecialCharacter(tz.current().text[0]))
+		if (tz.isSpecialCharacter(tz.current()[0]))
 		{
-			logError(tz, S_FMT("Unexpected special character '%s'", CHR(tz.current().text)));
+			logError(tz, S_FMT("Unexpected special character '%s'", CHR(tz.current().text())));
 			return false;
 		}
 
 		// So we have either a node or property name
-		name = tz.current().text;
+		name = tz.current().text();
 		type.Empty();
 		if (name.empty())
 		{
@@ -408,7 +400,7 @@ bool ParseTreeNode::parse(Tokenizer& tz)
 		if (tz.peek() != '=' && tz.peek() != '{' && tz.peek() != ';' && tz.peek() != ':')
 		{
 			type = name;
-			name = tz.next().text;
+			name = tz.next().text();
 
 			if (name.empty())
 			{
@@ -450,7 +442,7 @@ bool ParseTreeNode::parse(Tokenizer& tz)
 			{
 				// Add child node
 				auto child = addChildPTN(name, type);
-				child->inherit_ = tz.current().text;
+				child->inherit_ = tz.current().text();
 
 				// Skip {
 				tz.adv(2);
@@ -463,7 +455,7 @@ bool ParseTreeNode::parse(Tokenizer& tz)
 			{
 				// Add child node
 				auto child = addChildPTN(name, type);
-				child->inherit_ = tz.current().text;
+				child->inherit_ = tz.current().text();
 
 				// Skip ;
 				tz.adv(2);
@@ -472,7 +464,7 @@ bool ParseTreeNode::parse(Tokenizer& tz)
 			}
 			else
 			{
-				logError(tz, S_FMT("Expecting \"{\" or \";\", got \"%s\"", CHR(tz.next().text)));
+				logError(tz, S_FMT("Expecting \"{\" or \";\", got \"%s\"", CHR(tz.next().text())));
 				return false;
 			}
 		}
@@ -480,7 +472,7 @@ bool ParseTreeNode::parse(Tokenizer& tz)
 		// Unexpected token
 		else
 		{
-			logError(tz, S_FMT("Unexpected token \"%s\"", CHR(tz.next().text)));
+			logError(tz, S_FMT("Unexpected token \"%s\"", CHR(tz.next().text())));
 			return false;
 		}
 
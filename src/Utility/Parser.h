@@ -21,7 +21,7 @@ public:
 	~ParseTreeNode();
 
 	string	getName() override { return name_; }
-	void	setName(string name) override { this->name_ = name; }
+	void	setName(string name) override { string old = name_; name_ = name; renamed(old); }
 
 	const string&			inherit() const { return inherit_; }
 	const string&			type() const { return type_; }
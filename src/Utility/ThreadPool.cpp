@@ -0,0 +1,188 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    ThreadPool.cpp
+// Description: ThreadPool class, a simple fixed-size pool of worker threads
+//              that run queued tasks in FIFO order
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "ThreadPool.h"
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Int, max_worker_threads, 0, CVAR_SAVE)
+
+
+// -----------------------------------------------------------------------------
+//
+// ThreadPool Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// ThreadPool class constructor. Starts [num_threads] worker threads, or the
+// default number of threads (see defaultNumThreads) if 0
+// -----------------------------------------------------------------------------
+ThreadPool::ThreadPool(unsigned num_threads) : active_{ 0 }, stop_{ false }
+{
+	if (num_threads == 0)
+		num_threads = defaultNumThreads();
+
+	for (unsigned a = 0; a < num_threads; a++)
+		workers_.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+// -----------------------------------------------------------------------------
+// ThreadPool class destructor. Any tasks still queued are discarded, tasks
+// already running are allowed to finish
+// -----------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+		tasks_.clear();
+	}
+	cv_task_.notify_all();
+
+	for (auto& worker : workers_)
+		worker.join();
+}
+
+// -----------------------------------------------------------------------------
+// Returns the number of tasks that are queued or currently running
+// -----------------------------------------------------------------------------
+unsigned ThreadPool::numPending()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return tasks_.size() + active_;
+}
+
+// -----------------------------------------------------------------------------
+// Adds [task] to the queue. If [front] is true, the task is added to the front
+// of the queue so it will be the next one picked up by a worker
+// -----------------------------------------------------------------------------
+void ThreadPool::queue(Task task, bool front)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (front)
+			tasks_.push_front(std::move(task));
+		else
+			tasks_.push_back(std::move(task));
+	}
+	cv_task_.notify_one();
+}
+
+// -----------------------------------------------------------------------------
+// Discards all queued tasks that haven't been started yet
+// -----------------------------------------------------------------------------
+void ThreadPool::cancelPending()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		tasks_.clear();
+	}
+	cv_done_.notify_all();
+}
+
+// -----------------------------------------------------------------------------
+// Blocks until all queued tasks have finished
+// -----------------------------------------------------------------------------
+void ThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	cv_done_.wait(lock, [this] { return tasks_.empty() && active_ == 0; });
+}
+
+// -----------------------------------------------------------------------------
+// Blocks until all queued tasks have finished or [ms] milliseconds have
+// passed. Returns true if all tasks have finished
+// -----------------------------------------------------------------------------
+bool ThreadPool::waitFor(int ms)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	return cv_done_.wait_for(
+		lock, std::chrono::milliseconds(ms), [this] { return tasks_.empty() && active_ == 0; });
+}
+
+// -----------------------------------------------------------------------------
+// Worker thread function, runs tasks from the queue until the pool is
+// destroyed
+// -----------------------------------------------------------------------------
+void ThreadPool::workerLoop()
+{
+	while (true)
+	{
+		Task task;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			cv_task_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+			if (stop_)
+				return;
+
+			task = std::move(tasks_.front());
+			tasks_.pop_front();
+			active_++;
+		}
+
+		task();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			active_--;
+		}
+		cv_done_.notify_all();
+	}
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// ThreadPool Class Static Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Returns the number of worker threads to use by default, either the
+// max_worker_threads cvar or the number of hardware threads available
+// -----------------------------------------------------------------------------
+unsigned ThreadPool::defaultNumThreads()
+{
+	if (max_worker_threads > 0)
+		return max_worker_threads;
+
+	unsigned hw = std::thread::hardware_concurrency();
+	return hw > 0 ? hw : 2;
+}
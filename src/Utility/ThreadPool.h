@@ -0,0 +1,36 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+class ThreadPool
+{
+public:
+	typedef std::function<void()> Task;
+
+	ThreadPool(unsigned num_threads = 0);
+	~ThreadPool();
+
+	unsigned numThreads() const { return workers_.size(); }
+	unsigned numPending();
+
+	void queue(Task task, bool front = false);
+	void cancelPending();
+	void wait();
+	bool waitFor(int ms);
+
+	static unsigned defaultNumThreads();
+
+private:
+	vector<std::thread>     workers_;
+	std::deque<Task>        tasks_;
+	std::mutex              mutex_;
+	std::condition_variable cv_task_;
+	std::condition_variable cv_done_;
+	unsigned                active_;
+	bool                    stop_;
+
+	void workerLoop();
+};
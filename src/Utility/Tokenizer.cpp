@@ -31,7 +31,6 @@
 // ----------------------------------------------------------------------------
 #include "Main.h"
 #include "Tokenizer.h"
-#include "StringUtils.h"
 
 
 // ----------------------------------------------------------------------------
@@ -40,7 +39,12 @@
 //
 // ----------------------------------------------------------------------------
 const string Tokenizer::DEFAULT_SPECIAL_CHARACTERS = ";,:|={}/";
-Tokenizer::Token Tokenizer::invalid_token_{ "", 0, false, 0, 0, 0, false };
+Tokenizer::Token Tokenizer::invalid_token_{ "", 0, 0, false, 0, 0, false };
+
+namespace
+{
+	const size_t TEXT_BLOCK_SIZE = 16384;
+}
 
 
 // ----------------------------------------------------------------------------
@@ -60,6 +64,47 @@ namespace
 		// Whitespace is either a newline, tab character or space
 		return p == '\n' || p == 13 || p == ' ' || p == '\t';
 	}
+
+	// ------------------------------------------------------------------------
+	// isDigit
+	//
+	// Returns true if [p] is a decimal digit (0-9)
+	// ------------------------------------------------------------------------
+	bool isDigit(char p)
+	{
+		return p >= '0' && p <= '9';
+	}
+
+	// ------------------------------------------------------------------------
+	// allDigits
+	//
+	// Returns true if the [length] characters at [str] are all decimal digits
+	// (or, if [hex] is true, hex digits)
+	// ------------------------------------------------------------------------
+	bool allDigits(const char* str, unsigned length, bool hex = false)
+	{
+		for (unsigned a = 0; a < length; ++a)
+			if (!(hex ? isxdigit((unsigned char)str[a]) : isDigit(str[a])))
+				return false;
+
+		return true;
+	}
+
+	// ------------------------------------------------------------------------
+	// copyToBuffer
+	//
+	// Copies the text of [token] to [buffer] as a null-terminated string.
+	// Returns false if it doesn't fit
+	// ------------------------------------------------------------------------
+	template<size_t size> bool copyToBuffer(const Tokenizer::Token& token, char (&buffer)[size])
+	{
+		if (token.length >= size)
+			return false;
+
+		memcpy(buffer, token.data, token.length);
+		buffer[token.length] = 0;
+		return true;
+	}
 }
 
 
@@ -70,35 +115,140 @@ namespace
 // ----------------------------------------------------------------------------
 
 
+// ----------------------------------------------------------------------------
+// Token::operator==
+//
+// Returns true if the token text matches [cmp]
+// ----------------------------------------------------------------------------
+bool Tokenizer::Token::operator==(const string& cmp) const
+{
+	if (cmp.length() != length)
+		return false;
+
+	// Token text is converted to a string 1:1 (see text()), so just compare
+	// each character value
+	for (unsigned a = 0; a < length; ++a)
+		if (cmp[a].GetValue() != (unsigned char)data[a])
+			return false;
+
+	return true;
+}
+bool Tokenizer::Token::operator==(const char* cmp) const
+{
+	for (unsigned a = 0; a < length; ++a)
+		if (!cmp[a] || data[a] != cmp[a])
+			return false;
+
+	return cmp[length] == 0;
+}
+
+// ----------------------------------------------------------------------------
+// Token::equalsNC
+//
+// Returns true if the token text matches [cmp] (Case-Insensitive)
+// ----------------------------------------------------------------------------
+bool Tokenizer::Token::equalsNC(const char* cmp) const
+{
+	for (unsigned a = 0; a < length; ++a)
+		if (!cmp[a] || tolower((unsigned char)data[a]) != tolower((unsigned char)cmp[a]))
+			return false;
+
+	return cmp[length] == 0;
+}
+
+// ----------------------------------------------------------------------------
+// Token::startsWith
+//
+// Returns true if the token text begins with [cmp]
+// ----------------------------------------------------------------------------
+bool Tokenizer::Token::startsWith(const char* cmp) const
+{
+	unsigned cmp_length = strlen(cmp);
+	return cmp_length <= length && strncmp(data, cmp, cmp_length) == 0;
+}
+
 // ----------------------------------------------------------------------------
 // Token::isInteger
 //
 // Returns true if the token is a valid integer. If [allow_hex] is true, can
 // also be a valid hex string
+// (matches StringUtils::isInteger without needing to convert to a string)
 // ----------------------------------------------------------------------------
 bool Tokenizer::Token::isInteger(bool allow_hex) const
 {
-	return StringUtils::isInteger(text, allow_hex);
+	// [+-]?[0-9]+
+	unsigned start = (length > 0 && (data[0] == '+' || data[0] == '-')) ? 1 : 0;
+	if (length > start && allDigits(data + start, length - start))
+		return true;
+
+	return allow_hex && isHex();
 }
 
 // ----------------------------------------------------------------------------
 // Token::isHex
 //
 // Returns true if the token is a valid hex string
+// (matches StringUtils::isHex without needing to convert to a string)
 // ----------------------------------------------------------------------------
 bool Tokenizer::Token::isHex() const
 {
-	return StringUtils::isHex(text);
+	// 0x[0-9A-Fa-f]+
+	return length > 2 && data[0] == '0' && data[1] == 'x' && allDigits(data + 2, length - 2, true);
 }
 
 // ----------------------------------------------------------------------------
 // Token::isFloat
 //
 // Returns true if the token is a floating point number
+// (matches StringUtils::isFloat without needing to convert to a string)
 // ----------------------------------------------------------------------------
 bool Tokenizer::Token::isFloat() const
 {
-	return StringUtils::isFloat(text);
+	// [-+]?[0-9]*.?[0-9]+([eE][-+]?[0-9]+)?
+	// (note that the . matches any character)
+	unsigned start = (length > 0 && (data[0] == '+' || data[0] == '-')) ? 1 : 0;
+
+	// Try each possible end of the number before the exponent
+	for (unsigned end = start + 1; end <= length; ++end)
+	{
+		// Exponent
+		if (end < length)
+		{
+			if (data[end] != 'e' && data[end] != 'E')
+				continue;
+			unsigned exp = end + 1;
+			if (exp < length && (data[exp] == '+' || data[exp] == '-'))
+				++exp;
+			if (exp == length || !allDigits(data + exp, length - exp))
+				continue;
+		}
+
+		// Number must end with a digit, anything before the trailing digits
+		// must be digits followed by up to one other character
+		unsigned digits = end;
+		while (digits > start && isDigit(data[digits - 1]))
+			--digits;
+		if (digits == end)
+			continue;
+		if (digits == start || allDigits(data + start, digits - start - 1))
+			return true;
+	}
+
+	return false;
+}
+
+// ----------------------------------------------------------------------------
+// Token::asInt
+//
+// Returns the token as an integer value
+// ----------------------------------------------------------------------------
+int Tokenizer::Token::asInt() const
+{
+	char buffer[64];
+	if (!copyToBuffer(*this, buffer))
+		return wxAtoi(text());
+
+	return (int)strtol(buffer, nullptr, 10);
 }
 
 // ----------------------------------------------------------------------------
@@ -109,22 +259,21 @@ bool Tokenizer::Token::isFloat() const
 // ----------------------------------------------------------------------------
 bool Tokenizer::Token::asBool() const
 {
-	return !(S_CMPNOCASE(text, "false") ||
-			 S_CMPNOCASE(text, "no") ||
-			 S_CMPNOCASE(text, "0"));
+	return !(equalsNC("false") || equalsNC("no") || equalsNC("0"));
 }
 
 // ----------------------------------------------------------------------------
-// Token::toBool
+// Token::asFloat
 //
-// Sets [val] to the token as a bool value.
-// "false", "no" and "0" are false, anything else is true.
+// Returns the token as a floating point value
 // ----------------------------------------------------------------------------
-void Tokenizer::Token::toBool(bool& val) const
+double Tokenizer::Token::asFloat() const
 {
-	val = !(S_CMPNOCASE(text, "false") ||
-			S_CMPNOCASE(text, "no") ||
-			S_CMPNOCASE(text, "0"));
+	char buffer[64];
+	if (!copyToBuffer(*this, buffer))
+		return wxAtof(text());
+
+	return strtod(buffer, nullptr);
 }
 
 
@@ -141,6 +290,8 @@ void Tokenizer::Token::toBool(bool& val) const
 // Tokenizer class constructor
 // ----------------------------------------------------------------------------
 Tokenizer::Tokenizer(int comments, const string& special_characters) :
+	token_current_{ invalid_token_ },
+	token_next_{ invalid_token_ },
 	comment_types_{ comments },
 	special_characters_{special_characters.begin(), special_characters.end()},
 	decorate_{ false },
@@ -237,7 +388,7 @@ bool Tokenizer::advIf(char check, size_t inc)
 // ----------------------------------------------------------------------------
 bool Tokenizer::advIfNC(const char* check, size_t inc)
 {
-	if (S_CMPNOCASE(token_current_.text, check))
+	if (token_current_.equalsNC(check))
 	{
 		adv(inc);
 		return true;
@@ -247,7 +398,7 @@ bool Tokenizer::advIfNC(const char* check, size_t inc)
 }
 bool Tokenizer::advIfNC(const string& check, size_t inc)
 {
-	if (S_CMPNOCASE(token_current_.text, check))
+	if (S_CMPNOCASE(token_current_.text(), check))
 	{
 		adv(inc);
 		return true;
@@ -311,7 +462,7 @@ bool Tokenizer::advIfNextNC(const char* check, size_t inc)
 	if (!token_next_.valid)
 		return false;
 
-	if (S_CMPNOCASE(token_next_.text, check))
+	if (token_next_.equalsNC(check))
 	{
 		adv(inc);
 		return true;
@@ -517,7 +668,7 @@ bool Tokenizer::checkOrEndNC(const char* check) const
 	if (!token_next_.valid)
 		return true;
 
-	return S_CMPNOCASE(token_current_.text, check);
+	return token_current_.equalsNC(check);
 }
 
 // ----------------------------------------------------------------------------
@@ -552,7 +703,7 @@ bool Tokenizer::checkNextNC(const char* check) const
 	if (!token_next_.valid)
 		return false;
 
-	return S_CMPNOCASE(token_next_.text, check);
+	return token_next_.equalsNC(check);
 }
 
 // ----------------------------------------------------------------------------
@@ -656,6 +807,11 @@ void Tokenizer::reset()
 	state_ = TokenizeState{};
 	state_.size = data_.size();
 
+	// Reuse text storage
+	for (auto& block : text_blocks_)
+		block.clear();
+	text_block_ = 0;
+
 	// Read first tokens
 	readNext(&token_current_);
 	readNext(&token_next_);
@@ -905,31 +1061,47 @@ bool Tokenizer::readNext(Token* target)
 	// Write to target token (if specified)
 	if (target)
 	{
-		// How is this slower than using += in a loop as below? Just wxString things >_>
-		//target->text.assign(
-		//	data_.data() + state_.current_token.pos_start,
-		//	state_.position - state_.current_token.pos_start
-		//);
-		
-		target->text.Empty();
-		for (unsigned a = state_.current_token.pos_start; a < state_.position; ++a)
+		const char* start  = data_.data() + state_.current_token.pos_start;
+		unsigned    length = state_.position - state_.current_token.pos_start;
+		bool        quoted = state_.current_token.quoted_string;
+
+		// Check if the token text needs to differ from the source data
+		// (escape characters in quoted strings, or converting to lowercase)
+		bool modify = false;
+		for (unsigned a = 0; a < length && !modify; ++a)
 		{
-			if (state_.current_token.quoted_string && data_[a] == '\\')
-				++a;
+			if (quoted)
+				modify = start[a] == '\\';
+			else
+				modify = read_lowercase_ && isupper((unsigned char)start[a]);
+		}
 
-			target->text += data_[a];
+		if (modify)
+		{
+			char*    text        = storeText(length);
+			unsigned text_length = 0;
+			for (unsigned a = 0; a < length; ++a)
+			{
+				if (quoted && start[a] == '\\' && ++a == length)
+					break;
+
+				text[text_length++] = quoted ? start[a] : (char)tolower((unsigned char)start[a]);
+			}
+
+			target->data   = text;
+			target->length = text_length;
+		}
+		else
+		{
+			target->data   = start;
+			target->length = length;
 		}
 
 		target->line_no = state_.current_token.line_no;
-		target->quoted_string = state_.current_token.quoted_string;
+		target->quoted_string = quoted;
 		target->pos_start = state_.current_token.pos_start;
 		target->pos_end = state_.position;
-		target->length = target->pos_end - target->pos_start;
 		target->valid = true;
-
-		// Convert to lowercase if configured to and it isn't a quoted string
-		if (read_lowercase_ && !target->quoted_string)
-			target->text.LowerCase();
 	}
 
 	// Skip closing " if it was a quoted string
@@ -937,7 +1109,7 @@ bool Tokenizer::readNext(Token* target)
 		++state_.position;
 
 	if (debug_)
-		Log::debug(S_FMT("%d: \"%s\"", token_current_.line_no, CHR(token_current_.text)));
+		Log::debug(S_FMT("%d: \"%s\"", token_current_.line_no, CHR(token_current_.text())));
 		
 	return true;
 }
@@ -963,26 +1135,72 @@ void Tokenizer::resetToLineStart()
 	}
 }
 
+// ----------------------------------------------------------------------------
+// Tokenizer::storeText
+//
+// Returns a pointer to space for [length] characters of token text, that will
+// stay valid until the tokenizer is reset
+// ----------------------------------------------------------------------------
+char* Tokenizer::storeText(unsigned length)
+{
+	// Use the first block with enough space left
+	for (; text_block_ < text_blocks_.size(); ++text_block_)
+	{
+		auto& block = text_blocks_[text_block_];
+		if (block.capacity() - block.size() >= length)
+		{
+			size_t start = block.size();
+			block.resize(start + length);
+			return block.data() + start;
+		}
+	}
+
+	// Add a new block (never resized beyond its capacity, so it isn't moved)
+	text_blocks_.emplace_back();
+	text_blocks_.back().reserve(std::max<size_t>(length, TEXT_BLOCK_SIZE));
+	text_blocks_.back().resize(length);
+	return text_blocks_.back().data();
+}
+
 
 // Testing
 
 #include "General/Console/Console.h"
 #include "MainEditor/MainEditor.h"
-#include "Archive/ArchiveEntry.h"
+#include "Archive/ArchiveManager.h"
 #include "App.h"
 
+// ----------------------------------------------------------------------------
+// Tokenizes the current entry (or with 'configs', every entry in the config
+// directory of slade.pk3) and logs the time taken.
+// Optional args: number of times to tokenize, 'lower' to read in lowercase,
+// 'text' to also convert each token to a string (as parsers storing the token
+// text do), 'dump' to log the tokens (current entry only)
+// ----------------------------------------------------------------------------
 CONSOLE_COMMAND(test_tokenizer, 0, false)
 {
-	auto entry = MainEditor::currentEntry();
-	if (!entry)
-		return;
-
 	long num = 1;
 	if (!args.empty())
 		args[0].ToLong(&num);
+	if (num < 1)
+		num = 1;
 
 	bool lower = (VECTOR_EXISTS(args, "lower"));
 	bool dump = (VECTOR_EXISTS(args, "dump"));
+	bool text = (VECTOR_EXISTS(args, "text"));
+
+	// Get entries to tokenize
+	vector<ArchiveEntry*> entries;
+	if (VECTOR_EXISTS(args, "configs"))
+	{
+		auto archive = App::archiveManager().programResourceArchive();
+		auto dir = archive ? archive->getDir("config") : nullptr;
+		if (dir)
+			archive->getEntryTreeAsList(entries, dir);
+		dump = false;
+	}
+	else if (MainEditor::currentEntry())
+		entries.push_back(MainEditor::currentEntry());
 
 	struct TestToken
 	{
@@ -991,51 +1209,50 @@ CONSOLE_COMMAND(test_tokenizer, 0, false)
 		unsigned line_no;
 	};
 
-	// Tokenize it
+	// Tokenize them
 	Tokenizer tz;
 	vector<TestToken> t_new;
+	size_t num_entries = 0, num_tokens = 0, size = 0, text_length = 0;
 	tz.setReadLowerCase(lower);
 	long time = App::runTimer();
-	tz.openMem(entry->getMCData(), entry->getName());
-	for (long a = 0; a < num; a++)
+	for (auto entry : entries)
 	{
-		while (!tz.atEnd())
-		{
-			if (a == 0)
-				t_new.push_back({ tz.current().text, tz.current().quoted_string, tz.current().line_no });
+		if (entry->getSize() == 0 || entry->getType() == EntryType::folderType())
+			continue;
 
-			tz.next();
+		tz.openMem(entry->getMCData(), entry->getName());
+		num_entries++;
+		size += entry->getSize();
+		for (long a = 0; a < num; a++)
+		{
+			while (!tz.atEnd())
+			{
+				if (a == 0)
+				{
+					num_tokens++;
+					if (dump)
+						t_new.push_back({ tz.current().text(), tz.current().quoted_string, tz.current().line_no });
+				}
+				if (text)
+					text_length += tz.current().text().length();
+
+				tz.next();
+			}
+			tz.reset();
 		}
-		tz.reset();
 	}
 
 	long new_time = App::runTimer() - time;
 
-	Log::info(S_FMT("Tokenize x%d took %dms", num, new_time));
-
-
-	// Test old tokenizer also
-	/*
-	TokenizerOld tzo;
-	vector<TestToken> t_old;
-	time = App::runTimer();
-	tzo.openMem(&entry->getMCData(), entry->getName());
-	for (long a = 0; a < num; a++)
-	{
-		string token = tzo.getToken();
-		while (!tzo.isAtEnd())
-		{
-			if (a == 0)
-				t_old.push_back({ token, tzo.quotedString(), tzo.lineNo() });
-
-			tzo.getToken(&token);
-		}
-		tzo.reset();
-	}
-	time = App::runTimer() - time;
-	Log::info(S_FMT("Old Tokenize x%d took %dms", num, time));
-	Log::info(S_FMT("%1.3fx time", (float)new_time / (float)time));
-	*/
+	Log::info(S_FMT(
+		"Tokenize x%d took %dms (%d entries, %d tokens, %dKB)",
+		(int)num,
+		(int)new_time,
+		(int)num_entries,
+		(int)num_tokens,
+		(int)(size / 1024)));
+	if (text)
+		Log::info(S_FMT("Converted %d characters of token text", (int)text_length));
 
 	if (dump)
 	{
@@ -14,39 +14,50 @@ public:
 		Default = CStyle | CPPStyle | DoubleHash,
 	};
 
+	// A token read from the source data. The token text isn't copied to a
+	// string, [data] points to it within the tokenizer's source data (or its
+	// text storage if the text differs from the source, see storeText), so
+	// tokens are only valid until the tokenizer is reset or opens other data.
+	// Use text() to get the token as a string (converted from the current
+	// locale's encoding)
 	struct Token
 	{
-		string		text;
+		const char*	data;			// Start of the token text (not null-terminated)
+		unsigned	length;			// Length of the token text
 		unsigned	line_no;
 		bool		quoted_string;
-		unsigned	pos_start;
-		unsigned	pos_end;
-		unsigned	length;
+		unsigned	pos_start;		// Start of the token in the source data
+		unsigned	pos_end;		// End of the token in the source data
 		bool		valid;
 
-		explicit	operator	string() const { return text; }
-		explicit	operator	const string() const { return text; }
-		explicit	operator	const char*() const { return CHR(text); }
-		bool		operator	==(const string& cmp) const { return text == cmp; }
-		bool		operator	==(const char* cmp) const { return text.Cmp(cmp) == 0; }
-		bool		operator	==(char cmp) const { return length == 1 && text[0] == cmp; }
-		bool		operator	!=(const string& cmp) const { return text != cmp; }
-		bool		operator	!=(const char* cmp) const { return text.Cmp(cmp) != 0; }
-		bool		operator	!=(char cmp) const { return length != 1 || text[0] != cmp; }
-		char		operator	[](unsigned index) const { return text[index]; }
+		string		text() const { return wxString(data, wxConvLocal, length); }
+
+		explicit	operator	string() const { return text(); }
+		explicit	operator	const string() const { return text(); }
+		explicit	operator	const char*() const { return CHR(text()); }
+		bool		operator	==(const string& cmp) const;
+		bool		operator	==(const char* cmp) const;
+		bool		operator	==(char cmp) const { return length == 1 && data[0] == cmp; }
+		bool		operator	!=(const string& cmp) const { return !(*this == cmp); }
+		bool		operator	!=(const char* cmp) const { return !(*this == cmp); }
+		bool		operator	!=(char cmp) const { return length != 1 || data[0] != cmp; }
+		char		operator	[](unsigned index) const { return data[index]; }
+
+		bool	equalsNC(const char* cmp) const;
+		bool	startsWith(const char* cmp) const;
 
 		bool	isInteger(bool allow_hex = false) const;
 		bool	isHex() const;
 		bool	isFloat() const;
 
-		int		asInt() const { return wxAtoi(text); }
+		int		asInt() const;
 		bool	asBool() const;
-		double 	asFloat() const { return wxAtof(text); }
+		double 	asFloat() const;
 
-		void 	toInt(int& val) const { val = wxAtoi(text); }
-		void 	toBool(bool& val) const;
-		void 	toFloat(double& val) const { val = wxAtof(text); }
-		void	toFloat(float& val) const { val = (float) wxAtof(text); }
+		void 	toInt(int& val) const { val = asInt(); }
+		void 	toBool(bool& val) const { val = asBool(); }
+		void 	toFloat(double& val) const { val = asFloat(); }
+		void	toFloat(float& val) const { val = (float)asFloat(); }
 	};
 
 	struct TokenizeState
@@ -73,6 +84,8 @@ public:
 		int comments = CommentTypes::Default,
 		const string& special_characters = DEFAULT_SPECIAL_CHARACTERS
 	);
+	Tokenizer(const Tokenizer&) = delete;
+	Tokenizer& operator=(const Tokenizer&) = delete;
 
 	// Accessors
 	const string&	source() const { return source_; }
@@ -122,7 +135,7 @@ public:
 	bool	checkOrEnd(const char* check) const;
 	bool	checkOrEnd(const string& check) const;
 	bool	checkOrEnd(char check) const;
-	bool	checkNC(const char* check) const { return S_CMPNOCASE(token_current_.text, check); }
+	bool	checkNC(const char* check) const { return token_current_.equalsNC(check); }
 	bool	checkOrEndNC(const char* check) const;
 	bool	checkNext(const char* check) const;
 	bool	checkNext(const string& check) const;
@@ -147,10 +160,10 @@ public:
 
 	// Old tokenizer interface bridge (don't use)
 	string		getToken()
-				{ if (atEnd()) return ""; string t = token_current_.text; adv(); return t; }
+				{ if (atEnd()) return ""; string t = token_current_.text(); adv(); return t; }
 	void		getToken(string* str)
-				{ if (atEnd()) *str = ""; else *str = token_current_.text; adv(); }
-	string		peekToken() const { if (atEnd()) return ""; return token_next_.text; }
+				{ if (atEnd()) *str = ""; else *str = token_current_.text(); adv(); }
+	string		peekToken() const { if (atEnd()) return ""; return token_next_.text(); }
 	int			getInteger()
 				{ if (atEnd()) return 0; int v = token_current_.asInt(); adv(); return v; }
 	double		getDouble()
@@ -181,6 +194,12 @@ private:
 											// (except for quoted strings, obviously)
 	bool			debug_;					// Log each token read
 
+	// Storage for token text that differs from the source data (read in
+	// lowercase or with escape characters removed). Blocks are never
+	// reallocated so tokens can point into them, and are reused after a reset
+	vector<vector<char>>	text_blocks_;
+	size_t					text_block_ = 0;
+
 	// Static
 	static Token	invalid_token_;
 
@@ -193,4 +212,5 @@ private:
 	bool		readNext(Token* target);
 	bool		readNext() { return readNext(&token_next_); }
 	void		resetToLineStart();
+	char*		storeText(unsigned length);
 };
@@ -34,6 +34,41 @@
 #include "Tree.h"
 
 
+/*******************************************************************
+ * FUNCTIONS
+ *******************************************************************/
+namespace
+{
+
+/* splitPath
+ * Splits the first directory from [path] into [dir], and the rest of
+ * the path into [rest]. If [path] has no directories, [rest] is set
+ * to the name only and false is returned. Leading separators are
+ * skipped, as with wxFileName
+ *******************************************************************/
+bool splitPath(const string& path, string& dir, string& rest)
+{
+	size_t start = 0;
+	while (start < path.size() && wxFileName::IsPathSeparator(path[start]))
+		start++;
+
+	for (size_t a = start; a < path.size(); a++)
+	{
+		if (wxFileName::IsPathSeparator(path[a]))
+		{
+			dir = path.Mid(start, a - start);
+			rest = path.Mid(a + 1);
+			return true;
+		}
+	}
+
+	rest = path.Mid(start);
+	return false;
+}
+
+} // namespace
+
+
 /*******************************************************************
  * STREENODE CLASS FUNCTIONS
  *******************************************************************/
@@ -44,9 +79,13 @@
 STreeNode::STreeNode(STreeNode* parent)
 {
 	if (parent)
-		parent->addChild(this);
-	else
-		this->parent = nullptr;
+	{
+		// Can't use addChild here since the node isn't fully constructed
+		// (and has no name yet), setName will reindex it later
+		parent->children.push_back(this);
+		parent->child_index[wxEmptyString].push_back(this);
+	}
+	this->parent = parent;
 
 	// Disallow duplicate child names by default
 	allow_dup_child = false;
@@ -101,35 +140,23 @@ STreeNode* STreeNode::getChild(string name)
 	if (name.EndsWith("/"))
 		name.RemoveLast(1);
 
-	// Convert name to path for processing
-	wxFileName fn(name);
-
 	// If no directories were given
-	if (fn.GetDirCount() == 0)
+	string dir, rest;
+	if (!splitPath(name, dir, rest))
 	{
-		// Find child of this node
-		for (unsigned a = 0; a < children.size(); a++)
-		{
-			if (S_CMPNOCASE(name, children[a]->getName()))
-				return children[a];
-		}
+		// Find (first) child of this node
+		auto i = child_index.find(rest.Lower());
+		if (i == child_index.end() || i->second.empty())
+			return nullptr;
 
-		// Child not found
-		return nullptr;
+		return i->second[0];
 	}
 	else
 	{
-		// Directories were given, get the first directory
-		string dir = fn.GetDirs()[0];
-
-		// See if it is a child of this node
+		// Directories were given, see if the first is a child of this node
 		STreeNode* child = getChild(dir);
 		if (child)
-		{
-			// It is, remove the first directory and continue searching that child
-			fn.RemoveDir(0);
-			return child->getChild(fn.GetFullPath(wxPATH_UNIX));
-		}
+			return child->getChild(rest);	// It is, continue searching that child
 		else
 			return nullptr;	// Child doesn't exist
 	}
@@ -152,32 +179,21 @@ vector<STreeNode*> STreeNode::getChildren(string name)
 	if (name.EndsWith("/"))
 		name.RemoveLast(1);
 
-	// Convert name to path for processing
-	wxFileName fn(name);
-
 	// If no directories were given
-	if (fn.GetDirCount() == 0)
+	string dir, rest;
+	if (!splitPath(name, dir, rest))
 	{
-		// Find child of this node
-		for (unsigned a = 0; a < children.size(); a++)
-		{
-			if (S_CMPNOCASE(name, children[a]->getName()))
-				ret.push_back(children[a]);
-		}
+		// Find children of this node
+		auto i = child_index.find(rest.Lower());
+		if (i != child_index.end())
+			ret = i->second;
 	}
 	else
 	{
-		// Directories were given, get the first directory
-		string dir = fn.GetDirs()[0];
-
-		// See if it is a child of this node
+		// Directories were given, see if the first is a child of this node
 		STreeNode* child = getChild(dir);
 		if (child)
-		{
-			// It is, remove the first directory and continue searching that child
-			fn.RemoveDir(0);
-			return child->getChildren(fn.GetFullPath(wxPATH_UNIX));
-		}
+			return child->getChildren(rest);	// It is, continue searching that child
 	}
 
 	return ret;
@@ -189,6 +205,7 @@ vector<STreeNode*> STreeNode::getChildren(string name)
 void STreeNode::addChild(STreeNode* child)
 {
 	children.push_back(child);
+	child_index[child->getName().Lower()].push_back(child);
 	child->parent = this;
 }
 
@@ -206,51 +223,31 @@ STreeNode* STreeNode::addChild(string name)
 	if (name.EndsWith("/"))
 		name.RemoveLast(1);
 
-	// Convert name to path for processing
-	wxFileName fn(name);
+	// Get the first directory (or the name if no directories were given)
+	string dir, rest;
+	bool is_path = splitPath(name, dir, rest);
+	if (!is_path)
+		dir = rest;
 
-	// If no directories were given
-	if (fn.GetDirCount() == 0)
-	{
-		// If child name duplication is disallowed,
-		// check if a child with this name exists
-		STreeNode* child = nullptr;
-		if (!allow_dup_child)
-			child = getChild(name);
-
-		// If it doesn't exist, create it
-		if (!child)
-		{
-			child = createChild(name);
-			addChild(child);
-		}
+	// If child name duplication is disallowed,
+	// check if a child with this name exists
+	STreeNode* child = nullptr;
+	if (!allow_dup_child)
+		child = getChild(dir);
 
-		// Return the created child
-		return child;
-
-	}
-	else
+	// If it doesn't exist, create it
+	if (!child)
 	{
-		// Directories were given, get the first directory
-		string dir = fn.GetDirs()[0];
-
-		// If child name duplication is disallowed,
-		// check if a child with this name exists
-		STreeNode* child = nullptr;
-		if (!allow_dup_child)
-			child = getChild(dir);
-
-		// If it doesn't exist, create it
-		if (!child)
-		{
-			child = createChild(dir);
-			addChild(child);
-		}
-
-		// Continue adding child nodes
-		fn.RemoveDir(0);
-		return child->addChild(fn.GetFullPath(wxPATH_UNIX));
+		child = createChild(dir);
+		addChild(child);
 	}
+
+	// Continue adding child nodes if a path was given,
+	// otherwise return the created child
+	if (is_path)
+		return child->addChild(rest);
+	else
+		return child;
 }
 
 /* STreeNode::removeChild
@@ -264,6 +261,9 @@ bool STreeNode::removeChild(STreeNode* child)
 	{
 		if (children[a] == child)
 		{
+			// Remove child from name index
+			unindexChild(child, child->getName());
+
 			// Reset child's parent
 			children[a]->parent = nullptr;
 
@@ -277,3 +277,64 @@ bool STreeNode::removeChild(STreeNode* child)
 	// Child didn't exist
 	return false;
 }
+
+/* STreeNode::renamed
+ * Updates the parent node's child name index after this node was
+ * renamed from [old_name]
+ *******************************************************************/
+void STreeNode::renamed(const string& old_name)
+{
+	if (parent)
+		parent->childRenamed(this, old_name);
+}
+
+/* STreeNode::childRenamed
+ * Moves [child] from [old_name] to its current name in the child
+ * name index
+ *******************************************************************/
+void STreeNode::childRenamed(STreeNode* child, const string& old_name)
+{
+	string old_key = old_name.Lower();
+	string new_key = child->getName().Lower();
+	if (old_key == new_key)
+		return;
+
+	// Remove from old name
+	unindexChild(child, old_name);
+
+	// Rebuild the list for the new name, since it needs to stay in
+	// child order (renames are rare enough for this to be fine)
+	vector<STreeNode*>& list = child_index[new_key];
+	list.clear();
+	for (auto c : children)
+		if (c == child || S_CMPNOCASE(c->getName(), new_key))
+			list.push_back(c);
+}
+
+/* STreeNode::unindexChild
+ * Removes [child] from the child name index list for [name]
+ *******************************************************************/
+void STreeNode::unindexChild(STreeNode* child, const string& name)
+{
+	auto i = child_index.find(name.Lower());
+	if (i == child_index.end())
+		return;
+
+	auto& list = i->second;
+	auto  pos  = std::find(list.begin(), list.end(), child);
+	if (pos != list.end())
+		list.erase(pos);
+	if (list.empty())
+		child_index.erase(i);
+}
+
+/* STreeNode::clearChildren
+ * Deletes and removes all child nodes
+ *******************************************************************/
+void STreeNode::clearChildren()
+{
+	for (auto child : children)
+		delete child;
+	children.clear();
+	child_index.clear();
+}
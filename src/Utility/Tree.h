@@ -2,19 +2,29 @@
 #ifndef __TREE_H__
 #define __TREE_H__
 
+#include <unordered_map>
+
 /* Some notes:
 	createChild should simply create a STreeNode of the derived type, NOT set its parent (via the constructor or otherwise)
 	deleting a STreeNode will not remove it from its parent, this must be done manually
+	setName implementations must call renamed with the old name, so the parent node's child name index stays valid
 */
 class STreeNode
 {
 protected:
+	typedef std::unordered_map<string, vector<STreeNode*>, wxStringHash, wxStringEqual> ChildIndex;
+
 	vector<STreeNode*>	children;
 	STreeNode*			parent;
 	bool				allow_dup_child;
+	ChildIndex			child_index;	// Children by lowercase name, in child order
 
 	virtual STreeNode*	createChild(string name) = 0;
 
+	void	renamed(const string& old_name);
+	void	childRenamed(STreeNode* child, const string& old_name);
+	void	clearChildren();
+
 public:
 	STreeNode(STreeNode* parent);
 	virtual ~STreeNode();
@@ -37,6 +47,9 @@ public:
 	const vector<STreeNode*>&	allChildren() const { return children; }
 
 	virtual bool	isLeaf() { return children.empty(); }
+
+private:
+	void	unindexChild(STreeNode* child, const string& name);
 };
 
 #endif//__TREE_H__